@@ -0,0 +1,26 @@
+TEMPLATE = app
+TARGET = BatchCli
+CONFIG += console
+CONFIG -= app_bundle
+
+
+include(../shared_config.pri)
+
+# The projection viewers are compiled straight from MainApp — no widgets,
+# no render window.
+INCLUDEPATH += ../MainApp
+DEPENDPATH  += ../MainApp
+
+SOURCES += \
+    batch_main.cpp \
+    ../MainApp/brickedvolume.cpp \
+    ../MainApp/drrviewer.cpp \
+    ../MainApp/memoryledger.cpp \
+    ../MainApp/mipviewer.cpp \
+    ../MainApp/paralleldicomreader.cpp \
+    ../MainApp/parallelfor.cpp \
+    ../MainApp/projectionviewer.cpp \
+    ../MainApp/taskscheduler.cpp \
+    ../MainApp/tracing.cpp \
+    ../MainApp/volumelayouts.cpp \
+    ../MainApp/volumeofinterest.cpp
@@ -0,0 +1,419 @@
+// Headless MIP / DRR generation for DICOM series: the MainApp projection
+// viewers without Qt widgets or a render window, for QA thumbnails.
+//
+// Usage: BatchCli [options] dir...
+//   --list FILE                  series directories, one per line (with or instead of dir...)
+//   --depth N                    directory levels scanned for series   (default 1)
+//   --output DIR                 where the images go                   (default .)
+//   --projections mip,drr        projections per series                (default mip,drr)
+//   --axes sagittal,coronal,axial                                      (default all three)
+//   --format png|raw             png: 8-bit, min..max of each image;
+//                                raw: float32 MetaImage (.mhd + .raw)  (default png)
+//   --jobs N                     series projected at once              (default threads / 4)
+//   --memory-budget MB           decoded volumes and projection buffers
+//                                in flight                             (default 2048)
+//
+// Images are named <nnnn>-<series folder>_<projection>_<axis>. A series larger
+// than the whole budget still runs, alone. Exit code 1 when a series could
+// not be read or an image not written.
+
+#include "drrviewer.h"
+#include "memoryledger.h"
+#include "mipviewer.h"
+#include "paralleldicomreader.h"
+#include "parallelfor.h"
+#include "taskscheduler.h"
+#include "volumelayouts.h"
+
+#include "vtkAbstractArray.h"
+#include "vtkDICOMDirectory.h"
+#include "vtkDICOMReader.h"
+#include "vtkImageCast.h"
+#include "vtkImageData.h"
+#include "vtkImageShiftScale.h"
+#include "vtkInformation.h"
+#include "vtkMetaImageWriter.h"
+#include "vtkNew.h"
+#include "vtkPNGWriter.h"
+#include "vtkSmartPointer.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkStringArray.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+const char *const kAxisNames[3] = {"sagittal", "coronal", "axial"};
+
+enum class Format {
+    Png,
+    Raw,
+};
+
+/// @brief What to produce for every series.
+struct Options
+{
+    bool mip = true;
+    bool drr = true;
+    std::vector<int> axes; // 0 sagittal, 1 coronal, 2 axial
+    Format format = Format::Png;
+    QDir output;
+};
+
+/// @brief One series found by the scan.
+struct Series
+{
+    QString label; // output file prefix
+    vtkSmartPointer<vtkStringArray> files;
+};
+
+/// @brief Timings of one series, for its line and the totals.
+struct SeriesResult
+{
+    bool ok = false;
+    int dims[3] = {0, 0, 0};
+    int images = 0;
+    double megabytes = 0.0; // decoded volume
+    double readMs = 0.0;
+    double projectMs = 0.0;
+    double writeMs = 0.0;
+};
+
+/// @brief Admission control: at most `jobs` series and `budget` bytes in
+/// flight. A series larger than the budget is admitted once nothing else runs.
+class MemoryGate
+{
+public:
+    MemoryGate(int jobs, std::size_t budget) : m_jobs(jobs), m_budget(budget) {}
+
+    void acquire(std::size_t bytes)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released.wait(lock, [&] { return m_active == 0 || (m_active < m_jobs && m_used + bytes <= m_budget); });
+        ++m_active;
+        m_used += bytes;
+        m_peak = std::max(m_peak, m_used);
+    }
+
+    void release(std::size_t bytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_active;
+            m_used -= bytes;
+        }
+        m_released.notify_all();
+    }
+
+    [[nodiscard]] std::size_t peak() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_peak;
+    }
+
+private:
+    const int m_jobs;
+    const std::size_t m_budget;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_released;
+    int m_active = 0;
+    std::size_t m_used = 0;
+    std::size_t m_peak = 0;
+};
+
+// Every series under `dir`, labelled by running number and folder name.
+void collectSeries(const QString &dir, int depth, std::vector<Series> &out)
+{
+    vtkNew<vtkDICOMDirectory> directory;
+    directory->SetDirectoryName(dir.toUtf8().constData());
+    directory->SetScanDepth(depth);
+    directory->Update();
+    if (directory->GetNumberOfSeries() == 0) {
+        std::fprintf(stderr, "no DICOM series in %s\n", qPrintable(dir));
+        return;
+    }
+    static const QRegularExpression unsafe("[^A-Za-z0-9._-]");
+    for (int i = 0; i < directory->GetNumberOfSeries(); ++i) {
+        vtkStringArray *files = directory->GetFileNamesForSeries(i);
+        if (!files || files->GetNumberOfValues() == 0)
+            continue;
+        Series series;
+        series.files = vtkSmartPointer<vtkStringArray>::New();
+        series.files->DeepCopy(files);
+        QString folder = QFileInfo(QString::fromStdString(files->GetValue(0))).dir().dirName();
+        series.label = QString("%1-%2").arg(out.size() + 1, 4, 10, QChar('0')).arg(folder.replace(unsafe, "_"));
+        out.push_back(series);
+    }
+}
+
+// Bytes a series holds while it is projected: the decoded volume, the DRR's
+// float HU remap and, for sagittal views, the viewers' permuted copies when
+// they fit the layout budget. `layouts` is false when the copies would not
+// fit the whole memory budget; the series then reslices the native layout.
+std::size_t footprint(vtkDICOMReader *reader, const Options &options, std::size_t budget, bool &layouts)
+{
+    int extent[6];
+    reader->GetOutputInformation(0)->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), extent);
+    const std::size_t voxels =
+        std::size_t(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+    const std::size_t volume = voxels * vtkAbstractArray::GetDataTypeSize(reader->GetDataScalarType())
+                               * reader->GetNumberOfScalarComponents();
+    const std::size_t remap = options.drr ? voxels * sizeof(float) : 0;
+
+    std::size_t copies = 0;
+    if (std::find(options.axes.begin(), options.axes.end(), 0) != options.axes.end()) {
+        if (options.mip && volume <= VolumeLayouts::kDefaultBudget)
+            copies += volume;
+        if (options.drr && remap <= VolumeLayouts::kDefaultBudget)
+            copies += remap;
+    }
+    layouts = volume + remap + copies <= budget;
+    return volume + remap + (layouts ? copies : 0);
+}
+
+bool writeImage(vtkImageData *image, const QString &path, Format format)
+{
+    if (format == Format::Raw) {
+        vtkNew<vtkImageCast> cast;
+        cast->SetInputData(image);
+        cast->SetOutputScalarTypeToFloat();
+        vtkNew<vtkMetaImageWriter> writer;
+        writer->SetInputConnection(cast->GetOutputPort());
+        writer->SetFileName(QString(path + ".mhd").toUtf8().constData());
+        writer->SetRAWFileName(QString(path + ".raw").toUtf8().constData());
+        writer->SetCompression(false);
+        writer->Write();
+        return writer->GetErrorCode() == 0;
+    }
+
+    // thumbnails: the full range of each image, like the DRR view's first W/L
+    double range[2];
+    image->GetScalarRange(range);
+    vtkNew<vtkImageShiftScale> toBytes;
+    toBytes->SetInputData(image);
+    toBytes->SetShift(-range[0]);
+    toBytes->SetScale(range[1] > range[0] ? 255.0 / (range[1] - range[0]) : 0.0);
+    toBytes->SetOutputScalarTypeToUnsignedChar();
+    toBytes->ClampOverflowOn();
+    vtkNew<vtkPNGWriter> writer;
+    writer->SetInputConnection(toBytes->GetOutputPort());
+    writer->SetFileName(QString(path + ".png").toUtf8().constData());
+    writer->Write();
+    return writer->GetErrorCode() == 0;
+}
+
+// Decode, project every requested axis, write. Runs on the TaskScheduler.
+SeriesResult projectSeries(const Series &series, vtkDICOMReader *reader, const Options &options, bool layouts)
+{
+    SeriesResult result;
+    auto t0 = Clock::now();
+    reader->Update();
+    vtkImageData *volume = reader->GetOutput();
+    result.readMs = elapsedMs(t0);
+    if (reader->GetErrorCode() != 0 || volume->GetNumberOfPoints() == 0) {
+        std::fprintf(stderr, "cannot read series %s\n", qPrintable(series.label));
+        return result;
+    }
+    volume->GetDimensions(result.dims);
+    result.megabytes = MemoryLedger::dataBytes(volume) / 1e6;
+
+    MipViewer mip;
+    DrrViewer drr;
+    if (!layouts) {
+        mip.setLayoutBudget(0);
+        drr.setLayoutBudget(0);
+    }
+    if (options.mip)
+        mip.setInputData(volume);
+    if (options.drr)
+        drr.setInputData(volume);
+
+    result.ok = true;
+    for (int projection = 0; projection < 2; ++projection) {
+        const bool isMip = projection == 0;
+        if (isMip ? !options.mip : !options.drr)
+            continue;
+        for (int axis : options.axes) {
+            t0 = Clock::now();
+            vtkImageData *image = isMip ? mip.viewMip(static_cast<MipAxis>(axis))
+                                        : drr.viewDrr(static_cast<DrrAxis>(axis));
+            result.projectMs += elapsedMs(t0);
+
+            t0 = Clock::now();
+            const QString path = options.output.filePath(QString("%1_%2_%3").arg(
+                series.label, QLatin1String(isMip ? "mip" : "drr"), QLatin1String(kAxisNames[axis])));
+            if (image && writeImage(image, path, options.format)) {
+                ++result.images;
+            } else {
+                std::fprintf(stderr, "cannot write %s\n", qPrintable(path));
+                result.ok = false;
+            }
+            result.writeMs += elapsedMs(t0);
+        }
+    }
+    return result;
+}
+
+bool parseList(const QString &text, const std::vector<QString> &names, std::vector<int> &out)
+{
+    out.clear();
+    for (const QString &item : text.split(',', Qt::SkipEmptyParts)) {
+        const auto it = std::find(names.begin(), names.end(), item.trimmed());
+        if (it == names.end())
+            return false;
+        const int index = static_cast<int>(it - names.begin());
+        if (std::find(out.begin(), out.end(), index) == out.end())
+            out.push_back(index);
+    }
+    return !out.empty();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("MIP / DRR images for DICOM series, without a GUI.");
+    parser.addHelpOption();
+    const QCommandLineOption listOption("list", "Series directories, one per line.", "file");
+    const QCommandLineOption depthOption("depth", "Directory levels scanned for series.", "n", "1");
+    const QCommandLineOption outputOption("output", "Output directory.", "dir", ".");
+    const QCommandLineOption projectionsOption("projections", "mip, drr or both.", "list", "mip,drr");
+    const QCommandLineOption axesOption("axes", "sagittal, coronal, axial.", "list", "sagittal,coronal,axial");
+    const QCommandLineOption formatOption("format", "png or raw (float32 MetaImage).", "name", "png");
+    const QCommandLineOption jobsOption("jobs", "Series projected at once.", "n",
+                                        QString::number(std::max(1, Parallel::threadCount() / 4)));
+    const QCommandLineOption budgetOption("memory-budget", "Memory for series in flight, MB.", "MB", "2048");
+    parser.addOptions({listOption, depthOption, outputOption, projectionsOption, axesOption, formatOption,
+                       jobsOption, budgetOption});
+    parser.addPositionalArgument("dir", "Directories scanned for DICOM series.", "dir...");
+    parser.process(app);
+
+    Options options;
+    std::vector<int> projections;
+    if (!parseList(parser.value(projectionsOption), {"mip", "drr"}, projections)) {
+        std::fprintf(stderr, "bad --projections '%s'\n", qPrintable(parser.value(projectionsOption)));
+        return 1;
+    }
+    options.mip = std::find(projections.begin(), projections.end(), 0) != projections.end();
+    options.drr = std::find(projections.begin(), projections.end(), 1) != projections.end();
+    if (!parseList(parser.value(axesOption), {"sagittal", "coronal", "axial"}, options.axes)) {
+        std::fprintf(stderr, "bad --axes '%s'\n", qPrintable(parser.value(axesOption)));
+        return 1;
+    }
+    const QString format = parser.value(formatOption);
+    if (format != "png" && format != "raw") {
+        std::fprintf(stderr, "unknown format '%s'\n", qPrintable(format));
+        return 1;
+    }
+    options.format = format == "raw" ? Format::Raw : Format::Png;
+    options.output = QDir(parser.value(outputOption));
+    if (!QDir().mkpath(options.output.path())) {
+        std::fprintf(stderr, "cannot create %s\n", qPrintable(options.output.path()));
+        return 1;
+    }
+    const int depth = std::max(1, parser.value(depthOption).toInt());
+    const int jobs = std::max(1, parser.value(jobsOption).toInt());
+    const std::size_t budget = std::size_t(std::max(1.0, parser.value(budgetOption).toDouble()) * 1024 * 1024);
+
+    QStringList directories = parser.positionalArguments();
+    if (parser.isSet(listOption)) {
+        QFile list(parser.value(listOption));
+        if (!list.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            std::fprintf(stderr, "cannot read %s\n", qPrintable(list.fileName()));
+            return 1;
+        }
+        QTextStream lines(&list);
+        while (!lines.atEnd()) {
+            const QString line = lines.readLine().trimmed();
+            if (!line.isEmpty() && !line.startsWith('#'))
+                directories << line;
+        }
+    }
+    if (directories.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    std::vector<Series> series;
+    for (const QString &dir : directories)
+        collectSeries(dir, depth, series);
+    if (series.empty()) {
+        std::fprintf(stderr, "nothing to do\n");
+        return 1;
+    }
+    std::printf("%zu series, %d at once, %.0f MB budget\n", series.size(), jobs, budget / (1024.0 * 1024.0));
+
+    // Headers are read here, one series at a time, to size each series
+    // before it is admitted; decoding and projecting run on the scheduler.
+    MemoryGate gate(jobs, budget);
+    std::vector<SeriesResult> results(series.size());
+    std::vector<std::shared_future<void>> pending;
+    const auto start = Clock::now();
+    for (size_t i = 0; i < series.size(); ++i) {
+        auto reader = vtkSmartPointer<ParallelDicomReader>::New();
+        reader->SetFileNames(series[i].files);
+        reader->UpdateInformation();
+        bool layouts = true;
+        const std::size_t bytes = footprint(reader, options, budget, layouts);
+        gate.acquire(bytes);
+        auto task = [&, i, reader, bytes, layouts]() mutable {
+            SeriesResult &result = results[i];
+            result = projectSeries(series[i], reader, options, layouts);
+            reader = nullptr; // the decoded volume goes before the next series is admitted
+            gate.release(bytes);
+            const double ms = result.readMs + result.projectMs + result.writeMs;
+            std::printf("  [%zu/%zu] %-32s %4dx%4dx%4d  read %8.1f ms  project %8.1f ms  write %7.1f ms"
+                        "  %7.1f MB/s%s\n",
+                        i + 1, series.size(), qPrintable(series[i].label), result.dims[0], result.dims[1],
+                        result.dims[2], result.readMs, result.projectMs, result.writeMs,
+                        ms > 0 ? result.megabytes / (ms / 1000.0) : 0.0, result.ok ? "" : "  FAILED");
+        };
+        pending.push_back(TaskScheduler::instance().submit(TaskPriority::Background, task));
+    }
+    for (auto &future : pending)
+        future.wait();
+    const double seconds = elapsedMs(start) / 1000.0;
+
+    int failed = 0;
+    int images = 0;
+    double megabytes = 0.0;
+    double readMs = 0.0;
+    double projectMs = 0.0;
+    double writeMs = 0.0;
+    for (const SeriesResult &result : results) {
+        failed += result.ok ? 0 : 1;
+        images += result.images;
+        megabytes += result.megabytes;
+        readMs += result.readMs;
+        projectMs += result.projectMs;
+        writeMs += result.writeMs;
+    }
+    std::printf("%zu series (%d failed), %d images in %.1f s: %.2f series/s, %.1f images/s, %.1f MB/s\n",
+                series.size(), failed, images, seconds, series.size() / seconds, images / seconds,
+                megabytes / seconds);
+    std::printf("  summed over series: read %.1f s  project %.1f s  write %.1f s; peak admitted %.0f MB\n",
+                readMs / 1000.0, projectMs / 1000.0, writeMs / 1000.0, gate.peak() / (1024.0 * 1024.0));
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,41 @@
+TEMPLATE = app
+TARGET = Benchmark
+CONFIG += console
+CONFIG -= app_bundle
+
+
+include(../shared_config.pri)
+
+# The kernels under test are compiled straight from MainApp — no library split.
+INCLUDEPATH += ../MainApp
+DEPENDPATH  += ../MainApp
+
+SOURCES += \
+    bench_main.cpp \
+    benchreport.cpp \
+    phantom.cpp \
+    ../MainApp/annotationindex.cpp \
+    ../MainApp/annotationset.cpp \
+    ../MainApp/brickcodec.cpp \
+    ../MainApp/brickedvolume.cpp \
+    ../MainApp/compressedvolume.cpp \
+    ../MainApp/cpuraycaster.cpp \
+    ../MainApp/drrviewer.cpp \
+    ../MainApp/gradientvolume.cpp \
+    ../MainApp/isosurface.cpp \
+    ../MainApp/isotropicvolume.cpp \
+    ../MainApp/memoryledger.cpp \
+    ../MainApp/mipviewer.cpp \
+    ../MainApp/obliquereslicer.cpp \
+    ../MainApp/paralleldicomreader.cpp \
+    ../MainApp/parallelfor.cpp \
+    ../MainApp/preintegration.cpp \
+    ../MainApp/projectionviewer.cpp \
+    ../MainApp/taskscheduler.cpp \
+    ../MainApp/tracing.cpp \
+    ../MainApp/volumelayouts.cpp \
+    ../MainApp/volumeofinterest.cpp
+
+HEADERS += \
+    benchreport.h \
+    phantom.h
@@ -0,0 +1,1010 @@
+// Headless benchmark suite for the MainApp processing paths, run on
+// deterministic synthetic CT phantoms.
+//
+// Usage: Benchmark [options] [size]
+//   --sizes 256,512,512x512x2000   phantoms, N (N³) or XxYxZ   (default 256,512)
+//   --suite core|kernels|all       core: load (uncompressed and, with GDCM,
+//                                  JPEG-Lossless / JPEG 2000), MIP, DRR,
+//                                  isotropic resampling, bricks,
+//                                  compressed bricks, slice,
+//                                  window/level on every phantom;
+//                                  kernels: oblique, picking, raycast,
+//                                  isosurface on the first phantom
+//   --repeat N                     repetitions per timed case   (default 5)
+//   --json FILE                    machine-readable report ("-" = stdout)
+//   --compare FILE                 median ratios against an earlier report;
+//                                  exit code 2 when a case regressed
+//   --tolerance F                  allowed slowdown for --compare (default 0.10)
+//   --data-dir DIR                 where DICOM series are written (default temp)
+//   --trace FILE                   Chrome trace JSON of the whole run
+
+#include "annotationset.h"
+#include "benchreport.h"
+#include "brickedvolume.h"
+#include "compressedvolume.h"
+#include "cpuraycaster.h"
+#include "drrviewer.h"
+#include "isosurface.h"
+#include "isotropicvolume.h"
+#include "mipviewer.h"
+#include "obliquereslicer.h"
+#include "paralleldicomreader.h"
+#include "parallelfor.h"
+#include "phantom.h"
+#include "tracing.h"
+
+#include "vtkCamera.h"
+#include "vtkColorTransferFunction.h"
+#include "vtkDICOMCTGenerator.h"
+#include "vtkDICOMDirectory.h"
+#include "vtkDICOMWriter.h"
+#include "vtkExtractVOI.h"
+#include "vtkImageData.h"
+#include "vtkImageMapToWindowLevelColors.h"
+#include "vtkImageReslice.h"
+#include "vtkMatrix4x4.h"
+#include "vtkNew.h"
+#include "vtkPiecewiseFunction.h"
+#include "vtkSmartPointer.h"
+#include "vtkStringArray.h"
+#include "vtkTrivialProducer.h"
+#include "vtkVolumeProperty.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QSysInfo>
+#include <QTemporaryDir>
+
+#ifdef HAVE_GDCM
+#include "gdcmImageChangeTransferSyntax.h"
+#include "gdcmImageReader.h"
+#include "gdcmImageWriter.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Human-readable progress; moved to stderr when the JSON report goes to stdout.
+std::FILE *g_log = stdout;
+
+/// @brief Where results of one phantom go.
+struct Run
+{
+    BenchReport &report;
+    QString phantom; // PhantomSize::label()
+    int repeat = 5;
+    // in-core MIP / DRR medians per axis: the baseline the bricked paths
+    // report their slowdown against
+    double mipMs[3] = {0, 0, 0};
+    double drrMs[3] = {0, 0, 0};
+    // uncompressed series read through vtkDICOMReader: the compressed
+    // loads' baseline
+    double loadMs = 0;
+};
+
+template <typename Fn>
+std::vector<double> timeRepeated(int repeat, Fn &&fn)
+{
+    std::vector<double> samples;
+    samples.reserve(repeat);
+    for (int i = 0; i < repeat; ++i) {
+        const auto t0 = Clock::now();
+        fn(i);
+        samples.push_back(elapsedMs(t0));
+    }
+    return samples;
+}
+
+double median(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples.empty() ? 0.0 : samples[samples.size() / 2];
+}
+
+const char *const kAxisNames[3] = {"sagittal", "coronal", "axial"};
+
+// ---------------------------------------------------------------------------
+// Core suite: the paths every loaded series goes through
+// ---------------------------------------------------------------------------
+
+// The phantom as one CT slice per file, uncompressed; returns the write time.
+double writeSeries(vtkImageData *volume, const QString &seriesDir)
+{
+    QDir().mkpath(seriesDir);
+    vtkNew<vtkDICOMCTGenerator> generator;
+    vtkNew<vtkDICOMWriter> writer;
+    writer->SetInputData(volume);
+    writer->SetGenerator(generator);
+    writer->SetFilePrefix(seriesDir.toUtf8().constData());
+    writer->SetFilePattern("%s/IM-0001-%04.4d.dcm");
+    const auto t0 = Clock::now();
+    writer->Write();
+    return elapsedMs(t0);
+}
+
+// Scans `seriesDir` and reads its first series with a fresh reader, as
+// MainWindow::loadDicomDirectory does; true when the voxels are the phantom's.
+bool readSeries(const QString &seriesDir, vtkImageData *volume, bool parallel = true, bool *viaGdcm = nullptr)
+{
+    vtkNew<vtkDICOMDirectory> directory;
+    directory->SetDirectoryName(seriesDir.toUtf8().constData());
+    directory->Update();
+    if (directory->GetNumberOfSeries() == 0)
+        return false;
+    vtkNew<ParallelDicomReader> reader;
+    reader->SetParallelDecode(parallel);
+    reader->SetFileNames(directory->GetFileNamesForSeries(0));
+    reader->Update();
+    if (viaGdcm)
+        *viaGdcm = reader->GetDecodedWithGdcm();
+    vtkImageData *loaded = reader->GetOutput();
+    if (reader->GetErrorCode() != 0 || loaded->GetNumberOfPoints() != volume->GetNumberOfPoints())
+        return false;
+    const size_t count = volume->GetNumberOfPoints();
+    const auto *expected = static_cast<const short *>(volume->GetScalarPointer());
+    if (loaded->GetScalarType() == VTK_SHORT)
+        return std::memcmp(loaded->GetScalarPointer(), expected, count * sizeof(short)) == 0;
+    // a rescaled series may come back in a wider type; the HU must still match
+    bool same = false;
+    switch (loaded->GetScalarType()) {
+        vtkTemplateMacro(same = std::equal(expected, expected + count,
+                                           static_cast<const VTK_TT *>(loaded->GetScalarPointer()),
+                                           [](short hu, VTK_TT value) { return double(hu) == double(value); }));
+    }
+    return same;
+}
+
+// Series written once with vtkDICOMWriter (one CT slice per file), then
+// scanned and read back the way MainWindow::loadDicomDirectory does. Reads
+// after the first hit the OS file cache; the metric is the warm read rate.
+void benchLoad(vtkImageData *volume, const QString &dataDir, Run &run)
+{
+    const QString seriesDir = QDir(dataDir).filePath("series-" + run.phantom);
+    const double writeMs = writeSeries(volume, seriesDir);
+
+    bool identical = false;
+    std::vector<double> samples = timeRepeated(run.repeat, [&](int rep) {
+        // uncompressed: ParallelDicomReader is vtkDICOMReader here
+        const bool same = readSeries(seriesDir, volume);
+        if (rep == 0)
+            identical = same;
+    });
+    run.loadMs = median(samples);
+
+    const double megabytes = volume->GetNumberOfPoints() * sizeof(short) / 1e6;
+    BenchCase c{"load.dicom", run.phantom, {}, {}, samples};
+    c.metrics.insert("writeMs", writeMs);
+    c.metrics.insert("files", volume->GetDimensions()[2]);
+    c.metrics.insert("MBps", megabytes / (median(samples) / 1000.0));
+    c.metrics.insert("identical", identical);
+    run.report.add(c);
+    std::fprintf(g_log, "  load (scan + read, %d files)  %9.1f ms  %7.1f MB/s%s\n",
+                 volume->GetDimensions()[2], median(samples), megabytes / (median(samples) / 1000.0),
+                 identical ? "" : "  MISMATCH");
+
+    QDir(seriesDir).removeRecursively();
+}
+
+#ifdef HAVE_GDCM
+// Stores a signed HU slice the way most CT scanners do: unsigned 12-bit
+// values with intercept -1024, so reading it back has to rescale.
+bool storeUnsigned(gdcm::Image &image)
+{
+    if (image.GetPixelFormat() != gdcm::PixelFormat::INT16)
+        return false;
+    std::vector<short> hu(image.GetBufferLength() / sizeof(short));
+    if (!image.GetBuffer(reinterpret_cast<char *>(hu.data())))
+        return false;
+    std::vector<unsigned short> stored(hu.size());
+    std::transform(hu.begin(), hu.end(), stored.begin(),
+                   [](short value) { return static_cast<unsigned short>(value + 1024); });
+    gdcm::DataElement pixelData(gdcm::Tag(0x7fe0, 0x0010));
+    pixelData.SetByteValue(reinterpret_cast<const char *>(stored.data()),
+                           static_cast<uint32_t>(stored.size() * sizeof(unsigned short)));
+    pixelData.SetVR(gdcm::VR::OW);
+    image.SetDataElement(pixelData);
+    image.SetPixelFormat(gdcm::PixelFormat(1, 16, 12, 11, 0)); // unsigned, 12 of 16 bits
+    image.SetSlope(1.0);
+    image.SetIntercept(-1024.0);
+    return true;
+}
+
+// Re-encodes every file of `sourceDir` into `targetDir` with `syntax`,
+// stored unsigned (storeUnsigned); false when GDCM cannot. Files are
+// independent, so they are encoded in parallel.
+bool transcodeSeries(const QString &sourceDir, const QString &targetDir, const gdcm::TransferSyntax &syntax)
+{
+    QDir().mkpath(targetDir);
+    const QStringList names = QDir(sourceDir).entryList(QDir::Files, QDir::Name);
+    std::atomic<bool> ok{!names.isEmpty()};
+    Parallel::forRange(0, names.size(), 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            gdcm::ImageReader reader;
+            reader.SetFileName(QDir(sourceDir).filePath(names[i]).toUtf8().constData());
+            if (!reader.Read()) {
+                ok = false;
+                continue;
+            }
+            if (!storeUnsigned(reader.GetImage())) {
+                ok = false;
+                continue;
+            }
+            gdcm::ImageChangeTransferSyntax change;
+            change.SetTransferSyntax(syntax);
+            change.SetInput(reader.GetImage());
+            if (!change.Change()) {
+                ok = false;
+                continue;
+            }
+            gdcm::ImageWriter writer;
+            writer.SetFileName(QDir(targetDir).filePath(names[i]).toUtf8().constData());
+            writer.SetFile(reader.GetFile());
+            writer.SetImage(change.GetOutput());
+            if (!writer.Write())
+                ok = false;
+        }
+    });
+    return ok;
+}
+
+qint64 directoryBytes(const QString &dir)
+{
+    qint64 bytes = 0;
+    for (const QFileInfo &file : QDir(dir).entryInfoList(QDir::Files))
+        bytes += file.size();
+    return bytes;
+}
+#endif
+
+// The same series re-encoded as JPEG-Lossless and JPEG 2000 (lossless),
+// stored unsigned with intercept -1024 like scanner exports, read through ParallelDicomReader with one decoding thread and with all of
+// them. "vsUncompressed" is the median against load.dicom's.
+void benchLoadCompressed(vtkImageData *volume, const QString &dataDir, Run &run)
+{
+#ifdef HAVE_GDCM
+    const QString sourceDir = QDir(dataDir).filePath("series-" + run.phantom);
+    writeSeries(volume, sourceDir);
+    const qint64 rawBytes = directoryBytes(sourceDir);
+    const double megabytes = volume->GetNumberOfPoints() * sizeof(short) / 1e6;
+
+    const struct
+    {
+        const char *name;
+        gdcm::TransferSyntax::TSType syntax;
+    } encodings[] = {
+        {"jpeg-lossless", gdcm::TransferSyntax::JPEGLosslessProcess14_1},
+        {"jpeg2000", gdcm::TransferSyntax::JPEG2000Lossless},
+    };
+    for (const auto &encoding : encodings) {
+        const QString seriesDir = QDir(dataDir).filePath(QString("series-%1-%2").arg(run.phantom, encoding.name));
+        auto t0 = Clock::now();
+        if (!transcodeSeries(sourceDir, seriesDir, encoding.syntax)) {
+            std::fprintf(g_log, "  load (%s)  cannot encode, skipped\n", encoding.name);
+            QDir(seriesDir).removeRecursively();
+            continue;
+        }
+        const double encodeMs = elapsedMs(t0);
+        const qint64 compressedBytes = directoryBytes(seriesDir);
+
+        double serialMs = 0;
+        for (const bool parallel : {false, true}) {
+            bool identical = false;
+            bool gdcmPath = false;
+            std::vector<double> samples = timeRepeated(run.repeat, [&](int rep) {
+                bool viaGdcm = false;
+                const bool same = readSeries(seriesDir, volume, parallel, &viaGdcm);
+                if (rep == 0) {
+                    identical = same;
+                    gdcmPath = viaGdcm;
+                }
+            });
+            const double ms = median(samples);
+            if (!parallel)
+                serialMs = ms;
+
+            BenchCase c{"load.dicom.compressed", run.phantom, {}, {}, samples};
+            c.params.insert("syntax", encoding.name);
+            c.params.insert("decode", parallel ? "parallel" : "serial");
+            c.metrics.insert("encodeMs", encodeMs);
+            c.metrics.insert("compressionRatio", compressedBytes > 0 ? double(rawBytes) / compressedBytes : 0.0);
+            c.metrics.insert("MBps", megabytes / (ms / 1000.0));
+            c.metrics.insert("vsUncompressed", run.loadMs > 0 ? ms / run.loadMs : 0.0);
+            if (parallel)
+                c.metrics.insert("speedup", ms > 0 ? serialMs / ms : 0.0);
+            c.metrics.insert("identical", identical);
+            run.report.add(c);
+            std::fprintf(g_log, "  load (%s, %s decode, %.1fx smaller)  %9.1f ms  %7.1f MB/s  %.2fx uncompressed%s%s\n",
+                         encoding.name, parallel ? "parallel" : "serial",
+                         compressedBytes > 0 ? double(rawBytes) / compressedBytes : 0.0, ms,
+                         megabytes / (ms / 1000.0), run.loadMs > 0 ? ms / run.loadMs : 0.0,
+                         identical ? "" : "  MISMATCH", gdcmPath ? "" : "  (not via GDCM)");
+        }
+        QDir(seriesDir).removeRecursively();
+    }
+    QDir(sourceDir).removeRecursively();
+#else
+    (void) volume;
+    (void) dataDir;
+    (void) run;
+    std::fprintf(g_log, "  load (compressed)  skipped: built without GDCM\n");
+#endif
+}
+
+// MIP and DRR per axis through the MainApp viewers.
+void benchProjections(vtkImageData *volume, Run &run)
+{
+    MipViewer mip;
+    mip.setInputData(volume);
+    DrrViewer drr;
+    drr.setInputData(volume);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        std::vector<double> mipMs = timeRepeated(run.repeat, [&](int) {
+            (void) mip.viewMip(static_cast<MipAxis>(axis));
+        });
+        std::vector<double> drrMs = timeRepeated(run.repeat, [&](int) {
+            (void) drr.viewDrr(static_cast<DrrAxis>(axis));
+        });
+
+        run.mipMs[axis] = median(mipMs);
+        run.drrMs[axis] = median(drrMs);
+
+        BenchCase mipCase{"mip", run.phantom, {}, {}, mipMs};
+        mipCase.params.insert("axis", kAxisNames[axis]);
+        run.report.add(mipCase);
+        BenchCase drrCase{"drr", run.phantom, {}, {}, drrMs};
+        drrCase.params.insert("axis", kAxisNames[axis]);
+        run.report.add(drrCase);
+        std::fprintf(g_log, "  %-8s  mip %9.1f ms   drr %9.1f ms\n", kAxisNames[axis], median(mipMs), median(drrMs));
+    }
+
+    // Sagittal again on the native layout: what the permuted copy buys.
+    mip.setLayoutBudget(0);
+    drr.setLayoutBudget(0);
+    std::vector<double> mipMs = timeRepeated(run.repeat, [&](int) { (void) mip.viewMip(MipAxis::Sagittal); });
+    std::vector<double> drrMs = timeRepeated(run.repeat, [&](int) { (void) drr.viewDrr(DrrAxis::Sagittal); });
+    BenchCase mipCase{"mip.native", run.phantom, {}, {}, mipMs};
+    mipCase.params.insert("axis", kAxisNames[0]);
+    mipCase.metrics.insert("layoutSpeedup", run.mipMs[0] > 0 ? median(mipMs) / run.mipMs[0] : 0.0);
+    run.report.add(mipCase);
+    BenchCase drrCase{"drr.native", run.phantom, {}, {}, drrMs};
+    drrCase.params.insert("axis", kAxisNames[0]);
+    drrCase.metrics.insert("layoutSpeedup", run.drrMs[0] > 0 ? median(drrMs) / run.drrMs[0] : 0.0);
+    run.report.add(drrCase);
+    std::fprintf(g_log, "  %-8s  mip %9.1f ms   drr %9.1f ms   (native layout)\n", kAxisNames[0], median(mipMs),
+                 median(drrMs));
+}
+
+// Load-time isotropic resampling (the phantoms are 0.7 x 0.7 x 1.0 mm), then
+// MIP / DRR per axis on the cubic-voxel copy. "vsNative" is the median
+// against the projection of the original volume.
+void benchIsotropic(vtkImageData *volume, Run &run)
+{
+    const double spacing = Isotropic::targetSpacing(volume);
+    vtkSmartPointer<vtkImageData> isotropic;
+    std::vector<double> resampleMs = timeRepeated(run.repeat, [&](int) {
+        isotropic = Isotropic::resample(volume, spacing);
+    });
+    if (!isotropic)
+        return;
+    const double inMB = volume->GetNumberOfPoints() * std::size_t(volume->GetScalarSize()) / 1e6;
+    const double outMB = isotropic->GetNumberOfPoints() * std::size_t(isotropic->GetScalarSize()) / 1e6;
+    BenchCase resampleCase{"isotropic.resample", run.phantom, {}, {}, resampleMs};
+    resampleCase.metrics.insert("spacing", spacing);
+    resampleCase.metrics.insert("outputMB", outMB);
+    resampleCase.metrics.insert("MBps", inMB / (median(resampleMs) / 1000.0));
+    run.report.add(resampleCase);
+    std::fprintf(g_log, "  isotropic %.2f mm  %9.1f ms  %7.1f MB/s  (%.0f -> %.0f MB)
+", spacing,
+                 median(resampleMs), inMB / (median(resampleMs) / 1000.0), inMB, outMB);
+
+    MipViewer mip;
+    mip.setInputData(isotropic);
+    DrrViewer drr;
+    drr.setInputData(isotropic, volume->GetSpacing());
+    for (int axis = 0; axis < 3; ++axis) {
+        std::vector<double> mipMs = timeRepeated(run.repeat, [&](int) {
+            (void) mip.viewMip(static_cast<MipAxis>(axis));
+        });
+        std::vector<double> drrMs = timeRepeated(run.repeat, [&](int) {
+            (void) drr.viewDrr(static_cast<DrrAxis>(axis));
+        });
+
+        BenchCase mipCase{"mip.isotropic", run.phantom, {}, {}, mipMs};
+        mipCase.params.insert("axis", kAxisNames[axis]);
+        mipCase.metrics.insert("vsNative", run.mipMs[axis] > 0 ? median(mipMs) / run.mipMs[axis] : 0.0);
+        run.report.add(mipCase);
+        BenchCase drrCase{"drr.isotropic", run.phantom, {}, {}, drrMs};
+        drrCase.params.insert("axis", kAxisNames[axis]);
+        drrCase.metrics.insert("vsNative", run.drrMs[axis] > 0 ? median(drrMs) / run.drrMs[axis] : 0.0);
+        run.report.add(drrCase);
+        std::fprintf(g_log, "  %-8s  mip %9.1f ms   drr %9.1f ms   (isotropic)\n", kAxisNames[axis], median(mipMs),
+                     median(drrMs));
+    }
+}
+
+// Out-of-core path: the phantom converted to a brick file once, then MIP
+// and DRR per axis paged from it, one brick layer at a time.
+void benchBricks(vtkImageData *volume, const QString &dataDir, Run &run)
+{
+    const QString path = QDir(dataDir).filePath("bricks-" + run.phantom + ".bvol");
+    vtkNew<vtkTrivialProducer> producer;
+    producer->SetOutput(volume);
+    auto t0 = Clock::now();
+    if (!BrickedVolume::write(producer, path)) {
+        std::fprintf(stderr, "cannot write %s\n", qPrintable(path));
+        return;
+    }
+    const double writeMs = elapsedMs(t0);
+    run.report.add({"bricks.write", run.phantom, {}, {}, {writeMs}});
+
+    BrickedVolume bricked;
+    if (!bricked.open(path))
+        return;
+    MipViewer mip;
+    mip.setBrickedInput(&bricked);
+    DrrViewer drr;
+    drr.setBrickedInput(&bricked);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        std::vector<double> mipMs = timeRepeated(run.repeat, [&](int) {
+            (void) mip.viewMip(static_cast<MipAxis>(axis));
+        });
+        std::vector<double> drrMs = timeRepeated(run.repeat, [&](int) {
+            (void) drr.viewDrr(static_cast<DrrAxis>(axis));
+        });
+
+        BenchCase mipCase{"mip.bricked", run.phantom, {}, {}, mipMs};
+        mipCase.params.insert("axis", kAxisNames[axis]);
+        mipCase.metrics.insert("residentMB", bricked.residentBytes() / 1e6);
+        run.report.add(mipCase);
+        BenchCase drrCase{"drr.bricked", run.phantom, {}, {}, drrMs};
+        drrCase.params.insert("axis", kAxisNames[axis]);
+        drrCase.metrics.insert("residentMB", bricked.residentBytes() / 1e6);
+        run.report.add(drrCase);
+        std::fprintf(g_log, "  %-8s  mip %9.1f ms   drr %9.1f ms   (bricked, %.0f MB mapped)\n", kAxisNames[axis],
+                     median(mipMs), median(drrMs), bricked.residentBytes() / 1e6);
+    }
+    QFile::remove(path);
+}
+
+// In-RAM compressed bricks: compression ratio and rate, full decode rate with
+// a cold hot-cache, then MIP / DRR per axis and a slice sweep through the
+// compressed store. "slowdown" is the median against the in-core projection.
+void benchCompressed(vtkImageData *volume, Run &run)
+{
+    vtkNew<vtkTrivialProducer> producer;
+    producer->SetOutput(volume);
+    CompressedVolume compressed;
+    auto t0 = Clock::now();
+    if (!compressed.compress(producer)) {
+        std::fprintf(stderr, "cannot compress %s\n", qPrintable(run.phantom));
+        return;
+    }
+    const double compressMs = elapsedMs(t0);
+    const double rawMB = compressed.rawBytes() / 1e6;
+    const double ratio = double(compressed.rawBytes()) / std::max<std::size_t>(1, compressed.compressedBytes());
+
+    BenchCase compressCase{"bricks.compress", run.phantom, {}, {}, {compressMs}};
+    compressCase.metrics.insert("ratio", ratio);
+    compressCase.metrics.insert("compressedMB", compressed.compressedBytes() / 1e6);
+    compressCase.metrics.insert("MBps", rawMB / (compressMs / 1000.0));
+    run.report.add(compressCase);
+
+    // every brick decoded once: the cache budget is below a single brick
+    vtkNew<vtkImageData> decoded;
+    decoded->SetExtent(volume->GetExtent());
+    decoded->AllocateScalars(compressed.scalarType(), 1);
+    compressed.setCacheBudget(0);
+    std::vector<double> decodeMs = timeRepeated(run.repeat, [&](int) { compressed.extract(decoded); });
+    compressed.setCacheBudget(CompressedVolume::kDefaultCacheBudget);
+    const std::size_t bytes = volume->GetNumberOfPoints() * std::size_t(volume->GetScalarSize());
+    const bool identical = std::memcmp(decoded->GetScalarPointer(), volume->GetScalarPointer(), bytes) == 0;
+    BenchCase decodeCase{"bricks.decode", run.phantom, {}, {}, decodeMs};
+    decodeCase.metrics.insert("MBps", rawMB / (median(decodeMs) / 1000.0));
+    decodeCase.metrics.insert("identical", identical);
+    run.report.add(decodeCase);
+    std::fprintf(g_log, "  compressed  %.2f:1 (%.0f -> %.0f MB)  compress %7.1f MB/s  decode %7.1f MB/s%s\n", ratio,
+                 rawMB, compressed.compressedBytes() / 1e6, rawMB / (compressMs / 1000.0),
+                 rawMB / (median(decodeMs) / 1000.0), identical ? "" : "  MISMATCH");
+
+    MipViewer mip;
+    mip.setBrickedInput(&compressed);
+    DrrViewer drr;
+    drr.setBrickedInput(&compressed);
+    vtkNew<BrickedImageSource> source;
+    source->SetVolume(&compressed);
+    int extent[6];
+    volume->GetExtent(extent);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        std::vector<double> mipMs = timeRepeated(run.repeat, [&](int) {
+            (void) mip.viewMip(static_cast<MipAxis>(axis));
+        });
+        std::vector<double> drrMs = timeRepeated(run.repeat, [&](int) {
+            (void) drr.viewDrr(static_cast<DrrAxis>(axis));
+        });
+        // consecutive slices from the middle, as a scroll through the slice view would pull them
+        std::vector<double> sliceMs = timeRepeated(run.repeat, [&](int rep) {
+            int voi[6];
+            std::copy(extent, extent + 6, voi);
+            voi[2 * axis] = voi[2 * axis + 1] =
+                std::min(extent[2 * axis + 1], (extent[2 * axis] + extent[2 * axis + 1]) / 2 + rep);
+            source->UpdateExtent(voi);
+        });
+
+        BenchCase mipCase{"mip.compressed", run.phantom, {}, {}, mipMs};
+        mipCase.params.insert("axis", kAxisNames[axis]);
+        mipCase.metrics.insert("slowdown", run.mipMs[axis] > 0 ? median(mipMs) / run.mipMs[axis] : 0.0);
+        run.report.add(mipCase);
+        BenchCase drrCase{"drr.compressed", run.phantom, {}, {}, drrMs};
+        drrCase.params.insert("axis", kAxisNames[axis]);
+        drrCase.metrics.insert("slowdown", run.drrMs[axis] > 0 ? median(drrMs) / run.drrMs[axis] : 0.0);
+        run.report.add(drrCase);
+        BenchCase sliceCase{"slice.compressed", run.phantom, {}, {}, sliceMs};
+        sliceCase.params.insert("axis", kAxisNames[axis]);
+        run.report.add(sliceCase);
+        std::fprintf(g_log, "  %-8s  mip %9.1f ms   drr %9.1f ms   slice %7.2f ms   (compressed, x%.2f / x%.2f)\n",
+                     kAxisNames[axis], median(mipMs), median(drrMs), median(sliceMs),
+                     run.mipMs[axis] > 0 ? median(mipMs) / run.mipMs[axis] : 0.0,
+                     run.drrMs[axis] > 0 ? median(drrMs) / run.drrMs[axis] : 0.0);
+    }
+}
+
+// Middle slice per orientation, then the window/level mapping the slice
+// view applies to it (vtkImageViewer2's vtkImageMapToWindowLevelColors).
+void benchSlices(vtkImageData *volume, Run &run)
+{
+    int extent[6];
+    volume->GetExtent(extent);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        int voi[6];
+        std::copy(extent, extent + 6, voi);
+        voi[2 * axis] = voi[2 * axis + 1] = (extent[2 * axis] + extent[2 * axis + 1]) / 2;
+
+        vtkNew<vtkExtractVOI> extract;
+        extract->SetInputData(volume);
+        extract->SetVOI(voi);
+        std::vector<double> sliceMs = timeRepeated(run.repeat, [&](int) {
+            extract->Modified(); // same VOI every time: force re-execution
+            extract->Update();
+        });
+
+        vtkNew<vtkImageMapToWindowLevelColors> windowLevel;
+        windowLevel->SetInputData(extract->GetOutput());
+        windowLevel->SetLevel(40.0);
+        std::vector<double> wlMs = timeRepeated(run.repeat, [&](int rep) {
+            windowLevel->SetWindow(400.0 + rep); // a drag step changes the window
+            windowLevel->Update();
+        });
+
+        BenchCase sliceCase{"slice.extract", run.phantom, {}, {}, sliceMs};
+        sliceCase.params.insert("axis", kAxisNames[axis]);
+        run.report.add(sliceCase);
+        BenchCase wlCase{"windowlevel", run.phantom, {}, {}, wlMs};
+        wlCase.params.insert("axis", kAxisNames[axis]);
+        run.report.add(wlCase);
+        std::fprintf(g_log, "  %-8s  slice %7.2f ms   window/level %7.2f ms\n",
+                     kAxisNames[axis], median(sliceMs), median(wlMs));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Kernel suite
+// ---------------------------------------------------------------------------
+
+// Oblique plane rotating a full turn: ObliqueReslicer vs. vtkImageReslice on
+// the identical plane and output grid.
+void benchOblique(vtkImageData *volume, Run &run)
+{
+    constexpr int kFrames = 120;
+    constexpr int kOut = 512;
+
+    ObliqueReslicer reslicer;
+    reslicer.setOutputSize(kOut, kOut);
+    reslicer.setInputData(volume);
+    reslicer.rotate(20.0, 35.0);
+
+    vtkNew<vtkImageReslice> reference;
+    reference->SetInputData(volume);
+    reference->SetOutputDimensionality(2);
+    reference->SetInterpolationModeToLinear();
+    reference->SetOutputScalarType(VTK_FLOAT);
+
+    std::vector<double> oursMs;
+    std::vector<double> vtkMs;
+    double maxDiff = 0.0;
+
+    for (int frame = 0; frame < kFrames; ++frame) {
+        reslicer.rotate(360.0 / kFrames, 1.0);
+
+        auto t0 = Clock::now();
+        vtkImageData *ours = reslicer.reslice();
+        oursMs.push_back(elapsedMs(t0));
+
+        // Same plane as a reslice-axes matrix: columns U, V, N and center.
+        const double *u = reslicer.axisU();
+        const double *v = reslicer.axisV();
+        const double *c = reslicer.center();
+        const double n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+        vtkNew<vtkMatrix4x4> axes;
+        for (int i = 0; i < 3; ++i) {
+            axes->SetElement(i, 0, u[i]);
+            axes->SetElement(i, 1, v[i]);
+            axes->SetElement(i, 2, n[i]);
+            axes->SetElement(i, 3, c[i]);
+        }
+        const double ps = reslicer.pixelSpacing();
+        const double half = (kOut - 1) * 0.5 * ps;
+        reference->SetResliceAxes(axes);
+        reference->SetOutputSpacing(ps, ps, 1.0);
+        reference->SetOutputOrigin(-half, -half, 0.0);
+        reference->SetOutputExtent(0, kOut - 1, 0, kOut - 1, 0, 0);
+
+        t0 = Clock::now();
+        reference->Update();
+        vtkMs.push_back(elapsedMs(t0));
+
+        const float *a = static_cast<const float *>(ours->GetScalarPointer());
+        const float *b = static_cast<const float *>(reference->GetOutput()->GetScalarPointer());
+        for (int i = 0; i < kOut * kOut; ++i)
+            maxDiff = std::max(maxDiff, static_cast<double>(std::abs(a[i] - b[i])));
+    }
+
+    BenchCase ours{"oblique.reslicer", run.phantom, {}, {}, oursMs};
+    ours.params.insert("output", kOut);
+    ours.metrics.insert("maxDiffHu", maxDiff);
+    run.report.add(ours);
+    BenchCase reference{"oblique.vtkImageReslice", run.phantom, {}, {}, vtkMs};
+    reference.params.insert("output", kOut);
+    run.report.add(reference);
+
+    std::fprintf(g_log, "oblique %dx%d, %d frames, %d threads\n", kOut, kOut, kFrames, Parallel::threadCount());
+    std::fprintf(g_log, "  ObliqueReslicer : %8.2f ms/frame\n", median(oursMs));
+    std::fprintf(g_log, "  vtkImageReslice : %8.2f ms/frame\n", median(vtkMs));
+    std::fprintf(g_log, "  max |difference|: %.3f HU\n", maxDiff);
+}
+
+// Pick latency with many annotations: random pairs on one view plane,
+// rays cast straight through it like the 2D slice view does.
+void benchPicking(Run &run)
+{
+    constexpr int kMarkers = 10000;
+    constexpr int kPicks = 20000;
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> coord(0.0, 512.0);
+
+    AnnotationSet annotations;
+    for (int i = 0; i < kMarkers; ++i) {
+        const double pos[3] = {coord(rng), coord(rng), 0.0};
+        annotations.addMarker(pos);
+    }
+
+    const double dir[3] = {0.0, 0.0, 1.0};
+    std::vector<double> latencyUs;
+    latencyUs.reserve(kPicks);
+    int hits = 0;
+    for (int i = 0; i < kPicks; ++i) {
+        const double origin[3] = {coord(rng), coord(rng), -100.0};
+        const auto t0 = Clock::now();
+        const bool hit = annotations.pickMarker(origin, dir) >= 0 || annotations.pickSegment(origin, dir) >= 0;
+        latencyUs.push_back(elapsedMs(t0) * 1000.0);
+        hits += hit ? 1 : 0;
+    }
+    std::sort(latencyUs.begin(), latencyUs.end());
+
+    BenchCase c{"picking", QString(), {}, {}, {}};
+    c.params.insert("markers", kMarkers);
+    c.metrics.insert("p50Us", latencyUs[kPicks / 2]);
+    c.metrics.insert("p99Us", latencyUs[kPicks * 99 / 100]);
+    c.metrics.insert("maxUs", latencyUs.back());
+    for (double us : latencyUs)
+        c.samplesMs.push_back(us / 1000.0);
+    run.report.add(c);
+
+    std::fprintf(g_log, "picking, %d markers / %d segments, %d picks (%d hits)\n",
+                annotations.markerCount(), annotations.pairCount(), kPicks, hits);
+    std::fprintf(g_log, "  p50 %.1f us  p99 %.1f us  max %.1f us\n",
+                latencyUs[kPicks / 2], latencyUs[kPicks * 99 / 100], latencyUs.back());
+}
+
+/// @brief SandBox's composite transfer function for the phantom's range.
+vtkSmartPointer<vtkVolumeProperty> makeVolumeProperty(vtkImageData *volume)
+{
+    double range[2];
+    volume->GetScalarRange(range);
+    vtkNew<vtkPiecewiseFunction> opacity;
+    opacity->AddPoint(range[0], 0.0);
+    opacity->AddPoint(-1000, 0.0);
+    opacity->AddPoint(0, 0.05);
+    opacity->AddPoint(300, 0.2);
+    opacity->AddPoint(700, 0.7);
+    opacity->AddPoint(range[1], 1.0);
+    vtkNew<vtkColorTransferFunction> color;
+    color->AddRGBPoint(range[0], 0.0, 0.0, 0.0);
+    color->AddRGBPoint(range[1], 1.0, 1.0, 1.0);
+    auto property = vtkSmartPointer<vtkVolumeProperty>::New();
+    property->SetScalarOpacity(opacity);
+    property->SetColor(color);
+    return property;
+}
+
+// Camera looking at the volume center from -Y, ready to orbit with Azimuth().
+void aimCamera(vtkCamera *camera, vtkImageData *volume)
+{
+    double bounds[6];
+    volume->GetBounds(bounds);
+    camera->SetFocalPoint((bounds[0] + bounds[1]) * 0.5, (bounds[2] + bounds[3]) * 0.5, (bounds[4] + bounds[5]) * 0.5);
+    camera->SetPosition((bounds[0] + bounds[1]) * 0.5, bounds[2] - 2.0 * (bounds[3] - bounds[2]), (bounds[4] + bounds[5]) * 0.5);
+    camera->SetViewUp(0.0, 0.0, 1.0);
+    camera->SetClippingRange(1.0, 10.0 * (bounds[3] - bounds[2]));
+}
+
+// CPU composite raycast at 512² while the camera orbits the phantom, with
+// the SandBox bone/soft-tissue transfer function.
+void benchRaycast(vtkImageData *volume, Run &run)
+{
+    constexpr int kFrames = 36;
+    constexpr int kOut = 512;
+
+    vtkSmartPointer<vtkVolumeProperty> property = makeVolumeProperty(volume);
+    const double *spacing = volume->GetSpacing();
+    CpuRaycaster raycaster;
+    raycaster.setSampleDistance(std::min({spacing[0], spacing[1], spacing[2]}));
+    auto t0 = Clock::now();
+    raycaster.setInputData(volume);
+    raycaster.setProperty(property);
+    const double setupMs = elapsedMs(t0);
+
+    vtkNew<vtkCamera> camera;
+    aimCamera(camera, volume);
+
+    std::vector<double> frameMs;
+    long long samples = 0;
+    for (int frame = 0; frame < kFrames; ++frame) {
+        camera->Azimuth(360.0 / kFrames);
+        t0 = Clock::now();
+        (void) raycaster.render(camera, kOut, kOut);
+        frameMs.push_back(elapsedMs(t0));
+        samples += raycaster.lastSampleCount();
+    }
+
+    BenchCase c{"raycast.cpu", run.phantom, {}, {}, frameMs};
+    c.params.insert("output", kOut);
+    c.metrics.insert("macrocellMs", setupMs);
+    c.metrics.insert("MsamplesPerFrame", samples / 1e6 / kFrames);
+    run.report.add(c);
+
+    std::fprintf(g_log, "cpu raycast %dx%d, %d frames, %d threads (macrocells %.0f ms)\n",
+                 kOut, kOut, kFrames, Parallel::threadCount(), setupMs);
+    std::fprintf(g_log, "  %8.2f ms/frame  %.1f Msamples/frame\n", median(frameMs), samples / 1e6 / kFrames);
+}
+
+// Quality vs. speed: point-sampled and pre-integrated compositing at growing
+// sample distances, each compared against a point-sampled render at a
+// quarter of the voxel size. RMSE / max are in 8-bit RGBA levels.
+void benchPreIntegration(vtkImageData *volume, Run &run)
+{
+    constexpr int kViews = 4;
+    constexpr int kOut = 384;
+    const size_t values = static_cast<size_t>(kOut) * kOut * 4;
+
+    vtkSmartPointer<vtkVolumeProperty> property = makeVolumeProperty(volume);
+    const double *spacing = volume->GetSpacing();
+    const double voxel = std::min({spacing[0], spacing[1], spacing[2]});
+
+    vtkNew<vtkCamera> camera;
+    aimCamera(camera, volume);
+    std::vector<std::vector<unsigned char>> reference;
+    {
+        CpuRaycaster raycaster;
+        raycaster.setInputData(volume);
+        raycaster.setProperty(property);
+        raycaster.setPreIntegration(false);
+        raycaster.setSampleDistance(0.25 * voxel);
+        for (int view = 0; view < kViews; ++view) {
+            camera->Azimuth(360.0 / kViews + 7.0);
+            const auto *pixels = static_cast<const unsigned char *>(
+                raycaster.render(camera, kOut, kOut)->GetScalarPointer());
+            reference.emplace_back(pixels, pixels + values);
+        }
+    }
+
+    std::fprintf(g_log, "transfer function quality vs. speed %dx%d, %d views\n", kOut, kOut, kViews);
+    for (double factor : {0.5, 1.0, 2.0, 4.0}) {
+        for (bool preIntegrate : {false, true}) {
+            CpuRaycaster raycaster;
+            raycaster.setInputData(volume);
+            raycaster.setProperty(property);
+            raycaster.setPreIntegration(preIntegrate);
+            raycaster.setSampleDistance(factor * voxel);
+
+            aimCamera(camera, volume);
+            std::vector<double> viewMs;
+            double squaredError = 0.0;
+            int maxError = 0;
+            for (int view = 0; view < kViews; ++view) {
+                camera->Azimuth(360.0 / kViews + 7.0);
+                auto t0 = Clock::now();
+                const auto *pixels = static_cast<const unsigned char *>(
+                    raycaster.render(camera, kOut, kOut)->GetScalarPointer());
+                viewMs.push_back(elapsedMs(t0));
+                for (size_t i = 0; i < values; ++i) {
+                    const int error = pixels[i] - reference[view][i];
+                    squaredError += error * error;
+                    maxError = std::max(maxError, std::abs(error));
+                }
+            }
+            const double rmse = std::sqrt(squaredError / (values * kViews));
+            BenchCase c{"raycast.step", run.phantom, {}, {}, viewMs};
+            c.params.insert("stepVoxels", factor);
+            c.params.insert("mode", preIntegrate ? "pre-integrated" : "point");
+            c.metrics.insert("rmse", rmse);
+            c.metrics.insert("maxError", maxError);
+            run.report.add(c);
+            std::fprintf(g_log, "  step %.2f voxel  %-14s %8.2f ms/frame  rmse %5.2f  max %3d\n",
+                         factor, preIntegrate ? "pre-integrated" : "point", median(viewMs), rmse, maxError);
+        }
+    }
+}
+
+// Isosurface: octree build, a cold extraction per threshold, then an iso
+// drag of small steps the way the SandBox slider produces them.
+void benchIsoSurface(vtkImageData *volume, Run &run)
+{
+    IsoSurfaceExtractor extractor;
+    auto t0 = Clock::now();
+    extractor.setInputData(volume);
+    const double octreeMs = elapsedMs(t0);
+    run.report.add({"isosurface.octree", run.phantom, {}, {}, {octreeMs}});
+    std::fprintf(g_log, "isosurface (octree %.0f ms, %d blocks)\n", octreeMs, extractor.blockCount());
+
+    for (double iso : {-500.0, 300.0, 1000.0}) {
+        t0 = Clock::now();
+        vtkPolyData *surface = extractor.extract(iso);
+        const double ms = elapsedMs(t0);
+        BenchCase c{"isosurface.extract", run.phantom, {}, {}, {ms}};
+        c.params.insert("iso", iso);
+        c.metrics.insert("activeBlocks", extractor.lastActiveBlocks());
+        c.metrics.insert("triangles", static_cast<double>(surface->GetNumberOfCells()));
+        run.report.add(c);
+        std::fprintf(g_log, "  iso %6.0f  %8.2f ms  %5d active blocks  %lld triangles\n", iso, ms,
+                     extractor.lastActiveBlocks(), static_cast<long long>(surface->GetNumberOfCells()));
+    }
+
+    constexpr int kSteps = 20;
+    std::vector<double> stepMs = timeRepeated(kSteps, [&](int step) {
+        (void) extractor.extract(300.0 + 5.0 * step);
+    });
+    run.report.add({"isosurface.drag", run.phantom, {}, {}, stepMs});
+    std::fprintf(g_log, "  drag %d steps  %8.2f ms/step\n", kSteps, median(stepMs));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmarks for the MainApp processing paths on synthetic CT phantoms.");
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption("sizes", "Phantom sizes, N or XxYxZ, comma separated.", "list", "256,512");
+    const QCommandLineOption suiteOption("suite", "core, kernels or all.", "name", "all");
+    const QCommandLineOption repeatOption("repeat", "Repetitions per timed case.", "n", "5");
+    const QCommandLineOption jsonOption("json", "Write the report as JSON (- = stdout).", "file");
+    const QCommandLineOption compareOption("compare", "Compare medians against an earlier report.", "file");
+    const QCommandLineOption toleranceOption("tolerance", "Allowed slowdown for --compare.", "fraction", "0.10");
+    const QCommandLineOption dataDirOption("data-dir", "Directory for the written DICOM series.", "dir");
+    const QCommandLineOption traceOption("trace", "Write a Chrome trace of the run.", "file");
+    parser.addOptions({sizesOption, suiteOption, repeatOption, jsonOption, compareOption, toleranceOption,
+                       dataDirOption, traceOption});
+    parser.addPositionalArgument("size", "Single phantom size (same as --sizes).", "[size]");
+    parser.process(app);
+
+    QStringList sizeList = parser.value(sizesOption).split(',', Qt::SkipEmptyParts);
+    if (!parser.positionalArguments().isEmpty())
+        sizeList = parser.positionalArguments();
+    std::vector<PhantomSize> sizes;
+    for (const QString &text : sizeList) {
+        PhantomSize size;
+        if (!PhantomSize::parse(text.trimmed().toStdString(), size)) {
+            std::fprintf(stderr, "bad phantom size '%s'\n", qPrintable(text));
+            return 1;
+        }
+        sizes.push_back(size);
+    }
+
+    const QString suite = parser.value(suiteOption);
+    const bool core = suite == "core" || suite == "all";
+    const bool kernels = suite == "kernels" || suite == "all";
+    if (!core && !kernels) {
+        std::fprintf(stderr, "unknown suite '%s'\n", qPrintable(suite));
+        return 1;
+    }
+    const int repeat = std::max(1, parser.value(repeatOption).toInt());
+    const QString jsonPath = parser.value(jsonOption);
+    if (jsonPath == "-")
+        g_log = stderr; // keep stdout pure JSON
+
+    if (parser.isSet(traceOption)) {
+        Trace::setThreadName("main");
+        Trace::setEnabled(true);
+    }
+
+    QTemporaryDir tempDir;
+    const QString dataDir = parser.isSet(dataDirOption) ? parser.value(dataDirOption) : tempDir.path();
+
+    BenchReport report;
+    report.setContext("threads", Parallel::threadCount());
+    report.setContext("repeat", repeat);
+    report.setContext("suite", suite);
+    report.setContext("date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    report.setContext("os", QSysInfo::prettyProductName());
+    report.setContext("cpu", QSysInfo::currentCpuArchitecture());
+
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        const PhantomSize &size = sizes[i];
+        auto t0 = Clock::now();
+        vtkSmartPointer<vtkImageData> phantom = makePhantom(size);
+        const double buildMs = elapsedMs(t0);
+        std::fprintf(g_log, "phantom %s int16 (%.0f MB) built in %.0f ms\n", size.label().c_str(),
+                     size.voxelCount() * sizeof(short) / 1e6, buildMs);
+
+        Run run{report, QString::fromStdString(size.label()), repeat};
+        run.report.add({"phantom.build", run.phantom, {}, {}, {buildMs}});
+        if (core) {
+            benchLoad(phantom, dataDir, run);
+            benchLoadCompressed(phantom, dataDir, run);
+            benchProjections(phantom, run);
+            benchIsotropic(phantom, run);
+            benchBricks(phantom, dataDir, run);
+            benchCompressed(phantom, run);
+            benchSlices(phantom, run);
+        }
+        // kernels are size-sensitive in other ways (output resolution); the
+        // first phantom is enough to track them
+        if (kernels && i == 0) {
+            benchOblique(phantom, run);
+            benchPicking(run);
+            benchRaycast(phantom, run);
+            benchPreIntegration(phantom, run);
+            benchIsoSurface(phantom, run);
+        }
+    }
+
+    if (parser.isSet(traceOption) && !Trace::writeChromeJson(parser.value(traceOption).toStdString()))
+        std::fprintf(stderr, "cannot write %s\n", qPrintable(parser.value(traceOption)));
+    if (!jsonPath.isEmpty() && !report.write(jsonPath))
+        return 1;
+    if (parser.isSet(compareOption)) {
+        const int regressions = report.compare(parser.value(compareOption), parser.value(toleranceOption).toDouble());
+        if (regressions < 0)
+            return 1;
+        if (regressions > 0)
+            return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include "benchreport.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMap>
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+namespace Report {
+
+// Raw samples are kept up to this count; longer series keep the summary only.
+static constexpr size_t kMaxSamples = 256;
+
+static QJsonObject summarize(std::vector<double> samples)
+{
+    QJsonObject ms;
+    ms.insert("n", static_cast<int>(samples.size()));
+    if (samples.empty())
+        return ms;
+    std::sort(samples.begin(), samples.end());
+    const size_t n = samples.size();
+    const double median = n % 2 ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+    ms.insert("min", samples.front());
+    ms.insert("median", median);
+    ms.insert("mean", std::accumulate(samples.begin(), samples.end(), 0.0) / n);
+    ms.insert("max", samples.back());
+    return ms;
+}
+
+static QString caseKey(const QJsonObject &c)
+{
+    const QJsonDocument params(c.value("params").toObject());
+    return c.value("name").toString() + "|" + c.value("phantom").toString() + "|"
+           + QString::fromUtf8(params.toJson(QJsonDocument::Compact));
+}
+
+} // namespace Report
+
+void BenchReport::add(BenchCase benchCase)
+{
+    m_cases.push_back(std::move(benchCase));
+}
+
+QJsonObject BenchReport::toJson() const
+{
+    QJsonArray cases;
+    for (const BenchCase &c : m_cases) {
+        QJsonObject entry;
+        entry.insert("name", c.name);
+        entry.insert("phantom", c.phantom);
+        entry.insert("params", c.params);
+        entry.insert("metrics", c.metrics);
+        entry.insert("ms", Report::summarize(c.samplesMs));
+        if (c.samplesMs.size() <= Report::kMaxSamples) {
+            QJsonArray samples;
+            for (double ms : c.samplesMs)
+                samples.append(ms);
+            entry.insert("samples", samples);
+        }
+        cases.append(entry);
+    }
+
+    QJsonObject root;
+    root.insert("schema", 1);
+    root.insert("context", m_context);
+    root.insert("cases", cases);
+    return root;
+}
+
+bool BenchReport::write(const QString &path) const
+{
+    const QByteArray json = QJsonDocument(toJson()).toJson(QJsonDocument::Indented);
+    if (path == "-") {
+        std::fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+        return true;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::fprintf(stderr, "cannot write %s\n", qPrintable(path));
+        return false;
+    }
+    return file.write(json) == json.size();
+}
+
+int BenchReport::compare(const QString &baselinePath, double tolerance) const
+{
+    QFile file(baselinePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::fprintf(stderr, "cannot read %s\n", qPrintable(baselinePath));
+        return -1;
+    }
+    const QJsonDocument baseline = QJsonDocument::fromJson(file.readAll());
+    if (!baseline.isObject() || baseline.object().value("schema").toInt() != 1) {
+        std::fprintf(stderr, "%s is not a benchmark report\n", qPrintable(baselinePath));
+        return -1;
+    }
+
+    QMap<QString, double> baselineMedian;
+    for (const QJsonValue &value : baseline.object().value("cases").toArray()) {
+        const QJsonObject c = value.toObject();
+        baselineMedian.insert(Report::caseKey(c), c.value("ms").toObject().value("median").toDouble());
+    }
+
+    int regressions = 0;
+    std::printf("comparison against %s (tolerance %.0f %%)\n", qPrintable(baselinePath), tolerance * 100.0);
+    for (const QJsonValue &value : toJson().value("cases").toArray()) {
+        const QJsonObject c = value.toObject();
+        const auto it = baselineMedian.constFind(Report::caseKey(c));
+        if (it == baselineMedian.constEnd() || *it <= 0.0)
+            continue; // new case, or nothing timed
+        const double median = c.value("ms").toObject().value("median").toDouble();
+        const double ratio = median / *it;
+        const bool slower = ratio > 1.0 + tolerance;
+        regressions += slower ? 1 : 0;
+        const QString params = QString::fromUtf8(
+            QJsonDocument(c.value("params").toObject()).toJson(QJsonDocument::Compact));
+        std::printf("  %-20s %-14s %-32s %10.3f -> %10.3f ms  x%.2f%s\n",
+                    qPrintable(c.value("name").toString()), qPrintable(c.value("phantom").toString()),
+                    qPrintable(params), *it, median, ratio, slower ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
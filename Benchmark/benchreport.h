@@ -0,0 +1,47 @@
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <QJsonObject>
+#include <QString>
+#include <vector>
+
+/// @brief One measured case: what ran, on which phantom, and the wall time
+/// of every repetition. Metrics carry non-timing results (errors, counts).
+struct BenchCase
+{
+    QString name;    // "mip", "load.dicom", "raycast.cpu", ...
+    QString phantom; // PhantomSize::label(), empty when size-independent
+    QJsonObject params;
+    QJsonObject metrics;
+    std::vector<double> samplesMs;
+};
+
+/// @brief Collects cases and writes them as one JSON document:
+///
+///   { "schema": 1, "context": {...},
+///     "cases": [ { "name", "phantom", "params", "metrics",
+///                  "ms": { "n", "min", "median", "mean", "max" },
+///                  "samples": [...] } ] }
+///
+/// A case is identified by name + phantom + params, which is what compare()
+/// matches on between two runs.
+class BenchReport
+{
+public:
+    void setContext(const QString &key, const QJsonValue &value) { m_context.insert(key, value); }
+    void add(BenchCase benchCase);
+
+    QJsonObject toJson() const;
+    // "-" writes to stdout.
+    bool write(const QString &path) const;
+
+    // Prints median ratios against a previous report; returns the number of
+    // cases slower than `tolerance` (0.10 = 10 %), or -1 if it can't be read.
+    int compare(const QString &baselinePath, double tolerance) const;
+
+private:
+    QJsonObject m_context;
+    std::vector<BenchCase> m_cases;
+};
+
+#endif // BENCHREPORT_H
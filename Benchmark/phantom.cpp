@@ -0,0 +1,124 @@
+#include "phantom.h"
+#include "parallelfor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace Phantom {
+
+// Voxel noise amplitude (HU, ±).
+static constexpr int kNoise = 12;
+// Rib pitch and rib thickness along z (mm).
+static constexpr double kRibPitch = 25.0;
+static constexpr double kRibWidth = 8.0;
+
+/// @brief splitmix64 finalizer: a well-mixed hash of the voxel index.
+static std::uint64_t hash(std::uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static double ellipse(double u, double v, double cu, double cv, double ru, double rv)
+{
+    const double du = (u - cu) / ru;
+    const double dv = (v - cv) / rv;
+    return du * du + dv * dv;
+}
+
+/// @brief Tissue value (HU, noise-free) at normalized in-plane position
+/// (u, v) ∈ [-0.5, 0.5]² and axial position w ∈ [0, 1) / zMm.
+static int tissue(double u, double v, double w, double zMm)
+{
+    // patient table under the body (posterior is +y)
+    if (v > 0.32 && v < 0.35 && std::abs(u) < 0.45)
+        return 250;
+
+    const double body = ellipse(u, v, 0.0, 0.0, 0.40, 0.30);
+    if (body >= 1.0)
+        return -1000;
+
+    // spine: cortical ring around cancellous bone
+    const double spine = ellipse(u, v, 0.0, 0.20, 0.05, 0.05);
+    if (spine < 1.0)
+        return spine > 0.64 ? 1200 : 300;
+
+    const bool thorax = w < 0.55;
+    if (thorax) {
+        if (ellipse(u, v, -0.17, -0.03, 0.12, 0.17) < 1.0 || ellipse(u, v, 0.17, -0.03, 0.12, 0.17) < 1.0)
+            return -850;
+        if (body > 0.64 && body < 0.74 && std::fmod(zMm, kRibPitch) < kRibWidth)
+            return 1100;
+    } else if (w < 0.8 && ellipse(u, v, -0.12, 0.0, 0.15, 0.12) < 1.0) {
+        return 60; // liver
+    }
+
+    if (body > 0.85)
+        return -100; // subcutaneous fat
+    return 40;
+}
+
+} // namespace Phantom
+
+bool PhantomSize::parse(const std::string &text, PhantomSize &out)
+{
+    int x = 0, y = 0, z = 0;
+    char tail = 0;
+    if (std::sscanf(text.c_str(), "%dx%dx%d%c", &x, &y, &z, &tail) == 3) {
+        // explicit XxYxZ
+    } else if (std::sscanf(text.c_str(), "%d%c", &x, &tail) == 1) {
+        y = z = x;
+    } else {
+        return false;
+    }
+    if (x < 2 || y < 2 || z < 2)
+        return false;
+    out.dims[0] = x;
+    out.dims[1] = y;
+    out.dims[2] = z;
+    return true;
+}
+
+std::string PhantomSize::label() const
+{
+    return std::to_string(dims[0]) + "x" + std::to_string(dims[1]) + "x" + std::to_string(dims[2]);
+}
+
+vtkSmartPointer<vtkImageData> makePhantom(const PhantomSize &size)
+{
+    const int nx = size.dims[0];
+    const int ny = size.dims[1];
+    const int nz = size.dims[2];
+    const double spacing[3] = {0.7, 0.7, 1.0};
+
+    auto vol = vtkSmartPointer<vtkImageData>::New();
+    vol->SetDimensions(nx, ny, nz);
+    vol->SetSpacing(spacing[0], spacing[1], spacing[2]);
+    vol->SetOrigin(0.0, 0.0, 0.0);
+    vol->AllocateScalars(VTK_SHORT, 1);
+
+    short *voxels = static_cast<short *>(vol->GetScalarPointer());
+    Parallel::forRange(0, nz, 1, [&](int z0, int z1) {
+        for (int z = z0; z < z1; ++z) {
+            const double w = (z + 0.5) / nz;
+            const double zMm = z * spacing[2];
+            for (int y = 0; y < ny; ++y) {
+                const double v = (y + 0.5) / ny - 0.5;
+                const size_t row = (static_cast<size_t>(z) * ny + y) * nx;
+                for (int x = 0; x < nx; ++x) {
+                    const double u = (x + 0.5) / nx - 0.5;
+                    const int noise = static_cast<int>(Phantom::hash(row + x) % (2 * Phantom::kNoise + 1))
+                                      - Phantom::kNoise;
+                    const int hu = Phantom::tissue(u, v, w, zMm) + noise;
+                    voxels[row + x] = static_cast<short>(std::max(-1024, hu));
+                }
+            }
+        }
+    });
+    return vol;
+}
@@ -0,0 +1,33 @@
+TEMPLATE = app
+TARGET = LatencyHarness
+CONFIG += console
+CONFIG -= app_bundle
+
+
+include(../shared_config.pri)
+
+# The slice view is rebuilt from MainApp sources; the phantom and the JSON
+# report are shared with Benchmark.
+INCLUDEPATH += ../MainApp ../Benchmark
+DEPENDPATH  += ../MainApp ../Benchmark
+
+SOURCES += \
+    latency_main.cpp \
+    ../Benchmark/benchreport.cpp \
+    ../Benchmark/phantom.cpp \
+    ../MainApp/annotationindex.cpp \
+    ../MainApp/annotationset.cpp \
+    ../MainApp/cineplayer.cpp \
+    ../MainApp/cprengine.cpp \
+    ../MainApp/interactionscript.cpp \
+    ../MainApp/obliquereslicer.cpp \
+    ../MainApp/parallelfor.cpp \
+    ../MainApp/segmentmeasure.cpp \
+    ../MainApp/taskscheduler.cpp \
+    ../MainApp/tracing.cpp
+
+HEADERS += \
+    ../Benchmark/benchreport.h \
+    ../Benchmark/phantom.h \
+    ../MainApp/SphereInteractorStyle.h \
+    ../MainApp/interactionscript.h
@@ -0,0 +1,470 @@
+// Headless interaction-latency harness for the MainApp slice view.
+//
+// Builds the slice view the way MainWindow does (vtkImageViewer2 + the
+// SphereInteractorStyle, measurement and CPR callbacks) on an offscreen
+// render window, then replays interactor events in real time and measures
+// how long each one takes to reach a rendered frame.
+//
+// Usage: LatencyHarness [options]
+//   --scenario wheel|sphere|cylinder|windowlevel|all   built-in scripts (default all)
+//   --script FILE          replay a recording (DICOMViewer --record-interaction)
+//   --phantom N|XxYxZ      synthetic CT phantom              (default 256)
+//   --dicom DIR            load a DICOM series instead of the phantom
+//   --window WxH           render window size                (default 800x800)
+//   --budget MS            frame budget for "late" frames    (default 16.7)
+//   --json FILE            machine-readable report ("-" = stdout)
+//   --compare FILE         median ratios against an earlier report;
+//                          exit code 2 when a scenario regressed
+//   --tolerance F          allowed slowdown for --compare     (default 0.10)
+//
+// Needs no display or GPU when VTK is built with OSMesa or EGL offscreen
+// support; with a desktop OpenGL build the window is still never shown.
+
+#include "SphereInteractorStyle.h"
+#include "annotationset.h"
+#include "benchreport.h"
+#include "cprengine.h"
+#include "interactionscript.h"
+#include "parallelfor.h"
+#include "phantom.h"
+#include "segmentmeasure.h"
+
+#include "vtkAutoInit.h"
+#include "vtkCallbackCommand.h"
+#include "vtkCommand.h"
+#include "vtkDICOMDirectory.h"
+#include "vtkDICOMReader.h"
+#include "vtkImageData.h"
+#include "vtkImageViewer2.h"
+#include "vtkNew.h"
+#include "vtkRenderWindow.h"
+#include "vtkRenderWindowInteractor.h"
+#include "vtkRenderer.h"
+#include "vtkSmartPointer.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QSysInfo>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+VTK_MODULE_INIT(vtkRenderingOpenGL2);
+VTK_MODULE_INIT(vtkInteractionStyle);
+VTK_MODULE_INIT(vtkRenderingFreeType);
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Human-readable progress; moved to stderr when the JSON report goes to stdout.
+std::FILE *g_log = stdout;
+
+// Pointer sampling of the generated drags: 125 Hz, a common mouse poll rate.
+constexpr double kMovePeriodMs = 8.0;
+// Slice step per wheel notch, as MainWindow configures the style.
+constexpr int kSliceStep = 5;
+
+/// @brief The MainWindow slice view, minus Qt: one offscreen window, the
+/// custom style and the callbacks it drives on every drag frame.
+class SliceView
+{
+public:
+    SliceView(vtkImageData *image, int width, int height)
+    {
+        m_renderWindow->SetOffScreenRendering(1);
+        m_renderWindow->SetSize(width, height);
+
+        m_viewer->SetInputData(image);
+        m_viewer->SetRenderWindow(m_renderWindow);
+        m_viewer->SetupInteractor(m_interactor);
+        m_viewer->SetSliceOrientationToYZ();
+        m_viewer->SetColorWindow(400);
+        m_viewer->SetColorLevel(40);
+
+        m_style->SetDefaultRenderer(m_viewer->GetRenderer());
+        m_interactor->SetInteractorStyle(m_style);
+        m_style->SetImageViewer(m_viewer, m_viewer->GetSliceMax() + 1, kSliceStep);
+
+        m_measure.setInputData(image);
+        m_style->SetPairChangedCallback([this](int pair) {
+            if (pair < 0)
+                return;
+            AnnotationSet &annotations = m_style->GetAnnotations();
+            double a[3], b[3];
+            annotations.markerPosition(pair * 2, a);
+            annotations.markerPosition(pair * 2 + 1, b);
+            m_style->ProjectToSlice(a);
+            m_style->ProjectToSlice(b);
+            (void) m_measure.measure(pair, a, b, annotations.segmentRadius());
+        });
+        m_cpr.setInputData(image);
+        m_style->SetPathChangedCallback([this](int point) {
+            AnnotationSet &annotations = m_style->GetAnnotations();
+            if (point >= 0 && point < m_cpr.controlPointCount()) {
+                double pos[3];
+                annotations.pathPoint(point, pos);
+                m_style->ProjectToSlice(pos);
+                m_cpr.moveControlPoint(point, pos);
+            } else {
+                std::vector<std::array<double, 3>> points(annotations.pathPointCount());
+                for (int i = 0; i < annotations.pathPointCount(); ++i) {
+                    annotations.pathPoint(i, points[i].data());
+                    m_style->ProjectToSlice(points[i].data());
+                }
+                m_cpr.setControlPoints(points);
+            }
+            (void) m_cpr.output();
+        });
+
+        m_viewer->SetSlice((m_viewer->GetSliceMin() + m_viewer->GetSliceMax()) / 2);
+        m_viewer->GetRenderer()->ResetCamera();
+        m_interactor->Initialize();
+
+        m_frameCallback->SetCallback(SliceView::onFrame);
+        m_frameCallback->SetClientData(this);
+        m_renderWindow->AddObserver(vtkCommand::EndEvent, m_frameCallback);
+        m_viewer->Render();
+        m_frames = 0;
+    }
+
+    // Non-copyable — owns VTK pipeline objects with reference semantics.
+    SliceView(const SliceView &) = delete;
+    SliceView &operator=(const SliceView &) = delete;
+
+    bool setMode(const std::string &mode)
+    {
+        if (mode != "image" && mode != "annotation" && mode != "path")
+            return false;
+        m_style->SetAnnotationMode(mode == "annotation");
+        m_style->SetPathMode(mode == "path");
+        return true;
+    }
+
+    vtkRenderWindowInteractor *interactor() { return m_interactor; }
+    long frames() const { return m_frames; }
+
+private:
+    static void onFrame(vtkObject * /*caller*/, unsigned long /*eventId*/, void *clientData, void * /*callData*/)
+    {
+        ++static_cast<SliceView *>(clientData)->m_frames;
+    }
+
+    vtkNew<vtkRenderWindow> m_renderWindow;
+    vtkNew<vtkRenderWindowInteractor> m_interactor;
+    vtkNew<vtkImageViewer2> m_viewer;
+    vtkSmartPointer<SphereInteractorStyle> m_style = vtkSmartPointer<SphereInteractorStyle>::New();
+    vtkNew<vtkCallbackCommand> m_frameCallback;
+    SegmentMeasure m_measure;
+    CprEngine m_cpr;
+    long m_frames = 0;
+};
+
+/// @brief What one replay measured.
+struct ReplayResult
+{
+    std::vector<double> latencyMs; // event → end of its frame, rendered events only
+    int events = 0;                // interactor events in the script
+    int frames = 0;                // frames rendered
+    int coalesced = 0;             // moves skipped because a newer one was already due
+    int late = 0;                  // frames that finished past the budget
+    int badModes = 0;
+};
+
+// Replays in real time: each event is dispatched at its scheduled time, or
+// right away when the previous frame overran. Like Qt's mouse-move
+// compression, an overdue move is dropped when the next move is also due —
+// the user never sees a frame for it.
+ReplayResult replay(SliceView &view, const InteractionScript &script, double budgetMs)
+{
+    ReplayResult result;
+    const std::vector<InteractionEvent> &events = script.events();
+    const Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < events.size(); ++i) {
+        const InteractionEvent &event = events[i];
+        if (event.type == InteractionEvent::Type::Mode) {
+            result.badModes += view.setMode(event.key) ? 0 : 1;
+            continue;
+        }
+        ++result.events;
+
+        const double waitMs = event.timeMs - elapsedMs(start);
+        if (waitMs > 0.0)
+            std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(waitMs));
+        else if (event.type == InteractionEvent::Type::Move && i + 1 < events.size()
+                 && events[i + 1].type == InteractionEvent::Type::Move
+                 && events[i + 1].timeMs <= elapsedMs(start)) {
+            ++result.coalesced;
+            continue;
+        }
+
+        const long framesBefore = view.frames();
+        InteractionScript::dispatch(view.interactor(), event);
+        if (view.frames() == framesBefore)
+            continue; // press without feedback, move without a drag, ...
+        const double latency = elapsedMs(start) - event.timeMs;
+        result.frames += static_cast<int>(view.frames() - framesBefore);
+        result.latencyMs.push_back(latency);
+        result.late += latency > budgetMs ? 1 : 0;
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Built-in scenarios, in display coordinates of a width × height window
+// ---------------------------------------------------------------------------
+
+struct ScriptWriter
+{
+    InteractionScript script;
+    double timeMs = 0.0;
+
+    void add(InteractionEvent::Type type, int x, int y, double afterMs)
+    {
+        timeMs += afterMs;
+        InteractionEvent event;
+        event.timeMs = timeMs;
+        event.type = type;
+        event.x = x;
+        event.y = y;
+        script.append(event);
+    }
+    void mode(const char *name)
+    {
+        InteractionEvent event;
+        event.timeMs = timeMs;
+        event.type = InteractionEvent::Type::Mode;
+        event.key = name;
+        script.append(event);
+    }
+    void click(int x, int y)
+    {
+        add(InteractionEvent::Type::LeftPress, x, y, 150.0);
+        add(InteractionEvent::Type::LeftRelease, x, y, 80.0);
+    }
+    // Press at (x0, y0), move to (x1, y1) in `steps` samples, release.
+    void drag(int x0, int y0, int x1, int y1, int steps)
+    {
+        add(InteractionEvent::Type::LeftPress, x0, y0, 200.0);
+        for (int s = 1; s <= steps; ++s) {
+            const double t = static_cast<double>(s) / steps;
+            add(InteractionEvent::Type::Move, x0 + static_cast<int>(std::lround((x1 - x0) * t)),
+                y0 + static_cast<int>(std::lround((y1 - y0) * t)), kMovePeriodMs);
+        }
+        add(InteractionEvent::Type::LeftRelease, x1, y1, kMovePeriodMs);
+    }
+};
+
+// Flick bursts: notches 10 ms apart, a pause, the other direction.
+InteractionScript wheelScenario(int width, int height)
+{
+    ScriptWriter w;
+    w.mode("image");
+    for (int burst = 0; burst < 6; ++burst) {
+        const auto type = burst % 2 ? InteractionEvent::Type::WheelBackward : InteractionEvent::Type::WheelForward;
+        for (int notch = 0; notch < 12; ++notch)
+            w.add(type, width / 2, height / 2, notch == 0 ? 300.0 : 10.0);
+    }
+    return w.script;
+}
+
+// Two markers, then marker A dragged back and forth.
+InteractionScript sphereScenario(int width, int height)
+{
+    const int ax = width * 3 / 8, bx = width * 5 / 8, y = height / 2;
+    ScriptWriter w;
+    w.mode("annotation");
+    w.click(ax, y);
+    w.click(bx, y);
+    w.drag(ax, y, ax, y + height / 4, 60);
+    w.drag(ax, y + height / 4, ax - width / 8, y - height / 8, 60);
+    return w.script;
+}
+
+// The pair, then the segment grabbed at its midpoint and dragged.
+InteractionScript cylinderScenario(int width, int height)
+{
+    const int ax = width * 3 / 8, bx = width * 5 / 8, y = height / 2;
+    ScriptWriter w;
+    w.mode("annotation");
+    w.click(ax, y);
+    w.click(bx, y);
+    w.drag(width / 2, y, width / 2, y + height / 5, 60);
+    w.drag(width / 2, y + height / 5, width / 2 + width / 6, y - height / 6, 60);
+    return w.script;
+}
+
+// Window/level drag on the image (left button in image mode).
+InteractionScript windowLevelScenario(int width, int height)
+{
+    ScriptWriter w;
+    w.mode("image");
+    w.drag(width / 2, height / 2, width / 2 + width / 4, height / 2 - height / 6, 90);
+    w.drag(width / 2, height / 2, width / 2 - width / 5, height / 2 + height / 5, 90);
+    return w.script;
+}
+
+// Nearest-rank percentile.
+double percentile(std::vector<double> samples, double p)
+{
+    if (samples.empty())
+        return 0.0;
+    std::sort(samples.begin(), samples.end());
+    const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+    return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+vtkSmartPointer<vtkImageData> loadSeries(const QString &directoryPath)
+{
+    vtkNew<vtkDICOMDirectory> directory;
+    directory->SetDirectoryName(directoryPath.toUtf8().constData());
+    directory->SetScanDepth(1);
+    directory->Update();
+    if (directory->GetNumberOfSeries() == 0)
+        return nullptr;
+    vtkNew<vtkDICOMReader> reader;
+    reader->SetFileNames(directory->GetFileNamesForSeries(0));
+    reader->Update();
+    vtkSmartPointer<vtkImageData> image = reader->GetOutput();
+    return image;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Offscreen event-to-frame latency of the MainApp slice view.");
+    parser.addHelpOption();
+    const QCommandLineOption scenarioOption("scenario", "wheel, sphere, cylinder, windowlevel or all.", "name",
+                                            "all");
+    const QCommandLineOption scriptOption("script", "Replay a recorded interaction script.", "file");
+    const QCommandLineOption phantomOption("phantom", "Phantom size, N or XxYxZ.", "size", "256");
+    const QCommandLineOption dicomOption("dicom", "Load a DICOM series instead of the phantom.", "dir");
+    const QCommandLineOption windowOption("window", "Render window size, WxH.", "size", "800x800");
+    const QCommandLineOption budgetOption("budget", "Frame budget in ms.", "ms", "16.7");
+    const QCommandLineOption jsonOption("json", "Write the report as JSON (- = stdout).", "file");
+    const QCommandLineOption compareOption("compare", "Compare medians against an earlier report.", "file");
+    const QCommandLineOption toleranceOption("tolerance", "Allowed slowdown for --compare.", "fraction", "0.10");
+    parser.addOptions({scenarioOption, scriptOption, phantomOption, dicomOption, windowOption, budgetOption,
+                       jsonOption, compareOption, toleranceOption});
+    parser.process(app);
+
+    int width = 0, height = 0;
+    char tail = 0;
+    if (std::sscanf(qPrintable(parser.value(windowOption)), "%dx%d%c", &width, &height, &tail) != 2 || width < 16
+        || height < 16) {
+        std::fprintf(stderr, "bad window size '%s'\n", qPrintable(parser.value(windowOption)));
+        return 1;
+    }
+    const double budgetMs = parser.value(budgetOption).toDouble();
+    const QString jsonPath = parser.value(jsonOption);
+    if (jsonPath == "-")
+        g_log = stderr; // keep stdout pure JSON
+
+    // scenarios to run, in order
+    std::vector<std::pair<QString, InteractionScript>> scenarios;
+    if (parser.isSet(scriptOption)) {
+        InteractionScript script;
+        if (!script.load(parser.value(scriptOption).toStdString())) {
+            std::fprintf(stderr, "cannot read script %s\n", qPrintable(parser.value(scriptOption)));
+            return 1;
+        }
+        scenarios.emplace_back("script", script);
+    } else {
+        const QString name = parser.value(scenarioOption);
+        const bool all = name == "all";
+        if (all || name == "wheel")
+            scenarios.emplace_back("wheel", wheelScenario(width, height));
+        if (all || name == "sphere")
+            scenarios.emplace_back("sphere", sphereScenario(width, height));
+        if (all || name == "cylinder")
+            scenarios.emplace_back("cylinder", cylinderScenario(width, height));
+        if (all || name == "windowlevel")
+            scenarios.emplace_back("windowlevel", windowLevelScenario(width, height));
+        if (scenarios.empty()) {
+            std::fprintf(stderr, "unknown scenario '%s'\n", qPrintable(name));
+            return 1;
+        }
+    }
+
+    vtkSmartPointer<vtkImageData> image;
+    QString dataset;
+    if (parser.isSet(dicomOption)) {
+        image = loadSeries(parser.value(dicomOption));
+        if (!image) {
+            std::fprintf(stderr, "no DICOM series in %s\n", qPrintable(parser.value(dicomOption)));
+            return 1;
+        }
+        dataset = "dicom";
+    } else {
+        PhantomSize size;
+        if (!PhantomSize::parse(parser.value(phantomOption).toStdString(), size)) {
+            std::fprintf(stderr, "bad phantom size '%s'\n", qPrintable(parser.value(phantomOption)));
+            return 1;
+        }
+        image = makePhantom(size);
+        dataset = QString::fromStdString(size.label());
+    }
+
+    BenchReport report;
+    report.setContext("threads", Parallel::threadCount());
+    report.setContext("window", QString("%1x%2").arg(width).arg(height));
+    report.setContext("budgetMs", budgetMs);
+    report.setContext("date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    report.setContext("os", QSysInfo::prettyProductName());
+    report.setContext("cpu", QSysInfo::currentCpuArchitecture());
+
+    std::fprintf(g_log, "%s, %dx%d offscreen, budget %.1f ms\n", qPrintable(dataset), width, height, budgetMs);
+    std::fprintf(g_log, "  %-12s %7s %7s %9s %9s %9s %6s %6s\n", "scenario", "events", "frames", "p50 ms",
+                 "p95 ms", "p99 ms", "dropped", "late");
+    for (const auto &[name, script] : scenarios) {
+        // fresh view per scenario: annotations and camera don't leak between runs
+        SliceView view(image, width, height);
+        const ReplayResult result = replay(view, script, budgetMs);
+        if (result.badModes > 0)
+            std::fprintf(stderr, "%s: %d unsupported mode directives ignored\n", qPrintable(name), result.badModes);
+
+        const double p50 = percentile(result.latencyMs, 50.0);
+        const double p95 = percentile(result.latencyMs, 95.0);
+        const double p99 = percentile(result.latencyMs, 99.0);
+        std::fprintf(g_log, "  %-12s %7d %7d %9.2f %9.2f %9.2f %6d %6d\n", qPrintable(name), result.events,
+                     result.frames, p50, p95, p99, result.coalesced, result.late);
+
+        BenchCase c;
+        c.name = "interaction." + name;
+        c.phantom = dataset;
+        c.params.insert("events", result.events);
+        c.metrics.insert("frames", result.frames);
+        c.metrics.insert("dropped", result.coalesced);
+        c.metrics.insert("late", result.late);
+        c.metrics.insert("p50", p50);
+        c.metrics.insert("p95", p95);
+        c.metrics.insert("p99", p99);
+        c.samplesMs = result.latencyMs;
+        report.add(c);
+    }
+
+    if (!jsonPath.isEmpty() && !report.write(jsonPath))
+        return 1;
+    if (parser.isSet(compareOption)) {
+        const int regressions = report.compare(parser.value(compareOption), parser.value(toleranceOption).toDouble());
+        if (regressions < 0)
+            return 1;
+        if (regressions > 0)
+            return 2;
+    }
+    return 0;
+}
@@ -5,14 +5,64 @@ TARGET = DICOMViewer
 include(../shared_config.pri)
 
 SOURCES += \
+    annotationindex.cpp \
+    annotationset.cpp \
+    brickcodec.cpp \
+    brickedvolume.cpp \
+    cineplayer.cpp \
+    compressedvolume.cpp \
+    cprengine.cpp \
+    cpuraycaster.cpp \
     drrviewer.cpp \
+    gradientvolume.cpp \
+    interactionscript.cpp \
+    isosurface.cpp \
+    isotropicvolume.cpp \
     main.cpp \
     mainwindow.cpp \
-    mipviewer.cpp
+    memoryledger.cpp \
+    mipviewer.cpp \
+    obliquereslicer.cpp \
+    paralleldicomreader.cpp \
+    parallelfor.cpp \
+    preintegration.cpp \
+    progressiverenderer.cpp \
+    projectionviewer.cpp \
+    segmentmeasure.cpp \
+    taskscheduler.cpp \
+    tracing.cpp \
+    volumelayouts.cpp \
+    volumeofinterest.cpp \
+    volumeviewer.cpp
 
 HEADERS += \
     SphereInteractorStyle.h \
+    annotationindex.h \
+    annotationset.h \
+    brickcodec.h \
+    brickedvolume.h \
+    cineplayer.h \
+    compressedvolume.h \
+    cprengine.h \
+    cpuraycaster.h \
     drrviewer.h \
+    gradientvolume.h \
+    interactionscript.h \
+    isosurface.h \
+    isotropicvolume.h \
     mainwindow.h \
+    memoryledger.h \
     mipviewer.h \
-    precomp.h
+    obliquereslicer.h \
+    paralleldicomreader.h \
+    parallelfor.h \
+    preintegration.h \
+    precomp.h \
+    progressiverenderer.h \
+    projectionviewer.h \
+    segmentmeasure.h \
+    taskscheduler.h \
+    tracing.h \
+    volumelayouts.h \
+    volumeofinterest.h \
+    volumeviewer.h
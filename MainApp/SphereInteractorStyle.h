@@ -1,25 +1,27 @@
 ﻿#ifndef SPHEREINTERACTORSTYLE_H
 #define SPHEREINTERACTORSTYLE_H
 
+#include "annotationset.h"
+#include "cineplayer.h"
 #include "vtkRenderWindow.h"
 #include <vtkInteractorStyleImage.h>
 #include <vtkObjectFactory.h>          // vtkStandardNewMacro
-#include <vtkLineSource.h>          // vtkStandardNewMacro
 #include <vtkRenderWindowInteractor.h>
 #include <vtkRenderer.h>
-#include <vtkSphereSource.h>
-#include <vtkPolyDataMapper.h>
-#include <vtkActor.h>
-#include <vtkProperty.h>
-#include <vtkPropPicker.h>
 #include <vtkCoordinate.h>
+#include <vtkNew.h>
 #include <vtkSmartPointer.h>
-#include <vtkTubeFilter.h>
+#include <vtkMath.h>
 
-#include <vector>
 #include <vtkImageViewer2.h>
+#include <vtkImageActor.h>
+#include <vtkImageData.h>
+#include <vtkCornerAnnotation.h>
 #include <functional>
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
 
 
 class SphereInteractorStyle : public vtkInteractorStyleImage {
@@ -30,8 +32,53 @@ public:
     void SetAnnotationMode(bool enabled) { m_annotationMode = enabled; }
     bool GetAnnotationMode() const { return m_annotationMode; }
 
+    // Oblique mode: left drag rotates the reslice plane, wheel moves it along its normal.
+    void SetObliqueMode(bool enabled) { m_obliqueMode = enabled; m_obliqueRotating = false; }
+    void SetObliqueCallbacks(std::function<void(double, double)> rotateCb,
+                             std::function<void(int)> stepCb) {
+        m_obliqueRotateCb = std::move(rotateCb);
+        m_obliqueStepCb = std::move(stepCb);
+    }
+
+    // CPR path mode: clicks append control points, dragging one moves it.
+    void SetPathMode(bool enabled) { m_pathMode = enabled; }
+    bool GetPathMode() const { return m_pathMode; }
+    // Fired with the control point index on every frame of a drag, and with
+    // -1 when points were added or removed.
+    void SetPathChangedCallback(std::function<void(int)> cb) {
+        m_pathChangedCb = std::move(cb);
+    }
+
+    AnnotationSet &GetAnnotations() { return m_annotations; }
+
+    // Markers are picked on the camera's near plane so they draw above the
+    // image. Moves `point` along the view axis onto the slice on screen,
+    // the plane a measurement or a CPR path has to sample.
+    void ProjectToSlice(double point[3]) const {
+        if (!m_viewer) return;
+        const int axis = m_viewer->GetSliceOrientation(); // YZ, XZ, XY cross x, y, z
+        point[axis] = m_viewer->GetImageActor()->GetBounds()[2 * axis];
+    }
+
+    // Fired with the pair index whenever a complete pair is created, selected
+    // or moved (every frame of a drag), and with -1 when the selection is gone.
+    void SetPairChangedCallback(std::function<void(int)> cb) {
+        m_pairChangedCb = std::move(cb);
+    }
+
 
     void OnLeftButtonDown() override {
+        if (m_obliqueMode && m_obliqueRotateCb) {
+            int *pos = this->Interactor->GetEventPosition();
+            m_lastRotatePos[0] = pos[0];
+            m_lastRotatePos[1] = pos[1];
+            m_obliqueRotating = true;
+            return;
+        }
+        if (m_pathMode) {
+            onPathButtonDown();
+            return;
+        }
         if (!m_annotationMode) {
             // normal image interactin
             vtkInteractorStyleImage::OnLeftButtonDown();
@@ -41,49 +88,48 @@ public:
         int *clickPos = this->Interactor->GetEventPosition();
         this->FindPokedRenderer(clickPos[0], clickPos[1]);
         if (!this->CurrentRenderer) return;
-        vtkSmartPointer <vtkPropPicker> picker = vtkSmartPointer<vtkPropPicker>::New();
+        attachAnnotations();
 
-        // pick at 2D display , z depth always 0
-        picker->Pick(clickPos[0], clickPos[1], 0, this->CurrentRenderer);
+        // Analytic pick: cast the view ray through the click against the
+        // marker spheres first (they sit on top), then the segment tubes.
+        double rayOrigin[3], rayDir[3];
+        displayToRay(clickPos[0], clickPos[1], rayOrigin, rayDir);
 
-        vtkActor *pickedActor = dynamic_cast<vtkActor *>(picker->GetViewProp());
+        double worldPos[3];
+        displayToWorld(clickPos[0], clickPos[1], worldPos);
 
-        int pairIdx = -1;;
-        if (pickedActor && findPairIndexBySphere(pickedActor, pairIdx)) {
+        const int marker = m_annotations.pickMarker(rayOrigin, rayDir);
+        if (marker >= 0) {
             m_dragMode = DRAG_SPHERE;
-            m_draggedActor = pickedActor;
-            m_dragPairIndex = pairIdx;
-
+            m_dragMarker = marker;
+            m_dragPairIndex = marker / 2;
+            m_selectedPair = m_dragPairIndex;
 
-            // Highlight the picked sphere (visual feedback)
-            // Concept: we change the actor's Property â€” the mapper/source
-            // stay untouched (Composition: actor appearance is separate
-            // from geometry).
-            m_draggedActor->GetProperty()->SetColor(1.0, 1.0, 0.0); // yellow
+            // Highlight the picked sphere (visual feedback) — one color
+            // tuple changes, the shared glyph geometry stays untouched.
+            m_annotations.setMarkerHighlighted(marker, true);
 
             // Record offset so the sphere doesn't "jump" to cursor center.
-            // offset = clickWorldPos - actorCurrentPos
-            double worldPos[3];
-            displayToWorld(clickPos[0], clickPos[1], worldPos);
-
-
-            double *actorPos = m_draggedActor->GetPosition();
-            m_dragOffset[0] = worldPos[0] - actorPos[0];
-            m_dragOffset[1] = worldPos[1] - actorPos[1];
-            m_dragOffset[2] = worldPos[2] - actorPos[2];
-
-
+            // offset = clickWorldPos - markerCurrentPos
+            double markerPos[3];
+            m_annotations.markerPosition(marker, markerPos);
+            m_dragOffset[0] = worldPos[0] - markerPos[0];
+            m_dragOffset[1] = worldPos[1] - markerPos[1];
+            m_dragOffset[2] = worldPos[2] - markerPos[2];
+
+            notifyPairChanged(m_dragPairIndex);
+            this->Interactor->GetRenderWindow()->Render();
             // don't call parent, we are consuming this event
             return;
         }
     // clicked on one of cylinders
-        if (pickedActor && findPairIndexByCylinder(pickedActor, pairIdx)) {
+        const int pair = m_annotations.pickSegment(rayOrigin, rayDir);
+        if (pair >= 0) {
             m_dragMode = DRAG_CYLINDER;
-            m_draggedActor = pickedActor;
-            m_dragPairIndex = pairIdx;
-
+            m_dragPairIndex = pair;
+            m_selectedPair = pair;
 
-            m_draggedActor->GetProperty()->SetColor(1.0, 1.0, 0.0); // yellow
+            m_annotations.setSegmentHighlighted(pair, true);
 
             // Cache initial state so we can compute deltas during drag.
             // We store the mouse world pos AND both sphere positions at
@@ -91,53 +137,68 @@ public:
             //   delta = currentMouse - initialMouse
             //   newSphereA = initialA + delta
             //   newSphereB = initialB + delta
-
-            double worldPos[3];
-            displayToWorld(clickPos[0], clickPos[1], worldPos);
             m_initialMouseWorld[0] = worldPos[0];
             m_initialMouseWorld[1] = worldPos[1];
             m_initialMouseWorld[2] = worldPos[2];
 
+            m_annotations.markerPosition(pair * 2, m_initialSphereAPos);
+            m_annotations.markerPosition(pair * 2 + 1, m_initialSphereBPos);
 
-            AnnotationPair &pair = m_pairs[pairIdx];
-            double *posA = pair.sphereA->GetPosition();
-            double *posB = pair.sphereB->GetPosition();
-            for (int i = 0; i < 3; ++i) {
-                m_initialSphereAPos[i] = posA[i];
-                m_initialSphereBPos[i] = posB[i];
-            }
-            return;
-        }
-        if (m_clickCount >= 8) {
+            notifyPairChanged(pair);
+            this->Interactor->GetRenderWindow()->Render();
             return;
         }
 
         // emtpy space - create a new sphere
-        double worldPos[3];
-        displayToWorld(clickPos[0], clickPos[1], worldPos);
-        createSphereAt(worldPos);
+        const int added = m_annotations.addMarker(worldPos);
+        m_selectedPair = added / 2;
+        notifyPairChanged(m_selectedPair);
+        this->Interactor->GetRenderWindow()->Render();
     }
     // on move - update position if dragging
 
     void OnMouseMove() override {
+        if (m_obliqueRotating) {
+            int *pos = this->Interactor->GetEventPosition();
+            // half a degree per pixel feels close to a trackball
+            const double yaw = (pos[0] - m_lastRotatePos[0]) * 0.5;
+            const double pitch = (pos[1] - m_lastRotatePos[1]) * 0.5;
+            m_lastRotatePos[0] = pos[0];
+            m_lastRotatePos[1] = pos[1];
+            m_obliqueRotateCb(yaw, pitch);
+            this->Interactor->GetRenderWindow()->Render();
+            return;
+        }
+        if (m_dragMode == DRAG_PATH_POINT) {
+            int *movePos = this->Interactor->GetEventPosition();
+            double worldPos[3];
+            displayToWorld(movePos[0], movePos[1], worldPos);
+            const double pointPos[3] = {
+                worldPos[0] - m_dragOffset[0],
+                worldPos[1] - m_dragOffset[1],
+                worldPos[2] - m_dragOffset[2]
+            };
+            m_annotations.movePathPoint(m_dragMarker, pointPos);
+            if (m_pathChangedCb)
+                m_pathChangedCb(m_dragMarker);
+            this->Interactor->GetRenderWindow()->Render();
+            return;
+        }
         if (m_dragMode == DRAG_SPHERE ) {
           int *movePos = this->Interactor->GetEventPosition();
             double worldPos[3];
             displayToWorld(movePos[0], movePos[1], worldPos);
 
-            // newActorPos - mouseWorldPos - offset
+            // newMarkerPos - mouseWorldPos - offset
             // This keeps the grab-point stable under the cursor
-            m_draggedActor->SetPosition(
+            const double markerPos[3] = {
                 worldPos[0] - m_dragOffset[0],
                 worldPos[1] - m_dragOffset[1],
                 worldPos[2] - m_dragOffset[2]
-                );
-
-            AnnotationPair &pair = m_pairs[m_dragPairIndex];
-            if (pair.lineSource) {
-                updateCylinder(pair);
-            }
-
+            };
+            // one point slot (+ its segment slot) — nothing is rebuilt
+            m_annotations.moveMarker(m_dragMarker, markerPos);
+            notifyPairChanged(m_dragPairIndex);
 
             // reques re-render so user sees the sphere move in real-time
             this->Interactor->GetRenderWindow()->Render();
@@ -155,33 +216,41 @@ public:
                 delta[1] = worldPos[1] - m_initialMouseWorld[1];
                 delta[2] = worldPos[2] - m_initialMouseWorld[2];
 
-                // Move BOTH spheres by the same delta â†’ rigid body motion
-                AnnotationPair &pair = m_pairs[m_dragPairIndex];
-                pair.sphereA->SetPosition(
-                    m_initialSphereAPos[0] + delta[0],
-                    m_initialSphereAPos[1] + delta[1],
-                    m_initialSphereAPos[2] + delta[2]
-                    );
-                pair.sphereB->SetPosition(
-                    m_initialSphereBPos[0] + delta[0],
-                    m_initialSphereBPos[1] + delta[1],
-                    m_initialSphereBPos[2] + delta[2]
-                    );
-
-                updateCylinder(pair);
+                // Move BOTH spheres by the same delta → rigid body motion
+                double posA[3], posB[3];
+                for (int i = 0; i < 3; ++i) {
+                    posA[i] = m_initialSphereAPos[i] + delta[i];
+                    posB[i] = m_initialSphereBPos[i] + delta[i];
+                }
+                m_annotations.moveMarker(m_dragPairIndex * 2, posA);
+                m_annotations.moveMarker(m_dragPairIndex * 2 + 1, posB);
+                notifyPairChanged(m_dragPairIndex);
+
                 this->Interactor->GetRenderWindow()->Render();
                 return;
             }
+        // not dragging anything of ours — window/level, pan, zoom
+        vtkInteractorStyleImage::OnMouseMove();
     }
 
     // ===================================================================
-    // LEFT BUTTON UP â€” end any active drag
+    // LEFT BUTTON UP — end any active drag
     // ===================================================================
     void OnLeftButtonUp() override
     {
+        if (m_obliqueRotating) {
+            m_obliqueRotating = false;
+            return;
+        }
+
+        if (m_dragMode == DRAG_PATH_POINT) {
+            resetDragState();
+            return;
+        }
+
         if (m_dragMode == DRAG_SPHERE) {
             // Restore red
-            m_draggedActor->GetProperty()->SetColor(1.0, 0.2, 0.2);
+            m_annotations.setMarkerHighlighted(m_dragMarker, false);
             resetDragState();
             this->Interactor->GetRenderWindow()->Render();
             return;
@@ -190,7 +259,7 @@ public:
 
         if (m_dragMode == DRAG_CYLINDER) {
             // Restore blue
-            m_draggedActor->GetProperty()->SetColor(0.3, 0.6, 1.0);
+            m_annotations.setSegmentHighlighted(m_dragPairIndex, false);
             resetDragState();
             this->Interactor->GetRenderWindow()->Render();
             return;
@@ -198,7 +267,59 @@ public:
 
         vtkInteractorStyleImage::OnLeftButtonUp();
     }
+
+    // Delete / Backspace removes the last touched pair (or the open marker).
+    void OnKeyPress() override
+    {
+        const char *keySym = this->Interactor->GetKeySym();
+        const std::string key = keySym ? keySym : "";
+        if (m_pathMode && m_dragMode == DRAG_NONE && m_annotations.pathPointCount() > 0
+            && (key == "Delete" || key == "BackSpace")) {
+            m_annotations.removeLastPathPoint();
+            if (m_pathChangedCb)
+                m_pathChangedCb(-1);
+            this->Interactor->GetRenderWindow()->Render();
+            return;
+        }
+        if (m_annotationMode && m_dragMode == DRAG_NONE && m_selectedPair >= 0
+            && (key == "Delete" || key == "BackSpace")) {
+            m_annotations.removePair(m_selectedPair);
+            m_selectedPair = -1;
+            notifyPairChanged(-1);
+            this->Interactor->GetRenderWindow()->Render();
+            return;
+        }
+        if (m_cineVolume && !m_obliqueMode && onCineKey(key)) {
+            return;
+        }
+        vtkInteractorStyleImage::OnKeyPress();
+    }
+
+    // Cine frames are due on the interactor's repeating timer; the slice
+    // view starts no other timer (UseTimers stays off).
+    void OnTimer() override {
+        if (m_cineTimer < 0) {
+            vtkInteractorStyleImage::OnTimer();
+            return;
+        }
+        presentCineFrame();
+    }
+
+    // A timer belongs to its interactor: playback ends with it.
+    void SetInteractor(vtkRenderWindowInteractor *interactor) override {
+        if (interactor != this->Interactor) {
+            StopCine();
+        }
+        vtkInteractorStyleImage::SetInteractor(interactor);
+    }
+
     void OnMouseWheelForward () override {
+        StopCine();
+        if (m_obliqueMode && m_obliqueStepCb) {
+            m_obliqueStepCb(m_sliceStep);
+            this->Interactor->GetRenderWindow()->Render();
+            return;
+        }
         if (!m_viewer) return;
         m_viewer->SetSlice(std::min(m_viewer->GetSlice() + m_sliceStep, m_maxSlice));
         m_viewer->Render();
@@ -208,6 +329,12 @@ public:
         }
 
    void OnMouseWheelBackward () override {
+       StopCine();
+       if (m_obliqueMode && m_obliqueStepCb) {
+           m_obliqueStepCb(-m_sliceStep);
+           this->Interactor->GetRenderWindow()->Render();
+           return;
+       }
        if (!m_viewer) return;
        m_viewer->SetSlice(std::max(m_viewer->GetSlice() - m_sliceStep, m_minSlice));
        m_viewer->Render();
@@ -217,6 +344,7 @@ public:
 
         }
    void SetImageViewer(vtkImageViewer2 *viewer, int totalSlices, int sliceStep) {
+       StopCine();
        m_viewer = viewer;
        m_totalSlices = totalSlices;
        m_minSlice = viewer->GetSliceMin();
@@ -227,6 +355,114 @@ public:
        m_sliceChangedCb = std::move(cb);
    }
 
+    // Cine playback through the viewer's slices: Space plays / pauses,
+    // Right / Left play forward / back, Up / Down change the rate, "l"
+    // toggles looping. Slices are mapped ahead by a CinePlayer thread from
+    // `volume` (the viewer's input); nullptr — a bricked series, with no
+    // whole volume in RAM — leaves cine off.
+    void SetCineVolume(vtkImageData *volume) {
+        StopCine();
+        m_cineVolume = volume;
+    }
+    // Rate, direction, loop and dropped frames go to its lower-right corner.
+    void SetCineAnnotation(vtkCornerAnnotation *annotation) { m_cineAnnotation = annotation; }
+
+    static constexpr double kMinCineFps = 5.0;
+    static constexpr double kMaxCineFps = 60.0;
+
+    // Plays from the current slice; restarts in `direction` when playing.
+    bool StartCine(int direction) {
+        if (!m_viewer || !m_cineVolume || m_obliqueMode || !this->Interactor) return false;
+        if (m_cineTimer >= 0) {
+            this->Interactor->DestroyTimer(m_cineTimer);
+            m_cineTimer = -1;
+            m_viewer->SetSlice(m_cineSlice);
+        }
+
+        // vtkImageViewer2 orientations YZ, XZ, XY cross axes 0, 1, 2
+        const int axis = m_viewer->GetSliceOrientation();
+        CineSequence sequence;
+        sequence.first = m_viewer->GetSlice();
+        sequence.minSlice = m_viewer->GetSliceMin();
+        sequence.maxSlice = m_viewer->GetSliceMax();
+        sequence.direction = direction < 0 ? -1 : 1;
+        sequence.loop = m_cineLoop;
+        if (!sequence.loop && sequence.sliceAt(1) < 0) {
+            // a pass that would end at once starts over from the other end
+            sequence.first = sequence.direction > 0 ? sequence.minSlice : sequence.maxSlice;
+        }
+        m_cineWindow = m_viewer->GetColorWindow();
+        m_cineLevel = m_viewer->GetColorLevel();
+        if (!m_cine.start(m_cineVolume, axis, sequence, m_cineWindow, m_cineLevel)) return false;
+        m_cineSequence = sequence;
+        m_cineAxis = axis;
+
+        // One 8-bit slice, re-placed at every frame's extent; it shares the
+        // viewer actor's property, so interpolation and the style's own
+        // window/level drag look the same while playing.
+        int extent[6];
+        m_cineVolume->GetExtent(extent);
+        extent[2 * axis] = extent[2 * axis + 1] = sequence.first;
+        m_cineImage->SetExtent(extent);
+        m_cineImage->SetSpacing(m_cineVolume->GetSpacing());
+        m_cineImage->SetOrigin(m_cineVolume->GetOrigin());
+        m_cineImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+        m_cineActor->SetInputData(m_cineImage);
+        m_cineActor->SetProperty(m_viewer->GetImageActor()->GetProperty());
+        vtkRenderer *renderer = m_viewer->GetRenderer();
+        if (!renderer->HasViewProp(m_cineActor)) {
+            m_viewer->GetImageActor()->VisibilityOff();
+            renderer->AddViewProp(m_cineActor);
+        }
+
+        m_cineSlice = sequence.first;
+        m_cineShownStep = -1;
+        m_cineDropped = 0;
+        m_cineAnchorStep = 0;
+        m_cineAnchorTime = CineClock::now();
+        // ticks at twice the frame rate keep a frame at most half a period late
+        m_cineTimer = this->Interactor->CreateRepeatingTimer(
+            static_cast<unsigned long>(std::max(1.0, 500.0 / m_cineFps)));
+        updateCineAnnotation();
+        return true;
+    }
+
+    // Leaves the viewer on the last slice shown.
+    void StopCine() {
+        if (m_cineTimer < 0) return;
+        if (this->Interactor) {
+            this->Interactor->DestroyTimer(m_cineTimer);
+        }
+        m_cineTimer = -1;
+        m_cine.stop();
+        m_viewer->GetRenderer()->RemoveViewProp(m_cineActor);
+        m_viewer->GetImageActor()->VisibilityOn();
+        m_viewer->SetSlice(m_cineSlice);
+        updateCineAnnotation();
+        m_viewer->Render();
+    }
+
+    bool IsCinePlaying() const { return m_cineTimer >= 0; }
+
+    void SetCineRate(double fps) {
+        fps = std::min(kMaxCineFps, std::max(kMinCineFps, fps));
+        if (fps == m_cineFps) return;
+        if (m_cineTimer >= 0) {
+            // re-anchored, so the playhead does not jump
+            m_cineAnchorStep = dueCineStep();
+            m_cineAnchorTime = CineClock::now();
+            this->Interactor->DestroyTimer(m_cineTimer);
+            m_cineFps = fps;
+            m_cineTimer = this->Interactor->CreateRepeatingTimer(
+                static_cast<unsigned long>(std::max(1.0, 500.0 / m_cineFps)));
+            updateCineAnnotation();
+            m_viewer->Render();
+        } else {
+            m_cineFps = fps;
+        }
+    }
+    double GetCineRate() const { return m_cineFps; }
+
 
 private:
    vtkImageViewer2 *m_viewer = nullptr;
@@ -235,142 +471,197 @@ private:
     int m_maxSlice = 0;
     int m_sliceStep = 1;
    std::function<void(int, int, int)> m_sliceChangedCb;
-    struct AnnotationPair {
-        vtkSmartPointer<vtkActor> sphereA;
-        vtkSmartPointer<vtkActor> sphereB;
-        vtkSmartPointer<vtkLineSource> lineSource;
-        vtkSmartPointer<vtkTubeFilter> tubeFilter;
-        vtkSmartPointer<vtkActor> cylinderActor;
-
-    };
-    // sphere creation
-    void createSphereAt(const double worldPos[3]) {
-        vtkSmartPointer<vtkSphereSource> sphereSource = vtkSmartPointer<vtkSphereSource>::New();
-        sphereSource->SetRadius(8.0);
-        sphereSource->SetThetaResolution(20);
-        sphereSource->SetPhiResolution(20);
-
-        // source stays at 0,0,0, we move actor instead
-        sphereSource->Update();
 
+    // All markers and segments, drawn as two glyph sets.
+    AnnotationSet m_annotations;
+    bool m_annotationsAttached = false;
 
-        // mapper geometry to gpu
-        vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-
-
-        mapper->SetInputConnection(sphereSource->GetOutputPort());
-
-        // actor
-        vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
-        actor->SetMapper(mapper);
-        actor->SetPosition(worldPos[0], worldPos[1], worldPos[2]);
-        actor->GetProperty()->SetColor(1.0, 0.2, 0.2);
-        actor->GetProperty()->SetOpacity(0.8);
+    std::function<void(int)> m_pairChangedCb;
 
+    // Only complete pairs have something to measure.
+    void notifyPairChanged(int pair) {
+        if (!m_pairChangedCb) return;
+        m_pairChangedCb(pair >= 0 && pair < m_annotations.pairCount() ? pair : -1);
+    }
 
-        // add to renderer, track in our list
-        this->CurrentRenderer->AddActor(actor);
+    // Path mode click: grab an existing control point, or append a new one.
+    void onPathButtonDown() {
+        int *clickPos = this->Interactor->GetEventPosition();
+        this->FindPokedRenderer(clickPos[0], clickPos[1]);
+        if (!this->CurrentRenderer) return;
+        attachAnnotations();
 
-        if (m_clickCount % 2 == 0) {
-            AnnotationPair newPair;
-            newPair.sphereA = actor;
-            m_pairs.push_back(newPair);
-        }  else {
-            AnnotationPair &pair = m_pairs.back();
-            pair.sphereB = actor;
-            createConnectionBetween(pair);
+        double rayOrigin[3], rayDir[3];
+        displayToRay(clickPos[0], clickPos[1], rayOrigin, rayDir);
+        double worldPos[3];
+        displayToWorld(clickPos[0], clickPos[1], worldPos);
 
+        const int point = m_annotations.pickPathPoint(rayOrigin, rayDir);
+        if (point >= 0) {
+            m_dragMode = DRAG_PATH_POINT;
+            m_dragMarker = point;
+            double pointPos[3];
+            m_annotations.pathPoint(point, pointPos);
+            for (int i = 0; i < 3; ++i)
+                m_dragOffset[i] = worldPos[i] - pointPos[i];
+            return;
         }
-        m_clickCount++;
+
+        m_annotations.addPathPoint(worldPos);
+        if (m_pathChangedCb)
+            m_pathChangedCb(-1);
         this->Interactor->GetRenderWindow()->Render();
     }
 
-    void createConnectionBetween(AnnotationPair &pair) {
-        double *posA = pair.sphereA->GetPosition();
-        double *posB = pair.sphereB->GetPosition();
-
-
-        // source
-        pair.lineSource = vtkSmartPointer<vtkLineSource>::New();
-        pair.lineSource->SetPoint1(posA);
-        pair.lineSource->SetPoint2(posB);
-        pair.lineSource->Update();
-
-        // wrap a tube filter around it
-        pair.tubeFilter = vtkSmartPointer<vtkTubeFilter>::New();
-        pair.tubeFilter->SetInputConnection(pair.lineSource->GetOutputPort());
-        pair.tubeFilter->SetRadius(1.5);
-        pair.tubeFilter->SetNumberOfSides(20);
-        pair.tubeFilter->CappingOn();
-        pair.tubeFilter->Update();
-
+    void attachAnnotations() {
+        if (m_annotationsAttached) return;
+        m_annotations.addToRenderer(this->CurrentRenderer);
+        m_annotationsAttached = true;
+    }
 
-        vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-        mapper->SetInputConnection(pair.tubeFilter->GetOutputPort());
+    // coordinatee conversin from dispaly (pixel) -> world (3D)
+    void displayToWorld(int displayX, int displayY, double worldOut[3]) {
+        displayToWorld(displayX, displayY, 0.0, worldOut);
+    }
+    // Reuses one vtkCoordinate: mouse moves during a drag allocate nothing.
+    void displayToWorld(int displayX, int displayY, double depth, double worldOut[3]) {
+        m_coordinate->SetCoordinateSystemToDisplay();
+        m_coordinate->SetValue(displayX, displayY, depth);
 
-        pair.cylinderActor = vtkSmartPointer<vtkActor>::New();
-        pair.cylinderActor->SetMapper(mapper);
-        pair.cylinderActor->GetProperty()->SetColor(0.3, 0.6, 1.0);
-        pair.cylinderActor->GetProperty()->SetOpacity(0.7);
 
-        this->CurrentRenderer->AddActor(pair.cylinderActor);
+        double *w  = m_coordinate->GetComputedWorldValue(this->CurrentRenderer);
+        worldOut[0] = w[0];
+        worldOut[1] = w[1];
+        worldOut[2] = w[2];
 
     }
+    // view ray through a pixel: near-plane point + unit direction to far plane
+    void displayToRay(int displayX, int displayY, double originOut[3], double dirOut[3]) {
+        double farPoint[3];
+        displayToWorld(displayX, displayY, 0.0, originOut);
+        displayToWorld(displayX, displayY, 1.0, farPoint);
+        for (int i = 0; i < 3; ++i)
+            dirOut[i] = farPoint[i] - originOut[i];
+        vtkMath::Normalize(dirOut);
+    }
+    vtkNew<vtkCoordinate> m_coordinate;
+
+    bool onCineKey(const std::string &key) {
+        if (key == "space") {
+            if (IsCinePlaying())
+                StopCine();
+            else
+                StartCine(m_cineDirection);
+        } else if (key == "Right" || key == "Left") {
+            m_cineDirection = key == "Right" ? 1 : -1;
+            StartCine(m_cineDirection);
+        } else if (key == "Up" || key == "Down") {
+            SetCineRate(m_cineFps + (key == "Up" ? 5.0 : -5.0));
+        } else if (key == "l" || key == "L") {
+            m_cineLoop = !m_cineLoop;
+            if (IsCinePlaying())
+                StartCine(m_cineDirection); // the sequence is fixed per start
+        } else {
+            return false;
+        }
+        return true;
+    }
 
-    void updateCylinder(AnnotationPair &pair) {
-        double *posA = pair.sphereA->GetPosition();
-        double *posB = pair.sphereB->GetPosition();
-
-        pair.lineSource->SetPoint1(posA);
-        pair.lineSource->SetPoint2(posB);
-        pair.lineSource->Update();
+    // The playhead follows the clock, not the timer: a late tick shows the
+    // frame that is due and counts the ones it skipped.
+    long long dueCineStep() const {
+        const double seconds = std::chrono::duration<double>(CineClock::now() - m_cineAnchorTime).count();
+        return m_cineAnchorStep + static_cast<long long>(seconds * m_cineFps);
     }
 
-    bool findPairIndexBySphere(vtkActor *actor, int &outIndex) const {
-        for (int i = 0; i < static_cast<int>(m_pairs.size()); ++i) {
-            if (m_pairs[i].sphereA.GetPointer() == actor || (m_pairs[i].sphereB && m_pairs[i].sphereB.GetPointer() == actor)) {
-                outIndex = i;
-                return true;
-            }
+    // Render thread half: present the newest mapped frame that is due. The
+    // map already happened on the CinePlayer thread; this is a copy of
+    // one 8-bit slice and a render.
+    void presentCineFrame() {
+        if (m_viewer->GetColorWindow() != m_cineWindow || m_viewer->GetColorLevel() != m_cineLevel) {
+            m_cineWindow = m_viewer->GetColorWindow();
+            m_cineLevel = m_viewer->GetColorLevel();
+            m_cine.setWindowLevel(m_cineWindow, m_cineLevel);
         }
-        return false;
-    }
-    bool findPairIndexByCylinder(vtkActor *actor, int &outIndex) const {
-        for (int i = 0; i < static_cast<int>(m_pairs.size()); ++i) {
-            if (m_pairs[i].cylinderActor && m_pairs[i].cylinderActor.GetPointer() == actor) {
-                outIndex = i;
-                return true;
+
+        const long long due = dueCineStep();
+        CinePlayer::Frame frame;
+        if (!m_cine.take(due, static_cast<unsigned char *>(m_cineImage->GetScalarPointer()), frame)) {
+            if (m_cineSequence.sliceAt(due) < 0) {
+                StopCine(); // a pass without loop is over
             }
+            return;
         }
 
-        return false;
+        int extent[6];
+        m_cineImage->GetExtent(extent);
+        extent[2 * m_cineAxis] = extent[2 * m_cineAxis + 1] = frame.slice;
+        m_cineImage->SetExtent(extent);
+        m_cineImage->Modified();
+        m_cineDropped += frame.step - m_cineShownStep - 1;
+        m_cineShownStep = frame.step;
+        m_cineSlice = frame.slice;
+
+        updateCineAnnotation();
+        // the slice moved through the volume: the clipping range follows it
+        m_viewer->GetRenderer()->ResetCameraClippingRange();
+        if (m_sliceChangedCb)
+            m_sliceChangedCb(m_cineSlice, m_maxSlice, m_totalSlices);
+        this->Interactor->GetRenderWindow()->Render();
     }
 
-    // coordinatee conversin from dispaly (pixel) -> world (3D)
-    void displayToWorld(int displayX, int displayY, double worldOut[3]) {
-        vtkSmartPointer<vtkCoordinate> coord = vtkSmartPointer<vtkCoordinate>::New();
-        coord->SetCoordinateSystemToDisplay();
-        coord->SetValue(displayX, displayY, 0);
-
+    void updateCineAnnotation() {
+        if (!m_cineAnnotation) return;
+        if (m_cineTimer < 0) {
+            m_cineAnnotation->SetText(1, "");
+            return;
+        }
+        char text[96];
+        std::snprintf(text, sizeof(text), "Cine %.0f fps %s%s\nSlice %d  dropped %lld", m_cineFps,
+                      m_cineSequence.direction > 0 ? ">>" : "<<", m_cineSequence.loop ? " loop" : "",
+                      m_cineSlice, m_cineDropped);
+        m_cineAnnotation->SetText(1, text);
+    }
 
-        double *w  = coord->GetComputedWorldValue(this->CurrentRenderer);
-        worldOut[0] = w[0];
-        worldOut[1] = w[1];
-        worldOut[2] = w[2];
+    // cine
+    using CineClock = std::chrono::steady_clock;
+    CinePlayer m_cine;
+    vtkSmartPointer<vtkImageData> m_cineVolume;
+    vtkSmartPointer<vtkCornerAnnotation> m_cineAnnotation;
+    vtkNew<vtkImageData> m_cineImage;   // the presented frame
+    vtkNew<vtkImageActor> m_cineActor;  // stands in for the viewer's actor while playing
+    CineSequence m_cineSequence;
+    int m_cineAxis = 2;
+    int m_cineTimer = -1;               // playing while >= 0
+    int m_cineDirection = 1;
+    bool m_cineLoop = true;
+    double m_cineFps = 30.0;
+    double m_cineWindow = 0.0;
+    double m_cineLevel = 0.0;
+    long long m_cineAnchorStep = 0;
+    CineClock::time_point m_cineAnchorTime;
+    long long m_cineShownStep = -1;
+    long long m_cineDropped = 0;
+    int m_cineSlice = 0;
 
-    }
     // state
     bool m_annotationMode = false;
+    bool m_pathMode = false;
+    std::function<void(int)> m_pathChangedCb;
 
-    // std::vector<vtkSmartPointer<vtkActor>> m_sphereActors;
-    std::vector<AnnotationPair> m_pairs;
-    int m_clickCount = 0;
+    // oblique reslice
+    bool m_obliqueMode = false;
+    bool m_obliqueRotating = false;
+    int m_lastRotatePos[2] = {0, 0};
+    std::function<void(double, double)> m_obliqueRotateCb;
+    std::function<void(int)> m_obliqueStepCb;
 
-    enum DragMode { DRAG_NONE, DRAG_SPHERE, DRAG_CYLINDER };
+    enum DragMode { DRAG_NONE, DRAG_SPHERE, DRAG_CYLINDER, DRAG_PATH_POINT };
 
     DragMode m_dragMode = DRAG_NONE;
-    vtkActor *m_draggedActor = nullptr;
+    int m_dragMarker = -1;
     int m_dragPairIndex = -1;
+    int m_selectedPair = -1;
     double m_dragOffset[3] = { 0, 0, 0};
 
 
@@ -381,7 +672,7 @@ private:
 
     void resetDragState() {
         m_dragMode = DRAG_NONE;
-        m_draggedActor = nullptr;
+        m_dragMarker = -1;
         m_dragPairIndex = -1;
     }
 
@@ -0,0 +1,132 @@
+#include "annotationindex.h"
+
+namespace {
+
+// 21 bits per axis, biased so negative world coordinates pack cleanly.
+constexpr std::int64_t kAxisBias = 1 << 20;
+constexpr std::int64_t kAxisMask = (1 << 21) - 1;
+
+} // namespace
+
+AnnotationIndex::AnnotationIndex(double cellSize)
+    : m_cellSize(cellSize)
+    , m_invCellSize(1.0 / cellSize)
+{}
+
+AnnotationIndex::Key AnnotationIndex::keyOf(int ix, int iy, int iz) const
+{
+    return ((ix + kAxisBias) & kAxisMask) | (((iy + kAxisBias) & kAxisMask) << 21)
+           | (((iz + kAxisBias) & kAxisMask) << 42);
+}
+
+void AnnotationIndex::insertMarker(int id, const double center[3], double radius)
+{
+    if (id >= static_cast<int>(m_markerCells.size()))
+        m_markerCells.resize(id + 1);
+
+    const double lo[3] = {center[0] - radius, center[1] - radius, center[2] - radius};
+    const double hi[3] = {center[0] + radius, center[1] + radius, center[2] + radius};
+    std::vector<Key> &cells = m_markerCells[id];
+    cells.clear(); // keeps capacity — drags re-insert without allocating
+    boxCells(lo, hi, cells);
+    for (Key key : cells)
+        m_cells[key].markers.push_back(id);
+    growBounds(lo, hi);
+}
+
+void AnnotationIndex::removeMarker(int id)
+{
+    if (id < 0 || id >= static_cast<int>(m_markerCells.size()))
+        return;
+    for (Key key : m_markerCells[id]) {
+        auto it = m_cells.find(key);
+        if (it != m_cells.end())
+            eraseId(it->second.markers, id);
+    }
+    m_markerCells[id].clear();
+}
+
+void AnnotationIndex::insertSegment(int id, const double a[3], const double b[3], double radius)
+{
+    if (id >= static_cast<int>(m_segmentCells.size()))
+        m_segmentCells.resize(id + 1);
+
+    std::vector<Key> &cells = m_segmentCells[id];
+    cells.clear();
+
+    // Cover the capsule with the inflated boxes of sub-segments no longer than
+    // one cell: conservative, and a long diagonal touches O(length) cells
+    // instead of its whole bounding box.
+    const double d[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    const int pieces = std::max(1, static_cast<int>(std::ceil(length * m_invCellSize)));
+    for (int i = 0; i < pieces; ++i) {
+        const double s0 = static_cast<double>(i) / pieces;
+        const double s1 = static_cast<double>(i + 1) / pieces;
+        double lo[3], hi[3];
+        for (int k = 0; k < 3; ++k) {
+            const double p0 = a[k] + d[k] * s0;
+            const double p1 = a[k] + d[k] * s1;
+            lo[k] = std::min(p0, p1) - radius;
+            hi[k] = std::max(p0, p1) + radius;
+        }
+        boxCells(lo, hi, cells);
+        growBounds(lo, hi);
+    }
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+    for (Key key : cells)
+        m_cells[key].segments.push_back(id);
+}
+
+void AnnotationIndex::removeSegment(int id)
+{
+    if (id < 0 || id >= static_cast<int>(m_segmentCells.size()))
+        return;
+    for (Key key : m_segmentCells[id]) {
+        auto it = m_cells.find(key);
+        if (it != m_cells.end())
+            eraseId(it->second.segments, id);
+    }
+    m_segmentCells[id].clear();
+}
+
+void AnnotationIndex::clear()
+{
+    m_cells.clear();
+    m_markerCells.clear();
+    m_segmentCells.clear();
+    m_lo[0] = m_lo[1] = m_lo[2] = 0;
+    m_hi[0] = m_hi[1] = m_hi[2] = -1;
+}
+
+void AnnotationIndex::boxCells(const double lo[3], const double hi[3], std::vector<Key> &out)
+{
+    const int x0 = cellCoord(lo[0]), x1 = cellCoord(hi[0]);
+    const int y0 = cellCoord(lo[1]), y1 = cellCoord(hi[1]);
+    const int z0 = cellCoord(lo[2]), z1 = cellCoord(hi[2]);
+    for (int z = z0; z <= z1; ++z)
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                out.push_back(keyOf(x, y, z));
+}
+
+void AnnotationIndex::growBounds(const double lo[3], const double hi[3])
+{
+    const bool empty = m_hi[0] < m_lo[0];
+    for (int a = 0; a < 3; ++a) {
+        const int l = cellCoord(lo[a]);
+        const int h = cellCoord(hi[a]);
+        m_lo[a] = empty ? l : std::min(m_lo[a], l);
+        m_hi[a] = empty ? h : std::max(m_hi[a], h);
+    }
+}
+
+void AnnotationIndex::eraseId(std::vector<int> &ids, int id)
+{
+    auto it = std::find(ids.begin(), ids.end(), id);
+    if (it != ids.end()) {
+        *it = ids.back();
+        ids.pop_back();
+    }
+}
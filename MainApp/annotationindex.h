@@ -0,0 +1,124 @@
+#ifndef ANNOTATIONINDEX_H
+#define ANNOTATIONINDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Uniform hash grid over annotation geometry for ray picking.
+///
+/// Markers (spheres) and segments (capsules) are registered in every cell their
+/// bounds overlap. A pick walks the cells pierced by the ray front to back
+/// (3D DDA), so only annotations near the ray are ever tested.
+class AnnotationIndex
+{
+public:
+    struct Cell
+    {
+        std::vector<int> markers;
+        std::vector<int> segments;
+    };
+
+    explicit AnnotationIndex(double cellSize = 32.0);
+
+    void insertMarker(int id, const double center[3], double radius);
+    void removeMarker(int id);
+    void insertSegment(int id, const double a[3], const double b[3], double radius);
+    void removeSegment(int id);
+    void clear();
+
+    // Walk the cells pierced by the ray (unit direction) in front-to-back order.
+    // visit(cell, tExit) gets each non-empty cell and the ray parameter where
+    // the walk leaves it; returning false stops the walk.
+    template<typename Visitor>
+    void walkRay(const double origin[3], const double dir[3], Visitor &&visit) const;
+
+private:
+    using Key = std::int64_t;
+
+    Key keyOf(int ix, int iy, int iz) const;
+    int cellCoord(double v) const { return static_cast<int>(std::floor(v * m_invCellSize)); }
+    void boxCells(const double lo[3], const double hi[3], std::vector<Key> &out);
+    void growBounds(const double lo[3], const double hi[3]);
+    static void eraseId(std::vector<int> &ids, int id);
+
+    double m_cellSize;
+    double m_invCellSize;
+    std::unordered_map<Key, Cell> m_cells;
+    std::vector<std::vector<Key>> m_markerCells;  // id → cells it occupies
+    std::vector<std::vector<Key>> m_segmentCells; // id → cells it occupies
+
+    // Cell-coordinate bounds of everything ever inserted; clips the ray walk.
+    int m_lo[3] = {0, 0, 0};
+    int m_hi[3] = {-1, -1, -1};
+};
+
+template<typename Visitor>
+void AnnotationIndex::walkRay(const double origin[3], const double dir[3], Visitor &&visit) const
+{
+    if (m_cells.empty() || m_hi[0] < m_lo[0])
+        return;
+
+    // Clip the ray against the occupied box (slab test).
+    double tEnter = 0.0;
+    double tLeave = std::numeric_limits<double>::max();
+    for (int a = 0; a < 3; ++a) {
+        const double lo = m_lo[a] * m_cellSize;
+        const double hi = (m_hi[a] + 1) * m_cellSize;
+        if (std::abs(dir[a]) < 1e-12) {
+            if (origin[a] < lo || origin[a] > hi)
+                return;
+            continue;
+        }
+        double t0 = (lo - origin[a]) / dir[a];
+        double t1 = (hi - origin[a]) / dir[a];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tLeave = std::min(tLeave, t1);
+    }
+    if (tEnter > tLeave)
+        return;
+
+    // Amanatides–Woo traversal from the entry point.
+    int cell[3], step[3];
+    double tMax[3], tDelta[3];
+    for (int a = 0; a < 3; ++a) {
+        const double p = origin[a] + dir[a] * tEnter;
+        cell[a] = std::min(std::max(cellCoord(p), m_lo[a]), m_hi[a]);
+        if (dir[a] > 1e-12) {
+            step[a] = 1;
+            tMax[a] = ((cell[a] + 1) * m_cellSize - origin[a]) / dir[a];
+            tDelta[a] = m_cellSize / dir[a];
+        } else if (dir[a] < -1e-12) {
+            step[a] = -1;
+            tMax[a] = (cell[a] * m_cellSize - origin[a]) / dir[a];
+            tDelta[a] = -m_cellSize / dir[a];
+        } else {
+            step[a] = 0;
+            tMax[a] = std::numeric_limits<double>::max();
+            tDelta[a] = std::numeric_limits<double>::max();
+        }
+    }
+
+    for (;;) {
+        const int axis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        const double tExit = tMax[axis];
+
+        auto it = m_cells.find(keyOf(cell[0], cell[1], cell[2]));
+        if (it != m_cells.end() && !visit(it->second, tExit))
+            return;
+
+        if (tExit > tLeave || step[axis] == 0)
+            return;
+        cell[axis] += step[axis];
+        if (cell[axis] < m_lo[axis] || cell[axis] > m_hi[axis])
+            return;
+        tMax[axis] += tDelta[axis];
+    }
+}
+
+#endif // ANNOTATIONINDEX_H
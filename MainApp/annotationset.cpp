@@ -0,0 +1,391 @@
+#include "annotationset.h"
+#include "vtkMath.h"
+#include "vtkPointData.h"
+#include "vtkProperty.h"
+#include "vtkRenderer.h"
+
+#include <cmath>
+#include <limits>
+
+namespace Annotation {
+
+static constexpr unsigned char kMarkerColor[4] = {255, 51, 51, 255};    // red
+static constexpr unsigned char kSegmentColor[4] = {77, 153, 255, 255};  // blue
+static constexpr unsigned char kHighlightColor[4] = {255, 255, 0, 255}; // yellow
+
+/// @brief Ray parameter where the ray enters the sphere, or -1 on a miss.
+static double raySphere(const double o[3], const double d[3], const double c[3], double r)
+{
+    const double oc[3] = {c[0] - o[0], c[1] - o[1], c[2] - o[2]};
+    const double t = vtkMath::Dot(oc, d);
+    const double dist2 = vtkMath::Dot(oc, oc) - t * t;
+    if (dist2 > r * r)
+        return -1.0;
+    const double half = std::sqrt(r * r - dist2);
+    if (t + half < 0.0)
+        return -1.0; // sphere entirely behind the origin
+    if (t - half < 0.0)
+        return 0.0; // origin inside the sphere
+    return t - half;
+}
+
+/// @brief Ray parameter of the closest approach to segment [a, b] when the
+/// ray passes within r of it (a capsule hit), or -1 on a miss.
+static double rayCapsule(const double o[3], const double d[3], const double a[3], const double b[3], double r)
+{
+    const double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double ao[3] = {o[0] - a[0], o[1] - a[1], o[2] - a[2]};
+    const double abab = vtkMath::Dot(ab, ab);
+    const double abd = vtkMath::Dot(ab, d);
+    const double abao = vtkMath::Dot(ab, ao);
+    const double dao = vtkMath::Dot(d, ao);
+
+    // Closest points between the infinite ray line and the segment line,
+    // then clamp the segment parameter to [0, 1] and re-project.
+    const double denom = abab - abd * abd;
+    double s = denom > 1e-12 ? (abao - abd * dao) / denom : 0.0;
+    s = std::min(std::max(s, 0.0), 1.0);
+    const double onSeg[3] = {a[0] + ab[0] * s, a[1] + ab[1] * s, a[2] + ab[2] * s};
+    const double toSeg[3] = {onSeg[0] - o[0], onSeg[1] - o[1], onSeg[2] - o[2]};
+    const double t = std::max(0.0, vtkMath::Dot(toSeg, d));
+    const double onRay[3] = {o[0] + d[0] * t, o[1] + d[1] * t, o[2] + d[2] * t};
+    if (vtkMath::Distance2BetweenPoints(onRay, onSeg) > r * r)
+        return -1.0;
+    return t;
+}
+
+} // namespace Annotation
+
+AnnotationSet::AnnotationSet()
+{
+    // --- markers ---
+    m_markerColors->SetName("Colors");
+    m_markerColors->SetNumberOfComponents(4);
+    m_markers->SetPoints(m_markerPoints);
+    m_markers->GetPointData()->AddArray(m_markerColors);
+
+    m_sphereGlyph->SetRadius(kMarkerRadius);
+    m_sphereGlyph->SetThetaResolution(20);
+    m_sphereGlyph->SetPhiResolution(20);
+
+    m_markerMapper->SetInputData(m_markers);
+    m_markerMapper->SetSourceConnection(m_sphereGlyph->GetOutputPort());
+    m_markerMapper->ScalingOff();
+    m_markerMapper->OrientOff();
+    m_markerMapper->SetScalarModeToUsePointFieldData();
+    m_markerMapper->SelectColorArray("Colors");
+    m_markerMapper->SetColorModeToDirectScalars();
+
+    m_markerActor->SetMapper(m_markerMapper);
+    m_markerActor->GetProperty()->SetOpacity(0.8);
+
+    // --- segments ---
+    m_segmentDirections->SetName("Direction");
+    m_segmentDirections->SetNumberOfComponents(3);
+    m_segmentScales->SetName("Scale");
+    m_segmentScales->SetNumberOfComponents(3);
+    m_segmentColors->SetName("Colors");
+    m_segmentColors->SetNumberOfComponents(4);
+    m_segments->SetPoints(m_segmentCenters);
+    m_segments->GetPointData()->AddArray(m_segmentDirections);
+    m_segments->GetPointData()->AddArray(m_segmentScales);
+    m_segments->GetPointData()->AddArray(m_segmentColors);
+
+    // Unit-length tube along X, centered on the origin.
+    m_lineGlyph->SetPoint1(-0.5, 0.0, 0.0);
+    m_lineGlyph->SetPoint2(0.5, 0.0, 0.0);
+    m_tubeGlyph->SetInputConnection(m_lineGlyph->GetOutputPort());
+    m_tubeGlyph->SetRadius(kSegmentRadius);
+    m_tubeGlyph->SetNumberOfSides(20);
+    m_tubeGlyph->CappingOn();
+
+    m_segmentMapper->SetInputData(m_segments);
+    m_segmentMapper->SetSourceConnection(m_tubeGlyph->GetOutputPort());
+    m_segmentMapper->SetOrientationArray("Direction");
+    m_segmentMapper->SetOrientationModeToDirection();
+    m_segmentMapper->SetScaleArray("Scale");
+    m_segmentMapper->SetScaleModeToScaleByVectorComponents();
+    m_segmentMapper->SetScalarModeToUsePointFieldData();
+    m_segmentMapper->SelectColorArray("Colors");
+    m_segmentMapper->SetColorModeToDirectScalars();
+
+    m_segmentActor->SetMapper(m_segmentMapper);
+    m_segmentActor->GetProperty()->SetOpacity(0.7);
+
+    // --- CPR path ---
+    m_pathMarkers->SetPoints(m_pathPoints);
+    m_pathMarkerMapper->SetInputData(m_pathMarkers);
+    m_pathMarkerMapper->SetSourceConnection(m_sphereGlyph->GetOutputPort());
+    m_pathMarkerMapper->ScalingOff();
+    m_pathMarkerMapper->OrientOff();
+    m_pathMarkerMapper->ScalarVisibilityOff();
+    m_pathMarkerActor->SetMapper(m_pathMarkerMapper);
+    m_pathMarkerActor->GetProperty()->SetColor(0.2, 1.0, 0.4); // green
+    m_pathMarkerActor->GetProperty()->SetOpacity(0.8);
+
+    m_pathLine->SetPoints(m_pathPoints);
+    m_pathLine->SetLines(m_pathCells);
+    m_pathLineMapper->SetInputData(m_pathLine);
+    m_pathLineActor->SetMapper(m_pathLineMapper);
+    m_pathLineActor->GetProperty()->SetColor(0.2, 1.0, 0.4);
+    m_pathLineActor->GetProperty()->SetLineWidth(2.0);
+}
+
+void AnnotationSet::addToRenderer(vtkRenderer *renderer)
+{
+    renderer->AddActor(m_segmentActor);
+    renderer->AddActor(m_markerActor);
+    renderer->AddActor(m_pathLineActor);
+    renderer->AddActor(m_pathMarkerActor);
+}
+
+int AnnotationSet::addMarker(const double pos[3])
+{
+    const vtkIdType id = m_markerPoints->InsertNextPoint(pos);
+    m_markerColors->InsertNextTypedTuple(Annotation::kMarkerColor);
+    m_markerPoints->Modified();
+    m_markers->Modified();
+    indexMarker(static_cast<int>(id));
+    syncSegmentCount();
+    return static_cast<int>(id);
+}
+
+void AnnotationSet::moveMarker(int marker, const double pos[3])
+{
+    m_markerPoints->SetPoint(marker, pos);
+    m_markerPoints->Modified();
+    m_markers->Modified();
+    indexMarker(marker);
+    if (marker / 2 < pairCount())
+        updateSegment(marker / 2);
+}
+
+void AnnotationSet::markerPosition(int marker, double out[3]) const
+{
+    m_markerPoints->GetPoint(marker, out);
+}
+
+void AnnotationSet::removePair(int pair)
+{
+    const int count = markerCount();
+    const int first = pair * 2;
+    if (first >= count)
+        return;
+
+    const bool dangling = (count % 2) == 1;
+    const int lastPair = pairCount() - 1;
+    double pos[3];
+
+    // Every slot this removal can touch leaves the index first and the
+    // survivors are re-registered under their new ids afterwards.
+    const int touched[] = {first, first + 1, lastPair * 2, lastPair * 2 + 1, count - 1};
+    for (int marker : touched)
+        m_index.removeMarker(marker);
+    m_index.removeSegment(pair);
+    m_index.removeSegment(lastPair);
+
+    if (first + 1 >= count) {
+        // the open marker itself
+        m_markerPoints->SetNumberOfPoints(count - 1);
+        m_markerColors->SetNumberOfTuples(count - 1);
+    } else {
+        // Swap-remove: last complete pair fills the hole, then the open
+        // marker (if any) slides down so it stays last.
+        if (pair != lastPair) {
+            for (int k = 0; k < 2; ++k) {
+                m_markerPoints->GetPoint(lastPair * 2 + k, pos);
+                m_markerPoints->SetPoint(first + k, pos);
+                m_markerColors->SetTypedTuple(first + k, m_markerColors->GetPointer(4 * (lastPair * 2 + k)));
+            }
+        }
+        if (dangling) {
+            m_markerPoints->GetPoint(count - 1, pos);
+            m_markerPoints->SetPoint(lastPair * 2, pos);
+            m_markerColors->SetTypedTuple(lastPair * 2, m_markerColors->GetPointer(4 * (count - 1)));
+        }
+        m_markerPoints->SetNumberOfPoints(count - 2);
+        m_markerColors->SetNumberOfTuples(count - 2);
+        if (pair != lastPair)
+            m_segmentColors->SetTypedTuple(pair, m_segmentColors->GetPointer(4 * lastPair));
+    }
+
+    m_markerPoints->Modified();
+    m_markerColors->Modified();
+    m_markers->Modified();
+    for (int marker : touched) {
+        if (marker >= 0 && marker < markerCount())
+            indexMarker(marker);
+    }
+    syncSegmentCount();
+    if (pair < pairCount())
+        updateSegment(pair);
+    if (lastPair >= 0 && lastPair != pair && lastPair < pairCount())
+        updateSegment(lastPair);
+}
+
+void AnnotationSet::setMarkerHighlighted(int marker, bool highlighted)
+{
+    m_markerColors->SetTypedTuple(marker, highlighted ? Annotation::kHighlightColor : Annotation::kMarkerColor);
+    m_markerColors->Modified();
+    m_markers->Modified();
+}
+
+void AnnotationSet::setSegmentHighlighted(int pair, bool highlighted)
+{
+    m_segmentColors->SetTypedTuple(pair, highlighted ? Annotation::kHighlightColor : Annotation::kSegmentColor);
+    m_segmentColors->Modified();
+    m_segments->Modified();
+}
+
+int AnnotationSet::pickMarker(const double rayOrigin[3], const double rayDir[3]) const
+{
+    int best = -1;
+    double bestT = std::numeric_limits<double>::max();
+    double c[3];
+    m_index.walkRay(rayOrigin, rayDir, [&](const AnnotationIndex::Cell &cell, double tExit) {
+        for (int i : cell.markers) {
+            m_markerPoints->GetPoint(i, c);
+            const double t = Annotation::raySphere(rayOrigin, rayDir, c, kMarkerRadius);
+            if (t >= 0.0 && t < bestT) {
+                bestT = t;
+                best = i;
+            }
+        }
+        // nothing further along the ray can beat a hit inside this cell
+        return !(best >= 0 && bestT <= tExit);
+    });
+    return best;
+}
+
+int AnnotationSet::pickSegment(const double rayOrigin[3], const double rayDir[3]) const
+{
+    int best = -1;
+    double bestT = std::numeric_limits<double>::max();
+    double a[3], b[3];
+    m_index.walkRay(rayOrigin, rayDir, [&](const AnnotationIndex::Cell &cell, double tExit) {
+        for (int p : cell.segments) {
+            m_markerPoints->GetPoint(p * 2, a);
+            m_markerPoints->GetPoint(p * 2 + 1, b);
+            const double t = Annotation::rayCapsule(rayOrigin, rayDir, a, b, kSegmentRadius);
+            if (t >= 0.0 && t < bestT) {
+                bestT = t;
+                best = p;
+            }
+        }
+        return !(best >= 0 && bestT <= tExit);
+    });
+    return best;
+}
+
+void AnnotationSet::indexMarker(int marker)
+{
+    double c[3];
+    m_markerPoints->GetPoint(marker, c);
+    m_index.removeMarker(marker);
+    m_index.insertMarker(marker, c, kMarkerRadius);
+}
+
+// Grow/shrink the per-segment arrays to one entry per complete pair.
+void AnnotationSet::syncSegmentCount()
+{
+    const int pairs = pairCount();
+    const int previous = static_cast<int>(m_segmentCenters->GetNumberOfPoints());
+    if (pairs == previous)
+        return;
+
+    m_segmentCenters->SetNumberOfPoints(pairs);
+    m_segmentDirections->SetNumberOfTuples(pairs);
+    m_segmentScales->SetNumberOfTuples(pairs);
+    m_segmentColors->SetNumberOfTuples(pairs);
+    for (int p = previous; p < pairs; ++p) {
+        m_segmentColors->SetTypedTuple(p, Annotation::kSegmentColor);
+        updateSegment(p);
+    }
+    m_segmentCenters->Modified();
+    m_segments->Modified();
+}
+
+void AnnotationSet::updateSegment(int pair)
+{
+    double a[3], b[3];
+    m_markerPoints->GetPoint(pair * 2, a);
+    m_markerPoints->GetPoint(pair * 2 + 1, b);
+
+    double dir[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double length = vtkMath::Normalize(dir);
+    if (length == 0.0)
+        dir[0] = 1.0; // coincident markers: any orientation, zero length
+
+    m_segmentCenters->SetPoint(pair, (a[0] + b[0]) * 0.5, (a[1] + b[1]) * 0.5, (a[2] + b[2]) * 0.5);
+    m_segmentDirections->SetTuple3(pair, dir[0], dir[1], dir[2]);
+    m_segmentScales->SetTuple3(pair, length, 1.0, 1.0);
+
+    m_segmentCenters->Modified();
+    m_segmentDirections->Modified();
+    m_segmentScales->Modified();
+    m_segments->Modified();
+
+    m_index.removeSegment(pair);
+    m_index.insertSegment(pair, a, b, kSegmentRadius);
+}
+
+int AnnotationSet::addPathPoint(const double pos[3])
+{
+    const vtkIdType id = m_pathPoints->InsertNextPoint(pos);
+    rebuildPathLine();
+    return static_cast<int>(id);
+}
+
+void AnnotationSet::movePathPoint(int index, const double pos[3])
+{
+    // the polyline shares the points — no cell change on a move
+    m_pathPoints->SetPoint(index, pos);
+    m_pathPoints->Modified();
+    m_pathMarkers->Modified();
+    m_pathLine->Modified();
+}
+
+void AnnotationSet::removeLastPathPoint()
+{
+    const int count = pathPointCount();
+    if (count == 0)
+        return;
+    m_pathPoints->SetNumberOfPoints(count - 1);
+    rebuildPathLine();
+}
+
+void AnnotationSet::pathPoint(int index, double out[3]) const
+{
+    m_pathPoints->GetPoint(index, out);
+}
+
+int AnnotationSet::pickPathPoint(const double rayOrigin[3], const double rayDir[3]) const
+{
+    int best = -1;
+    double bestT = std::numeric_limits<double>::max();
+    double c[3];
+    for (int i = 0; i < pathPointCount(); ++i) {
+        m_pathPoints->GetPoint(i, c);
+        const double t = Annotation::raySphere(rayOrigin, rayDir, c, kMarkerRadius);
+        if (t >= 0.0 && t < bestT) {
+            bestT = t;
+            best = i;
+        }
+    }
+    return best;
+}
+
+void AnnotationSet::rebuildPathLine()
+{
+    const int count = pathPointCount();
+    m_pathCells->Reset();
+    if (count >= 2) {
+        m_pathCells->InsertNextCell(count);
+        for (int i = 0; i < count; ++i)
+            m_pathCells->InsertCellPoint(i);
+    }
+    m_pathCells->Modified();
+    m_pathPoints->Modified();
+    m_pathMarkers->Modified();
+    m_pathLine->Modified();
+}
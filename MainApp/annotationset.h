@@ -0,0 +1,113 @@
+#ifndef ANNOTATIONSET_H
+#define ANNOTATIONSET_H
+
+#include "annotationindex.h"
+#include "vtkActor.h"
+#include "vtkCellArray.h"
+#include "vtkDoubleArray.h"
+#include "vtkGlyph3DMapper.h"
+#include "vtkLineSource.h"
+#include "vtkNew.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataMapper.h"
+#include "vtkSphereSource.h"
+#include "vtkTubeFilter.h"
+#include "vtkUnsignedCharArray.h"
+
+class vtkRenderer;
+
+/// @brief All annotation markers and the segments joining them, held as two
+/// point sets and drawn through shared glyph geometry (one sphere, one tube).
+///
+/// Markers 2p and 2p+1 form pair p; a complete pair owns segment p. Adding,
+/// moving or deleting a marker edits one array slot — no per-marker pipeline —
+/// so render cost stays flat as the count grows.
+///
+/// Separately, an ordered path of control points (drawn with the same sphere
+/// glyph, joined by a polyline) feeds curved planar reformation.
+class AnnotationSet
+{
+public:
+    AnnotationSet();
+    ~AnnotationSet() = default;
+
+    // Non-copyable — owns VTK pipeline objects with reference semantics.
+    AnnotationSet(const AnnotationSet &) = delete;
+    AnnotationSet &operator=(const AnnotationSet &) = delete;
+
+    void addToRenderer(vtkRenderer *renderer);
+
+    // Returns the new marker index. Every second marker closes a pair.
+    int addMarker(const double pos[3]);
+    void moveMarker(int marker, const double pos[3]);
+    // Removes both markers and the segment of a pair (or a dangling marker).
+    // The last pair is moved into the freed slot, so indices above `pair` change.
+    void removePair(int pair);
+
+    int markerCount() const { return static_cast<int>(m_markerPoints->GetNumberOfPoints()); }
+    int pairCount() const { return markerCount() / 2; } // complete pairs only
+    void markerPosition(int marker, double out[3]) const;
+
+    void setMarkerHighlighted(int marker, bool highlighted);
+    void setSegmentHighlighted(int pair, bool highlighted);
+
+    double markerRadius() const { return kMarkerRadius; }
+    double segmentRadius() const { return kSegmentRadius; }
+
+    // Closest marker / segment hit by a ray (unit direction); -1 on a miss.
+    // Only annotations in grid cells pierced by the ray are tested.
+    int pickMarker(const double rayOrigin[3], const double rayDir[3]) const;
+    int pickSegment(const double rayOrigin[3], const double rayDir[3]) const;
+
+    // --- CPR path ---
+    int addPathPoint(const double pos[3]);
+    void movePathPoint(int index, const double pos[3]);
+    void removeLastPathPoint();
+    int pathPointCount() const { return static_cast<int>(m_pathPoints->GetNumberOfPoints()); }
+    void pathPoint(int index, double out[3]) const;
+    // Paths hold tens of points, so they are tested directly, not via the grid.
+    int pickPathPoint(const double rayOrigin[3], const double rayDir[3]) const;
+
+private:
+    static constexpr double kMarkerRadius = 8.0;
+    static constexpr double kSegmentRadius = 1.5;
+
+    void updateSegment(int pair);
+    void syncSegmentCount();
+    void indexMarker(int marker);
+    void rebuildPathLine();
+
+    AnnotationIndex m_index;
+
+    vtkNew<vtkPoints> m_markerPoints;
+    vtkNew<vtkUnsignedCharArray> m_markerColors;
+    vtkNew<vtkPolyData> m_markers;
+    vtkNew<vtkSphereSource> m_sphereGlyph;
+    vtkNew<vtkGlyph3DMapper> m_markerMapper;
+    vtkNew<vtkActor> m_markerActor;
+
+    // One glyph per segment: placed at the midpoint, X axis turned onto the
+    // segment direction and stretched to its length.
+    vtkNew<vtkPoints> m_segmentCenters;
+    vtkNew<vtkDoubleArray> m_segmentDirections;
+    vtkNew<vtkDoubleArray> m_segmentScales;
+    vtkNew<vtkUnsignedCharArray> m_segmentColors;
+    vtkNew<vtkPolyData> m_segments;
+    vtkNew<vtkLineSource> m_lineGlyph;
+    vtkNew<vtkTubeFilter> m_tubeGlyph;
+    vtkNew<vtkGlyph3DMapper> m_segmentMapper;
+    vtkNew<vtkActor> m_segmentActor;
+
+    // Path markers and the polyline share one point set.
+    vtkNew<vtkPoints> m_pathPoints;
+    vtkNew<vtkPolyData> m_pathMarkers;
+    vtkNew<vtkGlyph3DMapper> m_pathMarkerMapper;
+    vtkNew<vtkActor> m_pathMarkerActor;
+    vtkNew<vtkCellArray> m_pathCells;
+    vtkNew<vtkPolyData> m_pathLine;
+    vtkNew<vtkPolyDataMapper> m_pathLineMapper;
+    vtkNew<vtkActor> m_pathLineActor;
+};
+
+#endif // ANNOTATIONSET_H
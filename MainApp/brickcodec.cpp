@@ -0,0 +1,267 @@
+#include "brickcodec.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace BrickCodec {
+
+// First byte of every encoded brick.
+enum Mode : unsigned char {
+    kStored = 0,     // raw bytes
+    kLz = 1,         // LZ only (voxel width without a filter)
+    kFilteredLz = 2, // delta + zigzag + byte planes, then LZ
+};
+
+static constexpr int kMinMatch = 4;
+static constexpr int kHashBits = 14;
+static constexpr std::size_t kMaxOffset = 65535;
+
+static std::uint32_t read32(const unsigned char *p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static std::uint32_t hash4(std::uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+static unsigned char *putLength(unsigned char *op, std::size_t extra)
+{
+    // lengths past the token nibble: 255-byte steps plus a remainder
+    for (; extra >= 255; extra -= 255)
+        *op++ = 255;
+    *op++ = static_cast<unsigned char>(extra);
+    return op;
+}
+
+static unsigned char *putSequence(unsigned char *op, const unsigned char *literals, std::size_t literalCount,
+                                  std::size_t offset, std::size_t matchLength)
+{
+    unsigned char *token = op++;
+    *token = static_cast<unsigned char>((literalCount >= 15 ? 15 : literalCount) << 4);
+    if (literalCount >= 15)
+        op = putLength(op, literalCount - 15);
+    std::memcpy(op, literals, literalCount);
+    op += literalCount;
+    if (matchLength == 0) {
+        return op; // last sequence: literals only
+    }
+    *op++ = static_cast<unsigned char>(offset & 0xff);
+    *op++ = static_cast<unsigned char>(offset >> 8);
+    const std::size_t code = matchLength - kMinMatch;
+    *token |= static_cast<unsigned char>(code >= 15 ? 15 : code);
+    if (code >= 15)
+        op = putLength(op, code - 15);
+    return op;
+}
+
+// Worst case: every byte a literal.
+static std::size_t lzBound(std::size_t bytes)
+{
+    return bytes + bytes / 255 + 16;
+}
+
+static std::size_t lzCompress(const unsigned char *in, std::size_t n, unsigned char *out)
+{
+    std::vector<std::uint32_t> table(std::size_t(1) << kHashBits, 0);
+    unsigned char *op = out;
+    std::size_t anchor = 0;
+    std::size_t ip = 0;
+    unsigned misses = 0;
+    while (ip + kMinMatch <= n) {
+        const std::uint32_t sequence = read32(in + ip);
+        const std::uint32_t h = hash4(sequence);
+        const std::size_t candidate = table[h];
+        table[h] = static_cast<std::uint32_t>(ip);
+        if (candidate < ip && ip - candidate <= kMaxOffset && read32(in + candidate) == sequence) {
+            std::size_t length = kMinMatch;
+            while (ip + length < n && in[candidate + length] == in[ip + length])
+                ++length;
+            op = putSequence(op, in + anchor, ip - anchor, ip - candidate, length);
+            ip += length;
+            anchor = ip;
+            misses = 0;
+        } else {
+            // incompressible stretches are skipped faster and faster
+            ip += 1 + (++misses >> 5);
+        }
+    }
+    op = putSequence(op, in + anchor, n - anchor, 0, 0);
+    return static_cast<std::size_t>(op - out);
+}
+
+static bool lzDecompress(const unsigned char *src, std::size_t srcBytes, unsigned char *out, std::size_t bytes)
+{
+    const unsigned char *sp = src;
+    const unsigned char *const end = src + srcBytes;
+    std::size_t op = 0;
+    auto readLength = [&](std::size_t &length) {
+        unsigned char b;
+        do {
+            if (sp == end) {
+                return false;
+            }
+            b = *sp++;
+            length += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (sp < end) {
+        const unsigned char token = *sp++;
+        std::size_t literals = token >> 4;
+        if (literals == 15 && !readLength(literals)) {
+            return false;
+        }
+        if (literals > std::size_t(end - sp) || literals > bytes - op) {
+            return false;
+        }
+        std::memcpy(out + op, sp, literals);
+        sp += literals;
+        op += literals;
+        if (sp == end) {
+            break; // last sequence
+        }
+
+        if (end - sp < 2) {
+            return false;
+        }
+        const std::size_t offset = std::size_t(sp[0]) | (std::size_t(sp[1]) << 8);
+        sp += 2;
+        std::size_t length = (token & 15) + kMinMatch;
+        if ((token & 15) == 15 && !readLength(length)) {
+            return false;
+        }
+        if (offset == 0 || offset > op || length > bytes - op) {
+            return false;
+        }
+        unsigned char *dst = out + op;
+        const unsigned char *from = dst - offset;
+        if (offset == 1) {
+            std::memset(dst, *from, length); // runs: air, padding
+        } else if (offset >= length) {
+            std::memcpy(dst, from, length);
+        } else {
+            for (std::size_t i = 0; i < length; ++i)
+                dst[i] = from[i]; // overlapping: repeats the last `offset` bytes
+        }
+        op += length;
+    }
+    return op == bytes;
+}
+
+template <typename T>
+static void filter(const unsigned char *in, std::size_t count, unsigned char *planes)
+{
+    constexpr int kBits = 8 * sizeof(T);
+    T previous = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        T value;
+        std::memcpy(&value, in + i * sizeof(T), sizeof(T));
+        const T delta = static_cast<T>(value - previous);
+        previous = value;
+        const T zigzag = static_cast<T>(static_cast<T>(delta << 1) ^ static_cast<T>(0 - (delta >> (kBits - 1))));
+        for (std::size_t b = 0; b < sizeof(T); ++b)
+            planes[b * count + i] = static_cast<unsigned char>(zigzag >> (8 * b));
+    }
+}
+
+template <typename T>
+static void unfilter(const unsigned char *planes, std::size_t count, unsigned char *out)
+{
+    T previous = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        T zigzag = 0;
+        for (std::size_t b = 0; b < sizeof(T); ++b)
+            zigzag = static_cast<T>(zigzag | static_cast<T>(T(planes[b * count + i]) << (8 * b)));
+        const T delta = static_cast<T>(static_cast<T>(zigzag >> 1) ^ static_cast<T>(0 - (zigzag & 1)));
+        previous = static_cast<T>(previous + delta);
+        std::memcpy(out + i * sizeof(T), &previous, sizeof(T));
+    }
+}
+
+static bool filterable(std::size_t bytes, int voxelBytes)
+{
+    return (voxelBytes == 1 || voxelBytes == 2 || voxelBytes == 4 || voxelBytes == 8) && bytes % voxelBytes == 0;
+}
+
+static void filter(const unsigned char *in, std::size_t bytes, int voxelBytes, unsigned char *planes)
+{
+    const std::size_t count = bytes / voxelBytes;
+    switch (voxelBytes) {
+    case 1: filter<std::uint8_t>(in, count, planes); break;
+    case 2: filter<std::uint16_t>(in, count, planes); break;
+    case 4: filter<std::uint32_t>(in, count, planes); break;
+    default: filter<std::uint64_t>(in, count, planes); break;
+    }
+}
+
+static void unfilter(const unsigned char *planes, std::size_t bytes, int voxelBytes, unsigned char *out)
+{
+    const std::size_t count = bytes / voxelBytes;
+    switch (voxelBytes) {
+    case 1: unfilter<std::uint8_t>(planes, count, out); break;
+    case 2: unfilter<std::uint16_t>(planes, count, out); break;
+    case 4: unfilter<std::uint32_t>(planes, count, out); break;
+    default: unfilter<std::uint64_t>(planes, count, out); break;
+    }
+}
+
+std::vector<unsigned char> encode(const unsigned char *data, std::size_t bytes, int voxelBytes)
+{
+    std::vector<unsigned char> encoded(1 + lzBound(bytes));
+    std::size_t size = 0;
+    if (filterable(bytes, voxelBytes)) {
+        std::vector<unsigned char> planes(bytes);
+        filter(data, bytes, voxelBytes, planes.data());
+        encoded[0] = kFilteredLz;
+        size = 1 + lzCompress(planes.data(), bytes, encoded.data() + 1);
+    } else {
+        encoded[0] = kLz;
+        size = 1 + lzCompress(data, bytes, encoded.data() + 1);
+    }
+    if (size >= 1 + bytes) {
+        encoded[0] = kStored;
+        std::memcpy(encoded.data() + 1, data, bytes);
+        size = 1 + bytes;
+    }
+    encoded.resize(size);
+    encoded.shrink_to_fit(); // bricks stay resident: no slack
+    return encoded;
+}
+
+bool decode(const unsigned char *src, std::size_t srcBytes, unsigned char *out, std::size_t bytes, int voxelBytes)
+{
+    if (srcBytes < 1) {
+        return false;
+    }
+    switch (src[0]) {
+    case kStored:
+        if (srcBytes - 1 != bytes) {
+            return false;
+        }
+        std::memcpy(out, src + 1, bytes);
+        return true;
+    case kLz:
+        return lzDecompress(src + 1, srcBytes - 1, out, bytes);
+    case kFilteredLz: {
+        if (!filterable(bytes, voxelBytes)) {
+            return false;
+        }
+        thread_local std::vector<unsigned char> planes;
+        planes.resize(bytes);
+        if (!lzDecompress(src + 1, srcBytes - 1, planes.data(), bytes)) {
+            return false;
+        }
+        unfilter(planes.data(), bytes, voxelBytes, out);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+} // namespace BrickCodec
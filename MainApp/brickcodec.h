@@ -0,0 +1,27 @@
+#ifndef BRICKCODEC_H
+#define BRICKCODEC_H
+
+#include <cstddef>
+#include <vector>
+
+/// @brief Lossless codec for single bricks.
+///
+/// Voxels are delta-coded along x (as unsigned integers of the voxel width,
+/// so any scalar type round-trips bit for bit), zigzag-folded so small
+/// differences of either sign have small codes, and split into byte planes:
+/// the high planes of CT data are almost all zero. The planes are then packed
+/// with an LZ4-style byte codec (literal runs + 64 KB back-references), which
+/// decodes at memory speed. Bricks that would not shrink are stored as-is.
+namespace BrickCodec {
+
+// Encodes `bytes` bytes of voxels `voxelBytes` wide (1, 2, 4 or 8).
+[[nodiscard]] std::vector<unsigned char> encode(const unsigned char *data, std::size_t bytes, int voxelBytes);
+
+// Decodes into exactly `bytes` bytes at `out`; false on a corrupt or
+// mismatched stream (out is then unspecified).
+[[nodiscard]] bool decode(const unsigned char *src, std::size_t srcBytes, unsigned char *out, std::size_t bytes,
+                          int voxelBytes);
+
+} // namespace BrickCodec
+
+#endif // BRICKCODEC_H
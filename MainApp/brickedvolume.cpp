@@ -0,0 +1,452 @@
+#include "brickedvolume.h"
+#include "parallelfor.h"
+#include "taskscheduler.h"
+#include "tracing.h"
+#include "vtkAbstractArray.h"
+#include "vtkAlgorithm.h"
+#include "vtkDataArray.h"
+#include "vtkImageReslice.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkMatrix4x4.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+
+namespace Bricks {
+
+static constexpr char kMagic[8] = {'D', 'V', 'B', 'R', 'I', 'C', 'K', '1'};
+
+/// @brief On-disk header; plain fields, naturally aligned.
+struct FileHeader
+{
+    char magic[8];
+    std::int32_t dims[3];
+    std::int32_t brickSize;
+    std::int32_t scalarType;
+    std::int32_t reserved;
+    double spacing[3];
+    double origin[3];
+};
+static_assert(sizeof(FileHeader) == 80, "brick file header layout");
+
+static int ceilDiv(int a, int b)
+{
+    return (a + b - 1) / b;
+}
+
+} // namespace Bricks
+
+// ---------------------------------------------------------------------------
+// BrickStore
+// ---------------------------------------------------------------------------
+
+bool BrickStore::forEachLayer(vtkAlgorithm *source, int brickSize, const CancelToken *cancel,
+                              const LayerSink &sink)
+{
+    if (!source || brickSize <= 0) {
+        return false;
+    }
+    source->UpdateInformation();
+    int whole[6];
+    source->GetOutputInformation(0)->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), whole);
+    Layout layout;
+    layout.brickSize = brickSize;
+    for (int a = 0; a < 3; ++a)
+        layout.dims[a] = whole[2 * a + 1] - whole[2 * a] + 1;
+    if (layout.dims[0] <= 0 || layout.dims[1] <= 0 || layout.dims[2] <= 0) {
+        return false;
+    }
+    const int bricks[3] = {Bricks::ceilDiv(layout.dims[0], brickSize), Bricks::ceilDiv(layout.dims[1], brickSize),
+                           Bricks::ceilDiv(layout.dims[2], brickSize)};
+    const std::size_t brickVoxels = std::size_t(brickSize) * brickSize * brickSize;
+    const int perLayer = bricks[0] * bricks[1];
+
+    std::vector<unsigned char> buffer;
+    int voxelBytes = 0;
+    for (int bz = 0; bz < bricks[2]; ++bz) {
+        if (cancel && cancel->isCancelled()) {
+            return false;
+        }
+        // one layer of bricks decoded at a time
+        const int z0 = whole[4] + bz * brickSize;
+        const int z1 = std::min(whole[5], z0 + brickSize - 1);
+        const int layerExtent[6] = {whole[0], whole[1], whole[2], whole[3], z0, z1};
+        source->UpdateExtent(layerExtent);
+        vtkImageData *layer = vtkImageData::SafeDownCast(source->GetOutputDataObject(0));
+        if (!layer || !layer->GetPointData()->GetScalars() || layer->GetNumberOfScalarComponents() != 1) {
+            return false; // Fail fast — bricks hold single-component scalars
+        }
+        if (bz == 0) {
+            layout.scalarType = layer->GetScalarType();
+            voxelBytes = layer->GetPointData()->GetScalars()->GetDataTypeSize();
+            layer->GetSpacing(layout.spacing);
+            layer->GetOrigin(layout.origin);
+            // bricks are indexed from 0: fold a non-zero start into the origin
+            for (int a = 0; a < 3; ++a)
+                layout.origin[a] += whole[2 * a] * layout.spacing[a];
+            buffer.resize(brickVoxels * voxelBytes * perLayer);
+        }
+
+        std::fill(buffer.begin(), buffer.end(), 0);
+        for (int by = 0; by < bricks[1]; ++by) {
+            for (int bx = 0; bx < bricks[0]; ++bx) {
+                unsigned char *brick = buffer.data() + std::size_t(by * bricks[0] + bx) * brickVoxels * voxelBytes;
+                const int x0 = whole[0] + bx * brickSize;
+                const int x1 = std::min(whole[1], x0 + brickSize - 1);
+                const int y0 = whole[2] + by * brickSize;
+                const int y1 = std::min(whole[3], y0 + brickSize - 1);
+                const std::size_t rowBytes = std::size_t(x1 - x0 + 1) * voxelBytes;
+                for (int z = z0; z <= z1; ++z) {
+                    for (int y = y0; y <= y1; ++y) {
+                        const std::size_t local = (std::size_t(z - z0) * brickSize + (y - y0)) * brickSize;
+                        std::memcpy(brick + local * voxelBytes, layer->GetScalarPointer(x0, y, z), rowBytes);
+                    }
+                }
+            }
+        }
+        if (!sink(layout, bz * perLayer, perLayer, buffer.data())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BrickStore::setLayout(const Layout &layout)
+{
+    m_layout = layout;
+    m_voxelBytes = vtkAbstractArray::GetDataTypeSize(layout.scalarType);
+    for (int a = 0; a < 3; ++a)
+        m_bricks[a] = Bricks::ceilDiv(layout.dims[a], layout.brickSize);
+    m_geometry->Initialize();
+    m_geometry->SetExtent(0, layout.dims[0] - 1, 0, layout.dims[1] - 1, 0, layout.dims[2] - 1);
+    m_geometry->SetSpacing(layout.spacing[0], layout.spacing[1], layout.spacing[2]);
+    m_geometry->SetOrigin(layout.origin[0], layout.origin[1], layout.origin[2]);
+}
+
+void BrickStore::clearLayout()
+{
+    m_layout = Layout();
+    std::fill(m_bricks, m_bricks + 3, 0);
+    m_voxelBytes = 0;
+    m_geometry->Initialize();
+}
+
+std::size_t BrickStore::brickBytes() const
+{
+    const std::size_t edge = std::size_t(m_layout.brickSize);
+    return edge * edge * edge * m_voxelBytes;
+}
+
+void BrickStore::extract(vtkImageData *out)
+{
+    TRACE_SCOPE("bricks.extract");
+    if (!out || !hasData() || out->GetScalarType() != m_layout.scalarType || out->GetNumberOfScalarComponents() != 1) {
+        return; // Fail fast — caller allocated the wrong scalar layout
+    }
+    const int *dims = m_layout.dims;
+    const int edge = m_layout.brickSize;
+    int ext[6];
+    out->GetExtent(ext);
+    auto *dst = static_cast<unsigned char *>(out->GetScalarPointer());
+    const std::size_t rowStride = std::size_t(ext[1] - ext[0] + 1) * m_voxelBytes;
+    const std::size_t sliceStride = rowStride * (ext[3] - ext[2] + 1);
+
+    // bricks overlapping the (clamped) extent
+    int lo[3], hi[3];
+    for (int a = 0; a < 3; ++a) {
+        const int first = std::max(ext[2 * a], 0);
+        const int last = std::min(ext[2 * a + 1], dims[a] - 1);
+        if (first > last) {
+            return;
+        }
+        lo[a] = first / edge;
+        hi[a] = last / edge;
+    }
+    const int nx = hi[0] - lo[0] + 1;
+    const int ny = hi[1] - lo[1] + 1;
+    const int count = nx * ny * (hi[2] - lo[2] + 1);
+
+    // Bricks cover disjoint parts of `out`: one brick per work item.
+    Parallel::forRange(0, count, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const int b[3] = {lo[0] + i % nx, lo[1] + (i / nx) % ny, lo[2] + i / (nx * ny)};
+            const std::shared_ptr<const unsigned char> data =
+                brick((b[2] * m_bricks[1] + b[1]) * m_bricks[0] + b[0]);
+            if (!data) {
+                continue;
+            }
+            int from[3], to[3];
+            for (int a = 0; a < 3; ++a) {
+                from[a] = std::max({ext[2 * a], 0, b[a] * edge});
+                to[a] = std::min({ext[2 * a + 1], dims[a] - 1, (b[a] + 1) * edge - 1});
+            }
+            const std::size_t rowBytes = std::size_t(to[0] - from[0] + 1) * m_voxelBytes;
+            for (int z = from[2]; z <= to[2]; ++z) {
+                for (int y = from[1]; y <= to[1]; ++y) {
+                    const std::size_t local = (std::size_t(z - b[2] * edge) * edge + (y - b[1] * edge)) * edge
+                                              + (from[0] - b[0] * edge);
+                    std::memcpy(dst + (z - ext[4]) * sliceStride + (y - ext[2]) * rowStride
+                                    + std::size_t(from[0] - ext[0]) * m_voxelBytes,
+                                data.get() + local * m_voxelBytes, rowBytes);
+                }
+            }
+        }
+    });
+}
+
+// ---------------------------------------------------------------------------
+// BrickedVolume
+// ---------------------------------------------------------------------------
+
+BrickedVolume::~BrickedVolume()
+{
+    close();
+}
+
+bool BrickedVolume::write(vtkAlgorithm *source, const QString &path, int brickSize, const CancelToken *cancel)
+{
+    TRACE_SCOPE("bricks.write");
+    // QSaveFile: a cancelled or failed conversion never leaves a file that
+    // open() would accept.
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    Bricks::FileHeader header = {};
+    std::vector<IndexEntry> index;
+
+    const bool ok = forEachLayer(source, brickSize, cancel,
+                                 [&](const Layout &layout, int first, int count, const unsigned char *bricks) {
+        if (index.empty()) {
+            header.scalarType = layout.scalarType;
+            std::copy(layout.dims, layout.dims + 3, header.dims);
+            std::copy(layout.spacing, layout.spacing + 3, header.spacing);
+            std::copy(layout.origin, layout.origin + 3, header.origin);
+            const int total = Bricks::ceilDiv(layout.dims[0], brickSize) * Bricks::ceilDiv(layout.dims[1], brickSize)
+                              * Bricks::ceilDiv(layout.dims[2], brickSize);
+            index.resize(std::size_t(total));
+            if (!file.seek(sizeof(header) + qint64(index.size() * sizeof(IndexEntry)))) {
+                return false;
+            }
+        }
+        const std::size_t bytes = std::size_t(brickSize) * brickSize * brickSize
+                                  * vtkAbstractArray::GetDataTypeSize(layout.scalarType);
+        const auto layerStart = static_cast<std::uint64_t>(file.pos());
+        for (int i = 0; i < count; ++i) {
+            IndexEntry &entry = index[std::size_t(first + i)];
+            entry.offset = layerStart + std::uint64_t(i) * bytes;
+            entry.bytes = bytes;
+        }
+        const qint64 layerBytes = qint64(bytes * count);
+        return file.write(reinterpret_cast<const char *>(bricks), layerBytes) == layerBytes;
+    });
+    if (!ok || index.empty()) {
+        file.cancelWriting();
+        return false;
+    }
+
+    std::memcpy(header.magic, Bricks::kMagic, sizeof(header.magic));
+    header.brickSize = brickSize;
+    if (!file.seek(0)
+        || file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))
+        || file.write(reinterpret_cast<const char *>(index.data()), qint64(index.size() * sizeof(IndexEntry)))
+               != qint64(index.size() * sizeof(IndexEntry))) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool BrickedVolume::open(const QString &path)
+{
+    close();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    Bricks::FileHeader header;
+    if (m_file.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header))
+        || std::memcmp(header.magic, Bricks::kMagic, sizeof(header.magic)) != 0 || header.brickSize <= 0
+        || header.dims[0] <= 0 || header.dims[1] <= 0 || header.dims[2] <= 0
+        || vtkAbstractArray::GetDataTypeSize(header.scalarType) <= 0) {
+        m_file.close();
+        return false; // Fail fast — not a brick file, or a different version
+    }
+    Layout layout;
+    layout.brickSize = header.brickSize;
+    layout.scalarType = header.scalarType;
+    for (int a = 0; a < 3; ++a) {
+        layout.dims[a] = header.dims[a];
+        layout.spacing[a] = header.spacing[a];
+        layout.origin[a] = header.origin[a];
+    }
+    setLayout(layout);
+
+    m_index.resize(std::size_t(brickCount()));
+    const qint64 indexBytes = qint64(m_index.size() * sizeof(IndexEntry));
+    if (m_file.read(reinterpret_cast<char *>(m_index.data()), indexBytes) != indexBytes) {
+        m_file.close();
+        m_index.clear();
+        clearLayout();
+        return false;
+    }
+    return true;
+}
+
+void BrickedVolume::close()
+{
+    // Unmapping takes m_mutex, so the bricks are released outside it.
+    std::unordered_map<int, CacheEntry> released;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        released.swap(m_cache);
+        m_lru.clear();
+        m_resident = 0;
+    }
+    released.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file.close();
+    m_index.clear();
+    clearLayout();
+}
+
+void BrickedVolume::setCacheBudget(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = bytes;
+}
+
+std::size_t BrickedVolume::residentBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_resident;
+}
+
+std::shared_ptr<const unsigned char> BrickedVolume::brick(int index)
+{
+    std::vector<std::shared_ptr<const unsigned char>> evicted; // unmapped after the lock is dropped
+    std::shared_ptr<const unsigned char> data;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto hit = m_cache.find(index);
+        if (hit != m_cache.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, hit->second.lru);
+            return hit->second.data;
+        }
+
+        const IndexEntry &entry = m_index[index];
+        uchar *mapped = m_file.map(qint64(entry.offset), qint64(entry.bytes));
+        if (!mapped) {
+            return nullptr;
+        }
+        data.reset(mapped, [this](const unsigned char *p) {
+            std::lock_guard<std::mutex> unmapLock(m_mutex);
+            m_file.unmap(const_cast<uchar *>(p));
+        });
+        m_lru.push_front(index);
+        m_cache[index] = {data, m_lru.begin()};
+        m_resident += entry.bytes;
+
+        while (m_resident > m_budget && m_lru.size() > 1) {
+            const int victim = m_lru.back();
+            m_lru.pop_back();
+            auto it = m_cache.find(victim);
+            m_resident -= m_index[victim].bytes;
+            evicted.push_back(std::move(it->second.data));
+            m_cache.erase(it);
+        }
+    }
+    return data;
+}
+
+// ---------------------------------------------------------------------------
+// BrickedImageSource
+// ---------------------------------------------------------------------------
+
+vtkStandardNewMacro(BrickedImageSource);
+
+BrickedImageSource::BrickedImageSource()
+{
+    this->SetNumberOfInputPorts(0);
+}
+
+void BrickedImageSource::SetVolume(BrickStore *volume)
+{
+    if (m_volume != volume) {
+        m_volume = volume;
+        this->Modified();
+    }
+}
+
+int BrickedImageSource::RequestInformation(vtkInformation * /*request*/,
+                                           vtkInformationVector ** /*inputVector*/,
+                                           vtkInformationVector *outputVector)
+{
+    if (!m_volume || !m_volume->hasData()) {
+        return 0;
+    }
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    vtkImageData *geometry = m_volume->geometry();
+    outInfo->Set(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), geometry->GetExtent(), 6);
+    outInfo->Set(vtkDataObject::SPACING(), geometry->GetSpacing(), 3);
+    outInfo->Set(vtkDataObject::ORIGIN(), geometry->GetOrigin(), 3);
+    vtkDataObject::SetPointDataActiveScalarInfo(outInfo, m_volume->scalarType(), 1);
+    return 1;
+}
+
+void BrickedImageSource::ExecuteDataWithInformation(vtkDataObject *output, vtkInformation *outInfo)
+{
+    // allocates the update extent only
+    vtkImageData *image = this->AllocateOutputData(output, outInfo);
+    if (m_volume) {
+        m_volume->extract(image);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Layered projection
+// ---------------------------------------------------------------------------
+
+void Bricks::projectByLayers(vtkImageReslice *reslice, vtkMatrix4x4 *axes, int slabAxis,
+                             const int extent[6], const double bounds[6], double slabSpacing,
+                             int brickSize, Combine combine, vtkImageData *result)
+{
+    const int s = slabAxis;
+    bool first = true;
+    for (int k0 = extent[2 * s]; k0 <= extent[2 * s + 1];) {
+        // layers follow brick boundaries, so each pulls one layer of bricks
+        const int k1 = std::min(extent[2 * s + 1], (k0 / brickSize + 1) * brickSize - 1);
+        axes->SetElement(s, 3, bounds[2 * s] + (0.5 * (k0 + k1) - extent[2 * s]) * slabSpacing);
+        reslice->SetResliceAxes(axes);
+        reslice->SetSlabNumberOfSlices(k1 - k0 + 1);
+        reslice->Update();
+
+        vtkImageData *partial = reslice->GetOutput();
+        if (first) {
+            result->DeepCopy(partial);
+            first = false;
+        } else {
+            auto *acc = static_cast<float *>(result->GetScalarPointer());
+            const auto *src = static_cast<const float *>(partial->GetScalarPointer());
+            const vtkIdType n = partial->GetNumberOfPoints();
+            if (combine == Combine::Max) {
+                for (vtkIdType i = 0; i < n; ++i)
+                    acc[i] = std::max(acc[i], src[i]);
+            } else {
+                for (vtkIdType i = 0; i < n; ++i)
+                    acc[i] += src[i];
+            }
+        }
+        k0 = k1 + 1;
+    }
+    result->Modified();
+}
@@ -0,0 +1,201 @@
+#ifndef BRICKEDVOLUME_H
+#define BRICKEDVOLUME_H
+
+#include "vtkImageAlgorithm.h"
+#include "vtkImageData.h"
+#include "vtkNew.h"
+
+#include <QFile>
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class CancelToken;
+class vtkAlgorithm;
+class vtkImageReslice;
+class vtkMatrix4x4;
+
+/// @brief Volume held as fixed-size bricks that are fetched on demand.
+///
+/// Bricks are brickSize³ voxels, x fastest, indexed x fastest, then y, then
+/// z; edge bricks are zero-padded. Subclasses decide where a brick comes
+/// from (a mapped file, a compressed copy in RAM); extract() assembles any
+/// extent from the bricks it overlaps, so consumers never see the storage.
+class BrickStore
+{
+public:
+    static constexpr int kDefaultBrickSize = 64;
+
+    /// @brief Everything needed to address the bricks and place the volume.
+    struct Layout
+    {
+        int dims[3] = {0, 0, 0};
+        int brickSize = kDefaultBrickSize;
+        int scalarType = 0;
+        double spacing[3] = {1.0, 1.0, 1.0};
+        double origin[3] = {0.0, 0.0, 0.0};
+    };
+
+    // Receives one layer of bricks (bricksX × bricksY, contiguous, in index
+    // order) starting at brick index `first`; false stops the conversion.
+    using LayerSink = std::function<bool(const Layout &layout, int first, int count, const unsigned char *bricks)>;
+
+    virtual ~BrickStore() = default;
+
+    // Non-copyable — subclasses own caches and file handles.
+    BrickStore(const BrickStore &) = delete;
+    BrickStore &operator=(const BrickStore &) = delete;
+
+    // Pulls `source` (e.g. a vtkDICOMReader with its file names set) one
+    // brick layer at a time, so a series larger than RAM converts in bounded
+    // memory.
+    static bool forEachLayer(vtkAlgorithm *source, int brickSize, const CancelToken *cancel,
+                             const LayerSink &sink);
+
+    [[nodiscard]] bool hasData() const { return m_voxelBytes > 0; }
+    // Extent, spacing and origin without scalars — the volume's frame for
+    // code that never touches voxels (VOI, cameras, projection geometry).
+    [[nodiscard]] vtkImageData *geometry() const { return m_geometry; }
+    [[nodiscard]] int brickSize() const { return m_layout.brickSize; }
+    [[nodiscard]] int scalarType() const { return m_layout.scalarType; }
+    [[nodiscard]] int brickCount() const { return m_bricks[0] * m_bricks[1] * m_bricks[2]; }
+    [[nodiscard]] std::size_t brickBytes() const;
+
+    // Fills `out` (allocated by the caller with the volume's scalar type and
+    // one component) over its own extent, reading only the bricks it
+    // overlaps. Safe to call from several threads at once.
+    void extract(vtkImageData *out);
+
+    // Bytes currently held for bricks (mapped or decoded).
+    [[nodiscard]] virtual std::size_t residentBytes() const = 0;
+
+protected:
+    BrickStore() = default;
+
+    void setLayout(const Layout &layout);
+    void clearLayout();
+    // Brick data, valid while the returned pointer is held; nullptr on I/O
+    // or decode failure.
+    virtual std::shared_ptr<const unsigned char> brick(int index) = 0;
+
+    Layout m_layout;
+    int m_bricks[3] = {0, 0, 0}; // bricks per axis
+    int m_voxelBytes = 0;
+    vtkNew<vtkImageData> m_geometry;
+};
+
+/// @brief BrickStore paged from a brick file.
+///
+/// File layout (little-endian):
+///   header   magic "DVBRICK1", dimensions, brick size, VTK scalar type,
+///            spacing, origin
+///   index    one {offset, bytes} per brick
+///   bricks   raw brick voxels
+///
+/// A touched brick is memory-mapped and kept in an LRU cache under a byte
+/// budget; untouched bricks never take memory.
+class BrickedVolume : public BrickStore
+{
+public:
+    static constexpr std::size_t kDefaultCacheBudget = std::size_t(512) << 20;
+
+    BrickedVolume() = default;
+    ~BrickedVolume() override;
+
+    // Converts `source` into a brick file at `path`; the file only appears
+    // once it is complete.
+    static bool write(vtkAlgorithm *source, const QString &path, int brickSize = kDefaultBrickSize,
+                      const CancelToken *cancel = nullptr);
+
+    bool open(const QString &path);
+    [[nodiscard]] bool isOpen() const { return m_file.isOpen(); }
+
+    // Least recently used bricks are unmapped once the mapped total exceeds
+    // the budget; a brick being copied stays mapped until the copy is done.
+    void setCacheBudget(std::size_t bytes);
+    [[nodiscard]] std::size_t cacheBudget() const { return m_budget; }
+    [[nodiscard]] std::size_t residentBytes() const override;
+
+protected:
+    std::shared_ptr<const unsigned char> brick(int index) override;
+
+private:
+    struct IndexEntry
+    {
+        std::uint64_t offset = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    struct CacheEntry
+    {
+        std::shared_ptr<const unsigned char> data;
+        std::list<int>::iterator lru;
+    };
+
+    void close();
+
+    QFile m_file;
+    std::vector<IndexEntry> m_index;
+
+    mutable std::mutex m_mutex; // m_file, m_cache, m_lru, m_resident
+    std::unordered_map<int, CacheEntry> m_cache;
+    std::list<int> m_lru; // most recent first
+    std::size_t m_resident = 0;
+    std::size_t m_budget = kDefaultCacheBudget;
+};
+
+/// @brief Pipeline source over a BrickStore.
+///
+/// Produces only the update extent downstream asks for, so a streaming
+/// consumer (the slice view's image actor, a projection layer) reads just the
+/// bricks it needs.
+class BrickedImageSource : public vtkImageAlgorithm
+{
+public:
+    static BrickedImageSource *New();
+    vtkTypeMacro(BrickedImageSource, vtkImageAlgorithm);
+
+    // The store must outlive the source's pipeline updates.
+    void SetVolume(BrickStore *volume);
+
+protected:
+    BrickedImageSource();
+    ~BrickedImageSource() override = default;
+
+    int RequestInformation(vtkInformation *request,
+                           vtkInformationVector **inputVector,
+                           vtkInformationVector *outputVector) override;
+    void ExecuteDataWithInformation(vtkDataObject *output, vtkInformation *outInfo) override;
+
+private:
+    BrickedImageSource(const BrickedImageSource &) = delete;
+    void operator=(const BrickedImageSource &) = delete;
+
+    BrickStore *m_volume = nullptr;
+};
+
+namespace Bricks {
+
+enum class Combine {
+    Max, // MIP
+    Sum, // DRR
+};
+
+// Runs a slab reslice set up for extent's full depth along slabAxis one brick
+// layer at a time and combines the partial float images into `result`, so a
+// projection never needs more than one layer of the volume in memory.
+// `axes` is the reslice's axes matrix; its slab-axis origin is moved per layer.
+void projectByLayers(vtkImageReslice *reslice, vtkMatrix4x4 *axes, int slabAxis,
+                     const int extent[6], const double bounds[6], double slabSpacing,
+                     int brickSize, Combine combine, vtkImageData *result);
+
+} // namespace Bricks
+
+#endif // BRICKEDVOLUME_H
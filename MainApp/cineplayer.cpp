@@ -0,0 +1,237 @@
+#include "cineplayer.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace Cine {
+
+// In-plane axes of a slice across each axis, ascending.
+static constexpr int kPlaneAxes[3][2] = {{1, 2}, {0, 2}, {0, 1}};
+
+// Slice `index` across `axis` through window/level to 8-bit grey, the
+// first in-plane axis fastest. Axial slices read contiguous rows; the other
+// two gather with a stride, which is the work the producer takes off the
+// render thread.
+template <typename T>
+static void mapSlice(const T *volume, const int dims[3], int axis, int index, float lo, float scale,
+                     unsigned char *out)
+{
+    const int u = kPlaneAxes[axis][0];
+    const int v = kPlaneAxes[axis][1];
+    const std::size_t stride[3] = {1, std::size_t(dims[0]), std::size_t(dims[0]) * dims[1]};
+    const T *plane = volume + index * stride[axis];
+    const std::size_t du = stride[u];
+    for (int j = 0; j < dims[v]; ++j) {
+        const T *row = plane + j * stride[v];
+        for (int i = 0; i < dims[u]; ++i) {
+            const float value = (static_cast<float>(row[i * du]) - lo) * scale;
+            *out++ = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, value)) + 0.5f);
+        }
+    }
+}
+
+} // namespace Cine
+
+int CineSequence::sliceAt(long long step) const
+{
+    const long long count = maxSlice - minSlice + 1;
+    if (count <= 0) {
+        return -1;
+    }
+    long long position = (first - minSlice) + direction * step;
+    if (loop) {
+        position = ((position % count) + count) % count;
+    } else if (position < 0 || position >= count) {
+        return -1;
+    }
+    return minSlice + static_cast<int>(position);
+}
+
+CinePlayer::~CinePlayer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool CinePlayer::start(vtkImageData *volume, int axis, const CineSequence &sequence, double window, double level)
+{
+    if (!volume || !volume->GetScalarPointer() || axis < 0 || axis > 2) {
+        return false;
+    }
+    switch (volume->GetScalarType()) {
+    case VTK_SHORT:
+    case VTK_UNSIGNED_SHORT:
+    case VTK_INT:
+    case VTK_FLOAT:
+    case VTK_DOUBLE:
+        break;
+    default:
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    flush(lock);
+    m_volume = volume;
+    m_scalars = volume->GetScalarPointer();
+    m_scalarType = volume->GetScalarType();
+    volume->GetDimensions(m_dims);
+    m_firstIndex = volume->GetExtent()[2 * axis];
+    m_axis = axis;
+    m_sequence = sequence;
+    m_window = window;
+    m_level = level;
+
+    const std::size_t bytes = std::size_t(m_dims[Cine::kPlaneAxes[axis][0]]) * m_dims[Cine::kPlaneAxes[axis][1]];
+    if (bytes != m_frameBytes) {
+        m_frameBytes = bytes;
+        m_slots.assign(kQueueDepth, std::vector<unsigned char>(bytes));
+    }
+    m_free.resize(kQueueDepth);
+    std::iota(m_free.begin(), m_free.end(), 0);
+    m_nextStep = 0;
+    m_playhead = 0;
+    m_playing = true;
+    if (!m_thread.joinable()) {
+        m_thread = std::thread([this] { run(); });
+    }
+    lock.unlock();
+    m_wake.notify_one();
+    return true;
+}
+
+void CinePlayer::stop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    flush(lock);
+    m_playing = false;
+    m_volume = nullptr; // the volume may go with the next series
+    m_scalars = nullptr;
+}
+
+bool CinePlayer::isPlaying() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_playing;
+}
+
+void CinePlayer::setWindowLevel(double window, double level)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (window == m_window && level == m_level) {
+        return;
+    }
+    flush(lock);
+    m_window = window;
+    m_level = level;
+    m_nextStep = m_playhead;
+    lock.unlock();
+    m_wake.notify_one();
+}
+
+bool CinePlayer::take(long long step, unsigned char *pixels, Frame &frame)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_playhead = std::max(m_playhead, step);
+    int slot = -1;
+    while (!m_queue.empty() && m_queue.front().frame.step <= step) {
+        if (slot >= 0) {
+            m_free.push_back(slot); // overtaken before it was shown
+        }
+        frame = m_queue.front().frame;
+        slot = m_queue.front().slot;
+        m_queue.pop_front();
+    }
+    if (slot < 0) {
+        lock.unlock();
+        m_wake.notify_one(); // the playhead moved: a late producer skips ahead
+        return false;
+    }
+
+    // the slot is off the free list: the producer cannot touch it meanwhile
+    lock.unlock();
+    std::memcpy(pixels, m_slots[slot].data(), m_frameBytes);
+    lock.lock();
+    m_free.push_back(slot);
+    lock.unlock();
+    m_wake.notify_one();
+    return true;
+}
+
+void CinePlayer::flush(std::unique_lock<std::mutex> &lock)
+{
+    ++m_generation;
+    m_idle.wait(lock, [this] { return !m_busy; });
+    for (const Queued &queued : m_queue)
+        m_free.push_back(queued.slot);
+    m_queue.clear();
+}
+
+void CinePlayer::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        // a producer behind the playhead skips to it instead of mapping
+        // frames that would only be dropped
+        m_wake.wait(lock, [this] {
+            return m_quit
+                   || (m_playing && !m_free.empty() && m_sequence.sliceAt(std::max(m_nextStep, m_playhead)) >= 0);
+        });
+        if (m_quit) {
+            return;
+        }
+        const long long step = std::max(m_nextStep, m_playhead);
+        const int slice = m_sequence.sliceAt(step);
+        const int slot = m_free.back();
+        m_free.pop_back();
+        const int generation = m_generation;
+        m_busy = true;
+
+        lock.unlock();
+        mapSlice(slice, m_slots[slot].data());
+        lock.lock();
+
+        m_busy = false;
+        if (generation != m_generation) {
+            m_free.push_back(slot); // flushed while mapping
+        } else {
+            m_queue.push_back({{step, slice}, slot});
+            m_nextStep = step + 1;
+        }
+        m_idle.notify_all();
+    }
+}
+
+void CinePlayer::mapSlice(int slice, unsigned char *out) const
+{
+    TRACE_SCOPE("cine.map");
+    const int index = slice - m_firstIndex;
+    const float lo = static_cast<float>(m_level - 0.5 * m_window);
+    const float scale = static_cast<float>(255.0 / std::max(1e-6, m_window));
+    switch (m_scalarType) {
+    case VTK_SHORT:
+        Cine::mapSlice(static_cast<const short *>(m_scalars), m_dims, m_axis, index, lo, scale, out);
+        break;
+    case VTK_UNSIGNED_SHORT:
+        Cine::mapSlice(static_cast<const unsigned short *>(m_scalars), m_dims, m_axis, index, lo, scale, out);
+        break;
+    case VTK_INT:
+        Cine::mapSlice(static_cast<const int *>(m_scalars), m_dims, m_axis, index, lo, scale, out);
+        break;
+    case VTK_FLOAT:
+        Cine::mapSlice(static_cast<const float *>(m_scalars), m_dims, m_axis, index, lo, scale, out);
+        break;
+    case VTK_DOUBLE:
+        Cine::mapSlice(static_cast<const double *>(m_scalars), m_dims, m_axis, index, lo, scale, out);
+        break;
+    default:
+        break;
+    }
+}
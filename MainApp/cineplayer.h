@@ -0,0 +1,120 @@
+#ifndef CINEPLAYER_H
+#define CINEPLAYER_H
+
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief Order in which cine playback visits the slices: step 0 is
+/// `first`, each step moves by `direction`; past either end it wraps when
+/// looping and ends otherwise.
+struct CineSequence
+{
+    int first = 0;
+    int minSlice = 0;
+    int maxSlice = 0;
+    int direction = 1; // +1 forward, -1 back
+    bool loop = true;
+
+    // Slice shown at `step`, or -1 once a non-looping sequence has ended.
+    [[nodiscard]] int sliceAt(long long step) const;
+};
+
+/// @brief Producer half of cine playback.
+///
+/// A dedicated thread runs ahead of the playhead: it extracts each slice of
+/// the sequence from the volume and maps it through window/level to 8-bit
+/// grey, into one of kQueueDepth preallocated frames. The render thread only
+/// takes the frame that is due and copies it to the screen, so a slow map
+/// never stalls a present. The thread waits on a condition variable when the
+/// queue is full or nothing plays, rather than occupying a scheduler worker.
+///
+/// Frames are x fastest over the two in-plane axes (ascending), like a slice
+/// of the volume; the caller places them at the slice's extent.
+class CinePlayer
+{
+public:
+    static constexpr int kQueueDepth = 8;
+
+    /// @brief A frame handed to the render thread.
+    struct Frame
+    {
+        long long step = -1;
+        int slice = -1;
+    };
+
+    CinePlayer() = default;
+    // Stops and joins the producer.
+    ~CinePlayer();
+
+    // Non-copyable — owns the producer thread.
+    CinePlayer(const CinePlayer &) = delete;
+    CinePlayer &operator=(const CinePlayer &) = delete;
+
+    // Plays `sequence` through slices across `axis` (0 x, 1 y, 2 z, extent
+    // indices) of `volume`, from step 0. False for unsupported voxel types.
+    bool start(vtkImageData *volume, int axis, const CineSequence &sequence, double window, double level);
+    void stop();
+    [[nodiscard]] bool isPlaying() const;
+
+    // Queued frames were mapped with the old values: dropped, and the
+    // producer starts again at the playhead.
+    void setWindowLevel(double window, double level);
+
+    // Bytes of one frame.
+    [[nodiscard]] std::size_t frameBytes() const { return m_frameBytes; }
+
+    // Render thread. Moves the playhead to `step`, discards queued frames
+    // before the newest ready one at or before it and copies that one into
+    // `pixels`. False when none is ready yet.
+    bool take(long long step, unsigned char *pixels, Frame &frame);
+
+private:
+    /// @brief A produced frame and the slot holding its pixels.
+    struct Queued
+    {
+        Frame frame;
+        int slot = -1;
+    };
+
+    void run();
+    // Drops queued frames and waits until the producer is between frames;
+    // `lock` holds m_mutex.
+    void flush(std::unique_lock<std::mutex> &lock);
+    void mapSlice(int slice, unsigned char *out) const;
+
+    mutable std::mutex m_mutex; // everything below
+    std::condition_variable m_wake; // producer: work to do or quit
+    std::condition_variable m_idle; // flush(): producer finished its frame
+    std::thread m_thread;
+    bool m_quit = false;
+    bool m_playing = false;
+    bool m_busy = false;   // producer mapping a frame outside the lock
+    int m_generation = 0;  // bumped by every flush; stale frames are thrown away
+
+    // Read by the producer outside the lock; changed only after flush().
+    vtkSmartPointer<vtkImageData> m_volume;
+    const void *m_scalars = nullptr;
+    int m_scalarType = 0;
+    int m_dims[3] = {0, 0, 0};
+    int m_firstIndex = 0; // extent start across m_axis
+    int m_axis = 0;
+    CineSequence m_sequence;
+    double m_window = 400.0;
+    double m_level = 40.0;
+    std::size_t m_frameBytes = 0;
+
+    std::vector<std::vector<unsigned char>> m_slots;
+    std::vector<int> m_free;       // slot indices
+    std::deque<Queued> m_queue;    // produced, in step order
+    long long m_nextStep = 0;      // producer cursor
+    long long m_playhead = 0;      // last step the render thread asked for
+};
+
+#endif // CINEPLAYER_H
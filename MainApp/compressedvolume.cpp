@@ -0,0 +1,98 @@
+#include "compressedvolume.h"
+#include "brickcodec.h"
+#include "parallelfor.h"
+#include "tracing.h"
+
+bool CompressedVolume::compress(vtkAlgorithm *source, int brickSize, const CancelToken *cancel)
+{
+    TRACE_SCOPE("bricks.compress");
+    clear();
+    std::size_t total = 0;
+    const bool ok = forEachLayer(source, brickSize, cancel,
+                                 [&](const Layout &layout, int first, int count, const unsigned char *bricks) {
+        if (m_encoded.empty()) {
+            setLayout(layout);
+            m_encoded.resize(std::size_t(brickCount()));
+        }
+        const std::size_t bytes = brickBytes();
+        const int voxelBytes = m_voxelBytes;
+        Parallel::forRange(0, count, 1, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i)
+                m_encoded[std::size_t(first + i)] = BrickCodec::encode(bricks + std::size_t(i) * bytes, bytes, voxelBytes);
+        });
+        for (int i = 0; i < count; ++i)
+            total += m_encoded[std::size_t(first + i)].size();
+        return true;
+    });
+    if (!ok || m_encoded.empty()) {
+        clear();
+        return false;
+    }
+    m_compressedBytes = total;
+    return true;
+}
+
+void CompressedVolume::clear()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cache.clear();
+        m_lru.clear();
+        m_resident = 0;
+    }
+    m_encoded.clear();
+    m_encoded.shrink_to_fit();
+    m_compressedBytes = 0;
+    clearLayout();
+}
+
+void CompressedVolume::setCacheBudget(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = bytes;
+}
+
+std::size_t CompressedVolume::residentBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_resident;
+}
+
+std::shared_ptr<const unsigned char> CompressedVolume::brick(int index)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto hit = m_cache.find(index);
+        if (hit != m_cache.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, hit->second.lru);
+            return hit->second.data;
+        }
+    }
+
+    // Decode outside the lock: extract() misses on many bricks at once.
+    const std::size_t bytes = brickBytes();
+    const std::vector<unsigned char> &encoded = m_encoded[std::size_t(index)];
+    std::shared_ptr<unsigned char> decoded(new unsigned char[bytes], std::default_delete<unsigned char[]>());
+    if (!BrickCodec::decode(encoded.data(), encoded.size(), decoded.get(), bytes, m_voxelBytes)) {
+        return nullptr;
+    }
+
+    std::vector<std::shared_ptr<const unsigned char>> evicted; // freed after the lock is dropped
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto raced = m_cache.find(index);
+    if (raced != m_cache.end()) {
+        return raced->second.data; // another thread decoded it meanwhile
+    }
+    m_lru.push_front(index);
+    m_cache[index] = {decoded, m_lru.begin()};
+    m_resident += bytes;
+    while (m_resident > m_budget && m_lru.size() > 1) {
+        const int victim = m_lru.back();
+        m_lru.pop_back();
+        auto it = m_cache.find(victim);
+        m_resident -= bytes;
+        evicted.push_back(std::move(it->second.data));
+        m_cache.erase(it);
+    }
+    return decoded;
+}
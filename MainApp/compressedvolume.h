@@ -0,0 +1,65 @@
+#ifndef COMPRESSEDVOLUME_H
+#define COMPRESSEDVOLUME_H
+
+#include "brickedvolume.h"
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/// @brief BrickStore held in RAM as independently compressed bricks.
+///
+/// Each brick is packed with BrickCodec (lossless delta + LZ); CT compresses
+/// well because of the air around the patient and the narrow range of tissue
+/// values. Decoded bricks are kept in a small LRU cache, so consecutive slices
+/// and projection layers decode each brick once.
+class CompressedVolume : public BrickStore
+{
+public:
+    static constexpr std::size_t kDefaultCacheBudget = std::size_t(64) << 20;
+
+    CompressedVolume() = default;
+    ~CompressedVolume() override = default;
+
+    // Compresses `source` one brick layer at a time (bricks of a layer in
+    // parallel); the decoded volume is never held in full. Replaces any
+    // previous contents; false leaves the volume empty.
+    bool compress(vtkAlgorithm *source, int brickSize = kDefaultBrickSize, const CancelToken *cancel = nullptr);
+
+    // Bytes of all compressed bricks, and what they would take decoded.
+    [[nodiscard]] std::size_t compressedBytes() const { return m_compressedBytes; }
+    [[nodiscard]] std::size_t rawBytes() const { return std::size_t(brickCount()) * brickBytes(); }
+
+    // Least recently used decoded bricks are dropped once the cache exceeds
+    // the budget; a brick being copied stays alive until the copy is done.
+    void setCacheBudget(std::size_t bytes);
+    [[nodiscard]] std::size_t cacheBudget() const { return m_budget; }
+    // Decoded bricks in the hot cache.
+    [[nodiscard]] std::size_t residentBytes() const override;
+
+protected:
+    std::shared_ptr<const unsigned char> brick(int index) override;
+
+private:
+    struct CacheEntry
+    {
+        std::shared_ptr<const unsigned char> data;
+        std::list<int>::iterator lru;
+    };
+
+    void clear();
+
+    std::vector<std::vector<unsigned char>> m_encoded; // one stream per brick
+    std::size_t m_compressedBytes = 0;
+
+    mutable std::mutex m_mutex; // m_cache, m_lru, m_resident, m_budget
+    std::unordered_map<int, CacheEntry> m_cache;
+    std::list<int> m_lru; // most recent first
+    std::size_t m_resident = 0;
+    std::size_t m_budget = kDefaultCacheBudget;
+};
+
+#endif // COMPRESSEDVOLUME_H
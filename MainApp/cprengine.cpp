@@ -0,0 +1,291 @@
+#include "cprengine.h"
+#include "obliquereslicer.h"
+#include "parallelfor.h"
+#include "tracing.h"
+#include "vtkMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Cpr {
+
+// Chords per segment when measuring and inverting arc length.
+static constexpr int kArcSteps = 32;
+
+/// @brief Uniform Catmull-Rom position and derivative at t in [0, 1].
+static void catmullRom(const double p0[3],
+                       const double p1[3],
+                       const double p2[3],
+                       const double p3[3],
+                       double t,
+                       double pos[3],
+                       double tangent[3])
+{
+    const double t2 = t * t;
+    const double t3 = t2 * t;
+    for (int i = 0; i < 3; ++i) {
+        const double a = -p0[i] + p2[i];
+        const double b = 2.0 * p0[i] - 5.0 * p1[i] + 4.0 * p2[i] - p3[i];
+        const double c = -p0[i] + 3.0 * p1[i] - 3.0 * p2[i] + p3[i];
+        pos[i] = 0.5 * (2.0 * p1[i] + a * t + b * t2 + c * t3);
+        tangent[i] = 0.5 * (a + 2.0 * b * t + 3.0 * c * t2);
+    }
+}
+
+/// @brief One output row to sample: where column 0 sits and how it steps.
+struct RowJob
+{
+    const double *frame; // start[3], step[3] in index space
+    float *out;
+};
+
+template<typename T>
+void resampleRows(const T *volume, const int dims[3], const std::vector<RowJob> &jobs, int width, float background)
+{
+    Parallel::forRange(0, static_cast<int>(jobs.size()), 8, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+            Oblique::sampleRow(volume, dims, jobs[i].frame, jobs[i].frame + 3, 0, width, background, jobs[i].out);
+    });
+}
+
+} // namespace Cpr
+
+void CprEngine::setInputData(vtkImageData *data)
+{
+    m_imageData = data;
+    if (m_imageData) {
+        const double *spacing = m_imageData->GetSpacing();
+        m_stepMm = std::min({spacing[0], spacing[1], spacing[2]});
+    }
+    rebuildAll();
+}
+
+void CprEngine::setWidth(int samples)
+{
+    m_width = std::max(1, samples);
+    rebuildAll();
+}
+
+void CprEngine::setControlPoints(const std::vector<std::array<double, 3>> &points)
+{
+    m_points = points;
+    chooseReference();
+    rebuildAll();
+}
+
+void CprEngine::moveControlPoint(int index, const double pos[3])
+{
+    const int count = controlPointCount();
+    if (index < 0 || index >= count)
+        return;
+    std::copy(pos, pos + 3, m_points[index].begin());
+
+    // Segment j is shaped by points j-1 .. j+2.
+    const int first = std::max(0, index - 2);
+    const int last = std::min(static_cast<int>(m_segments.size()) - 1, index + 1);
+    for (int j = first; j <= last; ++j)
+        buildFrames(j);
+}
+
+double CprEngine::curveLength() const
+{
+    double length = 0.0;
+    for (const Segment &s : m_segments)
+        length += s.lengthMm;
+    return length;
+}
+
+// Reference direction for the lateral axis: the world axis least aligned
+// with the overall path, kept fixed while points are dragged so the image
+// does not flip under the cursor.
+void CprEngine::chooseReference()
+{
+    if (m_points.size() < 2)
+        return;
+    const auto &a = m_points.front();
+    const auto &b = m_points.back();
+    const double d[3] = {std::abs(b[0] - a[0]), std::abs(b[1] - a[1]), std::abs(b[2] - a[2])};
+    const int axis = d[0] < d[1] ? (d[0] < d[2] ? 0 : 2) : (d[1] < d[2] ? 1 : 2);
+    m_reference[0] = m_reference[1] = m_reference[2] = 0.0;
+    m_reference[axis] = 1.0;
+}
+
+void CprEngine::rebuildAll()
+{
+    const int segments = std::max(0, controlPointCount() - 1);
+    m_segments.assign(segments, Segment());
+    for (int j = 0; j < segments; ++j)
+        buildFrames(j);
+    m_layoutChanged = true;
+}
+
+// End tangents come from reflected phantom points, so the curve leaves the
+// first and last control point heading towards its neighbour.
+void CprEngine::controlPoint(int i, double out[3]) const
+{
+    const int count = controlPointCount();
+    if (i < 0) {
+        for (int k = 0; k < 3; ++k)
+            out[k] = 2.0 * m_points[0][k] - m_points[1][k];
+    } else if (i >= count) {
+        for (int k = 0; k < 3; ++k)
+            out[k] = 2.0 * m_points[count - 1][k] - m_points[count - 2][k];
+    } else {
+        std::copy(m_points[i].begin(), m_points[i].end(), out);
+    }
+}
+
+void CprEngine::buildFrames(int segment)
+{
+    Segment &seg = m_segments[segment];
+    seg.dirty = true;
+    if (!m_imageData)
+        return;
+
+    double p[4][3];
+    for (int k = 0; k < 4; ++k)
+        controlPoint(segment - 1 + k, p[k]);
+
+    // Arc-length table so rows are evenly spaced along the curve.
+    double arc[Cpr::kArcSteps + 1];
+    double prev[3], pos[3], tangent[3];
+    Cpr::catmullRom(p[0], p[1], p[2], p[3], 0.0, prev, tangent);
+    arc[0] = 0.0;
+    for (int i = 1; i <= Cpr::kArcSteps; ++i) {
+        Cpr::catmullRom(p[0], p[1], p[2], p[3], static_cast<double>(i) / Cpr::kArcSteps, pos, tangent);
+        arc[i] = arc[i - 1] + std::sqrt(vtkMath::Distance2BetweenPoints(prev, pos));
+        std::copy(pos, pos + 3, prev);
+    }
+    seg.lengthMm = arc[Cpr::kArcSteps];
+
+    // The last segment also samples its end point.
+    const bool lastSegment = segment == static_cast<int>(m_segments.size()) - 1;
+    const int intervals = std::max(1, static_cast<int>(std::lround(seg.lengthMm / m_stepMm)));
+    const int samples = intervals + (lastSegment ? 1 : 0);
+    if (samples != seg.samples)
+        m_layoutChanged = true;
+    seg.samples = samples;
+    seg.frames.resize(static_cast<size_t>(samples) * 6);
+    seg.rows.resize(static_cast<size_t>(samples) * m_width);
+
+    const double *spacing = m_imageData->GetSpacing();
+    const double *origin = m_imageData->GetOrigin();
+    const double halfWidth = (m_width - 1) * 0.5 * m_stepMm;
+
+    int chord = 0;
+    for (int s = 0; s < samples; ++s) {
+        // invert the arc-length table by linear interpolation within a chord
+        const double target = seg.lengthMm * s / intervals;
+        while (chord < Cpr::kArcSteps - 1 && arc[chord + 1] < target)
+            ++chord;
+        const double span = arc[chord + 1] - arc[chord];
+        const double f = span > 0.0 ? (target - arc[chord]) / span : 0.0;
+        const double t = (chord + std::min(std::max(f, 0.0), 1.0)) / Cpr::kArcSteps;
+        Cpr::catmullRom(p[0], p[1], p[2], p[3], t, pos, tangent);
+
+        if (vtkMath::Normalize(tangent) == 0.0)
+            tangent[0] = 1.0; // coincident control points
+
+        // Lateral axis: the reference projected onto the normal plane. Purely
+        // local, so a dragged point cannot twist frames outside its segments.
+        double lateral[3];
+        const double dot = vtkMath::Dot(m_reference, tangent);
+        for (int i = 0; i < 3; ++i)
+            lateral[i] = m_reference[i] - dot * tangent[i];
+        if (vtkMath::Normalize(lateral) < 1e-6) {
+            double any[3] = {1.0, 0.0, 0.0};
+            if (std::abs(tangent[0]) > 0.9)
+                any[0] = 0.0, any[1] = 1.0;
+            vtkMath::Cross(tangent, any, lateral);
+            vtkMath::Normalize(lateral);
+        }
+
+        double *frame = seg.frames.data() + static_cast<size_t>(s) * 6;
+        for (int i = 0; i < 3; ++i) {
+            frame[i] = (pos[i] - halfWidth * lateral[i] - origin[i]) / spacing[i];
+            frame[3 + i] = lateral[i] * m_stepMm / spacing[i];
+        }
+    }
+}
+
+void CprEngine::resampleDirty()
+{
+    std::vector<Cpr::RowJob> jobs;
+    for (Segment &seg : m_segments) {
+        if (!seg.dirty)
+            continue;
+        for (int s = 0; s < seg.samples; ++s)
+            jobs.push_back({seg.frames.data() + static_cast<size_t>(s) * 6,
+                            seg.rows.data() + static_cast<size_t>(s) * m_width});
+    }
+    if (jobs.empty())
+        return;
+
+    int dims[3];
+    m_imageData->GetDimensions(dims);
+    const void *in = m_imageData->GetScalarPointer();
+
+    switch (m_imageData->GetScalarType()) {
+    case VTK_SHORT:
+        Cpr::resampleRows(static_cast<const short *>(in), dims, jobs, m_width, m_background);
+        break;
+    case VTK_UNSIGNED_SHORT:
+        Cpr::resampleRows(static_cast<const unsigned short *>(in), dims, jobs, m_width, m_background);
+        break;
+    case VTK_INT:
+        Cpr::resampleRows(static_cast<const int *>(in), dims, jobs, m_width, m_background);
+        break;
+    case VTK_FLOAT:
+        Cpr::resampleRows(static_cast<const float *>(in), dims, jobs, m_width, m_background);
+        break;
+    case VTK_DOUBLE:
+        Cpr::resampleRows(static_cast<const double *>(in), dims, jobs, m_width, m_background);
+        break;
+    default:
+        break; // unsupported voxel type: rows keep their old contents
+    }
+}
+
+size_t CprEngine::outputBytes() const
+{
+    return static_cast<size_t>(m_output->GetActualMemorySize()) * 1024;
+}
+
+vtkImageData *CprEngine::output()
+{
+    TRACE_SCOPE("cpr.resample");
+    if (!m_imageData || !m_imageData->GetScalarPointer() || m_segments.empty()) {
+        return nullptr; // Fail fast — no volume or no curve yet
+    }
+
+    resampleDirty();
+
+    int height = 0;
+    for (const Segment &seg : m_segments)
+        height += seg.samples;
+
+    int outDims[3];
+    m_output->GetDimensions(outDims);
+    if (outDims[0] != m_width || outDims[1] != height || m_output->GetScalarType() != VTK_FLOAT) {
+        m_output->SetDimensions(m_width, height, 1);
+        m_output->AllocateScalars(VTK_FLOAT, 1);
+        m_layoutChanged = true;
+    }
+    m_output->SetSpacing(m_stepMm, m_stepMm, 1.0);
+    m_output->SetOrigin(0.0, 0.0, 0.0);
+
+    // Rows are stored per segment; only the re-sampled ones are copied unless
+    // a segment grew or shrank and shifted everything after it.
+    float *out = static_cast<float *>(m_output->GetScalarPointer());
+    for (Segment &seg : m_segments) {
+        if (seg.dirty || m_layoutChanged)
+            std::memcpy(out, seg.rows.data(), seg.rows.size() * sizeof(float));
+        out += seg.rows.size();
+        seg.dirty = false;
+    }
+    m_layoutChanged = false;
+
+    m_output->Modified();
+    return m_output;
+}
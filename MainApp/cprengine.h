@@ -0,0 +1,79 @@
+#ifndef CPRENGINE_H
+#define CPRENGINE_H
+
+#include "vtkImageData.h"
+#include "vtkNew.h"
+
+#include <array>
+#include <vector>
+
+/// @brief Straightened curved planar reformation along a control polyline.
+///
+/// The centerline is a Catmull-Rom spline through the control points, so
+/// spline segment j (between points j and j+1) depends only on points
+/// j-1 .. j+2. Each segment keeps its own sample frames and output rows;
+/// moving one control point re-samples at most four segments, and the
+/// output image is re-assembled from the per-segment rows.
+///
+/// Output: one row per centerline sample (Y, along the curve), one column per
+/// lateral sample (X, across it), VTK_FLOAT, spacing in mm.
+class CprEngine
+{
+public:
+    CprEngine() = default;
+    ~CprEngine() = default;
+
+    // Non-copyable — owns VTK pipeline objects with reference semantics.
+    CprEngine(const CprEngine &) = delete;
+    CprEngine &operator=(const CprEngine &) = delete;
+
+    void setInputData(vtkImageData *data);
+
+    // Lateral samples per row. Sample spacing (along and across) defaults to
+    // the smallest voxel spacing of the input.
+    void setWidth(int samples);
+
+    // Replace the whole path; every segment is rebuilt.
+    void setControlPoints(const std::vector<std::array<double, 3>> &points);
+    // Move one control point; only the segments it supports are rebuilt.
+    void moveControlPoint(int index, const double pos[3]);
+
+    int controlPointCount() const { return static_cast<int>(m_points.size()); }
+    double curveLength() const;
+
+    // Straightened image, or nullptr without input / with fewer than two
+    // points. The same object is reused and Modified() on every update.
+    [[nodiscard]] vtkImageData *output();
+    [[nodiscard]] size_t outputBytes() const;
+
+private:
+    /// @brief One spline segment: its sample frames and resampled rows.
+    struct Segment
+    {
+        int samples = 0;
+        std::vector<double> frames; // per sample: position[3], lateral[3] (index space)
+        std::vector<float> rows;    // samples x width
+        double lengthMm = 0.0;
+        bool dirty = true;
+    };
+
+    void rebuildAll();
+    void buildFrames(int segment);
+    void resampleDirty();
+    void chooseReference();
+    void controlPoint(int i, double out[3]) const;
+
+    vtkImageData *m_imageData = nullptr;
+    vtkNew<vtkImageData> m_output;
+
+    std::vector<std::array<double, 3>> m_points; // world, mm
+    std::vector<Segment> m_segments;
+    bool m_layoutChanged = true;
+
+    int m_width = 256;
+    double m_stepMm = 1.0;
+    double m_reference[3] = {0.0, 0.0, 1.0}; // projected onto each normal plane
+    float m_background = -1000.0f;
+};
+
+#endif // CPRENGINE_H
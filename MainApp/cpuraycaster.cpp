@@ -0,0 +1,797 @@
+#include "cpuraycaster.h"
+#include "gradientvolume.h"
+#include "parallelfor.h"
+#include "preintegration.h"
+#include "vtkCamera.h"
+#include "vtkColorTransferFunction.h"
+#include "vtkMatrix4x4.h"
+#include "vtkObjectFactory.h"
+#include "vtkPiecewiseFunction.h"
+#include "vtkRayCastImageDisplayHelper.h"
+#include "vtkRenderer.h"
+#include "vtkVolume.h"
+#include "vtkVolumeProperty.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace Raycast {
+
+// Transfer function resolution across the scalar range.
+static constexpr int kTableSize = 4096;
+// Macrocell edge in voxels for empty-space skipping.
+static constexpr int kCellSize = 8;
+// Screen tile handed to one task.
+static constexpr int kTile = 16;
+// Adjacent rays advanced one step each in turn (interleaved scalar lanes, not
+// SIMD); they traverse the same cells, so their voxel fetches share cache lines.
+static constexpr int kPacket = 4;
+// Accumulated opacity at which a ray stops.
+static constexpr float kOpaque = 0.99f;
+// Gradient opacity resolution — one entry per quantized magnitude level.
+static constexpr int kGradientLevels = 256;
+
+/// @brief Everything one frame's kernel reads; no VTK calls inside the loop.
+struct Frame
+{
+    int dims[3];
+    double spacing[3];
+    double origin[3];
+    double boxLo[3]; // index-space box rays are clipped to (volume or crop)
+    double boxHi[3];
+    int cellDims[3];
+    const unsigned char *cellEmpty;
+    const float *table; // kTableSize x (r, g, b, a)
+    float tableLo;
+    float tableScale;
+    // pre-integrated segments; null = point-sampled through `table`
+    const float *segmentTable; // PreIntegrationTable::kSize² x premultiplied RGBA
+    float segmentScale;
+    // shading from GradientVolume; null normals = unshaded
+    const std::uint16_t *normals;
+    const std::uint8_t *magnitudes;
+    const float *normalTable; // GradientVolume::normalTable()
+    const float *gradientOpacity; // kGradientLevels factors, or null
+    float ambient;
+    float diffuse;
+    float specular;
+    float specularPower;
+    double step; // mm
+    double invViewProj[16];
+    int width;
+    int height;
+    unsigned char *out;
+
+    // progressive refinement
+    int stride;              // 2 = preview: every other pixel, replicated 2x2
+    bool skipEven;           // even/even pixels already hold this step's result
+    const float *startDepth; // first-hit depth of the coarse pass, or null
+    double startBack;        // fine march starts this far before that hit
+    float *hitDepth;         // out: depth of the first visible sample, -1 = none
+};
+
+/// @brief One ray of a packet, marched in index space.
+struct Lane
+{
+    double entry[3]; // index-space position of sample 0
+    double delta[3]; // index-space advance per sample
+    float dir[3];    // world-space unit direction, also the headlight direction
+    double tEnter = 0.0; // world distance of sample 0 from the near plane
+    int sample = 0;
+    int samples = 0; // 0 = ray misses the volume
+    float rgba[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float hit = -1.0f;
+    float previous = 0.0f;   // scalar at the previous sample (pre-integration)
+    bool hasPrevious = false; // false at the entry and after a skipped cell
+    int x = 0;
+    int y = 0;
+};
+
+static void unproject(const double m[16], double x, double y, double z, double out[3])
+{
+    const double w = m[12] * x + m[13] * y + m[14] * z + m[15];
+    for (int i = 0; i < 3; ++i)
+        out[i] = (m[i * 4] * x + m[i * 4 + 1] * y + m[i * 4 + 2] * z + m[i * 4 + 3]) / w;
+}
+
+/// @brief Set up the lane for pixel (px, py): clip the view ray against the
+/// index-space box [boxLo, boxHi] and convert it to index-space steps.
+static void startLane(const Frame &f, int px, int py, Lane &lane)
+{
+    lane.x = px;
+    lane.y = py;
+    lane.sample = 0;
+    lane.samples = 0;
+    lane.hit = -1.0f;
+    lane.hasPrevious = false;
+    lane.rgba[0] = lane.rgba[1] = lane.rgba[2] = lane.rgba[3] = 0.0f;
+
+    const double ndcX = 2.0 * (px + 0.5) / f.width - 1.0;
+    const double ndcY = 2.0 * (py + 0.5) / f.height - 1.0;
+    double nearPt[3], farPt[3];
+    unproject(f.invViewProj, ndcX, ndcY, -1.0, nearPt);
+    unproject(f.invViewProj, ndcX, ndcY, 1.0, farPt);
+
+    double dir[3] = {farPt[0] - nearPt[0], farPt[1] - nearPt[1], farPt[2] - nearPt[2]};
+    const double length = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+    if (length <= 0.0)
+        return;
+
+    // Ray in index space, parameterized by world distance (mm) from the near plane.
+    double o[3], d[3];
+    double tEnter = 0.0;
+    double tExit = length;
+    for (int i = 0; i < 3; ++i) {
+        dir[i] /= length;
+        lane.dir[i] = static_cast<float>(dir[i]);
+        o[i] = (nearPt[i] - f.origin[i]) / f.spacing[i];
+        d[i] = dir[i] / f.spacing[i];
+        const double lo = f.boxLo[i];
+        const double hi = f.boxHi[i];
+        if (std::abs(d[i]) < 1e-12) {
+            if (o[i] < lo || o[i] > hi)
+                return;
+            continue;
+        }
+        double t0 = (lo - o[i]) / d[i];
+        double t1 = (hi - o[i]) / d[i];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        tEnter = std::max(tEnter, t0);
+        tExit = std::min(tExit, t1);
+    }
+    // Refinement: empty space in front of the coarse hit needs no re-march.
+    if (f.startDepth) {
+        const float coarseHit = f.startDepth[px + py * f.width];
+        if (coarseHit >= 0.0f)
+            tEnter = std::max(tEnter, coarseHit - f.startBack);
+    }
+    if (tExit <= tEnter)
+        return;
+
+    lane.tEnter = tEnter;
+    for (int i = 0; i < 3; ++i) {
+        lane.entry[i] = o[i] + tEnter * d[i];
+        lane.delta[i] = d[i] * f.step;
+    }
+    lane.samples = static_cast<int>((tExit - tEnter) / f.step) + 1;
+}
+
+/// @brief Samples needed to leave the macrocell containing `p` along `delta`.
+static int stepsToLeaveCell(const double p[3], const double delta[3], const int cell[3])
+{
+    double tMin = std::numeric_limits<double>::max();
+    for (int i = 0; i < 3; ++i) {
+        if (delta[i] > 1e-12)
+            tMin = std::min(tMin, ((cell[i] + 1) * kCellSize - p[i]) / delta[i]);
+        else if (delta[i] < -1e-12)
+            tMin = std::min(tMin, (cell[i] * kCellSize - p[i]) / delta[i]);
+    }
+    return static_cast<int>(tMin) + 1;
+}
+
+template<typename T>
+float trilinear(const T *volume, const Frame &f, const double p[3])
+{
+    const std::int64_t strideY = f.dims[0];
+    const std::int64_t strideZ = static_cast<std::int64_t>(f.dims[0]) * f.dims[1];
+    const int ix = std::min(static_cast<int>(p[0]), f.dims[0] - 2);
+    const int iy = std::min(static_cast<int>(p[1]), f.dims[1] - 2);
+    const int iz = std::min(static_cast<int>(p[2]), f.dims[2] - 2);
+    const float fx = static_cast<float>(p[0] - ix);
+    const float fy = static_cast<float>(p[1] - iy);
+    const float fz = static_cast<float>(p[2] - iz);
+
+    const T *v = volume + ix + iy * strideY + iz * strideZ;
+    const float c00 = v[0] + fx * (static_cast<float>(v[1]) - v[0]);
+    const float c10 = v[strideY] + fx * (static_cast<float>(v[strideY + 1]) - v[strideY]);
+    const float c01 = v[strideZ] + fx * (static_cast<float>(v[strideZ + 1]) - v[strideZ]);
+    const float c11 = v[strideY + strideZ] + fx * (static_cast<float>(v[strideY + strideZ + 1]) - v[strideY + strideZ]);
+    const float y0 = c00 + fy * (c10 - c00);
+    const float y1 = c01 + fy * (c11 - c01);
+    return y0 + fz * (y1 - y0);
+}
+
+static int binOf(float value, float lo, float scale, int size)
+{
+    return std::min(std::max(static_cast<int>((value - lo) * scale), 0), size - 1);
+}
+
+/// @brief Apply gradient opacity and headlight Blinn-Phong to a premultiplied
+/// sample. Normals and magnitudes are blended with the same trilinear weights
+/// as the scalar; lighting is two-sided.
+static void shadeSample(const Frame &f, const Lane &lane, const double p[3], float rgba[4])
+{
+    const std::int64_t strideY = f.dims[0];
+    const std::int64_t strideZ = static_cast<std::int64_t>(f.dims[0]) * f.dims[1];
+    const int ix = std::min(static_cast<int>(p[0]), f.dims[0] - 2);
+    const int iy = std::min(static_cast<int>(p[1]), f.dims[1] - 2);
+    const int iz = std::min(static_cast<int>(p[2]), f.dims[2] - 2);
+    const float fx = static_cast<float>(p[0] - ix);
+    const float fy = static_cast<float>(p[1] - iy);
+    const float fz = static_cast<float>(p[2] - iz);
+    const std::int64_t base = ix + iy * strideY + iz * strideZ;
+
+    float normal[3] = {0.0f, 0.0f, 0.0f};
+    float magnitude = 0.0f;
+    for (int corner = 0; corner < 8; ++corner) {
+        const int cx = corner & 1;
+        const int cy = (corner >> 1) & 1;
+        const int cz = corner >> 2;
+        const float weight = (cx ? fx : 1.0f - fx) * (cy ? fy : 1.0f - fy) * (cz ? fz : 1.0f - fz);
+        const std::int64_t voxel = base + cx + cy * strideY + cz * strideZ;
+        const float *n = f.normalTable + f.normals[voxel] * 3;
+        const float w = weight * f.magnitudes[voxel]; // flat regions carry no direction
+        normal[0] += w * n[0];
+        normal[1] += w * n[1];
+        normal[2] += w * n[2];
+        magnitude += weight * f.magnitudes[voxel];
+    }
+
+    if (f.gradientOpacity) {
+        const float factor = f.gradientOpacity[std::min(static_cast<int>(magnitude + 0.5f), kGradientLevels - 1)];
+        for (int c = 0; c < 4; ++c)
+            rgba[c] *= factor;
+    }
+
+    const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    if (length <= 1e-6f)
+        return; // no usable normal: leave the sample unlit
+    const float cosine = std::abs(normal[0] * lane.dir[0] + normal[1] * lane.dir[1] + normal[2] * lane.dir[2]) / length;
+    const float lit = f.ambient + f.diffuse * cosine;
+    // headlight: light, view and half vector coincide
+    const float highlight = f.specular * std::pow(cosine, f.specularPower) * rgba[3];
+    for (int c = 0; c < 3; ++c)
+        rgba[c] = rgba[c] * lit + highlight;
+}
+
+/// @brief Advance one lane by one sample (or one skipped macrocell).
+/// Returns false once the lane has finished.
+template<typename T>
+bool advance(const T *volume, const Frame &f, Lane &lane, long long &samples)
+{
+    if (lane.sample >= lane.samples || lane.rgba[3] >= kOpaque)
+        return false;
+
+    double p[3];
+    for (int i = 0; i < 3; ++i)
+        p[i] = lane.entry[i] + lane.sample * lane.delta[i];
+
+    int cell[3];
+    for (int i = 0; i < 3; ++i)
+        cell[i] = std::min(static_cast<int>(p[i]) / kCellSize, f.cellDims[i] - 1);
+    if (f.cellEmpty[cell[0] + f.cellDims[0] * (cell[1] + f.cellDims[1] * cell[2])]) {
+        lane.sample += stepsToLeaveCell(p, lane.delta, cell);
+        lane.hasPrevious = false;
+        return lane.sample < lane.samples;
+    }
+
+    const float value = trilinear(volume, f, p);
+    float rgba[4];
+    if (f.segmentTable) {
+        // Segment from the previous sample; after a skip, re-fetch the front
+        // end (it lies in the transparent cell, but the segment may not).
+        float front = value;
+        if (lane.hasPrevious) {
+            front = lane.previous;
+        } else if (lane.sample > 0) {
+            double q[3];
+            for (int i = 0; i < 3; ++i)
+                q[i] = p[i] - lane.delta[i];
+            front = trilinear(volume, f, q);
+        }
+        lane.previous = value;
+        lane.hasPrevious = true;
+
+        constexpr int n = PreIntegrationTable::kSize;
+        const float *entry = f.segmentTable
+                             + (binOf(value, f.tableLo, f.segmentScale, n) * n + binOf(front, f.tableLo, f.segmentScale, n)) * 4;
+        std::copy(entry, entry + 4, rgba); // already premultiplied
+    } else {
+        const float *entry = f.table + binOf(value, f.tableLo, f.tableScale, kTableSize) * 4;
+        for (int c = 0; c < 3; ++c)
+            rgba[c] = entry[c] * entry[3];
+        rgba[3] = entry[3];
+    }
+
+    if (rgba[3] > 0.0f) {
+        if (lane.hit < 0.0f)
+            lane.hit = static_cast<float>(lane.tEnter + lane.sample * f.step);
+        if (f.normals)
+            shadeSample(f, lane, p, rgba);
+        // front-to-back "over", premultiplied
+        const float transmit = 1.0f - lane.rgba[3];
+        for (int c = 0; c < 4; ++c)
+            lane.rgba[c] += transmit * rgba[c];
+    }
+    ++samples;
+    ++lane.sample;
+    return true;
+}
+
+static void writePixel(const Frame &f, const Lane &lane)
+{
+    unsigned char rgba[4];
+    for (int c = 0; c < 4; ++c)
+        rgba[c] = static_cast<unsigned char>(std::min(255.0f, lane.rgba[c] * 255.0f + 0.5f));
+
+    // A preview pixel also covers its 2x2 block (always inside its own tile).
+    const int x1 = std::min(lane.x + f.stride, f.width);
+    const int y1 = std::min(lane.y + f.stride, f.height);
+    for (int y = lane.y; y < y1; ++y) {
+        for (int x = lane.x; x < x1; ++x) {
+            const size_t pixel = x + static_cast<size_t>(y) * f.width;
+            std::copy(rgba, rgba + 4, f.out + pixel * 4);
+            f.hitDepth[pixel] = lane.hit;
+        }
+    }
+}
+
+template<typename T>
+long long castTiles(const T *volume, const Frame &f)
+{
+    const int tilesX = (f.width + kTile - 1) / kTile;
+    const int tilesY = (f.height + kTile - 1) / kTile;
+    std::vector<long long> tileSamples(static_cast<size_t>(tilesX) * tilesY, 0);
+
+    Parallel::forRange(0, tilesX * tilesY, 1, [&](int tileBegin, int tileEnd) {
+        for (int tile = tileBegin; tile < tileEnd; ++tile) {
+            const int x0 = (tile % tilesX) * kTile;
+            const int y0 = (tile / tilesX) * kTile;
+            const int x1 = std::min(x0 + kTile, f.width);
+            const int y1 = std::min(y0 + kTile, f.height);
+            long long &samples = tileSamples[tile];
+
+            for (int y = y0; y < y1; y += f.stride) {
+                // pixels of this tile row that the pass actually casts
+                int xs[kTile];
+                int pending = 0;
+                for (int x = x0; x < x1; x += f.stride) {
+                    if (!(f.skipEven && (x % 2) == 0 && (y % 2) == 0))
+                        xs[pending++] = x;
+                }
+
+                for (int first = 0; first < pending; first += kPacket) {
+                    Lane lanes[kPacket];
+                    const int count = std::min(kPacket, pending - first);
+                    for (int k = 0; k < count; ++k)
+                        startLane(f, xs[first + k], y, lanes[k]);
+
+                    bool running = true;
+                    while (running) {
+                        running = false;
+                        for (int k = 0; k < count; ++k)
+                            running |= advance(volume, f, lanes[k], samples);
+                    }
+                    for (int k = 0; k < count; ++k)
+                        writePixel(f, lanes[k]);
+                }
+            }
+        }
+    });
+
+    long long total = 0;
+    for (long long s : tileSamples)
+        total += s;
+    return total;
+}
+
+template<typename T>
+void cellRange(const T *volume, const int dims[3], const int cellDims[3], float *cellMin, float *cellMax)
+{
+    const std::int64_t strideY = dims[0];
+    const std::int64_t strideZ = static_cast<std::int64_t>(dims[0]) * dims[1];
+    Parallel::forRange(0, cellDims[2], 1, [&](int cz0, int cz1) {
+        for (int cz = cz0; cz < cz1; ++cz) {
+            for (int cy = 0; cy < cellDims[1]; ++cy) {
+                for (int cx = 0; cx < cellDims[0]; ++cx) {
+                    // voxels [c * size, (c + 1) * size] — the +1 apron covers
+                    // the far corner of trilinear samples in this cell
+                    const int x1 = std::min((cx + 1) * kCellSize, dims[0] - 1);
+                    const int y1 = std::min((cy + 1) * kCellSize, dims[1] - 1);
+                    const int z1 = std::min((cz + 1) * kCellSize, dims[2] - 1);
+                    float lo = std::numeric_limits<float>::max();
+                    float hi = std::numeric_limits<float>::lowest();
+                    for (int z = cz * kCellSize; z <= z1; ++z) {
+                        for (int y = cy * kCellSize; y <= y1; ++y) {
+                            const T *row = volume + y * strideY + z * strideZ;
+                            for (int x = cx * kCellSize; x <= x1; ++x) {
+                                lo = std::min(lo, static_cast<float>(row[x]));
+                                hi = std::max(hi, static_cast<float>(row[x]));
+                            }
+                        }
+                    }
+                    const size_t id = cx + static_cast<size_t>(cellDims[0]) * (cy + static_cast<size_t>(cellDims[1]) * cz);
+                    cellMin[id] = lo;
+                    cellMax[id] = hi;
+                }
+            }
+        }
+    });
+}
+
+} // namespace Raycast
+
+bool CpuRaycaster::ViewKey::operator==(const ViewKey &o) const
+{
+    return width == o.width && height == o.height && generation == o.generation
+           && std::equal(invViewProj, invViewProj + 16, o.invViewProj);
+}
+
+bool CpuRaycaster::ShadingState::operator==(const ShadingState &o) const
+{
+    return shade == o.shade && gradientOpacity == o.gradientOpacity && ambient == o.ambient
+           && diffuse == o.diffuse && specular == o.specular && specularPower == o.specularPower
+           && gradientOpacityTime == o.gradientOpacityTime && gradients == o.gradients;
+}
+
+size_t CpuRaycaster::memoryBytes() const
+{
+    const size_t floats = m_baseTable.capacity() + m_table.capacity() + m_gradientOpacityTable.capacity()
+                          + m_hitDepth.capacity() + m_cellMin.capacity() + m_cellMax.capacity();
+    return static_cast<size_t>(m_output->GetActualMemorySize()) * 1024 + floats * sizeof(float)
+           + m_cellEmpty.capacity();
+}
+
+size_t CpuRaycaster::gradientBytes() const
+{
+    return m_gradients ? m_gradients->memoryBytes() : 0;
+}
+
+void CpuRaycaster::setInputData(vtkImageData *data)
+{
+    if (data == m_imageData && (!data || data->GetMTime() == m_imageTime))
+        return;
+    m_imageData = data;
+    m_imageTime = data ? data->GetMTime() : 0;
+    m_gradients.reset(); // re-acquired on demand for the new scalars
+    buildMacrocells();
+    m_opacityTime = 0; // force re-classification against the new ranges
+    ++m_generation;
+}
+
+void CpuRaycaster::setProperty(vtkVolumeProperty *property)
+{
+    m_property = property;
+}
+
+void CpuRaycaster::setPreIntegration(bool enabled)
+{
+    if (enabled == m_preIntegrate)
+        return;
+    m_preIntegrate = enabled;
+    ++m_generation;
+}
+
+void CpuRaycaster::setSampleDistance(double mm)
+{
+    mm = std::max(0.01, mm);
+    if (mm == m_sampleDistance)
+        return;
+    m_sampleDistance = mm;
+    ++m_generation;
+}
+
+void CpuRaycaster::setCropBounds(const double *bounds)
+{
+    const bool cropped = bounds != nullptr;
+    if (cropped == m_cropped && (!cropped || std::equal(bounds, bounds + 6, m_cropBounds)))
+        return;
+    m_cropped = cropped;
+    if (cropped)
+        std::copy(bounds, bounds + 6, m_cropBounds);
+    ++m_generation;
+}
+
+void CpuRaycaster::buildMacrocells()
+{
+    m_cellMin.clear();
+    m_cellMax.clear();
+    m_cellEmpty.clear();
+    if (!m_imageData || !m_imageData->GetScalarPointer())
+        return;
+
+    int dims[3];
+    m_imageData->GetDimensions(dims);
+    for (int i = 0; i < 3; ++i)
+        m_cellDims[i] = std::max(1, (dims[i] - 1 + Raycast::kCellSize - 1) / Raycast::kCellSize);
+    const size_t cells = static_cast<size_t>(m_cellDims[0]) * m_cellDims[1] * m_cellDims[2];
+    m_cellMin.resize(cells);
+    m_cellMax.resize(cells);
+    m_cellEmpty.assign(cells, 0);
+
+    const void *in = m_imageData->GetScalarPointer();
+    switch (m_imageData->GetScalarType()) {
+    case VTK_SHORT:
+        Raycast::cellRange(static_cast<const short *>(in), dims, m_cellDims, m_cellMin.data(), m_cellMax.data());
+        break;
+    case VTK_UNSIGNED_SHORT:
+        Raycast::cellRange(static_cast<const unsigned short *>(in), dims, m_cellDims, m_cellMin.data(), m_cellMax.data());
+        break;
+    case VTK_INT:
+        Raycast::cellRange(static_cast<const int *>(in), dims, m_cellDims, m_cellMin.data(), m_cellMax.data());
+        break;
+    case VTK_FLOAT:
+        Raycast::cellRange(static_cast<const float *>(in), dims, m_cellDims, m_cellMin.data(), m_cellMax.data());
+        break;
+    case VTK_DOUBLE:
+        Raycast::cellRange(static_cast<const double *>(in), dims, m_cellDims, m_cellMin.data(), m_cellMax.data());
+        break;
+    default:
+        // unsupported voxel type: nothing is skippable, render() bails out
+        std::fill(m_cellMin.begin(), m_cellMin.end(), std::numeric_limits<float>::lowest());
+        std::fill(m_cellMax.begin(), m_cellMax.end(), std::numeric_limits<float>::max());
+        break;
+    }
+}
+
+// Re-sample the transfer functions when one of them changed, then
+// re-classify the macrocells against the new opacity.
+void CpuRaycaster::updateTables()
+{
+    vtkPiecewiseFunction *opacity = m_property->GetScalarOpacity();
+    vtkColorTransferFunction *color = m_property->GetRGBTransferFunction();
+    const double unitDistance = m_property->GetScalarOpacityUnitDistance();
+    if (opacity->GetMTime() == m_opacityTime && color->GetMTime() == m_colorTime
+        && unitDistance == m_tableUnitDistance && m_sampleDistance == m_tableSampleDistance && !m_baseTable.empty())
+        return;
+    m_opacityTime = opacity->GetMTime();
+    m_colorTime = color->GetMTime();
+    m_tableUnitDistance = unitDistance;
+    m_tableSampleDistance = m_sampleDistance;
+    m_tableStep = 0.0; // re-correct on the next pass
+    ++m_generation;
+
+    m_imageData->GetScalarRange(m_tableRange);
+    const int n = Raycast::kTableSize;
+    std::vector<float> alpha(n);
+    std::vector<float> rgb(static_cast<size_t>(n) * 3);
+    opacity->GetTable(m_tableRange[0], m_tableRange[1], n, alpha.data());
+    color->GetTable(m_tableRange[0], m_tableRange[1], n, rgb.data());
+
+    m_baseTable.resize(static_cast<size_t>(n) * 4);
+    std::vector<int> opaqueBefore(n + 1, 0); // prefix count of non-transparent bins
+    for (int i = 0; i < n; ++i) {
+        m_baseTable[i * 4 + 0] = rgb[i * 3 + 0];
+        m_baseTable[i * 4 + 1] = rgb[i * 3 + 1];
+        m_baseTable[i * 4 + 2] = rgb[i * 3 + 2];
+        m_baseTable[i * 4 + 3] = std::min(1.0f, std::max(0.0f, alpha[i]));
+        opaqueBefore[i + 1] = opaqueBefore[i] + (m_baseTable[i * 4 + 3] > 0.0f ? 1 : 0);
+    }
+
+    // A macrocell is empty when no bin in its [min, max] is visible.
+    const double span = m_tableRange[1] - m_tableRange[0];
+    const float lo = static_cast<float>(m_tableRange[0]);
+    const float scale = static_cast<float>(span > 0.0 ? n / span : 0.0);
+    Parallel::forRange(0, static_cast<int>(m_cellEmpty.size()), 4096, [&](int begin, int end) {
+        for (int c = begin; c < end; ++c) {
+            const int minBin = Raycast::binOf(m_cellMin[c], lo, scale, n);
+            const int maxBin = Raycast::binOf(m_cellMax[c], lo, scale, n);
+            m_cellEmpty[c] = opaqueBefore[maxBin + 1] == opaqueBefore[minBin] ? 1 : 0;
+        }
+    });
+
+    m_preIntegration.setTransferFunction(m_baseTable.data(), n, unitDistance);
+}
+
+// Lighting and gradient opacity. Gradients are acquired the first time either
+// needs them and stay shared with every other view of the volume.
+void CpuRaycaster::updateShading()
+{
+    const bool shade = m_property->GetShade() != 0;
+    const bool gradientOpacity = m_property->HasGradientOpacity() && !m_property->GetDisableGradientOpacity();
+    if ((shade || gradientOpacity) && !m_gradients)
+        m_gradients = GradientVolume::shared(m_imageData);
+
+    ShadingState state;
+    state.shade = shade && m_gradients;
+    state.gradientOpacity = gradientOpacity && m_gradients;
+    state.ambient = m_property->GetAmbient();
+    state.diffuse = m_property->GetDiffuse();
+    state.specular = m_property->GetSpecular();
+    state.specularPower = m_property->GetSpecularPower();
+    state.gradientOpacityTime = state.gradientOpacity ? m_property->GetGradientOpacity()->GetMTime() : 0;
+    state.gradients = m_gradients.get();
+    if (state == m_shading)
+        return;
+    m_shading = state;
+    ++m_generation;
+
+    m_gradientOpacityTable.clear();
+    if (state.gradientOpacity) {
+        m_gradientOpacityTable.resize(Raycast::kGradientLevels);
+        m_property->GetGradientOpacity()->GetTable(0.0, m_gradients->maxMagnitude(), Raycast::kGradientLevels,
+                                                   m_gradientOpacityTable.data());
+    }
+}
+
+// Opacity is defined per unit distance; correct it for the step marched.
+void CpuRaycaster::correctOpacity(double step)
+{
+    if (step == m_tableStep)
+        return;
+    m_tableStep = step;
+
+    const double unit = std::max(1e-6, m_property->GetScalarOpacityUnitDistance());
+    const double exponent = step / unit;
+    m_table = m_baseTable;
+    for (size_t i = 3; i < m_table.size(); i += 4)
+        m_table[i] = static_cast<float>(1.0 - std::pow(1.0 - m_baseTable[i], exponent));
+}
+
+vtkImageData *CpuRaycaster::render(vtkCamera *camera, int width, int height, RefinePass pass)
+{
+    if (!camera || width <= 0 || height <= 0)
+        return nullptr;
+
+    const double aspect = static_cast<double>(width) / height;
+    vtkNew<vtkMatrix4x4> inverse;
+    inverse->DeepCopy(camera->GetCompositeProjectionTransformMatrix(aspect, -1.0, 1.0));
+    inverse->Invert();
+    return render(&inverse->Element[0][0], width, height, pass);
+}
+
+vtkImageData *CpuRaycaster::render(const double invViewProj[16], int width, int height, RefinePass pass)
+{
+    if (!m_imageData || !m_imageData->GetScalarPointer() || !m_property || width <= 0 || height <= 0) {
+        return nullptr; // Fail fast — caller forgot setInputData() / setProperty()
+    }
+    setInputData(m_imageData); // picks up in-place edits of the volume
+    updateTables();
+    updateShading();
+
+    ViewKey key;
+    std::copy(invViewProj, invViewProj + 16, key.invViewProj);
+    key.width = width;
+    key.height = height;
+    key.generation = m_generation;
+
+    // Nothing changed since the last pass: re-present it (window expose, or
+    // the interactor re-rendering a finished refinement).
+    const bool sameView = m_lastValid && key == m_lastKey;
+    if (sameView && pass == m_lastPass) {
+        m_lastSamples = 0;
+        return m_output;
+    }
+
+    int outDims[3];
+    m_output->GetDimensions(outDims);
+    if (outDims[0] != width || outDims[1] != height || m_output->GetNumberOfScalarComponents() != 4) {
+        m_output->SetDimensions(width, height, 1);
+        m_output->AllocateScalars(VTK_UNSIGNED_CHAR, 4);
+    }
+    m_hitDepth.resize(static_cast<size_t>(width) * height);
+
+    // Each pass only builds on its immediate predecessor for the same view.
+    const double coarseStep = 2.0 * m_sampleDistance;
+    const bool fromPreview = sameView && m_lastPass == RefinePass::Preview;
+    const bool fromCoarse = sameView && m_lastPass == RefinePass::FullResolution;
+
+    Raycast::Frame f;
+    m_imageData->GetDimensions(f.dims);
+    m_imageData->GetSpacing(f.spacing);
+    m_imageData->GetOrigin(f.origin);
+    for (int i = 0; i < 3; ++i) {
+        f.boxLo[i] = 0.0;
+        f.boxHi[i] = f.dims[i] - 1;
+        if (m_cropped) {
+            double a = (m_cropBounds[2 * i] - f.origin[i]) / f.spacing[i];
+            double b = (m_cropBounds[2 * i + 1] - f.origin[i]) / f.spacing[i];
+            if (a > b)
+                std::swap(a, b);
+            f.boxLo[i] = std::max(f.boxLo[i], a);
+            f.boxHi[i] = std::min(f.boxHi[i], b);
+        }
+    }
+    std::copy(m_cellDims, m_cellDims + 3, f.cellDims);
+    f.cellEmpty = m_cellEmpty.data();
+    f.tableLo = static_cast<float>(m_tableRange[0]);
+    const double span = m_tableRange[1] - m_tableRange[0];
+    f.tableScale = static_cast<float>(span > 0.0 ? Raycast::kTableSize / span : 0.0);
+    f.segmentScale = static_cast<float>(span > 0.0 ? PreIntegrationTable::kSize / span : 0.0);
+    f.step = pass == RefinePass::Final ? m_sampleDistance : coarseStep;
+    std::copy(invViewProj, invViewProj + 16, f.invViewProj);
+    f.width = width;
+    f.height = height;
+    f.out = static_cast<unsigned char *>(m_output->GetScalarPointer());
+    f.stride = pass == RefinePass::Preview ? 2 : 1;
+    f.skipEven = pass == RefinePass::FullResolution && fromPreview;
+    f.startDepth = pass == RefinePass::Final && fromCoarse ? m_hitDepth.data() : nullptr;
+    f.startBack = coarseStep;
+    f.hitDepth = m_hitDepth.data();
+
+    if (m_preIntegrate) {
+        f.table = nullptr;
+        f.segmentTable = m_preIntegration.table(f.step);
+    } else {
+        correctOpacity(f.step);
+        f.table = m_table.data();
+        f.segmentTable = nullptr;
+    }
+    const bool lit = m_shading.shade || m_shading.gradientOpacity;
+    f.normals = lit ? m_gradients->normals() : nullptr;
+    f.magnitudes = lit ? m_gradients->magnitudes() : nullptr;
+    f.normalTable = lit ? GradientVolume::normalTable() : nullptr;
+    f.gradientOpacity = m_gradientOpacityTable.empty() ? nullptr : m_gradientOpacityTable.data();
+    // gradient opacity alone leaves the color unlit
+    f.ambient = m_shading.shade ? static_cast<float>(m_shading.ambient) : 1.0f;
+    f.diffuse = m_shading.shade ? static_cast<float>(m_shading.diffuse) : 0.0f;
+    f.specular = m_shading.shade ? static_cast<float>(m_shading.specular) : 0.0f;
+    f.specularPower = static_cast<float>(m_shading.specularPower);
+
+    if (f.dims[0] < 2 || f.dims[1] < 2 || f.dims[2] < 2)
+        return nullptr;
+
+    // The final pass reads coarse hits and writes fine ones per pixel; each
+    // pixel is owned by exactly one ray, so in-place is safe.
+    const void *in = m_imageData->GetScalarPointer();
+    switch (m_imageData->GetScalarType()) {
+    case VTK_SHORT:
+        m_lastSamples = Raycast::castTiles(static_cast<const short *>(in), f);
+        break;
+    case VTK_UNSIGNED_SHORT:
+        m_lastSamples = Raycast::castTiles(static_cast<const unsigned short *>(in), f);
+        break;
+    case VTK_INT:
+        m_lastSamples = Raycast::castTiles(static_cast<const int *>(in), f);
+        break;
+    case VTK_FLOAT:
+        m_lastSamples = Raycast::castTiles(static_cast<const float *>(in), f);
+        break;
+    case VTK_DOUBLE:
+        m_lastSamples = Raycast::castTiles(static_cast<const double *>(in), f);
+        break;
+    default:
+        return nullptr; // unsupported voxel type
+    }
+
+    m_lastKey = key;
+    m_lastPass = pass;
+    m_lastValid = true;
+    m_output->Modified();
+    return m_output;
+}
+
+// ---------------------------------------------------------------------------
+// CpuVolumeMapper
+// ---------------------------------------------------------------------------
+
+vtkStandardNewMacro(CpuVolumeMapper);
+
+CpuVolumeMapper::CpuVolumeMapper()
+    : m_display(vtkSmartPointer<vtkRayCastImageDisplayHelper>::Take(vtkRayCastImageDisplayHelper::New()))
+{
+    // The raycaster composites with premultiplied alpha.
+    m_display->PreMultipliedColorsOn();
+}
+
+void CpuVolumeMapper::Render(vtkRenderer *renderer, vtkVolume *volume)
+{
+    vtkImageData *input = this->GetInput();
+    if (!input || !m_display) {
+        return;
+    }
+
+    m_raycaster.setInputData(input);
+    m_raycaster.setProperty(volume->GetProperty());
+    // Only the sub-volume region is supported; other region flags render
+    // uncropped rather than wrongly.
+    const bool subVolume = this->GetCropping()
+                           && this->GetCroppingRegionFlags() == VTK_CROP_SUBVOLUME;
+    m_raycaster.setCropBounds(subVolume ? this->GetCroppingRegionPlanes() : nullptr);
+
+    const int *size = renderer->GetSize();
+    vtkImageData *image = m_raycaster.render(renderer->GetActiveCamera(), size[0], size[1], m_pass);
+    if (!image) {
+        return;
+    }
+
+    // Full-viewport texture; a negative depth lets the helper place the quad
+    // at the volume center's depth.
+    int imageSize[2] = {size[0], size[1]};
+    int imageOrigin[2] = {0, 0};
+    m_display->RenderTexture(volume, renderer, imageSize, imageSize, imageSize, imageOrigin, -1.0f,
+                             static_cast<unsigned char *>(image->GetScalarPointer()));
+}
@@ -0,0 +1,191 @@
+#ifndef CPURAYCASTER_H
+#define CPURAYCASTER_H
+
+#include "preintegration.h"
+#include "vtkImageData.h"
+#include "vtkNew.h"
+#include "vtkSmartPointer.h"
+#include "vtkVolumeMapper.h"
+
+#include <memory>
+#include <vector>
+
+class GradientVolume;
+class vtkCamera;
+class vtkRayCastImageDisplayHelper;
+class vtkVolumeProperty;
+
+/// @brief Refinement passes, cheapest first. Each pass reuses what the previous
+/// pass computed for the same view:
+///  - Preview: every other pixel at twice the sample distance, replicated 2x2;
+///  - FullResolution: the remaining pixels at the same coarse step;
+///  - Final: full sample density, each ray starting just before the coarse
+///    pass's first visible sample.
+enum class RefinePass { Preview, FullResolution, Final };
+
+/// @brief Multi-threaded composite raycaster for machines without a usable GPU.
+///
+/// Rays are cast in 16x16 pixel tiles spread over the worker pool; inside a
+/// tile, neighbouring rays are stepped in turn in small packets. Each ray stops
+/// once it is nearly opaque, and jumps over 8³ macrocells whose scalar range
+/// maps to zero opacity under the current transfer function.
+///
+/// By default each step composites a pre-integrated segment between two
+/// samples rather than a point sample, which keeps thin features at a
+/// larger sample distance.
+///
+/// Rays only enter the crop box when one is set (the mapper's cropping
+/// planes, sub-volume mode), so the cost follows the box, not the volume.
+///
+/// Shading and gradient opacity follow the volume property; the first time
+/// either is enabled the volume's GradientVolume is acquired (and shared).
+///
+/// Output: width x height RGBA (VTK_UNSIGNED_CHAR, premultiplied alpha).
+/// Re-rendering an unchanged view at the same pass returns the cached image.
+class CpuRaycaster
+{
+public:
+    CpuRaycaster() = default;
+    ~CpuRaycaster() = default;
+
+    // Non-copyable — owns VTK pipeline objects with reference semantics.
+    CpuRaycaster(const CpuRaycaster &) = delete;
+    CpuRaycaster &operator=(const CpuRaycaster &) = delete;
+
+    // Macrocell min/max is rebuilt only when the volume (or its MTime) changes.
+    void setInputData(vtkImageData *data);
+    // Transfer functions are re-sampled only when their MTime changes.
+    void setProperty(vtkVolumeProperty *property);
+
+    // false = classic point-sampled transfer function (reference / benchmarks).
+    void setPreIntegration(bool enabled);
+    bool preIntegration() const { return m_preIntegrate; }
+
+    void setSampleDistance(double mm);
+    double sampleDistance() const { return m_sampleDistance; }
+
+    // Rays are clipped to these world bounds (xmin, xmax, ymin, ymax, zmin,
+    // zmax) instead of the whole volume; nullptr removes the crop.
+    void setCropBounds(const double *bounds);
+
+    // Render through a VTK camera at the given viewport size.
+    [[nodiscard]] vtkImageData *render(vtkCamera *camera, int width, int height,
+                                       RefinePass pass = RefinePass::Final);
+    // Render with rays through an inverse view-projection matrix (row-major,
+    // normalized device coordinates → world, near plane at z = -1).
+    [[nodiscard]] vtkImageData *render(const double invViewProj[16], int width, int height,
+                                       RefinePass pass = RefinePass::Final);
+
+    // Samples taken by the last frame; skipped space is not counted.
+    long long lastSampleCount() const { return m_lastSamples; }
+
+    // Output image, tables, macrocells and per-pixel state; the shared
+    // gradient volume is reported separately.
+    [[nodiscard]] size_t memoryBytes() const;
+    [[nodiscard]] size_t gradientBytes() const;
+
+private:
+    /// @brief What a pass result depends on; reuse needs an exact match.
+    struct ViewKey
+    {
+        double invViewProj[16] = {};
+        int width = 0;
+        int height = 0;
+        unsigned long generation = 0; // bumped on volume / transfer function change
+
+        bool operator==(const ViewKey &o) const;
+    };
+
+    /// @brief Lighting inputs; any change invalidates cached passes.
+    struct ShadingState
+    {
+        bool shade = false;
+        bool gradientOpacity = false;
+        double ambient = 0.0;
+        double diffuse = 0.0;
+        double specular = 0.0;
+        double specularPower = 0.0;
+        vtkMTimeType gradientOpacityTime = 0;
+        const GradientVolume *gradients = nullptr;
+
+        bool operator==(const ShadingState &o) const;
+    };
+
+    void buildMacrocells();
+    void updateTables();
+    void updateShading();
+    void correctOpacity(double step);
+
+    vtkImageData *m_imageData = nullptr;
+    vtkMTimeType m_imageTime = 0;
+    vtkVolumeProperty *m_property = nullptr;
+    vtkNew<vtkImageData> m_output;
+
+    double m_sampleDistance = 1.0;
+    long long m_lastSamples = 0;
+    bool m_cropped = false;
+    double m_cropBounds[6] = {};
+
+    // Transfer function table: RGB plus opacity per unit distance, and the
+    // same table with opacity corrected for the step currently marched.
+    std::vector<float> m_baseTable;
+    std::vector<float> m_table;
+    double m_tableRange[2] = {0.0, 1.0};
+    vtkMTimeType m_opacityTime = 0;
+    vtkMTimeType m_colorTime = 0;
+    double m_tableUnitDistance = 0.0;   // ScalarOpacityUnitDistance the table was built for
+    double m_tableSampleDistance = 0.0; // sample distance the table was built for
+    double m_tableStep = 0.0;
+    unsigned long m_generation = 1;
+    bool m_preIntegrate = true;
+    PreIntegrationTable m_preIntegration;
+
+    std::shared_ptr<const GradientVolume> m_gradients;
+    ShadingState m_shading;
+    std::vector<float> m_gradientOpacityTable; // per quantized magnitude level
+
+    // Progressive state: first visible sample depth per pixel (-1 = none),
+    // and the view and pass that produced the current output.
+    std::vector<float> m_hitDepth;
+    ViewKey m_lastKey;
+    RefinePass m_lastPass = RefinePass::Final;
+    bool m_lastValid = false;
+
+    // Scalar min/max per macrocell (including a one-voxel apron on the high
+    // side, so every trilinear sample in the cell lies inside the range),
+    // and whether the cell is fully transparent under the current table.
+    int m_cellDims[3] = {0, 0, 0};
+    std::vector<float> m_cellMin;
+    std::vector<float> m_cellMax;
+    std::vector<unsigned char> m_cellEmpty;
+};
+
+/// @brief Volume mapper that renders through CpuRaycaster and blits the
+/// image into the render window — a drop-in for vtkGPUVolumeRayCastMapper.
+class CpuVolumeMapper : public vtkVolumeMapper
+{
+public:
+    static CpuVolumeMapper *New();
+    vtkTypeMacro(CpuVolumeMapper, vtkVolumeMapper);
+
+    void Render(vtkRenderer *renderer, vtkVolume *volume) override;
+
+    // Pass used by the next Render(); driven by ProgressiveRenderer.
+    void setPass(RefinePass pass) { m_pass = pass; }
+
+    CpuRaycaster &raycaster() { return m_raycaster; }
+
+protected:
+    CpuVolumeMapper();
+    ~CpuVolumeMapper() override = default;
+
+private:
+    CpuVolumeMapper(const CpuVolumeMapper &) = delete;
+    void operator=(const CpuVolumeMapper &) = delete;
+
+    CpuRaycaster m_raycaster;
+    RefinePass m_pass = RefinePass::Final;
+    vtkSmartPointer<vtkRayCastImageDisplayHelper> m_display;
+};
+
+#endif // CPURAYCASTER_H
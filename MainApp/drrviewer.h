@@ -1,9 +1,8 @@
 #ifndef DRRVIEWER_H
 #define DRRVIEWER_H
 
-#include "vtkImageReslice.h"
+#include "projectionviewer.h"
 #include "vtkImageShiftScale.h"
-#include "vtkNew.h"
 
 enum class DrrAxis {
     Sagittal = 0,
@@ -11,24 +10,59 @@ enum class DrrAxis {
     Axial = 2,
 };
 
+/// @brief Digitally reconstructed radiograph: HU shifted to non-negative
+/// attenuation and summed along each ray. Reslicing, caching and scheduling
+/// live in ProjectionViewer.
 class DrrViewer
 {
 public:
-    DrrViewer() = default;
-    ~DrrViewer() = default;
+    using Callback = ProjectionViewer::Callback;
+
+    DrrViewer();
 
     // Non-copyable — owns VTK pipeline objects with reference semantics.
     DrrViewer(const DrrViewer &) = delete;
     DrrViewer &operator=(const DrrViewer &) = delete;
 
-    void setInputData(vtkImageData *data);
+    // sumSpacing: voxel spacing the ray sums are normalized to, for an input
+    // resampled from another volume (nullptr = the input's own spacing). A
+    // DRR then keeps the brightness of the original slices: along a thinner
+    // slab axis every voxel counts for less.
+    void setInputData(vtkImageData *data, const double *sumSpacing = nullptr);
+    // Brick-store input (brick file or compressed bricks): projections run
+    // one brick layer at a time. The store must outlive this viewer or the
+    // next set*Input call.
+    void setBrickedInput(BrickStore *volume);
+    // Bytes the viewer may spend on an axis-permuted input copy (sagittal
+    // rows contiguous); 0 = always reslice the native layout.
+    void setLayoutBudget(size_t bytes) { m_projection.setLayoutBudget(bytes); }
+    // Project only through this box (nullptr = whole volume); read on every view call.
+    void setVolumeOfInterest(const VolumeOfInterest *voi) { m_projection.setVolumeOfInterest(voi); }
+
+    // Recompute the DRR for the given axis on the calling thread.
+    [[nodiscard]] vtkImageData *viewDrr(DrrAxis axis = DrrAxis::Sagittal)
+    {
+        return m_projection.view(static_cast<int>(axis));
+    }
 
-    // Recompute and display the MIP for the given axis.
-    [[nodiscard]] vtkImageData *viewDrr(DrrAxis axis = DrrAxis::Sagittal);
+    // See ProjectionViewer::request() and prefetch().
+    void requestDrr(DrrAxis axis, Callback done) { m_projection.request(static_cast<int>(axis), std::move(done)); }
+    void prefetch() { m_projection.prefetch(); }
+
+    // Bytes held by the float HU-remapped volume and by the reslice output
+    // plus the cached projections.
+    [[nodiscard]] size_t remapBytes() const { return m_projection.prefilterBytes(); }
+    [[nodiscard]] size_t outputBytes() const { return m_projection.outputBytes(); }
+    // Bytes held by the axis-permuted input copy.
+    [[nodiscard]] size_t layoutBytes() const { return m_projection.layoutBytes(); }
 
 private:
-    vtkNew<vtkImageReslice> m_reslice;
-    vtkImageData *m_imageData = nullptr;
+    void setInput(vtkImageData *data, BrickStore *bricked, const double *sumSpacing);
+
     vtkNew<vtkImageShiftScale> m_huRemap;
+    double m_sumSpacing[3] = {1.0, 1.0, 1.0}; // under the projection lock
+    // last: destroyed first, so running projections finish while the
+    // kernel's state is still here
+    ProjectionViewer m_projection;
 };
 #endif // DRRVIEWER_H
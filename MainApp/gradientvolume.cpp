@@ -0,0 +1,199 @@
+#include "gradientvolume.h"
+#include "parallelfor.h"
+#include "vtkImageData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+
+namespace Gradient {
+
+/// @brief Central difference along one axis (one-sided at the faces), in
+/// scalar units per mm.
+template<typename T>
+double difference(const T *v, int i, int size, std::int64_t stride, double spacing)
+{
+    if (size < 2)
+        return 0.0;
+    if (i == 0)
+        return (static_cast<double>(v[stride]) - v[0]) / spacing;
+    if (i == size - 1)
+        return (static_cast<double>(v[0]) - v[-stride]) / spacing;
+    return (static_cast<double>(v[stride]) - v[-stride]) / (2.0 * spacing);
+}
+
+template<typename T>
+void gradientAt(const T *volume, const int dims[3], const double spacing[3], int x, int y, int z, double g[3])
+{
+    const std::int64_t strideY = dims[0];
+    const std::int64_t strideZ = static_cast<std::int64_t>(dims[0]) * dims[1];
+    const T *v = volume + x + y * strideY + z * strideZ;
+    g[0] = difference(v, x, dims[0], 1, spacing[0]);
+    g[1] = difference(v, y, dims[1], strideY, spacing[1]);
+    g[2] = difference(v, z, dims[2], strideZ, spacing[2]);
+}
+
+// Two passes over the volume — the magnitude scale has to be known before
+// anything is quantized, and recomputing a gradient is cheaper than a float
+// side volume.
+template<typename T>
+double pack(const T *volume, const int dims[3], const double spacing[3],
+            std::uint16_t *normals, std::uint8_t *magnitudes)
+{
+    std::vector<double> slabMax(dims[2], 0.0);
+    Parallel::forRange(0, dims[2], 1, [&](int z0, int z1) {
+        for (int z = z0; z < z1; ++z) {
+            double maxSq = 0.0;
+            for (int y = 0; y < dims[1]; ++y) {
+                for (int x = 0; x < dims[0]; ++x) {
+                    double g[3];
+                    gradientAt(volume, dims, spacing, x, y, z, g);
+                    maxSq = std::max(maxSq, g[0] * g[0] + g[1] * g[1] + g[2] * g[2]);
+                }
+            }
+            slabMax[z] = std::sqrt(maxSq);
+        }
+    });
+    const double maxMagnitude = *std::max_element(slabMax.begin(), slabMax.end());
+    const double toLevel = maxMagnitude > 0.0 ? 255.0 / maxMagnitude : 0.0;
+
+    Parallel::forRange(0, dims[2], 1, [&](int z0, int z1) {
+        for (int z = z0; z < z1; ++z) {
+            for (int y = 0; y < dims[1]; ++y) {
+                const size_t row = (static_cast<size_t>(z) * dims[1] + y) * dims[0];
+                for (int x = 0; x < dims[0]; ++x) {
+                    double g[3];
+                    gradientAt(volume, dims, spacing, x, y, z, g);
+                    const double magnitude = std::sqrt(g[0] * g[0] + g[1] * g[1] + g[2] * g[2]);
+                    normals[row + x] = GradientVolume::encodeNormal(g[0], g[1], g[2]);
+                    magnitudes[row + x] = static_cast<std::uint8_t>(std::min(255.0, magnitude * toLevel + 0.5));
+                }
+            }
+        }
+    });
+    return maxMagnitude;
+}
+
+} // namespace Gradient
+
+std::shared_ptr<const GradientVolume> GradientVolume::shared(vtkImageData *image)
+{
+    if (!image || !image->GetScalarPointer())
+        return nullptr;
+
+    struct Entry
+    {
+        vtkMTimeType mtime = 0;
+        std::weak_ptr<const GradientVolume> gradients;
+    };
+    static std::mutex mutex;
+    static std::map<vtkImageData *, Entry> registry;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = registry.begin(); it != registry.end();) {
+        it = it->second.gradients.expired() ? registry.erase(it) : std::next(it);
+    }
+
+    Entry &entry = registry[image];
+    std::shared_ptr<const GradientVolume> gradients = entry.gradients.lock();
+    if (gradients && entry.mtime == image->GetMTime())
+        return gradients;
+
+    auto built = std::make_shared<const GradientVolume>(image);
+    if (!built->isValid()) {
+        registry.erase(image);
+        return nullptr;
+    }
+    entry.mtime = image->GetMTime();
+    entry.gradients = built;
+    return built;
+}
+
+GradientVolume::GradientVolume(vtkImageData *image)
+{
+    if (!image || !image->GetScalarPointer())
+        return;
+
+    int dims[3];
+    double spacing[3];
+    image->GetDimensions(dims);
+    image->GetSpacing(spacing);
+    const size_t voxels = static_cast<size_t>(dims[0]) * dims[1] * dims[2];
+    if (voxels == 0)
+        return;
+    m_normals.resize(voxels);
+    m_magnitudes.resize(voxels);
+
+    const void *in = image->GetScalarPointer();
+    switch (image->GetScalarType()) {
+    case VTK_SHORT:
+        m_maxMagnitude = Gradient::pack(static_cast<const short *>(in), dims, spacing, m_normals.data(), m_magnitudes.data());
+        break;
+    case VTK_UNSIGNED_SHORT:
+        m_maxMagnitude = Gradient::pack(static_cast<const unsigned short *>(in), dims, spacing, m_normals.data(), m_magnitudes.data());
+        break;
+    case VTK_INT:
+        m_maxMagnitude = Gradient::pack(static_cast<const int *>(in), dims, spacing, m_normals.data(), m_magnitudes.data());
+        break;
+    case VTK_FLOAT:
+        m_maxMagnitude = Gradient::pack(static_cast<const float *>(in), dims, spacing, m_normals.data(), m_magnitudes.data());
+        break;
+    case VTK_DOUBLE:
+        m_maxMagnitude = Gradient::pack(static_cast<const double *>(in), dims, spacing, m_normals.data(), m_magnitudes.data());
+        break;
+    default:
+        m_normals.clear(); // unsupported voxel type: stays invalid
+        m_magnitudes.clear();
+        return;
+    }
+    std::copy(dims, dims + 3, m_dims);
+}
+
+// Octahedral mapping: project onto |x| + |y| + |z| = 1, fold the lower half
+// over the diagonals, quantize (x, y) to 8 bits each.
+std::uint16_t GradientVolume::encodeNormal(double x, double y, double z)
+{
+    const double l1 = std::abs(x) + std::abs(y) + std::abs(z);
+    if (l1 <= 0.0)
+        return encodeNormal(0.0, 0.0, 1.0);
+    x /= l1;
+    y /= l1;
+    if (z < 0.0) {
+        const double fx = (1.0 - std::abs(y)) * (x >= 0.0 ? 1.0 : -1.0);
+        const double fy = (1.0 - std::abs(x)) * (y >= 0.0 ? 1.0 : -1.0);
+        x = fx;
+        y = fy;
+    }
+    const auto u = static_cast<std::uint16_t>(std::lround((x * 0.5 + 0.5) * 255.0));
+    const auto v = static_cast<std::uint16_t>(std::lround((y * 0.5 + 0.5) * 255.0));
+    return static_cast<std::uint16_t>(u | (v << 8));
+}
+
+void GradientVolume::decodeNormal(std::uint16_t code, float n[3])
+{
+    float x = (code & 0xff) * (2.0f / 255.0f) - 1.0f;
+    float y = (code >> 8) * (2.0f / 255.0f) - 1.0f;
+    const float z = 1.0f - std::abs(x) - std::abs(y);
+    if (z < 0.0f) {
+        const float fx = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float fy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    const float length = std::sqrt(x * x + y * y + z * z);
+    n[0] = x / length;
+    n[1] = y / length;
+    n[2] = z / length;
+}
+
+const float *GradientVolume::normalTable()
+{
+    static const std::vector<float> table = [] {
+        std::vector<float> normals(65536 * 3);
+        for (int code = 0; code < 65536; ++code)
+            decodeNormal(static_cast<std::uint16_t>(code), normals.data() + code * 3);
+        return normals;
+    }();
+    return table.data();
+}
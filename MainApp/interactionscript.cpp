@@ -0,0 +1,199 @@
+#include "interactionscript.h"
+#include "vtkCommand.h"
+#include "vtkRenderWindowInteractor.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace Script {
+
+struct TypeInfo
+{
+    InteractionEvent::Type type;
+    const char *name;
+    unsigned long vtkEvent; // 0 = replay directive
+};
+
+static constexpr TypeInfo kTypes[] = {
+    {InteractionEvent::Type::Move, "move", vtkCommand::MouseMoveEvent},
+    {InteractionEvent::Type::LeftPress, "left-press", vtkCommand::LeftButtonPressEvent},
+    {InteractionEvent::Type::LeftRelease, "left-release", vtkCommand::LeftButtonReleaseEvent},
+    {InteractionEvent::Type::MiddlePress, "middle-press", vtkCommand::MiddleButtonPressEvent},
+    {InteractionEvent::Type::MiddleRelease, "middle-release", vtkCommand::MiddleButtonReleaseEvent},
+    {InteractionEvent::Type::RightPress, "right-press", vtkCommand::RightButtonPressEvent},
+    {InteractionEvent::Type::RightRelease, "right-release", vtkCommand::RightButtonReleaseEvent},
+    {InteractionEvent::Type::WheelForward, "wheel-forward", vtkCommand::MouseWheelForwardEvent},
+    {InteractionEvent::Type::WheelBackward, "wheel-backward", vtkCommand::MouseWheelBackwardEvent},
+    {InteractionEvent::Type::KeyPress, "key", vtkCommand::KeyPressEvent},
+    {InteractionEvent::Type::Mode, "mode", 0},
+};
+
+static const TypeInfo *find(InteractionEvent::Type type)
+{
+    for (const TypeInfo &info : kTypes) {
+        if (info.type == type)
+            return &info;
+    }
+    return nullptr;
+}
+
+} // namespace Script
+
+const char *InteractionScript::typeName(InteractionEvent::Type type)
+{
+    const Script::TypeInfo *info = Script::find(type);
+    return info ? info->name : "?";
+}
+
+bool InteractionScript::parseType(const std::string &name, InteractionEvent::Type &type)
+{
+    for (const Script::TypeInfo &info : Script::kTypes) {
+        if (name == info.name) {
+            type = info.type;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool InteractionScript::load(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    std::vector<InteractionEvent> events;
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        std::istringstream fields(line);
+        InteractionEvent event;
+        std::string type;
+        int ctrl = 0;
+        int shift = 0;
+        if (!(fields >> event.timeMs >> type))
+            continue; // blank line
+        if (!parseType(type, event.type) || !(fields >> event.x >> event.y >> ctrl >> shift)) {
+            return false; // Fail fast — a half-read script replays something else
+        }
+        event.ctrl = ctrl != 0;
+        event.shift = shift != 0;
+        fields >> event.key;
+        events.push_back(event);
+    }
+    m_events = std::move(events);
+    return true;
+}
+
+bool InteractionScript::save(const std::string &path) const
+{
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << "# timeMs type x y ctrl shift [key]\n";
+    for (const InteractionEvent &event : m_events) {
+        out << event.timeMs << ' ' << typeName(event.type) << ' ' << event.x << ' ' << event.y << ' '
+            << (event.ctrl ? 1 : 0) << ' ' << (event.shift ? 1 : 0);
+        if (!event.key.empty())
+            out << ' ' << event.key;
+        out << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+void InteractionScript::dispatch(vtkRenderWindowInteractor *interactor, const InteractionEvent &event)
+{
+    const Script::TypeInfo *info = Script::find(event.type);
+    if (!interactor || !info || info->vtkEvent == 0) {
+        return;
+    }
+    const char keyCode = event.key.size() == 1 ? event.key[0] : 0;
+    interactor->SetEventInformation(event.x, event.y, event.ctrl ? 1 : 0, event.shift ? 1 : 0, keyCode, 0,
+                                    event.key.empty() ? nullptr : event.key.c_str());
+    interactor->InvokeEvent(info->vtkEvent, nullptr);
+}
+
+// ---------------------------------------------------------------------------
+// InteractionRecorder
+// ---------------------------------------------------------------------------
+
+InteractionRecorder::~InteractionRecorder()
+{
+    stop();
+}
+
+void InteractionRecorder::start(vtkRenderWindowInteractor *interactor, const std::string &path)
+{
+    stop();
+    if (!interactor) {
+        return;
+    }
+    m_interactor = interactor;
+    m_path = path;
+    m_script.clear();
+    m_start = std::chrono::steady_clock::now();
+
+    m_callback->SetCallback(InteractionRecorder::onEvent);
+    m_callback->SetClientData(this);
+    for (const Script::TypeInfo &info : Script::kTypes) {
+        // above the style's observers: record arrival, before any handling
+        if (info.vtkEvent != 0)
+            m_observerTags.push_back(interactor->AddObserver(info.vtkEvent, m_callback, 10.0f));
+    }
+}
+
+void InteractionRecorder::stop()
+{
+    if (!m_interactor) {
+        return;
+    }
+    for (unsigned long tag : m_observerTags)
+        m_interactor->RemoveObserver(tag);
+    m_observerTags.clear();
+    m_interactor = nullptr;
+    (void) m_script.save(m_path);
+}
+
+void InteractionRecorder::markMode(const std::string &mode)
+{
+    if (!m_interactor) {
+        return;
+    }
+    InteractionEvent event;
+    event.timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    event.type = InteractionEvent::Type::Mode;
+    event.key = mode;
+    m_script.append(event);
+}
+
+void InteractionRecorder::onEvent(vtkObject * /*caller*/, unsigned long eventId, void *clientData, void * /*callData*/)
+{
+    auto *self = static_cast<InteractionRecorder *>(clientData);
+    vtkRenderWindowInteractor *interactor = self->m_interactor;
+
+    InteractionEvent event;
+    bool known = false;
+    for (const Script::TypeInfo &info : Script::kTypes) {
+        if (info.vtkEvent == eventId) {
+            event.type = info.type;
+            known = true;
+            break;
+        }
+    }
+    if (!known) {
+        return;
+    }
+    event.timeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - self->m_start).count();
+    const int *pos = interactor->GetEventPosition();
+    event.x = pos[0];
+    event.y = pos[1];
+    event.ctrl = interactor->GetControlKey() != 0;
+    event.shift = interactor->GetShiftKey() != 0;
+    if (event.type == InteractionEvent::Type::KeyPress && interactor->GetKeySym())
+        event.key = interactor->GetKeySym();
+    self->m_script.append(event);
+}
@@ -0,0 +1,101 @@
+#ifndef INTERACTIONSCRIPT_H
+#define INTERACTIONSCRIPT_H
+
+#include "vtkCallbackCommand.h"
+#include "vtkNew.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+class vtkRenderWindowInteractor;
+
+/// @brief One interactor event of a recorded or generated session.
+struct InteractionEvent
+{
+    enum class Type {
+        Move,
+        LeftPress,
+        LeftRelease,
+        MiddlePress,
+        MiddleRelease,
+        RightPress,
+        RightRelease,
+        WheelForward,
+        WheelBackward,
+        KeyPress,
+        Mode, // replay directive: style mode ("image", "annotation", "path")
+    };
+
+    double timeMs = 0.0; // since the start of the session
+    Type type = Type::Move;
+    int x = 0; // display coordinates, origin bottom-left
+    int y = 0;
+    bool ctrl = false;
+    bool shift = false;
+    std::string key; // key sym for KeyPress, mode name for Mode
+};
+
+/// @brief A timed list of interactor events, stored as text.
+///
+/// One event per line, '#' starts a comment:
+///
+///   <timeMs> <type> <x> <y> <ctrl> <shift> [key]
+///
+/// e.g. "416.2 move 312 288 0 0" or "0 mode 0 0 0 0 annotation". Replaying
+/// dispatches each event through the interactor, so the installed style
+/// (SphereInteractorStyle in the slice view) handles it as if it came from Qt.
+class InteractionScript
+{
+public:
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+
+    void append(const InteractionEvent &event) { m_events.push_back(event); }
+    void clear() { m_events.clear(); }
+    const std::vector<InteractionEvent> &events() const { return m_events; }
+
+    // Sets the interactor's event information and invokes the VTK event.
+    // Mode events are not interactor events and are ignored here.
+    static void dispatch(vtkRenderWindowInteractor *interactor, const InteractionEvent &event);
+
+    static const char *typeName(InteractionEvent::Type type);
+    static bool parseType(const std::string &name, InteractionEvent::Type &type);
+
+private:
+    std::vector<InteractionEvent> m_events;
+};
+
+/// @brief Records what an interactor receives into an InteractionScript file.
+///
+/// Observes ahead of the interactor style, so timestamps are arrival times;
+/// the file is written by stop() (or on destruction).
+class InteractionRecorder
+{
+public:
+    InteractionRecorder() = default;
+    ~InteractionRecorder();
+
+    InteractionRecorder(const InteractionRecorder &) = delete;
+    InteractionRecorder &operator=(const InteractionRecorder &) = delete;
+
+    void start(vtkRenderWindowInteractor *interactor, const std::string &path);
+    void stop();
+    bool isRecording() const { return m_interactor != nullptr; }
+
+    // Appends a Mode directive ("image", "annotation", "path") at the current
+    // time, so a replay switches the style the way the user did.
+    void markMode(const std::string &mode);
+
+private:
+    static void onEvent(vtkObject *caller, unsigned long eventId, void *clientData, void *callData);
+
+    vtkRenderWindowInteractor *m_interactor = nullptr;
+    std::vector<unsigned long> m_observerTags;
+    vtkNew<vtkCallbackCommand> m_callback;
+    std::chrono::steady_clock::time_point m_start;
+    std::string m_path;
+    InteractionScript m_script;
+};
+
+#endif // INTERACTIONSCRIPT_H
@@ -0,0 +1,503 @@
+#include "isosurface.h"
+#include "parallelfor.h"
+#include "vtkCellArray.h"
+#include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace Iso {
+
+// Block edge in cells; one octree leaf and one task.
+static constexpr int kBlock = 16;
+
+/// @brief Cube edge `index` runs from `corner` one step along `axis`.
+/// Corner c sits at (c & 1, (c >> 1) & 1, (c >> 2) & 1).
+struct CubeEdge
+{
+    int corner;
+    int axis;
+};
+
+/// @brief Marching-cubes cases: edge triples per triangle for all 256 inside
+/// masks (bit c set = corner c is inside).
+struct CaseTable
+{
+    CubeEdge edges[12];
+    std::array<std::vector<std::uint8_t>, 256> triangles;
+};
+
+/// @brief Triangulate one contour loop (cube edge ids) without diagonals
+/// that lie in a cube face wherever possible: such a diagonal would
+/// duplicate the neighbouring cell's contour segment on that face. Small
+/// polygons (at most 12 corners), so an O(n³) interval DP is fine.
+static void triangulateLoop(const std::vector<int> &loop, const unsigned char faceMask[12],
+                            std::vector<std::uint8_t> &out)
+{
+    const int n = static_cast<int>(loop.size());
+    auto inFace = [&](int i, int j) { return (faceMask[loop[i]] & faceMask[loop[j]]) != 0; };
+    auto diagonalCost = [&](int i, int j) { return (j - i == 1 || (i == 0 && j == n - 1)) ? 0 : (inFace(i, j) ? 1 : 0); };
+
+    std::vector<int> cost(n * n, 0);
+    std::vector<int> split(n * n, -1);
+    for (int length = 2; length < n; ++length) {
+        for (int i = 0; i + length < n; ++i) {
+            const int j = i + length;
+            int best = std::numeric_limits<int>::max();
+            for (int k = i + 1; k < j; ++k) {
+                const int c = cost[i * n + k] + cost[k * n + j] + diagonalCost(i, k) + diagonalCost(k, j);
+                if (c < best) {
+                    best = c;
+                    split[i * n + j] = k;
+                }
+            }
+            cost[i * n + j] = best;
+        }
+    }
+
+    // Emit triangles of [0, n-1] recursively; winding matches the loop's
+    // reversed order (normals point from inside to outside).
+    std::vector<std::pair<int, int>> stack = {{0, n - 1}};
+    while (!stack.empty()) {
+        const auto [i, j] = stack.back();
+        stack.pop_back();
+        if (j - i < 2)
+            continue;
+        const int k = split[i * n + j];
+        out.push_back(static_cast<std::uint8_t>(loop[i]));
+        out.push_back(static_cast<std::uint8_t>(loop[j]));
+        out.push_back(static_cast<std::uint8_t>(loop[k]));
+        stack.push_back({i, k});
+        stack.push_back({k, j});
+    }
+}
+
+// The triangulation is derived rather than typed in. On each cube face the
+// contour runs from every edge where the inside is left (walking the face
+// counter-clockwise seen from outside) back to the edge where that inside run
+// began; the face segments chain into closed loops. A face with two diagonal
+// inside corners keeps them separate — the choice depends on that face
+// alone, so neighbouring cells agree and the surface stays watertight.
+static CaseTable buildCaseTable()
+{
+    CaseTable table;
+    int edgeOf[8][8];
+    int count = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        for (int corner = 0; corner < 8; ++corner) {
+            if (corner & (1 << axis))
+                continue;
+            table.edges[count] = {corner, axis};
+            edgeOf[corner][corner | (1 << axis)] = count;
+            edgeOf[corner | (1 << axis)][corner] = count;
+            ++count;
+        }
+    }
+
+    // Face corners, counter-clockwise seen from outside.
+    int faces[6][4];
+    for (int axis = 0; axis < 3; ++axis) {
+        const int u = 1 << ((axis + 1) % 3);
+        const int v = 1 << ((axis + 2) % 3);
+        const int a = 1 << axis;
+        const int high[4] = {a, a | u, a | u | v, a | v};
+        const int low[4] = {0, v, u | v, u};
+        std::copy(high, high + 4, faces[axis * 2]);
+        std::copy(low, low + 4, faces[axis * 2 + 1]);
+    }
+    unsigned char faceMask[12] = {}; // faces each edge lies on
+    for (int f = 0; f < 6; ++f)
+        for (int k = 0; k < 4; ++k)
+            faceMask[edgeOf[faces[f][k]][faces[f][(k + 1) % 4]]] |= static_cast<unsigned char>(1 << f);
+
+    for (int mask = 1; mask < 255; ++mask) {
+        auto inside = [mask](int corner) { return (mask >> corner) & 1; };
+        int next[12];
+        std::fill(next, next + 12, -1);
+        for (const auto &face : faces) {
+            for (int k = 0; k < 4; ++k) {
+                if (!inside(face[k]) || inside(face[(k + 1) % 4]))
+                    continue;
+                // walk back to the entry edge of this inside run
+                int j = (k + 3) % 4;
+                while (inside(face[j]))
+                    j = (j + 3) % 4;
+                next[edgeOf[face[k]][face[(k + 1) % 4]]] = edgeOf[face[j]][face[(j + 1) % 4]];
+            }
+        }
+
+        bool used[12] = {};
+        for (int start = 0; start < 12; ++start) {
+            if (next[start] < 0 || used[start])
+                continue;
+            std::vector<int> loop;
+            for (int e = start; !used[e]; e = next[e]) {
+                used[e] = true;
+                loop.push_back(e);
+            }
+            triangulateLoop(loop, faceMask, table.triangles[mask]);
+        }
+    }
+    return table;
+}
+
+static const CaseTable &caseTable()
+{
+    static const CaseTable table = buildCaseTable();
+    return table;
+}
+
+/// @brief Volume geometry shared by the kernels; no VTK calls inside loops.
+struct Grid
+{
+    int dims[3];
+    double spacing[3];
+    double origin[3];
+    int blockDims[3];
+    std::int64_t stride[3]; // voxel index step per axis
+};
+
+template<typename T>
+void blockRanges(const T *volume, const Grid &g, float *blockMin, float *blockMax)
+{
+    Parallel::forRange(0, g.blockDims[2], 1, [&](int bz0, int bz1) {
+        for (int bz = bz0; bz < bz1; ++bz) {
+            for (int by = 0; by < g.blockDims[1]; ++by) {
+                for (int bx = 0; bx < g.blockDims[0]; ++bx) {
+                    // every corner of the block's cells
+                    const int x1 = std::min((bx + 1) * kBlock, g.dims[0] - 1);
+                    const int y1 = std::min((by + 1) * kBlock, g.dims[1] - 1);
+                    const int z1 = std::min((bz + 1) * kBlock, g.dims[2] - 1);
+                    float lo = std::numeric_limits<float>::max();
+                    float hi = std::numeric_limits<float>::lowest();
+                    for (int z = bz * kBlock; z <= z1; ++z) {
+                        for (int y = by * kBlock; y <= y1; ++y) {
+                            const T *row = volume + y * g.stride[1] + z * g.stride[2];
+                            for (int x = bx * kBlock; x <= x1; ++x) {
+                                lo = std::min(lo, static_cast<float>(row[x]));
+                                hi = std::max(hi, static_cast<float>(row[x]));
+                            }
+                        }
+                    }
+                    const size_t id = bx + static_cast<size_t>(g.blockDims[0]) * (by + static_cast<size_t>(g.blockDims[1]) * bz);
+                    blockMin[id] = lo;
+                    blockMax[id] = hi;
+                }
+            }
+        }
+    });
+}
+
+/// @brief Scalar gradient (per mm) at a voxel; one-sided at the faces.
+template<typename T>
+void gradientAt(const T *volume, const Grid &g, const int p[3], float out[3])
+{
+    const T *v = volume + p[0] + p[1] * g.stride[1] + p[2] * g.stride[2];
+    for (int i = 0; i < 3; ++i) {
+        const std::int64_t s = g.stride[i];
+        if (p[i] == 0)
+            out[i] = static_cast<float>((static_cast<double>(v[s]) - v[0]) / g.spacing[i]);
+        else if (p[i] == g.dims[i] - 1)
+            out[i] = static_cast<float>((static_cast<double>(v[0]) - v[-s]) / g.spacing[i]);
+        else
+            out[i] = static_cast<float>((static_cast<double>(v[s]) - v[-s]) / (2.0 * g.spacing[i]));
+    }
+}
+
+/// @brief Triangulate one block: vertices on the crossing edges it owns
+/// (those starting at its voxels), triangles for its cells.
+template<typename T>
+void extractBlock(const T *volume, const Grid &g, int block, float iso, IsoSurfaceExtractor::BlockMesh &mesh)
+{
+    mesh.edgeIds.clear();
+    mesh.points.clear();
+    mesh.normals.clear();
+    mesh.triangles.clear();
+
+    const int b[3] = {block % g.blockDims[0], (block / g.blockDims[0]) % g.blockDims[1],
+                      block / (g.blockDims[0] * g.blockDims[1])};
+    int lo[3], cellEnd[3], voxelEnd[3];
+    for (int i = 0; i < 3; ++i) {
+        lo[i] = b[i] * kBlock;
+        cellEnd[i] = std::min(lo[i] + kBlock, g.dims[i] - 1);
+        // the last block also owns the far face of the volume
+        voxelEnd[i] = b[i] == g.blockDims[i] - 1 ? g.dims[i] : lo[i] + kBlock;
+    }
+
+    int p[3];
+    for (p[2] = lo[2]; p[2] < voxelEnd[2]; ++p[2]) {
+        for (p[1] = lo[1]; p[1] < voxelEnd[1]; ++p[1]) {
+            for (p[0] = lo[0]; p[0] < voxelEnd[0]; ++p[0]) {
+                const std::int64_t voxel = p[0] + p[1] * g.stride[1] + p[2] * g.stride[2];
+                const float a = static_cast<float>(volume[voxel]);
+                for (int axis = 0; axis < 3; ++axis) {
+                    if (p[axis] + 1 >= g.dims[axis])
+                        continue;
+                    const float c = static_cast<float>(volume[voxel + g.stride[axis]]);
+                    if ((a >= iso) == (c >= iso))
+                        continue;
+
+                    const float t = (iso - a) / (c - a);
+                    int q[3] = {p[0], p[1], p[2]};
+                    ++q[axis];
+                    float ga[3], gc[3];
+                    gradientAt(volume, g, p, ga);
+                    gradientAt(volume, g, q, gc);
+                    float n[3];
+                    for (int i = 0; i < 3; ++i) {
+                        const double along = i == axis ? t : 0.0;
+                        mesh.points.push_back(static_cast<float>(g.origin[i] + (p[i] + along) * g.spacing[i]));
+                        n[i] = -(ga[i] + t * (gc[i] - ga[i])); // outward: toward lower values
+                    }
+                    const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                    for (int i = 0; i < 3; ++i)
+                        mesh.normals.push_back(length > 0.0f ? n[i] / length : 0.0f);
+                    mesh.edgeIds.push_back(static_cast<std::uint64_t>(voxel) * 3 + axis);
+                }
+            }
+        }
+    }
+
+    const CaseTable &table = caseTable();
+    for (p[2] = lo[2]; p[2] < cellEnd[2]; ++p[2]) {
+        for (p[1] = lo[1]; p[1] < cellEnd[1]; ++p[1]) {
+            for (p[0] = lo[0]; p[0] < cellEnd[0]; ++p[0]) {
+                const std::int64_t base = p[0] + p[1] * g.stride[1] + p[2] * g.stride[2];
+                int mask = 0;
+                for (int corner = 0; corner < 8; ++corner) {
+                    const std::int64_t voxel = base + (corner & 1) + ((corner >> 1) & 1) * g.stride[1]
+                                               + (corner >> 2) * g.stride[2];
+                    mask |= (volume[voxel] >= iso ? 1 : 0) << corner;
+                }
+                for (std::uint8_t e : table.triangles[mask]) {
+                    const CubeEdge &edge = table.edges[e];
+                    const std::int64_t voxel = base + (edge.corner & 1) + ((edge.corner >> 1) & 1) * g.stride[1]
+                                               + (edge.corner >> 2) * g.stride[2];
+                    mesh.triangles.push_back(static_cast<std::uint64_t>(voxel) * 3 + edge.axis);
+                }
+            }
+        }
+    }
+}
+
+} // namespace Iso
+
+void IsoSurfaceExtractor::setInputData(vtkImageData *data)
+{
+    if (data == m_imageData && (!data || data->GetMTime() == m_imageTime))
+        return;
+    m_imageData = data;
+    m_imageTime = data ? data->GetMTime() : 0;
+    buildOctree();
+}
+
+void IsoSurfaceExtractor::buildOctree()
+{
+    m_levels.clear();
+    m_blocks.clear();
+    std::fill(m_blockDims, m_blockDims + 3, 0);
+    if (!m_imageData || !m_imageData->GetScalarPointer())
+        return;
+
+    int dims[3];
+    m_imageData->GetDimensions(dims);
+    if (dims[0] < 2 || dims[1] < 2 || dims[2] < 2)
+        return;
+
+    Iso::Grid g;
+    std::copy(dims, dims + 3, g.dims);
+    for (int i = 0; i < 3; ++i)
+        m_blockDims[i] = g.blockDims[i] = (dims[i] - 1 + Iso::kBlock - 1) / Iso::kBlock;
+    g.stride[0] = 1;
+    g.stride[1] = dims[0];
+    g.stride[2] = static_cast<std::int64_t>(dims[0]) * dims[1];
+
+    Level leaves;
+    std::copy(m_blockDims, m_blockDims + 3, leaves.dims);
+    const size_t blocks = static_cast<size_t>(m_blockDims[0]) * m_blockDims[1] * m_blockDims[2];
+    leaves.min.resize(blocks);
+    leaves.max.resize(blocks);
+
+    const void *in = m_imageData->GetScalarPointer();
+    switch (m_imageData->GetScalarType()) {
+    case VTK_SHORT:
+        Iso::blockRanges(static_cast<const short *>(in), g, leaves.min.data(), leaves.max.data());
+        break;
+    case VTK_UNSIGNED_SHORT:
+        Iso::blockRanges(static_cast<const unsigned short *>(in), g, leaves.min.data(), leaves.max.data());
+        break;
+    case VTK_INT:
+        Iso::blockRanges(static_cast<const int *>(in), g, leaves.min.data(), leaves.max.data());
+        break;
+    case VTK_FLOAT:
+        Iso::blockRanges(static_cast<const float *>(in), g, leaves.min.data(), leaves.max.data());
+        break;
+    case VTK_DOUBLE:
+        Iso::blockRanges(static_cast<const double *>(in), g, leaves.min.data(), leaves.max.data());
+        break;
+    default:
+        return; // unsupported voxel type: extract() yields nothing
+    }
+    m_levels.push_back(std::move(leaves));
+    m_blocks.resize(blocks);
+
+    // Parents halve each axis until one root node remains.
+    while (m_levels.back().dims[0] > 1 || m_levels.back().dims[1] > 1 || m_levels.back().dims[2] > 1) {
+        const Level &child = m_levels.back();
+        Level parent;
+        for (int i = 0; i < 3; ++i)
+            parent.dims[i] = (child.dims[i] + 1) / 2;
+        const size_t nodes = static_cast<size_t>(parent.dims[0]) * parent.dims[1] * parent.dims[2];
+        parent.min.assign(nodes, std::numeric_limits<float>::max());
+        parent.max.assign(nodes, std::numeric_limits<float>::lowest());
+        for (int z = 0; z < child.dims[2]; ++z) {
+            for (int y = 0; y < child.dims[1]; ++y) {
+                for (int x = 0; x < child.dims[0]; ++x) {
+                    const size_t c = x + static_cast<size_t>(child.dims[0]) * (y + static_cast<size_t>(child.dims[1]) * z);
+                    const size_t p = x / 2 + static_cast<size_t>(parent.dims[0]) * (y / 2 + static_cast<size_t>(parent.dims[1]) * (z / 2));
+                    parent.min[p] = std::min(parent.min[p], child.min[c]);
+                    parent.max[p] = std::max(parent.max[p], child.max[c]);
+                }
+            }
+        }
+        m_levels.push_back(std::move(parent));
+    }
+}
+
+void IsoSurfaceExtractor::collectActive(int level, int x, int y, int z, float iso)
+{
+    const Level &node = m_levels[level];
+    const size_t id = x + static_cast<size_t>(node.dims[0]) * (y + static_cast<size_t>(node.dims[1]) * z);
+    // a cell crosses the surface only if some corner is inside and some is not
+    if (!(node.min[id] < iso && node.max[id] >= iso))
+        return;
+    if (level == 0) {
+        m_active.push_back(static_cast<int>(id));
+        return;
+    }
+    const Level &child = m_levels[level - 1];
+    for (int cz = 2 * z; cz < std::min(2 * z + 2, child.dims[2]); ++cz)
+        for (int cy = 2 * y; cy < std::min(2 * y + 2, child.dims[1]); ++cy)
+            for (int cx = 2 * x; cx < std::min(2 * x + 2, child.dims[0]); ++cx)
+                collectActive(level - 1, cx, cy, cz, iso);
+}
+
+vtkPolyData *IsoSurfaceExtractor::extract(double isoValue)
+{
+    if (!m_imageData) {
+        return nullptr; // Fail fast — caller forgot setInputData()
+    }
+    setInputData(m_imageData); // picks up in-place edits of the volume
+
+    const float iso = static_cast<float>(isoValue);
+    m_active.clear();
+    if (!m_levels.empty())
+        collectActive(static_cast<int>(m_levels.size()) - 1, 0, 0, 0, iso);
+
+    Iso::Grid g;
+    m_imageData->GetDimensions(g.dims);
+    m_imageData->GetSpacing(g.spacing);
+    m_imageData->GetOrigin(g.origin);
+    std::copy(m_blockDims, m_blockDims + 3, g.blockDims);
+    g.stride[0] = 1;
+    g.stride[1] = g.dims[0];
+    g.stride[2] = static_cast<std::int64_t>(g.dims[0]) * g.dims[1];
+
+    auto extractActive = [&](auto *volume) {
+        Parallel::forRange(0, static_cast<int>(m_active.size()), 1, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i)
+                Iso::extractBlock(volume, g, m_active[i], iso, m_blocks[m_active[i]]);
+        });
+    };
+    const void *in = m_imageData->GetScalarPointer();
+    switch (m_imageData->GetScalarType()) {
+    case VTK_SHORT:
+        extractActive(static_cast<const short *>(in));
+        break;
+    case VTK_UNSIGNED_SHORT:
+        extractActive(static_cast<const unsigned short *>(in));
+        break;
+    case VTK_INT:
+        extractActive(static_cast<const int *>(in));
+        break;
+    case VTK_FLOAT:
+        extractActive(static_cast<const float *>(in));
+        break;
+    case VTK_DOUBLE:
+        extractActive(static_cast<const double *>(in));
+        break;
+    default:
+        m_active.clear(); // unsupported voxel type: empty surface
+        break;
+    }
+
+    // Number vertices block by block; triangles follow the same order.
+    std::int64_t vertexCount = 0;
+    std::vector<std::int64_t> firstTriangle(m_active.size() + 1, 0);
+    for (size_t i = 0; i < m_active.size(); ++i) {
+        BlockMesh &mesh = m_blocks[m_active[i]];
+        mesh.firstVertex = vertexCount;
+        vertexCount += static_cast<std::int64_t>(mesh.edgeIds.size());
+        firstTriangle[i + 1] = firstTriangle[i] + static_cast<std::int64_t>(mesh.triangles.size() / 3);
+    }
+    const std::int64_t triangleCount = firstTriangle.back();
+
+    vtkNew<vtkFloatArray> coords;
+    coords->SetNumberOfComponents(3);
+    coords->SetNumberOfTuples(vertexCount);
+    vtkNew<vtkFloatArray> normals;
+    normals->SetName("Normals");
+    normals->SetNumberOfComponents(3);
+    normals->SetNumberOfTuples(vertexCount);
+    vtkNew<vtkIdTypeArray> connectivity;
+    connectivity->SetNumberOfValues(triangleCount * 4);
+
+    // An edge's owner block is the one holding its start voxel — always
+    // active, since one of its cells uses the edge.
+    auto vertexOf = [&](std::uint64_t edgeId) -> vtkIdType {
+        const std::int64_t voxel = static_cast<std::int64_t>(edgeId / 3);
+        const int x = static_cast<int>(voxel % g.dims[0]);
+        const int y = static_cast<int>((voxel / g.dims[0]) % g.dims[1]);
+        const int z = static_cast<int>(voxel / g.stride[2]);
+        const int block = std::min(x / Iso::kBlock, g.blockDims[0] - 1)
+                          + g.blockDims[0] * (std::min(y / Iso::kBlock, g.blockDims[1] - 1)
+                                              + g.blockDims[1] * std::min(z / Iso::kBlock, g.blockDims[2] - 1));
+        const BlockMesh &owner = m_blocks[block];
+        const auto it = std::lower_bound(owner.edgeIds.begin(), owner.edgeIds.end(), edgeId);
+        return static_cast<vtkIdType>(owner.firstVertex + (it - owner.edgeIds.begin()));
+    };
+
+    float *coordOut = coords->GetPointer(0);
+    float *normalOut = normals->GetPointer(0);
+    vtkIdType *cellOut = connectivity->GetPointer(0);
+    Parallel::forRange(0, static_cast<int>(m_active.size()), 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const BlockMesh &mesh = m_blocks[m_active[i]];
+            std::copy(mesh.points.begin(), mesh.points.end(), coordOut + mesh.firstVertex * 3);
+            std::copy(mesh.normals.begin(), mesh.normals.end(), normalOut + mesh.firstVertex * 3);
+            vtkIdType *cell = cellOut + firstTriangle[i] * 4;
+            for (size_t t = 0; t < mesh.triangles.size(); t += 3) {
+                *cell++ = 3;
+                *cell++ = vertexOf(mesh.triangles[t]);
+                *cell++ = vertexOf(mesh.triangles[t + 1]);
+                *cell++ = vertexOf(mesh.triangles[t + 2]);
+            }
+        }
+    });
+
+    vtkNew<vtkPoints> points;
+    points->SetData(coords);
+    vtkNew<vtkCellArray> polys;
+    polys->SetCells(triangleCount, connectivity);
+
+    m_output->Initialize();
+    m_output->SetPoints(points);
+    m_output->SetPolys(polys);
+    m_output->GetPointData()->SetNormals(normals);
+    return m_output;
+}
@@ -0,0 +1,76 @@
+#ifndef ISOSURFACE_H
+#define ISOSURFACE_H
+
+#include "vtkImageData.h"
+#include "vtkNew.h"
+#include "vtkPolyData.h"
+
+#include <cstdint>
+#include <vector>
+
+/// @brief Multi-threaded marching-cubes isosurface with a min/max octree.
+///
+/// The volume is split into 16³-cell blocks whose scalar ranges form the
+/// leaves of an octree, built once per volume. An extraction walks the tree
+/// and only visits blocks whose range straddles the iso value; those are
+/// triangulated in parallel. Every vertex is owned by the grid edge it lies
+/// on, so neighbouring cells and blocks share it — the output is an indexed,
+/// watertight mesh with normals from the scalar gradient.
+///
+/// Dragging the iso value re-runs extract(): the cost follows the number of
+/// straddling blocks, and per-block buffers are kept between calls.
+class IsoSurfaceExtractor
+{
+public:
+    IsoSurfaceExtractor() = default;
+    ~IsoSurfaceExtractor() = default;
+
+    // Non-copyable — owns VTK pipeline objects with reference semantics.
+    IsoSurfaceExtractor(const IsoSurfaceExtractor &) = delete;
+    IsoSurfaceExtractor &operator=(const IsoSurfaceExtractor &) = delete;
+
+    // The octree is rebuilt only when the volume (or its MTime) changes.
+    void setInputData(vtkImageData *data);
+
+    // Surface where the scalar crosses `isoValue` (inside: value >= isoValue).
+    // Points in world coordinates with point normals; triangles only.
+    [[nodiscard]] vtkPolyData *extract(double isoValue);
+
+    int blockCount() const { return static_cast<int>(m_blocks.size()); }
+    // Blocks visited by the last extract().
+    int lastActiveBlocks() const { return static_cast<int>(m_active.size()); }
+
+    /// @brief One block's share of the mesh, in global edge ids until the
+    /// vertices are numbered.
+    struct BlockMesh
+    {
+        std::vector<std::uint64_t> edgeIds; // owned crossing edges, ascending
+        std::vector<float> points;          // xyz per owned edge
+        std::vector<float> normals;
+        std::vector<std::uint64_t> triangles; // three edge ids each
+        std::int64_t firstVertex = 0;
+    };
+
+private:
+    /// @brief Min/max of every node on one octree level (level 0 = blocks).
+    struct Level
+    {
+        int dims[3] = {0, 0, 0};
+        std::vector<float> min;
+        std::vector<float> max;
+    };
+
+    void buildOctree();
+    void collectActive(int level, int x, int y, int z, float iso);
+
+    vtkImageData *m_imageData = nullptr;
+    vtkMTimeType m_imageTime = 0;
+    vtkNew<vtkPolyData> m_output;
+
+    int m_blockDims[3] = {0, 0, 0};
+    std::vector<Level> m_levels;
+    std::vector<BlockMesh> m_blocks;
+    std::vector<int> m_active; // block indices, traversal order
+};
+
+#endif // ISOSURFACE_H
@@ -0,0 +1,288 @@
+#include "isotropicvolume.h"
+#include "parallelfor.h"
+#include "taskscheduler.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace Isotropic {
+
+static constexpr double kTolerance = 0.01;
+
+/// @brief Input taps of every output sample along one axis.
+struct Contributions
+{
+    std::vector<int> first;      // first tap of output j in index/weight
+    std::vector<int> index;      // input sample of each tap
+    std::vector<float> weight;   // normalized weight of each tap
+};
+
+// Catmull-Rom (cubic convolution, a = -0.5): interpolating, support [-2, 2].
+static double kernel(double x)
+{
+    x = std::abs(x);
+    if (x < 1.0)
+        return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0)
+        return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+static int outputCount(int inputCount, double inputSpacing, double spacing)
+{
+    return static_cast<int>(std::floor((inputCount - 1) * inputSpacing / spacing + 1e-6)) + 1;
+}
+
+// `step` input samples per output sample. Downsampling stretches the kernel
+// by `step` so every input sample contributes (no aliasing); taps past the
+// ends are folded onto the edge sample.
+static Contributions contributions(int inputCount, int outputCount, double step)
+{
+    const double scale = std::max(1.0, step);
+    const double support = 2.0 * scale;
+    Contributions c;
+    c.first.reserve(std::size_t(outputCount) + 1);
+    for (int j = 0; j < outputCount; ++j) {
+        c.first.push_back(static_cast<int>(c.index.size()));
+        const double centre = j * step;
+        const int lo = static_cast<int>(std::ceil(centre - support));
+        const int hi = static_cast<int>(std::floor(centre + support));
+        const std::size_t begin = c.index.size();
+        double sum = 0.0;
+        for (int i = lo; i <= hi; ++i) {
+            const double w = kernel((i - centre) / scale);
+            if (w == 0.0)
+                continue;
+            const int clamped = std::clamp(i, 0, inputCount - 1);
+            if (c.index.size() > begin && c.index.back() == clamped) {
+                c.weight.back() += static_cast<float>(w);
+            } else {
+                c.index.push_back(clamped);
+                c.weight.push_back(static_cast<float>(w));
+            }
+            sum += w;
+        }
+        for (std::size_t t = begin; t < c.weight.size(); ++t)
+            c.weight[t] = static_cast<float>(c.weight[t] / sum);
+    }
+    c.first.push_back(static_cast<int>(c.index.size()));
+    return c;
+}
+
+template<typename T>
+static T store(float value)
+{
+    if constexpr (std::is_integral_v<T>) {
+        const float lo = static_cast<float>(std::numeric_limits<T>::lowest());
+        const float hi = static_cast<float>(std::numeric_limits<T>::max());
+        return static_cast<T>(std::lround(std::clamp(value, lo, hi)));
+    } else {
+        return static_cast<T>(value);
+    }
+}
+
+// One separable pass along `axis`: the volume is [outer][dims[axis]][inner]
+// and each output row of `inner` samples is a weighted sum of input rows.
+// Rows are contiguous for y and z, so the inner loop vectorizes; x gathers.
+template<typename TIn, typename TOut>
+static bool pass(const TIn *in, const int dims[3], int axis, const Contributions &c, TOut *out,
+                 const CancelToken *cancel)
+{
+    std::size_t inner = 1;
+    for (int a = 0; a < axis; ++a)
+        inner *= std::size_t(dims[a]);
+    std::size_t outer = 1;
+    for (int a = axis + 1; a < 3; ++a)
+        outer *= std::size_t(dims[a]);
+    const std::size_t count = std::size_t(dims[axis]);
+    const int outCount = static_cast<int>(c.first.size()) - 1;
+
+    if (inner == 1) {
+        // x: one work item per input row, taps gathered along the row
+        Parallel::forRange(0, static_cast<int>(outer), 64, [&](int begin, int end) {
+            if (cancel && cancel->isCancelled())
+                return;
+            for (int o = begin; o < end; ++o) {
+                const TIn *src = in + std::size_t(o) * count;
+                TOut *dst = out + std::size_t(o) * outCount;
+                for (int j = 0; j < outCount; ++j) {
+                    float acc = 0.0f;
+                    for (int t = c.first[j]; t < c.first[j + 1]; ++t)
+                        acc += c.weight[t] * static_cast<float>(src[c.index[t]]);
+                    dst[j] = store<TOut>(acc);
+                }
+            }
+        });
+        return !(cancel && cancel->isCancelled());
+    }
+
+    // y, z: one work item per output row
+    const int items = static_cast<int>(outer) * outCount;
+    const int grain = static_cast<int>(std::max<std::size_t>(1, 16384 / inner));
+    Parallel::forRange(0, items, grain, [&](int begin, int end) {
+        if (cancel && cancel->isCancelled())
+            return;
+        std::vector<float> acc(inner);
+        for (int item = begin; item < end; ++item) {
+            const std::size_t o = std::size_t(item / outCount);
+            const int j = item % outCount;
+            const TIn *src = in + o * count * inner;
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            for (int t = c.first[j]; t < c.first[j + 1]; ++t) {
+                const TIn *row = src + std::size_t(c.index[t]) * inner;
+                const float w = c.weight[t];
+                for (std::size_t k = 0; k < inner; ++k)
+                    acc[k] += w * static_cast<float>(row[k]);
+            }
+            TOut *dst = out + (o * outCount + j) * inner;
+            for (std::size_t k = 0; k < inner; ++k)
+                dst[k] = store<TOut>(acc[k]);
+        }
+    });
+    return !(cancel && cancel->isCancelled());
+}
+
+// Runs the passes in `axes` order: typed input -> float -> ... -> typed
+// output, ping-ponging between two float buffers.
+template<typename T>
+static bool resampleAs(const T *in, const int inDims[3], const int outDims[3], const double step[3],
+                       const std::vector<int> &axes, T *out, const CancelToken *cancel)
+{
+    int dims[3] = {inDims[0], inDims[1], inDims[2]};
+    std::vector<float> buffers[2];
+    const float *src = nullptr;
+    for (std::size_t p = 0; p < axes.size(); ++p) {
+        const int axis = axes[p];
+        const Contributions c = contributions(inDims[axis], outDims[axis], step[axis]);
+        int next[3] = {dims[0], dims[1], dims[2]};
+        next[axis] = outDims[axis];
+        const bool last = p + 1 == axes.size();
+        std::vector<float> &dst = buffers[p % 2];
+        if (!last)
+            dst.resize(std::size_t(next[0]) * next[1] * next[2]);
+
+        bool ok;
+        if (p == 0)
+            ok = last ? pass(in, dims, axis, c, out, cancel) : pass(in, dims, axis, c, dst.data(), cancel);
+        else
+            ok = last ? pass(src, dims, axis, c, out, cancel) : pass(src, dims, axis, c, dst.data(), cancel);
+        if (!ok)
+            return false;
+        if (p > 0)
+            buffers[(p + 1) % 2] = std::vector<float>(); // the pass's input is spent
+        src = dst.data();
+        std::copy(next, next + 3, dims);
+    }
+    return true;
+}
+
+bool isIsotropic(vtkImageData *image)
+{
+    if (!image)
+        return true;
+    const double *spacing = image->GetSpacing();
+    const double lo = std::min({std::abs(spacing[0]), std::abs(spacing[1]), std::abs(spacing[2])});
+    const double hi = std::max({std::abs(spacing[0]), std::abs(spacing[1]), std::abs(spacing[2])});
+    return hi <= lo * (1.0 + kTolerance);
+}
+
+double targetSpacing(vtkImageData *image, std::size_t maxBytes)
+{
+    if (!image)
+        return 1.0;
+    int dims[3];
+    image->GetDimensions(dims);
+    const double *spacing = image->GetSpacing();
+    double target = std::min({std::abs(spacing[0]), std::abs(spacing[1]), std::abs(spacing[2])});
+    if (target <= 0.0)
+        return 1.0;
+
+    const std::size_t voxelBytes = std::size_t(image->GetScalarSize()) * image->GetNumberOfScalarComponents();
+    auto bytesAt = [&](double s) {
+        std::size_t voxels = voxelBytes;
+        for (int a = 0; a < 3; ++a)
+            voxels *= std::size_t(outputCount(dims[a], std::abs(spacing[a]), s));
+        return voxels;
+    };
+    const std::size_t bytes = bytesAt(target);
+    if (bytes > maxBytes && maxBytes > 0) {
+        target *= std::cbrt(double(bytes) / double(maxBytes));
+        while (bytesAt(target) > maxBytes)
+            target *= 1.01; // the voxel counts round, so the cube root can fall just short
+    }
+    return target;
+}
+
+vtkSmartPointer<vtkImageData> resample(vtkImageData *image, double spacing, const CancelToken *cancel)
+{
+    if (!image || spacing <= 0.0 || !image->GetScalarPointer() || image->GetNumberOfScalarComponents() != 1)
+        return nullptr;
+
+    TRACE_SCOPE("isotropic.resample");
+    int dims[3], extent[6];
+    double inSpacing[3], origin[3];
+    image->GetDimensions(dims);
+    image->GetExtent(extent);
+    image->GetSpacing(inSpacing);
+    image->GetOrigin(origin);
+
+    int outDims[3];
+    double step[3], outSpacing[3], outOrigin[3];
+    std::vector<std::pair<double, int>> changed; // (step, axis)
+    for (int a = 0; a < 3; ++a) {
+        outDims[a] = outputCount(dims[a], std::abs(inSpacing[a]), spacing);
+        step[a] = spacing / std::abs(inSpacing[a]);
+        outSpacing[a] = std::copysign(spacing, inSpacing[a]);
+        outOrigin[a] = origin[a] + extent[2 * a] * inSpacing[a]; // first voxel stays put
+        if (outDims[a] != dims[a] || std::abs(step[a] - 1.0) > 1e-6)
+            changed.emplace_back(step[a], a);
+    }
+
+    auto output = vtkSmartPointer<vtkImageData>::New();
+    if (changed.empty()) {
+        output->ShallowCopy(image);
+        return output;
+    }
+    // shrinking axes first: later passes then touch fewer samples
+    std::sort(changed.begin(), changed.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    std::vector<int> axes;
+    for (const auto &axis : changed)
+        axes.push_back(axis.second);
+
+    output->SetExtent(0, outDims[0] - 1, 0, outDims[1] - 1, 0, outDims[2] - 1);
+    output->SetSpacing(outSpacing);
+    output->SetOrigin(outOrigin);
+    output->AllocateScalars(image->GetScalarType(), 1);
+
+    const void *in = image->GetScalarPointer();
+    void *out = output->GetScalarPointer();
+    bool ok;
+    switch (image->GetScalarType()) {
+    case VTK_SHORT:
+        ok = resampleAs(static_cast<const short *>(in), dims, outDims, step, axes, static_cast<short *>(out), cancel);
+        break;
+    case VTK_UNSIGNED_SHORT:
+        ok = resampleAs(static_cast<const unsigned short *>(in), dims, outDims, step, axes,
+                        static_cast<unsigned short *>(out), cancel);
+        break;
+    case VTK_INT:
+        ok = resampleAs(static_cast<const int *>(in), dims, outDims, step, axes, static_cast<int *>(out), cancel);
+        break;
+    case VTK_FLOAT:
+        ok = resampleAs(static_cast<const float *>(in), dims, outDims, step, axes, static_cast<float *>(out), cancel);
+        break;
+    case VTK_DOUBLE:
+        ok = resampleAs(static_cast<const double *>(in), dims, outDims, step, axes, static_cast<double *>(out), cancel);
+        break;
+    default:
+        return nullptr; // unsupported voxel type
+    }
+    return ok ? output : nullptr;
+}
+
+} // namespace Isotropic
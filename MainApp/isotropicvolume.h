@@ -0,0 +1,39 @@
+#ifndef ISOTROPICVOLUME_H
+#define ISOTROPICVOLUME_H
+
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include <cstddef>
+
+class CancelToken;
+
+/// @brief Resampling of anisotropic CT onto a cubic voxel grid.
+///
+/// Axial series are typically 0.7 x 0.7 x 2.5 mm: fine for the slice view,
+/// but projections along x or y then come out with stretched pixels, and
+/// every reslice re-interpolates between thick slices. Resampling once at
+/// load time gives the projection engines a volume they can sample on its
+/// own grid. The filter is separable Catmull-Rom, one parallel pass per axis
+/// that changes, with the kernel widened when an axis is downsampled.
+namespace Isotropic {
+
+// Largest isotropic copy targetSpacing() plans for by default.
+static constexpr std::size_t kDefaultMaxBytes = std::size_t(1) << 30;
+
+// True when the three spacings agree within 1%.
+[[nodiscard]] bool isIsotropic(vtkImageData *image);
+
+// The finest spacing of `image`, coarsened as needed for the resampled copy
+// to fit in `maxBytes`.
+[[nodiscard]] double targetSpacing(vtkImageData *image, std::size_t maxBytes = kDefaultMaxBytes);
+
+// `image` resampled to `spacing` mm on every axis, with the same scalar type
+// and the first voxel at the same world position. A shallow copy when no axis
+// changes; nullptr when cancelled or for an unsupported scalar type.
+[[nodiscard]] vtkSmartPointer<vtkImageData> resample(vtkImageData *image, double spacing,
+                                                     const CancelToken *cancel = nullptr);
+
+} // namespace Isotropic
+
+#endif // ISOTROPICVOLUME_H
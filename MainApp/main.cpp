@@ -1,18 +1,79 @@
 #include <QApplication>
+#include <QEventLoop>
 #include <QSurfaceFormat>
 #include "QVTKOpenGLNativeWidget.h"
 #include "mainwindow.h"
+#include "tracing.h"
 #include <Qdebug>
 
+#include <cstdio>
+
 int main(int argc, char *argv[])
 
 {
-    QApplication a(argc, argv);
+    // The 3D pane's vtkGPUVolumeRayCastMapper needs MSAA off and shared
+    // contexts under QVTKOpenGLNativeWidget (same setup as SandBox).
+    QSurfaceFormat format = QVTKOpenGLNativeWidget::defaultFormat();
+    format.setSamples(0);
+    QSurfaceFormat::setDefaultFormat(format);
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
 
+    QApplication a(argc, argv);
 
+    // --trace <file>: record from startup (series load included) and write
+    // Chrome trace JSON on exit
+    const QStringList args = a.arguments();
+    const int traceArg = args.indexOf("--trace");
+    const QString tracePath = traceArg >= 0 && traceArg + 1 < args.size() ? args.at(traceArg + 1) : QString();
+    if (!tracePath.isEmpty()) {
+        Trace::setThreadName("main");
+        Trace::setEnabled(true);
+    }
 
-    MainWindow w;
+    // --cpu: software raycaster for the 3D pane
+    // --out-of-core: page the series from a brick file instead of decoding it into RAM
+    // --compressed: keep the series in RAM as compressed bricks
+    // --isotropic: MIP/DRR from a cubic-voxel copy of anisotropic series
+    VolumeStorage storage = VolumeStorage::Decoded;
+    if (args.contains("--out-of-core"))
+        storage = VolumeStorage::BrickFile;
+    else if (args.contains("--compressed"))
+        storage = VolumeStorage::Compressed;
+    MainWindow w(args.contains("--cpu"), storage, args.contains("--isotropic"));
+    // --record-interaction <file>: script of the slice-view session for LatencyHarness
+    const int recordArg = args.indexOf("--record-interaction");
+    if (recordArg >= 0 && recordArg + 1 < args.size())
+        w.recordInteraction(args.at(recordArg + 1));
     w.show();
 
-    return a.exec();
+    // --memory-report: print the memory ledger once the series is up and
+    // exit; --memory-budget <MB> also fails (exit 3) when the peak total is
+    // over the budget.
+    const int budgetArg = args.indexOf("--memory-budget");
+    if (args.contains("--memory-report") || budgetArg >= 0) {
+        // the series decodes in the background; wait for the views to be set up
+        if (w.isLoading()) {
+            QEventLoop loop;
+            QObject::connect(&w, &MainWindow::loadFinished, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        QCoreApplication::processEvents(); // first paint: W/L images and textures exist
+        MemoryLedger &ledger = w.memoryLedger();
+        ledger.sample();
+        std::fputs(ledger.report().c_str(), stdout);
+        if (budgetArg >= 0 && budgetArg + 1 < args.size()) {
+            const double budgetMb = args.at(budgetArg + 1).toDouble();
+            const double peakMb = ledger.peakTotalBytes() / (1024.0 * 1024.0);
+            if (peakMb > budgetMb) {
+                std::fprintf(stderr, "memory budget exceeded: peak %.1f MB > %.1f MB\n", peakMb, budgetMb);
+                return 3;
+            }
+        }
+        return 0;
+    }
+
+    const int status = a.exec();
+    if (!tracePath.isEmpty() && !Trace::writeChromeJson(tracePath.toStdString()))
+        qWarning() << "Cannot write trace to" << tracePath;
+    return status;
 }
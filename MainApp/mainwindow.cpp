@@ -1,5 +1,8 @@
 #include "mainwindow.h"
 #include "SphereInteractorStyle.h"
+#include "isotropicvolume.h"
+#include "paralleldicomreader.h"
+#include "tracing.h"
 #include "vtkImageMapToWindowLevelColors.h"
 #include "vtkImageProperty.h" // window/level control for vtkImageActor
 #include "vtkImageReslice.h"  // 2D slab/MIP filter (vtkImagingCore — already linked)
@@ -13,11 +16,14 @@
 // VTK 2D image viewer — purpose-built for medical slice viewing.
 // Internally manages: renderer, image actor, window/level lookup table.
 #include "vtkImageViewer2.h"
+#include "vtkImageActor.h"
+#include "vtkImageMapper3D.h"
 
 // VTK interaction
 #include "vtkRenderWindowInteractor.h"
 #include "vtkInteractorStyleImage.h"
 #include "vtkCallbackCommand.h"
+#include "vtkAlgorithm.h"
 
 #include <QHBoxLayout>
 
@@ -26,6 +32,9 @@
 #include "vtkCoordinate.h"
 #include "vtkImageData.h"
 #include "vtkProperty.h"
+#include "vtkProperty2D.h"
+#include "vtkCellArray.h"
+#include "vtkPoints.h"
 #include "vtkSphereWidget.h"
 
 // VTK utilities
@@ -36,10 +45,18 @@
 #include "vtkDICOMDirectory.h"
 
 #include <QButtonGroup>
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QDir>
+#include <QDockWidget>
+#include <QFileDialog>
+#include <QMenuBar>
+#include <QStandardPaths>
 #include <QStringList>
+#include <QTimer>
 #include <QToolBar>
+#include <QTreeWidget>
+#include <algorithm>
 #include <array>
 
 #include "vtkVolume.h" // 3d actor equivalent
@@ -59,25 +76,61 @@ VTK_MODULE_INIT(vtkRenderingVolumeOpenGL2);
 // MainWindow Implementation
 // ---------------------------------------------------------------------------
 
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(bool cpuRendering, VolumeStorage storage, bool isotropicProjections, QWidget *parent)
     : QMainWindow(parent)
+    , m_storage(storage)
+    , m_isotropic(isotropicProjections)
+    , m_volumeViewer(std::make_unique<VolumeViewer>(cpuRendering))
 {
     setWindowTitle("DICOM Viewer");
     resize(1920, 1080);
 
     setupToolBar();
     setupVTKWidget();
+    setupMemoryPanel();
 
     // Load the DICOM dataset. The path is injected at the call site —
     // loadDicomDirectory() itself is path-agnostic (Dependency Inversion).
     loadDicomDirectory("C:/Users/cdac/Projects/SE2dcm");
 }
 
-MainWindow::~MainWindow() = default;
+MainWindow::~MainWindow()
+{
+    // the cine thread reads the volume and its timer drives the viewer
+    if (m_sphereStyle) {
+        m_sphereStyle->StopCine();
+    }
+    // Worker tasks post back to this window: let them finish (or drop them)
+    // while it is still whole.
+    m_loadToken.cancel();
+    if (m_loadDone.valid()) {
+        m_loadDone.wait();
+    }
+    if (m_resampleDone.valid()) {
+        m_resampleDone.wait();
+    }
+    m_mipViewer.reset();
+    m_drrViewer.reset();
+}
 
 void MainWindow::setupToolBar() {
     QToolBar *toolbar = addToolBar("Tools");
 
+    // Tracing: spans go to per-thread rings while checked; saving writes
+    // Chrome trace JSON (chrome://tracing or ui.perfetto.dev).
+    QMenu *diagnostics = menuBar()->addMenu("&Diagnostics");
+    m_diagnosticsMenu = diagnostics;
+    QAction *recordTrace = diagnostics->addAction("Record Trace");
+    recordTrace->setCheckable(true);
+    recordTrace->setChecked(Trace::isEnabled());
+    connect(recordTrace, &QAction::toggled, this, [](bool enabled) { Trace::setEnabled(enabled); });
+    connect(diagnostics->addAction("Save Trace..."), &QAction::triggered, this, [this] {
+        const QString path = QFileDialog::getSaveFileName(this, "Save Trace", "trace.json", "Chrome trace (*.json)");
+        if (!path.isEmpty() && !Trace::writeChromeJson(path.toStdString()))
+            qWarning() << "Cannot write trace to" << path;
+    });
+    connect(diagnostics->addAction("Clear Trace"), &QAction::triggered, this, [] { Trace::clear(); });
+
     m_annotateButton = new QPushButton("Mark Point", this);
     m_annotateButton->setCheckable(true);
     // m_annotateButton->setChecked(true);
@@ -85,6 +138,30 @@ void MainWindow::setupToolBar() {
             this, &MainWindow::toggleAnnotationMode);
     toolbar->addWidget(m_annotateButton);
 
+    m_obliqueButton = new QPushButton("Oblique", this);
+    m_obliqueButton->setCheckable(true);
+    connect(m_obliqueButton, &QPushButton::toggled,
+            this, &MainWindow::toggleObliqueMode);
+    toolbar->addWidget(m_obliqueButton);
+
+    m_pathButton = new QPushButton("CPR Path", this);
+    m_pathButton->setCheckable(true);
+    connect(m_pathButton, &QPushButton::toggled,
+            this, &MainWindow::togglePathMode);
+    toolbar->addWidget(m_pathButton);
+
+    m_volumeButton = new QPushButton("3D", this);
+    m_volumeButton->setCheckable(true);
+    connect(m_volumeButton, &QPushButton::toggled,
+            this, &MainWindow::toggleVolumeView);
+    toolbar->addWidget(m_volumeButton);
+
+    m_cropButton = new QPushButton("Crop", this);
+    m_cropButton->setCheckable(true);
+    connect(m_cropButton, &QPushButton::toggled,
+            this, &MainWindow::toggleCropBox);
+    toolbar->addWidget(m_cropButton);
+
     toolbar->addSeparator();
 
     m_mipAxisGroup = new QButtonGroup(this);
@@ -107,14 +184,7 @@ void MainWindow::setupToolBar() {
 
     m_mipAxisGroup->button(static_cast<int>(MipAxis::Sagittal))->setChecked(true);
 
-    connect(m_mipAxisGroup, &QButtonGroup::idClicked, this, [this](int id) {
-        m_mipData = m_mipViewer->viewMip(static_cast<MipAxis>(id));
-        if (m_mipData) {
-            m_mipImageViewer->SetInputData(m_mipData);
-            m_mipImageViewer->GetRenderer()->ResetCamera();
-            m_mipImageViewer->Render();
-        }
-    });
+    connect(m_mipAxisGroup, &QButtonGroup::idClicked, this, [this](int) { requestMip(true); });
 
     toolbar->addSeparator();
     m_drrAxisGroup = new QButtonGroup(this);
@@ -130,14 +200,7 @@ void MainWindow::setupToolBar() {
 
     m_drrAxisGroup->button(static_cast<int>(DrrAxis::Sagittal))->setChecked(true);
 
-    connect(m_drrAxisGroup, &QButtonGroup::idClicked, this, [this](int id) {
-        m_drrData = m_drrViewer->viewDrr(static_cast<DrrAxis>(id));
-        if (m_drrData) {
-            m_drrImageViewer->SetInputData(m_drrData);
-            m_drrImageViewer->GetRenderer()->ResetCamera();
-            m_drrImageViewer->Render();
-        }
-    });
+    connect(m_drrAxisGroup, &QButtonGroup::idClicked, this, [this](int) { requestDrr(true); });
 }
 void MainWindow::onDrrWindowLevel(vtkObject *caller,
                                   unsigned long eventId,
@@ -181,25 +244,164 @@ void MainWindow::setupVTKWidget()
     m_vtkWidget = new QVTKOpenGLNativeWidget(container);
     m_mipWidget = new QVTKOpenGLNativeWidget(container);
     m_drrWidget = new QVTKOpenGLNativeWidget(container);
+    m_cprWidget = new QVTKOpenGLNativeWidget(container);
+    m_volumeWidget = new QVTKOpenGLNativeWidget(container);
 
     layout->addWidget(m_vtkWidget, 1);
     layout->addWidget(m_mipWidget, 1);
     layout->addWidget(m_drrWidget, 1);
+    layout->addWidget(m_cprWidget, 1);
+    layout->addWidget(m_volumeWidget, 1);
+    m_cprWidget->setVisible(false); // shown while a CPR path is being drawn
+    m_volumeWidget->setVisible(false); // shown by the 3D button
 
     setCentralWidget(container);
 
     m_vtkWidget->SetRenderWindow(m_renderWindow);
     m_mipWidget->SetRenderWindow(m_mipRenderWindow);
     m_drrWidget->SetRenderWindow(m_drrRenderWindow);
+    m_cprWidget->SetRenderWindow(m_cprRenderWindow);
+    m_volumeWidget->SetRenderWindow(m_volumeRenderWindow);
 
     // m_mipImageViewer->SetRenderWindow(m_mipRenderWindow);
 
+    Trace::observe(m_renderWindow, "render.slice");
+    Trace::observe(m_mipRenderWindow, "render.mip");
+    Trace::observe(m_drrRenderWindow, "render.drr");
+    Trace::observe(m_cprRenderWindow, "render.cpr");
+    Trace::observe(m_volumeRenderWindow, "render.volume");
+
     m_renderWindow->GetInteractor()->Initialize();
     m_mipRenderWindow->GetInteractor()->Initialize();
     m_drrRenderWindow->GetInteractor()->Initialize();
+    m_cprRenderWindow->GetInteractor()->Initialize();
+    m_volumeRenderWindow->GetInteractor()->Initialize();
 
     m_mipViewer = std::make_unique<MipViewer>();
     m_drrViewer = std::make_unique<DrrViewer>();
+    m_obliqueReslicer = std::make_unique<ObliqueReslicer>();
+    m_segmentMeasure = std::make_unique<SegmentMeasure>();
+    m_cprEngine = std::make_unique<CprEngine>();
+    m_volumeViewer->setRenderWindow(m_volumeRenderWindow);
+
+    // Faces only: the VOI stays axis-aligned in volume space.
+    m_voiRepresentation->SetPlaceFactor(1.0);
+    m_voiRepresentation->OutlineCursorWiresOff();
+    m_voiWidget->SetRepresentation(m_voiRepresentation);
+    m_voiWidget->SetInteractor(m_volumeRenderWindow->GetInteractor());
+    m_voiWidget->RotationEnabledOff();
+    m_voiWidget->TranslationEnabledOff();
+    m_voiCallback->SetCallback(MainWindow::onVoiBoxInteraction);
+    m_voiCallback->SetClientData(this);
+    m_voiWidget->AddObserver(vtkCommand::InteractionEvent, m_voiCallback);
+    m_voiWidget->AddObserver(vtkCommand::EndInteractionEvent, m_voiCallback);
+}
+
+void MainWindow::setupMemoryPanel()
+{
+    // Probes read the buffers' current sizes; a missing viewer reports 0.
+    const auto windowLevelBytes = [](vtkImageViewer2 *viewer) {
+        return viewer ? MemoryLedger::dataBytes(viewer->GetWindowLevel()->GetOutput()) : size_t(0);
+    };
+    // image actors upload the W/L output as an RGBA8 texture
+    const auto windowLevelTexture = [](vtkImageViewer2 *viewer) {
+        return viewer ? static_cast<size_t>(viewer->GetWindowLevel()->GetOutput()->GetNumberOfPoints()) * 4
+                      : size_t(0);
+    };
+
+    m_memoryLedger.track("DICOM reader output", MemoryCategory::Volume, [this] {
+        return MemoryLedger::dataBytes(m_dicomReader ? m_dicomReader->GetOutput() : nullptr);
+    });
+    m_memoryLedger.track("Isotropic volume", MemoryCategory::DerivedVolume,
+                         [this] { return MemoryLedger::dataBytes(m_isoVolume); });
+    m_memoryLedger.track("DRR HU remap (float)", MemoryCategory::DerivedVolume,
+                         [this] { return m_drrViewer->remapBytes(); });
+    m_memoryLedger.track("MIP sagittal layout", MemoryCategory::DerivedVolume,
+                         [this] { return m_mipViewer->layoutBytes(); });
+    m_memoryLedger.track("DRR sagittal layout", MemoryCategory::DerivedVolume,
+                         [this] { return m_drrViewer->layoutBytes(); });
+    m_memoryLedger.track("Gradient volume", MemoryCategory::DerivedVolume,
+                         [this] { return m_volumeViewer->gradientBytes(); });
+    m_memoryLedger.track("MIP reslice", MemoryCategory::Projection, [this] { return m_mipViewer->outputBytes(); });
+    m_memoryLedger.track("DRR reslice", MemoryCategory::Projection, [this] { return m_drrViewer->outputBytes(); });
+    m_memoryLedger.track("Oblique slice", MemoryCategory::Projection,
+                         [this] { return m_obliqueReslicer->outputBytes(); });
+    m_memoryLedger.track("CPR image", MemoryCategory::Projection, [this] { return m_cprEngine->outputBytes(); });
+    m_memoryLedger.track("Slice view W/L image", MemoryCategory::Projection,
+                         [this, windowLevelBytes] { return windowLevelBytes(m_imageViewer); });
+    m_memoryLedger.track("MIP view W/L image", MemoryCategory::Projection,
+                         [this, windowLevelBytes] { return windowLevelBytes(m_mipImageViewer); });
+    m_memoryLedger.track("DRR view W/L image", MemoryCategory::Projection,
+                         [this, windowLevelBytes] { return windowLevelBytes(m_drrImageViewer); });
+    m_memoryLedger.track("CPR view W/L image", MemoryCategory::Projection,
+                         [this, windowLevelBytes] { return windowLevelBytes(m_cprImageViewer); });
+    m_memoryLedger.track("Compressed bricks", MemoryCategory::Volume, [this] {
+        const auto *compressed = dynamic_cast<const CompressedVolume *>(m_brickedVolume.get());
+        return compressed ? compressed->compressedBytes() : 0;
+    });
+    m_memoryLedger.track("Brick cache (mapped or decoded)", MemoryCategory::Cache,
+                         [this] { return m_brickedVolume ? m_brickedVolume->residentBytes() : 0; });
+    m_memoryLedger.track("Segment measurements", MemoryCategory::Cache,
+                         [this] { return m_segmentMeasure->cacheBytes(); });
+    m_memoryLedger.track("CPU raycaster", MemoryCategory::Cache, [this] { return m_volumeViewer->cacheBytes(); });
+    m_memoryLedger.track("Volume 3D texture", MemoryCategory::GpuTexture,
+                         [this] { return m_volumeViewer->textureBytesEstimate(); });
+    m_memoryLedger.track("Image view textures", MemoryCategory::GpuTexture, [this, windowLevelTexture] {
+        return windowLevelTexture(m_imageViewer) + windowLevelTexture(m_mipImageViewer)
+               + windowLevelTexture(m_drrImageViewer) + windowLevelTexture(m_cprImageViewer);
+    });
+
+    m_memoryTree = new QTreeWidget(this);
+    m_memoryTree->setColumnCount(3);
+    m_memoryTree->setHeaderLabels({"Buffer", "Current", "Peak"});
+    m_memoryTree->setRootIsDecorated(true);
+
+    m_memoryDock = new QDockWidget("Memory", this);
+    m_memoryDock->setWidget(m_memoryTree);
+    addDockWidget(Qt::RightDockWidgetArea, m_memoryDock);
+    m_memoryDock->hide();
+    m_diagnosticsMenu->addSeparator();
+    m_diagnosticsMenu->addAction(m_memoryDock->toggleViewAction());
+
+    // Peaks are only as fine as the sampling, so sample whether or not the
+    // panel is open; redrawing waits for it to be visible.
+    m_memoryTimer = new QTimer(this);
+    m_memoryTimer->setInterval(1000);
+    connect(m_memoryTimer, &QTimer::timeout, this, [this] {
+        m_memoryLedger.sample();
+        if (m_memoryDock->isVisible())
+            refreshMemoryPanel();
+    });
+    connect(m_memoryDock, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible)
+            refreshMemoryPanel();
+    });
+    m_memoryTimer->start();
+}
+
+void MainWindow::refreshMemoryPanel()
+{
+    const auto mb = [](size_t bytes) { return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1); };
+
+    m_memoryTree->clear();
+    for (int c = 0; c < static_cast<int>(MemoryCategory::Count); ++c) {
+        const auto category = static_cast<MemoryCategory>(c);
+        auto *group = new QTreeWidgetItem(m_memoryTree, {MemoryLedger::categoryName(category),
+                                                         mb(m_memoryLedger.categoryBytes(category)),
+                                                         mb(m_memoryLedger.categoryPeakBytes(category))});
+        for (const MemoryLedger::Entry &entry : m_memoryLedger.entries()) {
+            if (entry.category == category)
+                new QTreeWidgetItem(group, {QString::fromStdString(entry.name), mb(entry.bytes), mb(entry.peakBytes)});
+        }
+        group->setExpanded(true);
+    }
+    auto *total = new QTreeWidgetItem(m_memoryTree, {"Total", mb(m_memoryLedger.totalBytes()),
+                                                     mb(m_memoryLedger.peakTotalBytes())});
+    QFont bold = total->font(0);
+    bold.setBold(true);
+    for (int column = 0; column < 3; ++column)
+        total->setFont(column, bold);
+    m_memoryTree->resizeColumnToContents(0);
 }
 
 void MainWindow::toggleAnnotationMode(bool enabled)
@@ -207,154 +409,616 @@ void MainWindow::toggleAnnotationMode(bool enabled)
     if (m_sphereStyle) {
         m_sphereStyle->SetAnnotationMode(enabled);
     }
+    markInteractionMode();
 }
 
-void MainWindow::loadDicomDirectory(const QString &directoryPath)
+void MainWindow::togglePathMode(bool enabled)
 {
-    // -----------------------------------------------------------------------
-    // Step 1: Scan the directory with vtkDICOMDirectory.
-    //
-    // WHY this over QDir:
-    //   - Detects DICOM files by header magic bytes, not just ".dcm" extension
-    //   - Automatically groups files into separate series (by SeriesInstanceUID)
-    //   - Returns vtkStringArray directly — no Qt↔VTK string conversion needed
-    //   - Sorts by ImagePositionPatient within each series
-    //
-    // SetScanDepth(1) means: scan only the given directory, not subdirectories.
-    // Increase to 2+ if your DICOM files are nested in subfolders.
-    // -----------------------------------------------------------------------
-    vtkNew<vtkDICOMDirectory> dicomDir;
-    dicomDir->SetDirectoryName(directoryPath.toUtf8().constData());
-    dicomDir->SetScanDepth(1);
-    dicomDir->Update();
-
-    const int numberOfSeries = dicomDir->GetNumberOfSeries();
-    if (numberOfSeries == 0) {
-        qWarning() << "No DICOM series found in:" << directoryPath;
-        setWindowTitle("DICOM Viewer — ERROR: No DICOM series found");
+    // Path and pair annotation both own the left button — one at a time.
+    if (enabled)
+        m_annotateButton->setChecked(false);
+    m_annotateButton->setEnabled(!enabled);
+    m_cprWidget->setVisible(enabled);
+
+    if (m_sphereStyle) {
+        m_sphereStyle->SetPathMode(enabled);
+    }
+    markInteractionMode();
+}
+
+void MainWindow::recordInteraction(const QString &path)
+{
+    m_interactionRecorder.start(m_renderWindow->GetInteractor(), path.toStdString());
+    markInteractionMode();
+}
+
+void MainWindow::markInteractionMode()
+{
+    if (!m_interactionRecorder.isRecording() || !m_sphereStyle) {
         return;
     }
+    if (m_sphereStyle->GetPathMode())
+        m_interactionRecorder.markMode("path");
+    else if (m_sphereStyle->GetAnnotationMode())
+        m_interactionRecorder.markMode("annotation");
+    else
+        m_interactionRecorder.markMode("image");
+}
 
-    qDebug() << "Found" << numberOfSeries << "DICOM series";
+void MainWindow::toggleVolumeView(bool enabled)
+{
+    m_volumeWidget->setVisible(enabled);
+    if (!enabled) {
+        m_cropButton->setChecked(false); // the box lives in this pane
+    }
+    if (!enabled) {
+        return;
+    }
 
-    // -----------------------------------------------------------------------
-    // Step 2: Get file names for the first series.
-    //
-    // GetFileNamesForSeries() returns a vtkStringArray* directly —
-    // no QDir, no QStringList, no manual conversion loop.
-    // If you have multiple series (e.g., CT + scout), you'd let the user
-    // choose which series to load. For now, we take the first one.
-    // -----------------------------------------------------------------------
-    constexpr int seriesIndex = 0;  // First series
-    vtkStringArray *fileNames = dicomDir->GetFileNamesForSeries(seriesIndex);
+    // Deferred until shown: sessions that never open the pane pay nothing
+    // for transfer functions or volume upload. Each new series is prepared
+    // again; a bricked one has no in-RAM volume and leaves the pane empty.
+    if (m_dicomReader) {
+        m_volumeViewer->prepare();
+        if (!m_volumeRefiner) {
+            m_volumeRefiner = new ProgressiveRenderer(
+                m_volumeViewer->renderer(),
+                [this](RefinePass pass) { m_volumeViewer->applyPass(pass); },
+                this);
+        }
+    }
+    m_volumeRenderWindow->Render();
+}
 
-    if (fileNames == nullptr || fileNames->GetNumberOfValues() == 0) {
-        qWarning() << "Series 0 contains no files";
-        setWindowTitle("DICOM Viewer — ERROR: Empty series");
+void MainWindow::toggleCropBox(bool enabled)
+{
+    if (!enabled) {
+        // hiding the box keeps the crop; drag it back out to undo
+        m_voiWidget->Off();
+        m_volumeRenderWindow->Render();
+        return;
+    }
+    if (!m_dicomReader) {
         return;
     }
 
-    qDebug() << "Series 0 contains" << fileNames->GetNumberOfValues() << "files";
+    m_volumeButton->setChecked(true); // prepares the 3D pane on first use
+    double bounds[6];
+    m_voi.bounds(bounds);
+    m_voiRepresentation->PlaceWidget(bounds);
+    m_voiWidget->On();
+    m_volumeRenderWindow->Render();
+}
 
-    // -----------------------------------------------------------------------
-    // Step 3: Read the DICOM series.
-    // -----------------------------------------------------------------------
-    m_dicomReader = vtkSmartPointer<vtkDICOMReader>::New();
-    m_dicomReader->SetFileNames(fileNames);  // ← Direct! No conversion!
-    m_dicomReader->Update();
+void MainWindow::onVoiBoxInteraction(vtkObject * /*caller*/,
+                                     unsigned long eventId,
+                                     void *clientData,
+                                     void * /*callData*/)
+{
+    auto *self = static_cast<MainWindow *>(clientData);
 
-    // mipViewer
-    m_mipViewer->setInputData(m_dicomReader->GetOutput());
+    if (eventId == vtkCommand::InteractionEvent) {
+        // 3D follows every drag step, at preview quality
+        if (!self->m_voi.setBounds(self->m_voiRepresentation->GetBounds())) {
+            return;
+        }
+        self->m_volumeViewer->updateCropping();
+        if (self->m_volumeRefiner) {
+            self->m_volumeRefiner->interrupt();
+        }
+        return; // the widget renders after this event
+    }
+
+    // Projections are re-run once, when the box is released.
+    self->updateProjections();
+}
 
-    vtkImageData *m_mipData = m_mipViewer->viewMip();
-    if (m_mipData) {
-        m_mipImageViewer = vtkSmartPointer<vtkImageViewer2>::New();
+void MainWindow::updateProjections()
+{
+    // Output images keep world coordinates, so the cameras stay put.
+    requestMip(false);
+    requestDrr(false);
+    // the other axes for this box, in case the user switches next
+    m_mipViewer->prefetch();
+    m_drrViewer->prefetch();
+}
 
+void MainWindow::requestMip(bool resetCamera)
+{
+    const auto axis = static_cast<MipAxis>(m_mipAxisGroup->checkedId());
+    m_mipViewer->requestMip(axis, [this, resetCamera](vtkSmartPointer<vtkImageData> image) {
+        QMetaObject::invokeMethod(this, [this, image, resetCamera] { showMip(image, resetCamera); },
+                                  Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::requestDrr(bool resetCamera)
+{
+    const auto axis = static_cast<DrrAxis>(m_drrAxisGroup->checkedId());
+    m_drrViewer->requestDrr(axis, [this, resetCamera](vtkSmartPointer<vtkImageData> image) {
+        QMetaObject::invokeMethod(this, [this, image, resetCamera] { showDrr(image, resetCamera); },
+                                  Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::showMip(vtkSmartPointer<vtkImageData> image, bool resetCamera)
+{
+    m_mipData = image;
+    if (m_mipImageViewer) {
         m_mipImageViewer->SetInputData(m_mipData);
-        m_mipImageViewer->SetRenderWindow(m_mipRenderWindow);
-        m_mipImageViewer->SetupInteractor(m_mipRenderWindow->GetInteractor());
+        if (resetCamera) {
+            m_mipImageViewer->GetRenderer()->ResetCamera();
+        }
+        m_mipImageViewer->Render();
+        return;
+    }
+
+    // first MIP of the session: build the viewer around it
+    m_mipImageViewer = vtkSmartPointer<vtkImageViewer2>::New();
+    Trace::observe(m_mipImageViewer->GetWindowLevel(), "mip.windowLevel");
+
+    m_mipImageViewer->SetInputData(m_mipData);
+    m_mipImageViewer->SetRenderWindow(m_mipRenderWindow);
+    m_mipImageViewer->SetupInteractor(m_mipRenderWindow->GetInteractor());
 
-        // annotation settings
+    // annotation settings
 
-        m_mipAnnotation->SetLinearFontScaleFactor(2);
-        m_mipAnnotation->SetNonlinearFontScaleFactor(1);
-        m_mipAnnotation->SetMaximumFontSize(16);
-        m_mipAnnotation->GetTextProperty()->SetColor(1.0, 1.0, 0.0);
+    m_mipAnnotation->SetLinearFontScaleFactor(2);
+    m_mipAnnotation->SetNonlinearFontScaleFactor(1);
+    m_mipAnnotation->SetMaximumFontSize(16);
+    m_mipAnnotation->GetTextProperty()->SetColor(1.0, 1.0, 0.0);
 
-        m_mipAnnotation->SetText(3, "W: 2000 L: 400");
-        m_mipImageViewer->GetRenderer()->AddViewProp(m_mipAnnotation);
+    m_mipAnnotation->SetText(3, "W: 2000 L: 400");
+    m_mipImageViewer->GetRenderer()->AddViewProp(m_mipAnnotation);
 
-        vtkInteractorStyleImage *mipStyle = vtkInteractorStyleImage::SafeDownCast(
-            m_mipRenderWindow->GetInteractor()->GetInteractorStyle());
+    vtkInteractorStyleImage *mipStyle = vtkInteractorStyleImage::SafeDownCast(
+        m_mipRenderWindow->GetInteractor()->GetInteractorStyle());
 
-        if (mipStyle) {
-            vtkNew<vtkCallbackCommand> wlCallback;
-            wlCallback->SetCallback(MainWindow::onMipWindowLevel);
-            wlCallback->SetClientData(this);
-            mipStyle->AddObserver(vtkCommand::WindowLevelEvent, wlCallback);
+    if (mipStyle) {
+        vtkNew<vtkCallbackCommand> wlCallback;
+        wlCallback->SetCallback(MainWindow::onMipWindowLevel);
+        wlCallback->SetClientData(this);
+        mipStyle->AddObserver(vtkCommand::WindowLevelEvent, wlCallback);
+    }
+
+    m_mipImageViewer->SetColorWindow(2000.0);
+    m_mipImageViewer->SetColorLevel(300.0);
+    // m_mipImageViewer->SetColorWindow(1000.0);
+    // m_mipImageViewer->SetColorLevel(400.0);
+
+    m_mipImageViewer->Render();
+    m_mipImageViewer->GetRenderer()->ResetCamera();
+}
+
+void MainWindow::showDrr(vtkSmartPointer<vtkImageData> image, bool resetCamera)
+{
+    m_drrData = image;
+    if (m_drrImageViewer) {
+        m_drrImageViewer->SetInputData(m_drrData);
+        if (resetCamera) {
+            m_drrImageViewer->GetRenderer()->ResetCamera();
         }
+        m_drrImageViewer->Render();
+        return;
+    }
 
-        m_mipImageViewer->SetColorWindow(2000.0);
-        m_mipImageViewer->SetColorLevel(300.0);
-        // m_mipImageViewer->SetColorWindow(1000.0);
-        // m_mipImageViewer->SetColorLevel(400.0);
+    // first DRR of the session: window/level from its range
+    double range[2];
+    m_drrData->GetScalarRange(range); // range[0] = min, range[1] = max
 
-        m_mipImageViewer->Render();
-        m_mipImageViewer->GetRenderer()->ResetCamera();
+    const double drrLevel = (range[0] + range[1]) * 0.5; // center of range
+
+    // Clamp the lower bound to 0.
+    // CT scanners pad out-of-field voxels with HU < -1000 (e.g. -2048).
+    // After the +1000 shift these become negative and pollute the range minimum.
+    // All meaningful anatomy has sum >= 0, so we anchor the window there.
+    const double drrWindow = (range[1] - std::max(0.0, range[0]));
+
+    m_drrImageViewer = vtkSmartPointer<vtkImageViewer2>::New();
+    Trace::observe(m_drrImageViewer->GetWindowLevel(), "drr.windowLevel");
+    m_drrImageViewer->SetInputData(m_drrData);
+    m_drrImageViewer->SetRenderWindow(m_drrRenderWindow);
+    m_drrImageViewer->SetupInteractor(m_drrRenderWindow->GetInteractor());
+
+    // annotation settings
+
+    m_drrAnnotation->SetLinearFontScaleFactor(2);
+    m_drrAnnotation->SetNonlinearFontScaleFactor(1);
+    m_drrAnnotation->SetMaximumFontSize(16);
+    m_drrAnnotation->GetTextProperty()->SetColor(1.0, 1.0, 0.0);
+
+    const std::string initText = "W: " + std::to_string(static_cast<int>(-drrWindow))
+                                 + " L: " + std::to_string(static_cast<int>(drrLevel));
+    m_drrAnnotation->SetText(3, initText.c_str());
+
+    m_drrImageViewer->GetRenderer()->AddViewProp(m_drrAnnotation);
+
+    vtkInteractorStyleImage *drrStyle = vtkInteractorStyleImage::SafeDownCast(
+        m_drrRenderWindow->GetInteractor()->GetInteractorStyle());
+
+    if (drrStyle) {
+        vtkNew<vtkCallbackCommand> wlCallback;
+        wlCallback->SetCallback(MainWindow::onDrrWindowLevel);
+        wlCallback->SetClientData(this);
+        drrStyle->AddObserver(vtkCommand::WindowLevelEvent, wlCallback);
     }
-    m_mipViewer->setInputData(m_dicomReader->GetOutput());
 
-    // drrData
-    m_drrViewer->setInputData(m_dicomReader->GetOutput());
+    m_drrImageViewer->SetColorWindow(drrWindow);
+    m_drrImageViewer->SetColorLevel(drrLevel);
+    // m_drrImageViewer->SetColorWindow(1000.0);
+    // m_drrImageViewer->SetColorLevel(400.0);
 
-    vtkImageData *m_drrData = m_drrViewer->viewDrr();
-    if (m_drrData) {
-        double range[2];
-        m_drrData->GetScalarRange(range); // range[0] = min, range[1] = max
+    m_drrImageViewer->Render();
+    m_drrImageViewer->GetRenderer()->ResetCamera();
+}
 
-        const double drrLevel = (range[0] + range[1]) * 0.5; // center of range
+void MainWindow::toggleObliqueMode(bool enabled)
+{
+    if (!m_imageViewer || !m_dicomReader) {
+        return;
+    }
 
-        // Clamp the lower bound to 0.
-        // CT scanners pad out-of-field voxels with HU < -1000 (e.g. -2048).
-        // After the +1000 shift these become negative and pollute the range minimum.
-        // All meaningful anatomy has sum >= 0, so we anchor the window there.
-        const double drrWindow = (range[1] - std::max(0.0, range[0]));
+    // the viewer's input is about to change under the cine frames
+    m_sphereStyle->StopCine();
 
-        m_drrImageViewer = vtkSmartPointer<vtkImageViewer2>::New();
-        m_drrImageViewer->SetInputData(m_drrData);
-        m_drrImageViewer->SetRenderWindow(m_drrRenderWindow);
-        m_drrImageViewer->SetupInteractor(m_drrRenderWindow->GetInteractor());
+    if (enabled) {
+        // Annotations live in axis-aligned world space — not meaningful on
+        // a rotated plane, so the tool is parked while oblique is active.
+        m_annotateButton->setChecked(false);
+        m_annotateButton->setEnabled(false);
+        m_pathButton->setChecked(false);
+        m_pathButton->setEnabled(false);
 
-        // annotation settings
+        vtkImageData *plane = m_obliqueReslicer->reslice();
+        if (!plane) {
+            return;
+        }
+        m_imageViewer->SetInputData(plane);
+        m_imageViewer->SetSliceOrientationToXY();
+        m_imageViewer->SetSlice(0);
+    } else {
+        m_imageViewer->SetInputConnection(m_dicomReader->GetOutputPort());
+        m_imageViewer->SetSliceOrientationToYZ();
+        m_imageViewer->SetSlice((m_minSlice + m_maxSlice) / 2);
+        m_annotateButton->setEnabled(true);
+        m_pathButton->setEnabled(true);
+    }
 
-        m_drrAnnotation->SetLinearFontScaleFactor(2);
-        m_drrAnnotation->SetNonlinearFontScaleFactor(1);
-        m_drrAnnotation->SetMaximumFontSize(16);
-        m_drrAnnotation->GetTextProperty()->SetColor(1.0, 1.0, 0.0);
+    m_sphereStyle->SetObliqueMode(enabled);
+    m_imageViewer->GetRenderer()->ResetCamera();
+    m_imageViewer->Render();
+}
 
-        const std::string initText = "W: " + std::to_string(static_cast<int>(-drrWindow))
-                                     + " L: " + std::to_string(static_cast<int>(drrLevel));
-        m_drrAnnotation->SetText(3, initText.c_str());
+void MainWindow::updateMeasurement(int pair)
+{
+    m_measuredPair = pair;
+    if (pair < 0) {
+        m_measureAnnotation->SetText(3, "");
+        m_profileActor->VisibilityOff();
+        return;
+    }
 
-        m_drrImageViewer->GetRenderer()->AddViewProp(m_drrAnnotation);
+    AnnotationSet &annotations = m_sphereStyle->GetAnnotations();
+    double a[3], b[3];
+    annotations.markerPosition(pair * 2, a);
+    annotations.markerPosition(pair * 2 + 1, b);
+    // sample the slice on screen, not the near plane the markers sit on
+    m_sphereStyle->ProjectToSlice(a);
+    m_sphereStyle->ProjectToSlice(b);
+    const SegmentStats &stats = m_segmentMeasure->measure(pair, a, b, annotations.segmentRadius());
+
+    const QString text = QString("Pair %1  L: %2 mm\nHU mean %3  SD %4\nmin %5  max %6  (%7 vox)")
+                             .arg(pair + 1)
+                             .arg(stats.lengthMm, 0, 'f', 1)
+                             .arg(stats.meanHu, 0, 'f', 1)
+                             .arg(stats.stdHu, 0, 'f', 1)
+                             .arg(stats.minHu, 0, 'f', 0)
+                             .arg(stats.maxHu, 0, 'f', 0)
+                             .arg(stats.voxelCount);
+    m_measureAnnotation->SetText(3, text.toUtf8().constData());
+
+    // Profile as a polyline in the bottom strip of the view, in normalized
+    // viewport coordinates (x: along the segment, y: HU scaled to its range).
+    const int n = static_cast<int>(stats.profileHu.size());
+    if (n < 2 || stats.lengthMm <= 0.0) {
+        m_profileActor->VisibilityOff();
+        return;
+    }
+    const auto [lo, hi] = std::minmax_element(stats.profileHu.begin(), stats.profileHu.end());
+    const double span = std::max(1.0f, *hi - *lo);
+
+    vtkNew<vtkPoints> points;
+    vtkNew<vtkCellArray> lines;
+    points->SetNumberOfPoints(n);
+    lines->InsertNextCell(n);
+    for (int i = 0; i < n; ++i) {
+        points->SetPoint(i,
+                         0.05 + 0.9 * stats.profileMm[i] / stats.lengthMm,
+                         0.03 + 0.17 * (stats.profileHu[i] - *lo) / span,
+                         0.0);
+        lines->InsertCellPoint(i);
+    }
+    m_profilePolyData->SetPoints(points);
+    m_profilePolyData->SetLines(lines);
+    m_profileActor->VisibilityOn();
+}
+
+void MainWindow::updateCpr(int movedPoint)
+{
+    AnnotationSet &annotations = m_sphereStyle->GetAnnotations();
+    // the curve runs through the slice on screen, not the near plane the
+    // control points are drawn on
+    if (movedPoint >= 0 && movedPoint < m_cprEngine->controlPointCount()) {
+        // drag: only the spline segments around this point are re-sampled
+        double pos[3];
+        annotations.pathPoint(movedPoint, pos);
+        m_sphereStyle->ProjectToSlice(pos);
+        m_cprEngine->moveControlPoint(movedPoint, pos);
+    } else {
+        std::vector<std::array<double, 3>> points(annotations.pathPointCount());
+        for (int i = 0; i < annotations.pathPointCount(); ++i) {
+            annotations.pathPoint(i, points[i].data());
+            m_sphereStyle->ProjectToSlice(points[i].data());
+        }
+        m_cprEngine->setControlPoints(points);
+    }
 
-        vtkInteractorStyleImage *drrStyle = vtkInteractorStyleImage::SafeDownCast(
-            m_drrRenderWindow->GetInteractor()->GetInteractorStyle());
+    vtkImageData *cpr = m_cprEngine->output();
+    if (!cpr) {
+        return; // fewer than two points
+    }
 
-        if (drrStyle) {
-            vtkNew<vtkCallbackCommand> wlCallback;
-            wlCallback->SetCallback(MainWindow::onDrrWindowLevel);
-            wlCallback->SetClientData(this);
-            drrStyle->AddObserver(vtkCommand::WindowLevelEvent, wlCallback);
+    if (!m_cprImageViewer) {
+        m_cprImageViewer = vtkSmartPointer<vtkImageViewer2>::New();
+        m_cprImageViewer->SetInputData(cpr);
+        m_cprImageViewer->SetRenderWindow(m_cprRenderWindow);
+        m_cprImageViewer->SetupInteractor(m_cprRenderWindow->GetInteractor());
+        m_cprImageViewer->SetSliceOrientationToXY();
+        m_cprImageViewer->SetColorWindow(m_imageViewer->GetColorWindow());
+        m_cprImageViewer->SetColorLevel(m_imageViewer->GetColorLevel());
+        m_cprImageViewer->GetRenderer()->SetBackground(0.05, 0.05, 0.05);
+        m_cprImageViewer->GetRenderer()->ResetCamera();
+    } else if (movedPoint < 0) {
+        // the curve changed length: refit the camera to the new image
+        m_cprImageViewer->GetRenderer()->ResetCamera();
+    }
+    m_cprImageViewer->Render();
+}
+
+void MainWindow::onLoadProgress(vtkObject *caller,
+                                unsigned long /*eventId*/,
+                                void *clientData,
+                                void * /*callData*/)
+{
+    // a newer load (or closing the window) stops the decode between slices
+    const auto *token = static_cast<CancelToken *>(clientData);
+    if (token->isCancelled()) {
+        static_cast<vtkAlgorithm *>(caller)->SetAbortExecute(1);
+    }
+}
+
+void MainWindow::loadDicomDirectory(const QString &directoryPath)
+{
+    m_loadToken.cancel();
+    m_loadToken = CancelToken();
+    m_loading = true;
+    const CancelToken token = m_loadToken;
+
+    // Errors are reported on the GUI thread, like the result.
+    auto fail = [this, token](const QString &message) {
+        QMetaObject::invokeMethod(this, [this, token, message] {
+            if (token.isCancelled()) {
+                return;
+            }
+            setWindowTitle("DICOM Viewer — ERROR: " + message);
+            finishLoad(false);
+        }, Qt::QueuedConnection);
+    };
+
+    // Scan and decode off the GUI thread; the window stays responsive and a
+    // newer load cancels this one.
+    const VolumeStorage storage = m_storage;
+    m_loadDone = TaskScheduler::instance().submit(TaskPriority::Visible, [this, directoryPath, token, fail, storage] {
+        // -----------------------------------------------------------------------
+        // Step 1: Scan the directory with vtkDICOMDirectory.
+        //
+        // WHY this over QDir:
+        //   - Detects DICOM files by header magic bytes, not just ".dcm" extension
+        //   - Automatically groups files into separate series (by SeriesInstanceUID)
+        //   - Returns vtkStringArray directly — no Qt↔VTK string conversion needed
+        //   - Sorts by ImagePositionPatient within each series
+        //
+        // SetScanDepth(1) means: scan only the given directory, not subdirectories.
+        // Increase to 2+ if your DICOM files are nested in subfolders.
+        // -----------------------------------------------------------------------
+        TRACE_SCOPE("dicom.load");
+        vtkNew<vtkDICOMDirectory> dicomDir;
+        Trace::observe(dicomDir, "dicom.scan");
+        dicomDir->SetDirectoryName(directoryPath.toUtf8().constData());
+        dicomDir->SetScanDepth(1);
+        dicomDir->Update();
+
+        const int numberOfSeries = dicomDir->GetNumberOfSeries();
+        if (numberOfSeries == 0) {
+            qWarning() << "No DICOM series found in:" << directoryPath;
+            fail("No DICOM series found");
+            return;
         }
 
-        m_drrImageViewer->SetColorWindow(drrWindow);
-        m_drrImageViewer->SetColorLevel(drrLevel);
-        // m_drrImageViewer->SetColorWindow(1000.0);
-        // m_drrImageViewer->SetColorLevel(400.0);
+        qDebug() << "Found" << numberOfSeries << "DICOM series";
+
+        // -----------------------------------------------------------------------
+        // Step 2: Get file names for the first series.
+        //
+        // GetFileNamesForSeries() returns a vtkStringArray* directly —
+        // no QDir, no QStringList, no manual conversion loop.
+        // If you have multiple series (e.g., CT + scout), you'd let the user
+        // choose which series to load. For now, we take the first one.
+        // -----------------------------------------------------------------------
+        constexpr int seriesIndex = 0;  // First series
+        vtkStringArray *fileNames = dicomDir->GetFileNamesForSeries(seriesIndex);
+
+        if (fileNames == nullptr || fileNames->GetNumberOfValues() == 0) {
+            qWarning() << "Series 0 contains no files";
+            fail("Empty series");
+            return;
+        }
 
-        m_drrImageViewer->Render();
-        m_drrImageViewer->GetRenderer()->ResetCamera();
+        qDebug() << "Series 0 contains" << fileNames->GetNumberOfValues() << "files";
+
+        // -----------------------------------------------------------------------
+        // Step 3: Read the DICOM series.
+        // -----------------------------------------------------------------------
+        auto reader = vtkSmartPointer<ParallelDicomReader>::New(); // compressed series: all cores decode
+        Trace::observe(reader, "dicom.read", true); // + one span per slice
+        vtkNew<vtkCallbackCommand> abortCallback;
+        abortCallback->SetCallback(MainWindow::onLoadProgress);
+        CancelToken watched = token;
+        abortCallback->SetClientData(&watched);
+        reader->AddObserver(vtkCommand::ProgressEvent, abortCallback);
+        reader->SetFileNames(fileNames);  // ← Direct! No conversion!
+        const int fileCount = static_cast<int>(fileNames->GetNumberOfValues());
+
+        if (storage == VolumeStorage::Compressed) {
+            // Compressed layer by layer; the reader only ever holds one brick layer.
+            auto compressed = std::make_shared<CompressedVolume>();
+            if (!compressed->compress(reader, CompressedVolume::kDefaultBrickSize, &token)) {
+                if (!token.isCancelled()) {
+                    qWarning() << "Could not compress series:" << directoryPath;
+                    fail("Could not compress series");
+                }
+                return;
+            }
+            reader->RemoveObserver(abortCallback);
+            qDebug() << "Compressed" << compressed->rawBytes() / (1024 * 1024) << "MB to"
+                     << compressed->compressedBytes() / (1024 * 1024) << "MB";
+            QMetaObject::invokeMethod(this, [this, token, compressed, fileCount] {
+                if (!token.isCancelled()) {
+                    onSeriesLoaded(nullptr, compressed, fileCount);
+                }
+            }, Qt::QueuedConnection);
+            return;
+        }
+        if (storage == VolumeStorage::BrickFile) {
+            // Converted once per series (keyed by its file list), then paged
+            // from the brick file; the reader only ever holds one brick layer.
+            QCryptographicHash key(QCryptographicHash::Md5);
+            for (vtkIdType i = 0; i < fileNames->GetNumberOfValues(); ++i)
+                key.addData(QByteArray(fileNames->GetValue(i).c_str()));
+            const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/bricks";
+            QDir().mkpath(cacheDir);
+            const QString brickPath = cacheDir + "/" + key.result().toHex() + ".bvol";
+
+            auto bricked = std::make_shared<BrickedVolume>();
+            if (!bricked->open(brickPath)
+                && !(BrickedVolume::write(reader, brickPath, BrickedVolume::kDefaultBrickSize, &token)
+                     && bricked->open(brickPath))) {
+                if (!token.isCancelled()) {
+                    qWarning() << "Could not write brick file:" << brickPath;
+                    fail("Could not write brick file");
+                }
+                return;
+            }
+            reader->RemoveObserver(abortCallback);
+            QMetaObject::invokeMethod(this, [this, token, bricked, fileCount] {
+                if (!token.isCancelled()) {
+                    onSeriesLoaded(nullptr, bricked, fileCount);
+                }
+            }, Qt::QueuedConnection);
+            return;
+        }
+
+        reader->Update();
+        reader->RemoveObserver(abortCallback);
+        if (token.isCancelled()) {
+            return;
+        }
+
+        QMetaObject::invokeMethod(this, [this, token, reader, fileCount] {
+            if (!token.isCancelled()) {
+                onSeriesLoaded(reader, nullptr, fileCount);
+            }
+        }, Qt::QueuedConnection);
+    }, token);
+}
+
+void MainWindow::finishLoad(bool ok)
+{
+    m_loading = false;
+    emit loadFinished(ok);
+}
+
+void MainWindow::onIsotropicReady(vtkSmartPointer<vtkImageData> isotropic)
+{
+    if (!m_dicomReader) {
+        return;
+    }
+    m_isoVolume = isotropic;
+    // DRR sums stay in units of the original slices: same W/L as before
+    double nativeSpacing[3];
+    m_dicomReader->GetOutput()->GetSpacing(nativeSpacing);
+    m_mipViewer->setInputData(m_isoVolume);
+    m_drrViewer->setInputData(m_isoVolume, nativeSpacing);
+    updateProjections();
+}
+
+void MainWindow::onSeriesLoaded(vtkSmartPointer<vtkDICOMReader> reader, std::shared_ptr<BrickStore> bricked,
+                                int fileCount)
+{
+    TRACE_SCOPE("dicom.setup");
+    // cine presents through the previous viewer, which goes below
+    if (m_sphereStyle) {
+        m_sphereStyle->StopCine();
+    }
+    m_dicomReader = reader;
+    // Whole decoded volume for the in-RAM tools; nullptr when bricked, where
+    // only the volume's frame (extent, spacing, origin) is at hand.
+    vtkImageData *volume = reader ? reader->GetOutput() : nullptr;
+    vtkImageData *frame = volume ? volume : bricked->geometry();
+
+    // One VOI per volume; every projection reads it in place.
+    m_voi.setInputData(frame);
+    m_mipViewer->setVolumeOfInterest(&m_voi);
+    m_drrViewer->setVolumeOfInterest(&m_voi);
+    m_volumeViewer->setVolumeOfInterest(&m_voi);
+
+    // Projections are computed on the scheduler and shown as they finish;
+    // the slice view below does not wait for them.
+    if (bricked) {
+        m_mipViewer->setBrickedInput(bricked.get());
+        m_drrViewer->setBrickedInput(bricked.get());
+    } else {
+        m_mipViewer->setInputData(volume);
+        m_drrViewer->setInputData(volume);
+    }
+    // the viewers have let go of the previous brick store
+    m_brickedVolume = bricked;
+    m_brickSource->SetVolume(bricked.get());
+    requestMip(true);
+    requestDrr(true);
+    m_mipViewer->prefetch();
+    m_drrViewer->prefetch();
+
+    // Anisotropic series: the projections switch to a cubic-voxel copy once
+    // it is ready; until then (and for the slice view always) native voxels.
+    m_isoVolume = nullptr; // the viewers have let go of the previous copy
+    if (m_isotropic && volume && !Isotropic::isIsotropic(volume)) {
+        // shares the voxels, but not the reader's pipeline information
+        auto native = vtkSmartPointer<vtkImageData>::New();
+        native->ShallowCopy(volume);
+        const CancelToken token = m_loadToken;
+        m_resampleDone = TaskScheduler::instance().submit(TaskPriority::Background, [this, native, token] {
+            vtkSmartPointer<vtkImageData> isotropic =
+                Isotropic::resample(native, Isotropic::targetSpacing(native), &token);
+            if (!isotropic) {
+                return; // cancelled by a newer load
+            }
+            QMetaObject::invokeMethod(this, [this, isotropic, token] {
+                if (!token.isCancelled()) {
+                    onIsotropicReady(isotropic);
+                }
+            }, Qt::QueuedConnection);
+        }, token);
     }
 
     // -----------------------------------------------------------------------
@@ -367,7 +1031,14 @@ void MainWindow::loadDicomDirectory(const QString &directoryPath)
     // One class delegates to many specialized objects behind a clean API.
     // -----------------------------------------------------------------------
     m_imageViewer = vtkSmartPointer<vtkImageViewer2>::New();
-    m_imageViewer->SetInputConnection(m_dicomReader->GetOutputPort());
+    Trace::observe(m_imageViewer->GetWindowLevel(), "slice.windowLevel");
+    if (bricked) {
+        // streaming: the image actor pulls only the displayed slice
+        m_imageViewer->SetInputConnection(m_brickSource->GetOutputPort());
+        m_imageViewer->GetImageActor()->GetMapper()->StreamingOn();
+    } else {
+        m_imageViewer->SetInputConnection(m_dicomReader->GetOutputPort());
+    }
 
     // Use the same render window that our Qt widget owns.
     m_imageViewer->SetRenderWindow(m_renderWindow);
@@ -388,6 +1059,55 @@ void MainWindow::loadDicomDirectory(const QString &directoryPath)
     // but m_sphereStyle didn't exist yet — push the state now.
     m_sphereStyle->SetAnnotationMode(m_annotateButton->isChecked());
 
+    // Measurements follow the selected pair; the style calls back before each
+    // render, so values track every frame of a drag.
+    m_segmentMeasure->setInputData(volume);
+    m_measuredPair = -1; // the new style starts without pairs
+    m_sphereStyle->SetPairChangedCallback([this](int pair) { updateMeasurement(pair); });
+
+    // CPR follows the path: a dragged point re-samples only its local segments.
+    m_cprEngine->setInputData(volume);
+
+    // 3D pane: same image object, nothing decoded or copied again. An open
+    // pane switches to the new series right away.
+    m_volumeViewer->setInputData(volume);
+    if (m_volumeButton->isChecked()) {
+        toggleVolumeView(true);
+    }
+    m_sphereStyle->SetPathMode(m_pathButton->isChecked());
+    m_sphereStyle->SetPathChangedCallback([this](int point) { updateCpr(point); });
+
+    vtkNew<vtkCoordinate> profileCoords;
+    profileCoords->SetCoordinateSystemToNormalizedViewport();
+    m_profileMapper->SetInputData(m_profilePolyData);
+    m_profileMapper->SetTransformCoordinate(profileCoords);
+    m_profileActor->SetMapper(m_profileMapper);
+    m_profileActor->GetProperty()->SetColor(1.0, 1.0, 0.0);
+    m_profileActor->GetProperty()->SetLineWidth(2.0);
+    m_profileActor->VisibilityOff();
+    m_imageViewer->GetRenderer()->AddViewProp(m_profileActor);
+
+    m_measureAnnotation->SetLinearFontScaleFactor(2);
+    m_measureAnnotation->SetNonlinearFontScaleFactor(1);
+    m_measureAnnotation->SetMaximumFontSize(14);
+    m_measureAnnotation->GetTextProperty()->SetColor(1.0, 1.0, 0.0);
+    m_imageViewer->GetRenderer()->AddViewProp(m_measureAnnotation);
+
+    // Oblique reslice: the style owns the gestures, the reslicer owns the plane.
+    // Each gesture re-samples in place; the viewer picks up the Modified() output.
+    m_obliqueReslicer->setInputData(volume);
+    const double *spacing = frame->GetSpacing();
+    const double stepMm = std::min({spacing[0], spacing[1], spacing[2]});
+    m_sphereStyle->SetObliqueCallbacks(
+        [this](double yaw, double pitch) {
+            m_obliqueReslicer->rotate(yaw, pitch);
+            (void) m_obliqueReslicer->reslice();
+        },
+        [this, stepMm](int steps) {
+            m_obliqueReslicer->translate(steps * stepMm);
+            (void) m_obliqueReslicer->reslice();
+        });
+
 
     // Axial view (looking down the Z-axis: head-to-feet in CT).
     // m_imageViewer->SetSliceOrientationToXY();
@@ -411,7 +1131,7 @@ void MainWindow::loadDicomDirectory(const QString &directoryPath)
 
 
 
-    const int  totalSlices = static_cast<int>(fileNames->GetNumberOfValues());
+    const int  totalSlices = fileCount;
     const int   sliceStep = 5;
     m_sphereStyle->SetImageViewer(m_imageViewer, totalSlices, sliceStep);
     m_sphereStyle->SetSliceChangedCallback([this, totalSlices](int current, int maxSlice, int /*total*/) {
@@ -420,6 +1140,14 @@ void MainWindow::loadDicomDirectory(const QString &directoryPath)
                            .arg(current)
                            .arg(maxSlice)
                        );
+        // the measured slice moved under the markers
+        if (m_measuredPair >= 0) {
+            updateMeasurement(m_measuredPair);
+        }
+        // and under the CPR path
+        if (m_sphereStyle->GetAnnotations().pathPointCount() >= 2) {
+            updateCpr(-1);
+        }
     });
 
 
@@ -445,6 +1173,11 @@ void MainWindow::loadDicomDirectory(const QString &directoryPath)
     annotation->GetTextProperty()->SetColor(1.0, 1.0, 1.0);
     m_imageViewer->GetRenderer()->AddViewProp(annotation);
 
+    // Cine (Space, arrow keys) maps slices from the decoded volume; a
+    // bricked series has none in RAM and keeps wheel stepping only.
+    m_sphereStyle->SetCineVolume(volume);
+    m_sphereStyle->SetCineAnnotation(annotation);
+
     m_imageViewer->GetRenderer()->SetBackground(0.05, 0.05, 0.05);
 
     // -----------------------------------------------------------------------
@@ -467,11 +1200,28 @@ void MainWindow::loadDicomDirectory(const QString &directoryPath)
     m_imageViewer->Render();
 
     setWindowTitle(QString("DICOM Viewer — %1 slices [%2/%3]")
-                       .arg(fileNames->GetNumberOfValues())
+                       .arg(fileCount)
                        .arg(middleSlice)
                        .arg(m_maxSlice));
 
     qDebug() << "DICOM loaded successfully."
              << "Slices:" << m_minSlice << "-" << m_maxSlice
              << "| Starting at:" << middleSlice;
+
+    // Measurements, oblique, CPR and 3D read the whole volume from RAM.
+    for (QPushButton *button : {m_annotateButton, m_obliqueButton, m_pathButton, m_volumeButton, m_cropButton}) {
+        if (!volume) {
+            button->setChecked(false);
+        }
+        button->setEnabled(volume != nullptr);
+    }
+    // A series loaded while Oblique is on opens on its oblique plane: the new
+    // style takes the mode over, and Mark Point and CPR Path stay parked.
+    if (m_obliqueButton->isChecked()) {
+        toggleObliqueMode(true);
+    }
+
+    // the load is where the high-water mark usually is
+    m_memoryLedger.sample();
+    finishLoad(true);
 }
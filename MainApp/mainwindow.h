@@ -4,12 +4,28 @@
 #include <QMainWindow>
 #include <QPushButton>
 #include "DrrViewer.h"
+#include "brickedvolume.h"
+#include "compressedvolume.h"
 #include "MipViewer.h"
+#include "cprengine.h"
+#include "interactionscript.h"
+#include "memoryledger.h"
+#include "obliquereslicer.h"
+#include "progressiverenderer.h"
+#include "segmentmeasure.h"
+#include "taskscheduler.h"
+#include "volumeofinterest.h"
+#include "volumeviewer.h"
 #include "QVTKOpenGLNativeWidget.h"
 #include "vtkActor.h"
+#include "vtkActor2D.h"
+#include "vtkBoxRepresentation.h"
+#include "vtkBoxWidget2.h"
 #include "vtkCornerAnnotation.h"
 #include "vtkGenericOpenGLRenderWindow.h"
 #include "vtkNew.h"
+#include "vtkPolyData.h"
+#include "vtkPolyDataMapper2D.h"
 #include "vtkRenderer.h"
 #include "vtkSmartPointer.h"
 #include <vtkCallbackCommand.h>
@@ -20,12 +36,23 @@
 // Forward-declare VTK types to keep the header lightweight.
 // Consumers of MainWindow don't need full VTK definitions — this is
 // Interface Segregation in practice (only expose what's needed).
+class QDockWidget;
+class QMenu;
+class QTimer;
+class QTreeWidget;
 class vtkImageViewer2;
 class vtkDICOMReader;
 class vtkRenderWindowInteractor;
 class SphereInteractorStyle;
 
 
+// Where a loaded series' voxels live.
+enum class VolumeStorage {
+    Decoded,    // decoded in RAM; every tool available
+    Compressed, // compressed bricks in RAM, decoded on demand
+    BrickFile,  // brick file on disk, paged on demand
+};
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWindow;
@@ -38,14 +65,54 @@ class MainWindow : public QMainWindow
 
 public:
 
-    MainWindow(QWidget *parent = nullptr);
+    // cpuRendering: the 3D pane uses CpuVolumeMapper instead of the GPU mapper.
+    // storage: how series are held; the bricked modes stream slices and
+    // projections from a BrickStore and disable the whole-volume tools.
+    // isotropicProjections: decoded series with anisotropic voxels are
+    // resampled to cubic voxels in the background for the MIP and DRR.
+    explicit MainWindow(bool cpuRendering = false, VolumeStorage storage = VolumeStorage::Decoded,
+                        bool isotropicProjections = false, QWidget *parent = nullptr);
     ~MainWindow();
+    // Scans and decodes on the TaskScheduler, then sets the views up on the
+    // GUI thread and emits loadFinished(). A load still running is cancelled.
     void loadDicomDirectory(const QString &directoryPath);
+    [[nodiscard]] bool isLoading() const { return m_loading; }
+    // Records slice-view interaction to `path` (InteractionScript format)
+    // until the window closes; LatencyHarness replays it.
+    void recordInteraction(const QString &path);
+    // Bytes per pipeline buffer; sampled every second and after each load.
+    MemoryLedger &memoryLedger() { return m_memoryLedger; }
+signals:
+    void loadFinished(bool ok);
 private slots:
     void toggleAnnotationMode(bool enabled);
+    void toggleObliqueMode(bool enabled);
+    void togglePathMode(bool enabled);
+    void toggleVolumeView(bool enabled);
+    void toggleCropBox(bool enabled);
 private:
     void setupVTKWidget();
     void setupToolBar();
+    void setupMemoryPanel();
+    void refreshMemoryPanel();
+    void updateMeasurement(int pair);
+    void updateCpr(int movedPoint);
+    void updateProjections();
+    // Exactly one of reader (decoded in RAM) and bricked (brick store) is set.
+    void onSeriesLoaded(vtkSmartPointer<vtkDICOMReader> reader, std::shared_ptr<BrickStore> bricked,
+                        int fileCount);
+    void finishLoad(bool ok);
+    // Switches the projections to the resampled copy of the current series.
+    void onIsotropicReady(vtkSmartPointer<vtkImageData> isotropic);
+    // Projections run on the TaskScheduler; show*() gets the result on the GUI thread.
+    void requestMip(bool resetCamera);
+    void requestDrr(bool resetCamera);
+    void showMip(vtkSmartPointer<vtkImageData> image, bool resetCamera);
+    void showDrr(vtkSmartPointer<vtkImageData> image, bool resetCamera);
+    static void onLoadProgress(vtkObject *caller,
+                               unsigned long eventId,
+                               void *clientData,
+                               void *callData);
 
     QVTKOpenGLNativeWidget *m_vtkWidget = nullptr; // Owned by Qt parent hierarchy
     vtkSmartPointer<vtkImageViewer2> m_imageViewer;
@@ -53,15 +120,29 @@ private:
     QVTKOpenGLNativeWidget *m_mipWidget = nullptr; // Owned by Qt parent hierarchy
     std::unique_ptr<MipViewer> m_mipViewer;
     QButtonGroup *m_mipAxisGroup = nullptr;
-    vtkImageData *m_mipData = nullptr; // Owned by Qt parent hierarchy
+    vtkSmartPointer<vtkImageData> m_mipData; // shown image, shared with MipViewer's cache
     vtkNew<vtkGenericOpenGLRenderWindow> m_renderWindow;
     vtkSmartPointer<vtkImageViewer2> m_mipImageViewer;
     vtkSmartPointer<vtkDICOMReader> m_dicomReader;
+    // background scan + decode of the series being loaded
+    CancelToken m_loadToken;
+    std::shared_future<void> m_loadDone;
+    bool m_loading = false;
+    // bricked series: the slice view streams single slices from the brick
+    // store; tools that need the whole volume in RAM are disabled
+    VolumeStorage m_storage = VolumeStorage::Decoded;
+    std::shared_ptr<BrickStore> m_brickedVolume;
+    vtkNew<BrickedImageSource> m_brickSource;
+    // isotropic copy of a decoded series for the projections (the slice view
+    // and 3D keep the native voxels); resampled after load, under m_loadToken
+    bool m_isotropic = false;
+    vtkSmartPointer<vtkImageData> m_isoVolume;
+    std::shared_future<void> m_resampleDone;
 
     QVTKOpenGLNativeWidget *m_drrWidget = nullptr; // Owned by Qt parent hierarchy
     std::unique_ptr<DrrViewer> m_drrViewer;
     QButtonGroup *m_drrAxisGroup = nullptr;
-    vtkImageData *m_drrData = nullptr; // Owned by Qt parent hierarchy
+    vtkSmartPointer<vtkImageData> m_drrData; // shown image, shared with DrrViewer's cache
     vtkSmartPointer<vtkImageViewer2> m_drrImageViewer;
     vtkNew<vtkGenericOpenGLRenderWindow> m_drrRenderWindow;
 
@@ -70,9 +151,50 @@ private:
     int m_maxSlice = 0;
 
     vtkSmartPointer<SphereInteractorStyle> m_sphereStyle;
+    InteractionRecorder m_interactionRecorder;
+    void markInteractionMode();
 
     QPushButton *m_annotateButton = nullptr;
 
+    // free-rotation oblique slice, shown in the slice view when enabled
+    std::unique_ptr<ObliqueReslicer> m_obliqueReslicer;
+    QPushButton *m_obliqueButton = nullptr;
+
+    // curved planar reformation along the path drawn in the slice view
+    std::unique_ptr<CprEngine> m_cprEngine;
+    QPushButton *m_pathButton = nullptr;
+    QVTKOpenGLNativeWidget *m_cprWidget = nullptr; // Owned by Qt parent hierarchy
+    vtkSmartPointer<vtkImageViewer2> m_cprImageViewer;
+    vtkNew<vtkGenericOpenGLRenderWindow> m_cprRenderWindow;
+
+    // 3D composite rendering of m_dicomReader's output; transfer functions
+    // are set up the first time the pane is shown
+    std::unique_ptr<VolumeViewer> m_volumeViewer;
+    ProgressiveRenderer *m_volumeRefiner = nullptr; // Owned by Qt parent hierarchy
+    QPushButton *m_volumeButton = nullptr;
+    QVTKOpenGLNativeWidget *m_volumeWidget = nullptr; // Owned by Qt parent hierarchy
+    vtkNew<vtkGenericOpenGLRenderWindow> m_volumeRenderWindow;
+
+    // volume of interest shared by the MIP, DRR and 3D views, edited with a
+    // box widget in the 3D pane
+    VolumeOfInterest m_voi;
+    QPushButton *m_cropButton = nullptr;
+    vtkNew<vtkBoxWidget2> m_voiWidget;
+    vtkNew<vtkBoxRepresentation> m_voiRepresentation;
+    vtkNew<vtkCallbackCommand> m_voiCallback;
+    static void onVoiBoxInteraction(vtkObject *caller,
+                                    unsigned long eventId,
+                                    void *clientData,
+                                    void *callData);
+
+    // live measurement of the selected annotation pair (slice view overlay)
+    std::unique_ptr<SegmentMeasure> m_segmentMeasure;
+    int m_measuredPair = -1; // re-measured when the slice changes
+    vtkNew<vtkCornerAnnotation> m_measureAnnotation;
+    vtkNew<vtkPolyData> m_profilePolyData;
+    vtkNew<vtkPolyDataMapper2D> m_profileMapper;
+    vtkNew<vtkActor2D> m_profileActor;
+
     vtkNew<vtkCornerAnnotation> m_mipAnnotation;
     static void onMipWindowLevel(vtkObject *caller,
                                  unsigned long eventId,
@@ -86,5 +208,13 @@ private:
                                  void *callData);
 
     vtkNew<vtkGenericOpenGLRenderWindow> m_mipRenderWindow;
+
+    QMenu *m_diagnosticsMenu = nullptr; // Owned by Qt parent hierarchy
+
+    // memory accounting: one probe per buffer, shown in a dock panel
+    MemoryLedger m_memoryLedger;
+    QDockWidget *m_memoryDock = nullptr;  // Owned by Qt parent hierarchy
+    QTreeWidget *m_memoryTree = nullptr;  // Owned by Qt parent hierarchy
+    QTimer *m_memoryTimer = nullptr;      // Owned by Qt parent hierarchy
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,117 @@
+#include "memoryledger.h"
+#include "vtkDataObject.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace Ledger {
+
+static std::string megabytes(std::size_t bytes)
+{
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.1f MB", bytes / (1024.0 * 1024.0));
+    return text;
+}
+
+} // namespace Ledger
+
+void MemoryLedger::track(const std::string &name, MemoryCategory category, std::function<std::size_t()> probe)
+{
+    auto it = std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry &e) { return e.name == name; });
+    if (it != m_entries.end()) {
+        it->category = category;
+        m_probes[it - m_entries.begin()] = std::move(probe);
+        return;
+    }
+    m_entries.push_back({name, category, 0, 0});
+    m_probes.push_back(std::move(probe));
+}
+
+void MemoryLedger::untrack(const std::string &name)
+{
+    auto it = std::find_if(m_entries.begin(), m_entries.end(), [&](const Entry &e) { return e.name == name; });
+    if (it == m_entries.end()) {
+        return;
+    }
+    m_probes.erase(m_probes.begin() + (it - m_entries.begin()));
+    m_entries.erase(it);
+}
+
+void MemoryLedger::sample()
+{
+    m_totalBytes = 0;
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        Entry &entry = m_entries[i];
+        entry.bytes = m_probes[i] ? m_probes[i]() : 0;
+        entry.peakBytes = std::max(entry.peakBytes, entry.bytes);
+        m_totalBytes += entry.bytes;
+    }
+    for (int c = 0; c < static_cast<int>(MemoryCategory::Count); ++c) {
+        m_categoryPeak[c] = std::max(m_categoryPeak[c], categoryBytes(static_cast<MemoryCategory>(c)));
+    }
+    m_peakTotalBytes = std::max(m_peakTotalBytes, m_totalBytes);
+}
+
+std::size_t MemoryLedger::categoryBytes(MemoryCategory category) const
+{
+    std::size_t bytes = 0;
+    for (const Entry &entry : m_entries) {
+        if (entry.category == category)
+            bytes += entry.bytes;
+    }
+    return bytes;
+}
+
+std::size_t MemoryLedger::categoryPeakBytes(MemoryCategory category) const
+{
+    return m_categoryPeak[static_cast<int>(category)];
+}
+
+std::string MemoryLedger::report() const
+{
+    std::string text;
+    char line[160];
+    for (int c = 0; c < static_cast<int>(MemoryCategory::Count); ++c) {
+        const auto category = static_cast<MemoryCategory>(c);
+        std::snprintf(line, sizeof(line), "%-32s %12s   peak %12s\n", categoryName(category),
+                      Ledger::megabytes(categoryBytes(category)).c_str(),
+                      Ledger::megabytes(categoryPeakBytes(category)).c_str());
+        text += line;
+        for (const Entry &entry : m_entries) {
+            if (entry.category != category)
+                continue;
+            std::snprintf(line, sizeof(line), "  %-30s %12s   peak %12s\n", entry.name.c_str(),
+                          Ledger::megabytes(entry.bytes).c_str(), Ledger::megabytes(entry.peakBytes).c_str());
+            text += line;
+        }
+    }
+    std::snprintf(line, sizeof(line), "%-32s %12s   peak %12s\n", "Total", Ledger::megabytes(m_totalBytes).c_str(),
+                  Ledger::megabytes(m_peakTotalBytes).c_str());
+    text += line;
+    return text;
+}
+
+const char *MemoryLedger::categoryName(MemoryCategory category)
+{
+    switch (category) {
+    case MemoryCategory::Volume:
+        return "Volume";
+    case MemoryCategory::DerivedVolume:
+        return "Derived volumes";
+    case MemoryCategory::Projection:
+        return "Projections";
+    case MemoryCategory::Cache:
+        return "Caches";
+    case MemoryCategory::GpuTexture:
+        return "GPU textures (estimate)";
+    case MemoryCategory::Count:
+        break;
+    }
+    return "?";
+}
+
+std::size_t MemoryLedger::dataBytes(vtkDataObject *data)
+{
+    // GetActualMemorySize() is in KiB
+    return data ? static_cast<std::size_t>(data->GetActualMemorySize()) * 1024 : 0;
+}
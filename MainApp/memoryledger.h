@@ -0,0 +1,70 @@
+#ifndef MEMORYLEDGER_H
+#define MEMORYLEDGER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+class vtkDataObject;
+
+enum class MemoryCategory {
+    Volume = 0,     // decoded series
+    DerivedVolume,  // full-size copies derived from it (HU remap, gradients)
+    Projection,     // 2D outputs: MIP, DRR, oblique, CPR, W/L display images
+    Cache,          // working sets kept between frames
+    GpuTexture,     // estimate of what the OpenGL textures hold
+    Count,
+};
+
+/// @brief Bytes held per pipeline buffer, grouped by subsystem.
+///
+/// Owners register a probe that reports the buffer's current size; nothing
+/// is hooked into allocation. sample() re-reads every probe and updates the
+/// high-water marks, so peaks are as fine-grained as the sampling — the
+/// memory panel samples once a second and after every load.
+class MemoryLedger
+{
+public:
+    struct Entry
+    {
+        std::string name;
+        MemoryCategory category = MemoryCategory::Cache;
+        std::size_t bytes = 0;
+        std::size_t peakBytes = 0;
+    };
+
+    MemoryLedger() = default;
+
+    MemoryLedger(const MemoryLedger &) = delete;
+    MemoryLedger &operator=(const MemoryLedger &) = delete;
+
+    // Registers (or replaces) a probe. The probe must stay valid until
+    // untrack() or the ledger's destruction.
+    void track(const std::string &name, MemoryCategory category, std::function<std::size_t()> probe);
+    void untrack(const std::string &name);
+
+    void sample();
+
+    const std::vector<Entry> &entries() const { return m_entries; }
+    [[nodiscard]] std::size_t categoryBytes(MemoryCategory category) const;
+    [[nodiscard]] std::size_t categoryPeakBytes(MemoryCategory category) const;
+    [[nodiscard]] std::size_t totalBytes() const { return m_totalBytes; }
+    [[nodiscard]] std::size_t peakTotalBytes() const { return m_peakTotalBytes; }
+
+    // Plain-text table of every entry and the totals.
+    [[nodiscard]] std::string report() const;
+
+    static const char *categoryName(MemoryCategory category);
+    // vtkDataObject::GetActualMemorySize() in bytes; 0 for nullptr.
+    static std::size_t dataBytes(vtkDataObject *data);
+
+private:
+    std::vector<Entry> m_entries;
+    std::vector<std::function<std::size_t()>> m_probes; // parallel to m_entries
+    std::size_t m_categoryPeak[static_cast<int>(MemoryCategory::Count)] = {};
+    std::size_t m_totalBytes = 0;
+    std::size_t m_peakTotalBytes = 0;
+};
+
+#endif // MEMORYLEDGER_H
@@ -1,91 +1,22 @@
 #include "mipviewer.h"
-#include "vtkCamera.h"
-#include "vtkImageData.h"
-#include "vtkImageMapper3D.h"
-#include "vtkInteractorStyleImage.h"
-#include "vtkMatrix4x4.h"
 
 namespace Mip {
 
-/// @brief Reslice matrix + slab dimension for one projection axis.
-/// matrix[]   - storing the current selected axis matrix
-/// slabDimIdx - storing which axis the matrix belongs to
-struct AxisConfig
+static ProjectionViewer::Kernel kernel()
 {
-    double matrix[16];
-    int slabDimIdx;
-};
-
-// Column layout (VTK reslice axes convention):
-//   col 0 = world direction → output image X-axis
-//   col 1 = world direction → output image Y-axis
-//   col 2 = projection / slab direction (rays fire along this)
-//   col 3 = origin (filled at runtime)
-static constexpr AxisConfig kAxisConfigs[] = {
-
-    // axis directions :
-    // saggital x - to x +
-    // coronal y - to y +
-    // axial z - to z +
-
-    // Sagittal
-    // looking from  x- to x+ (projection) (1, 0, 0)
-    // ouput image plane will be in the yz plane
-    // output image horizontal axis y- to y+  (0, 1, 0)
-    // output image vertical axis z- to z+  (0, 0 , 1)
-
-    {{0, 0, 1, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1}, 0},
-
-    // coronal
-    {{1, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1}, 1},
-
-    // axial
-    {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}, 2},
-};
+    ProjectionViewer::Kernel kernel;
+    kernel.traceName = "mip.reslice";
+    kernel.combine = Bricks::Combine::Max;
+    kernel.slab = [](vtkImageReslice *reslice, int /*slabAxis*/, double /*slabSpacing*/) {
+        // take max voxel along each ray
+        reslice->SetSlabModeToMax();
+    };
+    return kernel;
+}
 
 } // namespace Mip
 
-void MipViewer::setInputData(vtkImageData *data)
-{
-    m_imageData = data;
-    m_reslice->SetInputData(data);
-    m_reslice->SetOutputScalarType(VTK_FLOAT);
-}
-
-vtkImageData *MipViewer::viewMip(MipAxis axis)
+MipViewer::MipViewer()
+    : m_projection(Mip::kernel())
 {
-    vtkImageData *vol = vtkImageData::SafeDownCast(m_reslice->GetInput());
-    if (!vol) {
-        return nullptr; // Fail fast — caller forgot setInputConnection()
-    }
-
-    int dims[3];      // the voxel no in each axis
-    double bounds[6]; // the max and min bounds in each axis
-    vol->GetDimensions(dims);
-    vol->GetBounds(bounds);
-
-    // calculate center from each max and min bounds
-    const double cx = (bounds[0] + bounds[1]) * 0.5;
-    const double cy = (bounds[2] + bounds[3]) * 0.5;
-    const double cz = (bounds[4] + bounds[5]) * 0.5;
-
-    const auto &cfg = Mip::kAxisConfigs[static_cast<int>(axis)];
-
-    vtkNew<vtkMatrix4x4> resliceAxes;
-    resliceAxes->DeepCopy(cfg.matrix);
-    // insierting center to the transilation column
-    resliceAxes->SetElement(0, 3, cx);
-    resliceAxes->SetElement(1, 3, cy);
-    resliceAxes->SetElement(2, 3, cz);
-
-    m_reslice->SetOutputDimensionality(2);
-    m_reslice->SetResliceAxes(resliceAxes);
-    m_reslice->SetInterpolationModeToLinear();
-    // take max voxel along each ray
-    m_reslice->SetSlabModeToMax();
-    // how many vosels deep the volume along slab axis
-    m_reslice->SetSlabNumberOfSlices(dims[cfg.slabDimIdx]);
-    m_reslice->Update();
-
-    return m_reslice->GetOutput();
 }
@@ -1,8 +1,7 @@
 #ifndef MIPVIEWER_H
 #define MIPVIEWER_H
 
-#include "vtkImageReslice.h"
-#include "vtkNew.h"
+#include "projectionviewer.h"
 
 enum class MipAxis {
     Sagittal = 0,
@@ -10,24 +9,47 @@ enum class MipAxis {
     Axial = 2,
 };
 
+/// @brief Maximum intensity projection: the brightest voxel along each ray.
+/// Reslicing, caching and scheduling live in ProjectionViewer.
 class MipViewer
 {
 public:
-    MipViewer() = default;
-    ~MipViewer() = default;
+    using Callback = ProjectionViewer::Callback;
+
+    MipViewer();
 
     // Non-copyable — owns VTK pipeline objects with reference semantics.
     MipViewer(const MipViewer &) = delete;
     MipViewer &operator=(const MipViewer &) = delete;
 
-    void setInputData(vtkImageData *data);
-
-    // Recompute and display the MIP for the given axis.
-    [[nodiscard]] vtkImageData *viewMip(MipAxis axis = MipAxis::Sagittal);
+    void setInputData(vtkImageData *data) { m_projection.setInput(data, nullptr); }
+    // Brick-store input (brick file or compressed bricks): projections run
+    // one brick layer at a time. The store must outlive this viewer or the
+    // next set*Input call.
+    void setBrickedInput(BrickStore *volume) { m_projection.setInput(volume ? volume->geometry() : nullptr, volume); }
+    // Bytes the viewer may spend on an axis-permuted input copy (sagittal
+    // rows contiguous); 0 = always reslice the native layout.
+    void setLayoutBudget(size_t bytes) { m_projection.setLayoutBudget(bytes); }
+    // Project only through this box (nullptr = whole volume); read on every view call.
+    void setVolumeOfInterest(const VolumeOfInterest *voi) { m_projection.setVolumeOfInterest(voi); }
+
+    // Recompute the MIP for the given axis on the calling thread.
+    [[nodiscard]] vtkImageData *viewMip(MipAxis axis = MipAxis::Sagittal)
+    {
+        return m_projection.view(static_cast<int>(axis));
+    }
+
+    // See ProjectionViewer::request() and prefetch().
+    void requestMip(MipAxis axis, Callback done) { m_projection.request(static_cast<int>(axis), std::move(done)); }
+    void prefetch() { m_projection.prefetch(); }
+
+    // Bytes held by the reslice output and the cached projections.
+    [[nodiscard]] size_t outputBytes() const { return m_projection.outputBytes(); }
+    // Bytes held by the axis-permuted input copy.
+    [[nodiscard]] size_t layoutBytes() const { return m_projection.layoutBytes(); }
 
 private:
-    vtkNew<vtkImageReslice> m_reslice;
-    vtkImageData *m_imageData = nullptr;
+    ProjectionViewer m_projection;
 };
 
 #endif // MIPVIEWER_H
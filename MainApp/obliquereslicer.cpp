@@ -0,0 +1,328 @@
+#include "obliquereslicer.h"
+#include "parallelfor.h"
+#include "tracing.h"
+#include "vtkMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace Oblique {
+
+// Output tile processed by one task. 64 floats = one 256-byte row strip, and
+// 32 rows keep the volume neighbourhood touched by the tile in L2.
+static constexpr int kTileWidth = 64;
+static constexpr int kTileHeight = 32;
+// Samples evaluated together: eight floats fill one AVX register, four
+// fill SSE/NEON twice.
+static constexpr int kLanes = 8;
+
+/// @brief Clip the column span [first, last) so every sample in it lies inside
+/// [0, dim - 1] on one axis. The sample position is start + i * step.
+static void clipSpan(double start, double step, int dim, int &first, int &last)
+{
+    const double hi = dim - 1;
+    if (std::abs(step) < 1e-12) {
+        if (start < 0.0 || start > hi)
+            last = first; // whole row outside
+        return;
+    }
+    double lo = (0.0 - start) / step;
+    double up = (hi - start) / step;
+    if (lo > up)
+        std::swap(lo, up);
+    // A near-zero step puts the crossings far outside int; clamp to the
+    // span in double before converting.
+    lo = std::min(std::max(lo, static_cast<double>(first)), static_cast<double>(last));
+    up = std::min(std::max(up, static_cast<double>(first) - 1.0), static_cast<double>(last));
+    first = std::max(first, static_cast<int>(std::ceil(lo)));
+    last = std::min(last, static_cast<int>(std::floor(up)) + 1);
+}
+
+template<typename T>
+void sampleRow(const T *volume,
+               const int dims[3],
+               const double start[3],
+               const double step[3],
+               int first,
+               int last,
+               float background,
+               float *out)
+{
+    if (dims[0] < 2 || dims[1] < 2 || dims[2] < 2) {
+        std::fill(out + first, out + last, background);
+        return;
+    }
+
+    const std::int64_t strideY = dims[0];
+    const std::int64_t strideZ = static_cast<std::int64_t>(dims[0]) * dims[1];
+    const int maxX = dims[0] - 2;
+    const int maxY = dims[1] - 2;
+    const int maxZ = dims[2] - 2;
+
+    const int c0 = first;
+    const int c1 = last;
+    clipSpan(start[0], step[0], dims[0], first, last);
+    clipSpan(start[1], step[1], dims[1], first, last);
+    clipSpan(start[2], step[2], dims[2], first, last);
+    if (last <= first) {
+        std::fill(out + c0, out + c1, background);
+        return;
+    }
+    std::fill(out + c0, out + first, background);
+    std::fill(out + last, out + c1, background);
+
+    // Interior span: no per-sample bounds test, lanes advance together.
+    // Start in double, then step incrementally in float — drift over one
+    // row is far below a voxel.
+    const float dux = static_cast<float>(step[0]);
+    const float duy = static_cast<float>(step[1]);
+    const float duz = static_cast<float>(step[2]);
+    float px[kLanes], py[kLanes], pz[kLanes];
+    for (int k = 0; k < kLanes; ++k) {
+        px[k] = static_cast<float>(start[0] + (first + k) * step[0]);
+        py[k] = static_cast<float>(start[1] + (first + k) * step[1]);
+        pz[k] = static_cast<float>(start[2] + (first + k) * step[2]);
+    }
+
+    // Each block runs full-width loops over contiguous lane arrays, so the
+    // index and blend loops compile to vector code. Only the corner loads
+    // are per-lane gathers. Lanes past `last` are clamped into the volume
+    // like the rest and simply not stored. Clamping happens in float before
+    // the truncation, which keeps the index loop branch-free.
+    const float hiX = static_cast<float>(maxX);
+    const float hiY = static_cast<float>(maxY);
+    const float hiZ = static_cast<float>(maxZ);
+    int ix[kLanes], iy[kLanes], iz[kLanes];
+    std::int64_t offset[kLanes];
+    float fx[kLanes], fy[kLanes], fz[kLanes];
+    float v000[kLanes], v100[kLanes], v010[kLanes], v110[kLanes];
+    float v001[kLanes], v101[kLanes], v011[kLanes], v111[kLanes];
+    for (int col = first; col < last; col += kLanes) {
+        for (int k = 0; k < kLanes; ++k) {
+            // Clamp keeps the +1 neighbour in range despite float drift.
+            ix[k] = static_cast<int>(std::min(std::max(px[k], 0.0f), hiX));
+            iy[k] = static_cast<int>(std::min(std::max(py[k], 0.0f), hiY));
+            iz[k] = static_cast<int>(std::min(std::max(pz[k], 0.0f), hiZ));
+            fx[k] = px[k] - static_cast<float>(ix[k]);
+            fy[k] = py[k] - static_cast<float>(iy[k]);
+            fz[k] = pz[k] - static_cast<float>(iz[k]);
+        }
+        for (int k = 0; k < kLanes; ++k)
+            offset[k] = ix[k] + iy[k] * strideY + iz[k] * strideZ;
+        for (int k = 0; k < kLanes; ++k) {
+            const T *p = volume + offset[k];
+            v000[k] = p[0];
+            v100[k] = p[1];
+            v010[k] = p[strideY];
+            v110[k] = p[strideY + 1];
+            v001[k] = p[strideZ];
+            v101[k] = p[strideZ + 1];
+            v011[k] = p[strideY + strideZ];
+            v111[k] = p[strideY + strideZ + 1];
+        }
+        float result[kLanes];
+        for (int k = 0; k < kLanes; ++k) {
+            const float c00 = v000[k] + fx[k] * (v100[k] - v000[k]);
+            const float c10 = v010[k] + fx[k] * (v110[k] - v010[k]);
+            const float c01 = v001[k] + fx[k] * (v101[k] - v001[k]);
+            const float c11 = v011[k] + fx[k] * (v111[k] - v011[k]);
+            const float y0 = c00 + fy[k] * (c10 - c00);
+            const float y1 = c01 + fy[k] * (c11 - c01);
+            result[k] = y0 + fz[k] * (y1 - y0);
+        }
+        std::copy(result, result + std::min(kLanes, last - col), out + col);
+
+        for (int k = 0; k < kLanes; ++k) {
+            px[k] += kLanes * dux;
+            py[k] += kLanes * duy;
+            pz[k] += kLanes * duz;
+        }
+    }
+}
+
+template<typename T>
+void resliceTrilinear(const T *volume,
+                      const int dims[3],
+                      const IndexPlane &plane,
+                      int outWidth,
+                      int outHeight,
+                      float background,
+                      float *out)
+{
+    const int tilesX = (outWidth + kTileWidth - 1) / kTileWidth;
+    const int tilesY = (outHeight + kTileHeight - 1) / kTileHeight;
+
+    Parallel::forRange(0, tilesX * tilesY, 1, [&](int tileBegin, int tileEnd) {
+        for (int tile = tileBegin; tile < tileEnd; ++tile) {
+            const int c0 = (tile % tilesX) * kTileWidth;
+            const int c1 = std::min(c0 + kTileWidth, outWidth);
+            const int r0 = (tile / tilesX) * kTileHeight;
+            const int r1 = std::min(r0 + kTileHeight, outHeight);
+
+            for (int row = r0; row < r1; ++row) {
+                const double start[3] = {plane.origin[0] + row * plane.dv[0],
+                                         plane.origin[1] + row * plane.dv[1],
+                                         plane.origin[2] + row * plane.dv[2]};
+                sampleRow(volume, dims, start, plane.du, c0, c1, background,
+                          out + static_cast<size_t>(row) * outWidth);
+            }
+        }
+    });
+}
+
+// Scalar types the DICOM reader can hand us.
+#define OBLIQUE_INSTANTIATE(T) \
+    template void sampleRow<T>(const T *, const int[3], const double[3], const double[3], int, int, float, float *); \
+    template void resliceTrilinear<T>(const T *, const int[3], const IndexPlane &, int, int, float, float *);
+OBLIQUE_INSTANTIATE(short)
+OBLIQUE_INSTANTIATE(unsigned short)
+OBLIQUE_INSTANTIATE(int)
+OBLIQUE_INSTANTIATE(float)
+OBLIQUE_INSTANTIATE(double)
+#undef OBLIQUE_INSTANTIATE
+
+/// @brief Rotate v about a unit axis by angle (radians) — Rodrigues' formula.
+static void rotateAbout(double v[3], const double axis[3], double angle)
+{
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    double cross[3];
+    vtkMath::Cross(axis, v, cross);
+    const double dot = vtkMath::Dot(axis, v);
+    for (int i = 0; i < 3; ++i)
+        v[i] = v[i] * c + cross[i] * s + axis[i] * dot * (1.0 - c);
+}
+
+} // namespace Oblique
+
+void ObliqueReslicer::setInputData(vtkImageData *data)
+{
+    m_imageData = data;
+    resetPlane();
+}
+
+void ObliqueReslicer::setOutputSize(int width, int height)
+{
+    m_outSize[0] = std::max(1, width);
+    m_outSize[1] = std::max(1, height);
+    resetPlane();
+}
+
+void ObliqueReslicer::resetPlane()
+{
+    m_axisU[0] = 0, m_axisU[1] = 1, m_axisU[2] = 0;
+    m_axisV[0] = 0, m_axisV[1] = 0, m_axisV[2] = 1;
+    if (!m_imageData)
+        return;
+
+    double bounds[6];
+    m_imageData->GetBounds(bounds);
+    m_center[0] = (bounds[0] + bounds[1]) * 0.5;
+    m_center[1] = (bounds[2] + bounds[3]) * 0.5;
+    m_center[2] = (bounds[4] + bounds[5]) * 0.5;
+
+    // Field of view = volume diagonal, so no rotation ever clips the volume.
+    const double diag = std::sqrt((bounds[1] - bounds[0]) * (bounds[1] - bounds[0])
+                                  + (bounds[3] - bounds[2]) * (bounds[3] - bounds[2])
+                                  + (bounds[5] - bounds[4]) * (bounds[5] - bounds[4]));
+    m_pixelSpacing = std::max(diag, 1.0) / std::max(m_outSize[0], m_outSize[1]);
+}
+
+void ObliqueReslicer::rotate(double yawDeg, double pitchDeg)
+{
+    const double yaw = vtkMath::RadiansFromDegrees(yawDeg);
+    const double pitch = vtkMath::RadiansFromDegrees(pitchDeg);
+
+    Oblique::rotateAbout(m_axisU, m_axisV, yaw);
+    Oblique::rotateAbout(m_axisV, m_axisU, pitch);
+
+    // Re-orthonormalize so repeated drags don't accumulate skew.
+    vtkMath::Normalize(m_axisU);
+    double normal[3];
+    vtkMath::Cross(m_axisU, m_axisV, normal);
+    vtkMath::Normalize(normal);
+    vtkMath::Cross(normal, m_axisU, m_axisV);
+}
+
+void ObliqueReslicer::translate(double distance)
+{
+    double normal[3];
+    vtkMath::Cross(m_axisU, m_axisV, normal);
+    for (int i = 0; i < 3; ++i)
+        m_center[i] += normal[i] * distance;
+}
+
+size_t ObliqueReslicer::outputBytes() const
+{
+    return static_cast<size_t>(m_output->GetActualMemorySize()) * 1024;
+}
+
+vtkImageData *ObliqueReslicer::reslice()
+{
+    TRACE_SCOPE("oblique.reslice");
+    if (!m_imageData || !m_imageData->GetScalarPointer()) {
+        return nullptr; // Fail fast — caller forgot setInputData()
+    }
+
+    const int width = m_outSize[0];
+    const int height = m_outSize[1];
+
+    int outDims[3];
+    m_output->GetDimensions(outDims);
+    if (outDims[0] != width || outDims[1] != height || m_output->GetScalarType() != VTK_FLOAT) {
+        m_output->SetDimensions(width, height, 1);
+        m_output->AllocateScalars(VTK_FLOAT, 1);
+    }
+    m_output->SetSpacing(m_pixelSpacing, m_pixelSpacing, 1.0);
+    m_output->SetOrigin(0.0, 0.0, 0.0);
+
+    int dims[3];
+    int extent[6];
+    double spacing[3];
+    double origin[3];
+    m_imageData->GetDimensions(dims);
+    m_imageData->GetExtent(extent);
+    m_imageData->GetSpacing(spacing);
+    m_imageData->GetOrigin(origin);
+
+    // World position of output pixel (0, 0): the plane center minus half the
+    // field of view along U and V.
+    const double halfW = (width - 1) * 0.5 * m_pixelSpacing;
+    const double halfH = (height - 1) * 0.5 * m_pixelSpacing;
+
+    Oblique::IndexPlane plane;
+    for (int i = 0; i < 3; ++i) {
+        const double corner = m_center[i] - halfW * m_axisU[i] - halfH * m_axisV[i];
+        // index into the scalar buffer, which starts at the extent's corner
+        plane.origin[i] = (corner - origin[i]) / spacing[i] - extent[2 * i];
+        plane.du[i] = m_axisU[i] * m_pixelSpacing / spacing[i];
+        plane.dv[i] = m_axisV[i] * m_pixelSpacing / spacing[i];
+    }
+
+    float *out = static_cast<float *>(m_output->GetScalarPointer());
+    void *in = m_imageData->GetScalarPointer();
+
+    switch (m_imageData->GetScalarType()) {
+    case VTK_SHORT:
+        Oblique::resliceTrilinear(static_cast<const short *>(in), dims, plane, width, height, m_background, out);
+        break;
+    case VTK_UNSIGNED_SHORT:
+        Oblique::resliceTrilinear(static_cast<const unsigned short *>(in), dims, plane, width, height, m_background, out);
+        break;
+    case VTK_INT:
+        Oblique::resliceTrilinear(static_cast<const int *>(in), dims, plane, width, height, m_background, out);
+        break;
+    case VTK_FLOAT:
+        Oblique::resliceTrilinear(static_cast<const float *>(in), dims, plane, width, height, m_background, out);
+        break;
+    case VTK_DOUBLE:
+        Oblique::resliceTrilinear(static_cast<const double *>(in), dims, plane, width, height, m_background, out);
+        break;
+    default:
+        return nullptr; // unsupported voxel type
+    }
+
+    m_output->Modified();
+    return m_output;
+}
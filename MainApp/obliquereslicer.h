@@ -0,0 +1,89 @@
+#ifndef OBLIQUERESLICER_H
+#define OBLIQUERESLICER_H
+
+#include "vtkImageData.h"
+#include "vtkNew.h"
+
+namespace Oblique {
+
+/// @brief Sampling plane expressed in continuous voxel-index space.
+/// origin - index of output pixel (0, 0)
+/// du     - index step per output column
+/// dv     - index step per output row
+struct IndexPlane
+{
+    double origin[3];
+    double du[3];
+    double dv[3];
+};
+
+// Trilinear samples along one line: columns [first, last) of a row whose
+// column 0 sits at index-space position `start` and advances by `step`.
+// Out-of-volume samples receive `background`; `out` points at column 0.
+template<typename T>
+void sampleRow(const T *volume,
+               const int dims[3],
+               const double start[3],
+               const double step[3],
+               int first,
+               int last,
+               float background,
+               float *out);
+
+// Trilinear reslice of a scalar volume onto an arbitrary plane.
+// Rows are processed in cache-sized tiles across the shared thread pool;
+// samples outside the volume receive `background`.
+template<typename T>
+void resliceTrilinear(const T *volume,
+                      const int dims[3],
+                      const IndexPlane &plane,
+                      int outWidth,
+                      int outHeight,
+                      float background,
+                      float *out);
+
+} // namespace Oblique
+
+class ObliqueReslicer
+{
+public:
+    ObliqueReslicer() = default;
+    ~ObliqueReslicer() = default;
+
+    // Non-copyable — owns VTK pipeline objects with reference semantics.
+    ObliqueReslicer(const ObliqueReslicer &) = delete;
+    ObliqueReslicer &operator=(const ObliqueReslicer &) = delete;
+
+    void setInputData(vtkImageData *data);
+    void setOutputSize(int width, int height);
+
+    // Plane through the volume center, sagittal like the default slice view.
+    void resetPlane();
+    // Free rotation: yaw turns about the plane's vertical axis, pitch about
+    // its horizontal axis. Angles in degrees.
+    void rotate(double yawDeg, double pitchDeg);
+    // Move the plane along its normal, in world units (mm).
+    void translate(double distance);
+
+    const double *center() const { return m_center; }
+    const double *axisU() const { return m_axisU; }
+    const double *axisV() const { return m_axisV; }
+    double pixelSpacing() const { return m_pixelSpacing; }
+
+    // Resample the current plane. The returned image is reused across calls.
+    [[nodiscard]] vtkImageData *reslice();
+    [[nodiscard]] size_t outputBytes() const;
+
+private:
+    vtkImageData *m_imageData = nullptr;
+    vtkNew<vtkImageData> m_output;
+    int m_outSize[2] = {512, 512};
+    float m_background = 0.0f; // matches vtkImageReslice's default
+
+    double m_center[3] = {0, 0, 0};
+    double m_axisU[3] = {0, 1, 0}; // world direction → output X
+    double m_axisV[3] = {0, 0, 1}; // world direction → output Y
+    double m_pixelSpacing = 1.0;
+};
+
+#endif // OBLIQUERESLICER_H
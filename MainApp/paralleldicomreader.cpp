@@ -0,0 +1,269 @@
+#include "paralleldicomreader.h"
+#include "parallelfor.h"
+#include "tracing.h"
+
+#include "vtkDICOMMetaData.h"
+#include "vtkDataArray.h"
+#include "vtkErrorCode.h"
+#include "vtkImageData.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkIntArray.h"
+#include "vtkObjectFactory.h"
+#include "vtkPointData.h"
+#include "vtkStreamingDemandDrivenPipeline.h"
+#include "vtkStringArray.h"
+
+#ifdef HAVE_GDCM
+#include "gdcmImage.h"
+#include "gdcmImageReader.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+vtkStandardNewMacro(ParallelDicomReader);
+
+#ifdef HAVE_GDCM
+namespace Decode {
+
+// Decodes a single-frame file into `stored`, exactly `bytes` of pixel data
+// as the file stores it.
+static bool file(const std::string &path, char *stored, std::size_t bytes)
+{
+    gdcm::ImageReader reader;
+    reader.SetFileName(path.c_str());
+    if (!reader.Read()) {
+        return false;
+    }
+    const gdcm::Image &image = reader.GetImage();
+    return static_cast<std::size_t>(image.GetBufferLength()) == bytes && image.GetBuffer(stored);
+}
+
+// Turns the rows of a slice bottom-up, as vtkDICOMReader's default row order has them.
+static void flipRows(char *slice, std::size_t bytes, std::size_t rowBytes)
+{
+    const std::size_t rows = bytes / rowBytes;
+    for (std::size_t top = 0, bottom = rows - 1; top < bottom; ++top, --bottom)
+        std::swap_ranges(slice + top * rowBytes, slice + (top + 1) * rowBytes, slice + bottom * rowBytes);
+}
+
+// VTK type of the stored pixels, or VTK_VOID for a layout this path leaves
+// to vtkDICOMReader.
+static int storedType(int bitsAllocated, bool isSigned)
+{
+    switch (bitsAllocated) {
+    case 8:
+        return isSigned ? VTK_SIGNED_CHAR : VTK_UNSIGNED_CHAR;
+    case 16:
+        return isSigned ? VTK_SHORT : VTK_UNSIGNED_SHORT;
+    case 32:
+        return isSigned ? VTK_INT : VTK_UNSIGNED_INT;
+    default:
+        return VTK_VOID;
+    }
+}
+
+// Slope and intercept of one file; absent means identity.
+static void rescaleOf(vtkDICOMMetaData *meta, int file, double &slope, double &intercept)
+{
+    const vtkDICOMValue &s = meta->Get(file, DC::RescaleSlope);
+    const vtkDICOMValue &i = meta->Get(file, DC::RescaleIntercept);
+    slope = s.IsValid() ? s.AsDouble() : 1.0;
+    intercept = i.IsValid() ? i.AsDouble() : 0.0;
+}
+
+template <class TIn, class TOut>
+static void rescale(const TIn *in, TOut *out, std::size_t count, double slope, double intercept)
+{
+    // exact for integer outputs: vtkDICOMReader only picks one for an
+    // integer slope and intercept
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = static_cast<TOut>(in[i] * slope + intercept);
+}
+
+// Stored values of type `inType` to the output's type, as vtkDICOMReader's
+// AutoRescale converts them.
+template <class TOut>
+static void rescaleTo(const char *in, int inType, TOut *out, std::size_t count, double slope, double intercept)
+{
+    switch (inType) {
+    case VTK_SIGNED_CHAR:
+        rescale(reinterpret_cast<const signed char *>(in), out, count, slope, intercept);
+        break;
+    case VTK_UNSIGNED_CHAR:
+        rescale(reinterpret_cast<const unsigned char *>(in), out, count, slope, intercept);
+        break;
+    case VTK_SHORT:
+        rescale(reinterpret_cast<const short *>(in), out, count, slope, intercept);
+        break;
+    case VTK_UNSIGNED_SHORT:
+        rescale(reinterpret_cast<const unsigned short *>(in), out, count, slope, intercept);
+        break;
+    case VTK_INT:
+        rescale(reinterpret_cast<const int *>(in), out, count, slope, intercept);
+        break;
+    case VTK_UNSIGNED_INT:
+        rescale(reinterpret_cast<const unsigned int *>(in), out, count, slope, intercept);
+        break;
+    }
+}
+
+} // namespace Decode
+#endif
+
+void ParallelDicomReader::SetParallelDecode(bool on)
+{
+    if (m_parallel != on) {
+        m_parallel = on;
+        this->Modified();
+    }
+}
+
+bool ParallelDicomReader::isCompressed(const std::string &transferSyntax)
+{
+    return !transferSyntax.empty()
+           && transferSyntax != "1.2.840.10008.1.2"    // implicit VR little endian
+           && transferSyntax != "1.2.840.10008.1.2.1"  // explicit VR little endian
+           && transferSyntax != "1.2.840.10008.1.2.2"; // explicit VR big endian
+}
+
+int ParallelDicomReader::RequestData(vtkInformation *request,
+                                     vtkInformationVector **inputVector,
+                                     vtkInformationVector *outputVector)
+{
+    m_decodedWithGdcm = false;
+#ifdef HAVE_GDCM
+    // the overlay port and a reader already in error stay with vtkDICOMReader
+    if (request->Get(vtkDemandDrivenPipeline::FROM_OUTPUT_PORT()) <= 0
+        && this->GetErrorCode() == vtkErrorCode::NoError) {
+        bool failed = false;
+        if (decodeWithGdcm(outputVector, failed)) {
+            m_decodedWithGdcm = true;
+            if (failed) {
+                this->SetErrorCode(vtkErrorCode::FileFormatError);
+                return 0;
+            }
+            return 1;
+        }
+    }
+#endif
+    return vtkDICOMReader::RequestData(request, inputVector, outputVector);
+}
+
+#ifdef HAVE_GDCM
+bool ParallelDicomReader::decodeWithGdcm(vtkInformationVector *outputVector, bool &failed)
+{
+    vtkStringArray *files = this->GetFileNames();
+    vtkIntArray *fileIndex = this->GetFileIndexArray();
+    vtkIntArray *frameIndex = this->GetFrameIndexArray();
+    vtkDICOMMetaData *meta = this->GetMetaData();
+    if (!files || !fileIndex || !frameIndex || !meta || fileIndex->GetNumberOfComponents() != 1) {
+        return false;
+    }
+
+    vtkInformation *outInfo = outputVector->GetInformationObject(0);
+    int extent[6];
+    int whole[6];
+    outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), extent);
+    outInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), whole);
+    if (extent[0] != whole[0] || extent[1] != whole[1] || extent[2] != whole[2] || extent[3] != whole[3]) {
+        return false; // part of a slice: vtkDICOMReader crops while it reads
+    }
+    const int first = extent[4] - whole[4];
+    const int count = extent[5] - extent[4] + 1;
+    if (count <= 0 || first + count > fileIndex->GetNumberOfTuples()) {
+        return false;
+    }
+
+    // Decided over the whole series, so every update extent of one series
+    // (the bricked loaders pull it layer by layer) takes the same path.
+    double slope = 1.0;
+    double intercept = 0.0;
+    Decode::rescaleOf(meta, 0, slope, intercept);
+    const int bitsAllocated = meta->Get(0, DC::BitsAllocated).AsInt();
+    const int pixelRepresentation = meta->Get(0, DC::PixelRepresentation).AsInt();
+    const int stored = Decode::storedType(bitsAllocated, pixelRepresentation == 1);
+    if (stored == VTK_VOID) {
+        return false;
+    }
+    for (vtkIdType slice = 0; slice < fileIndex->GetNumberOfTuples(); ++slice) {
+        const int file = fileIndex->GetValue(slice);
+        if (frameIndex->GetValue(slice) != 0 || file < 0 || file >= files->GetNumberOfValues()) {
+            return false;
+        }
+        double fileSlope = 1.0;
+        double fileIntercept = 0.0;
+        Decode::rescaleOf(meta, file, fileSlope, fileIntercept);
+        if (!isCompressed(meta->Get(file, DC::TransferSyntaxUID).AsString())
+            || meta->Get(file, DC::NumberOfFrames).AsInt() > 1
+            || meta->Get(file, DC::SamplesPerPixel).AsInt() > 1
+            || meta->Get(file, DC::BitsAllocated).AsInt() != bitsAllocated
+            || meta->Get(file, DC::PixelRepresentation).AsInt() != pixelRepresentation
+            || fileSlope != slope || fileIntercept != intercept) {
+            return false;
+        }
+    }
+    if (!this->GetAutoRescale()) {
+        slope = 1.0;
+        intercept = 0.0;
+    }
+
+    TRACE_SCOPE("dicom.decode");
+    vtkImageData *data = vtkImageData::GetData(outInfo);
+    this->AllocateOutputData(data, outInfo, extent);
+    data->GetPointData()->GetScalars()->SetName("PixelData");
+
+    const std::size_t pixels = std::size_t(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1);
+    const std::size_t rowBytes = std::size_t(extent[1] - extent[0] + 1) * data->GetScalarSize()
+                                 * data->GetNumberOfScalarComponents();
+    const std::size_t sliceBytes = rowBytes * (extent[3] - extent[2] + 1);
+    const std::size_t storedBytes = pixels * (bitsAllocated / 8);
+    const std::size_t flipRowBytes = this->GetMemoryRowOrder() == vtkDICOMReader::BottomUp ? rowBytes : 0;
+    // Stored values already in the output's type and units decode straight
+    // into their slice; anything else (a CT series stored unsigned with
+    // intercept -1024) goes through a per-batch buffer and is rescaled.
+    const int outType = data->GetScalarType();
+    const bool direct = stored == outType && slope == 1.0 && intercept == 0.0;
+    auto *base = static_cast<char *>(data->GetScalarPointer());
+    std::atomic<int> badFile{-1};
+    const std::function<void(int, int)> decodeSlices = [&](int begin, int end) {
+        std::vector<char> buffer(direct ? 0 : storedBytes);
+        for (int z = begin; z < end; ++z) {
+            const int file = fileIndex->GetValue(first + z);
+            char *slice = base + z * sliceBytes;
+            if (!Decode::file(files->GetValue(file), direct ? slice : buffer.data(), storedBytes)) {
+                badFile = file;
+                continue;
+            }
+            if (!direct) {
+                switch (outType) {
+                    vtkTemplateMacro(Decode::rescaleTo(buffer.data(), stored, reinterpret_cast<VTK_TT *>(slice),
+                                                       pixels, slope, intercept));
+                }
+            }
+            if (flipRowBytes > 0)
+                Decode::flipRows(slice, sliceBytes, flipRowBytes);
+        }
+    };
+
+    // Batches keep progress events (and with them AbortExecute) on this
+    // thread, a few slices per worker apart.
+    const int batch = m_parallel ? std::max(1, Parallel::threadCount() * 4) : 1;
+    for (int begin = 0; begin < count && !this->GetAbortExecute(); begin += batch) {
+        const int end = std::min(count, begin + batch);
+        if (m_parallel)
+            Parallel::forRange(begin, end, 1, decodeSlices);
+        else
+            decodeSlices(begin, end);
+        this->UpdateProgress(double(end) / count);
+    }
+
+    if (badFile >= 0) {
+        vtkErrorMacro("Cannot decode " << files->GetValue(badFile.load()));
+        failed = true;
+    }
+    return true;
+}
+#endif
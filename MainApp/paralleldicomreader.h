@@ -0,0 +1,64 @@
+#ifndef PARALLELDICOMREADER_H
+#define PARALLELDICOMREADER_H
+
+#include "vtkDICOMReader.h"
+
+#include <string>
+
+/// @brief vtkDICOMReader that decodes compressed series on every core.
+///
+/// vtkDICOMReader decodes one file after the other, which for JPEG-Lossless
+/// and JPEG 2000 exports makes decompression the whole load time. For a
+/// series in a compressed transfer syntax (one single-frame, single-sample
+/// file per slice, one rescale for all files) this reader allocates the
+/// output once and decodes the files of the update extent with GDCM on the
+/// shared scheduler, each into its slice of the output and rescaled to the
+/// output type as vtkDICOMReader's AutoRescale would; every decode runs its
+/// own gdcm::ImageReader, so workers share no codec state.
+/// Everything else — uncompressed data, multi-frame files, per-file rescale,
+/// builds without GDCM (HAVE_GDCM, see shared_config.pri) — goes through
+/// vtkDICOMReader unchanged. Geometry, slice order, row order and meta data
+/// always come from vtkDICOMReader.
+///
+/// Progress events and AbortExecute are handled between batches of slices,
+/// on the thread that runs Update().
+class ParallelDicomReader : public vtkDICOMReader
+{
+public:
+    static ParallelDicomReader *New();
+    vtkTypeMacro(ParallelDicomReader, vtkDICOMReader);
+
+    // Off: compressed series are still decoded by GDCM, one file at a time
+    // (the benchmark's serial baseline).
+    void SetParallelDecode(bool on);
+    [[nodiscard]] bool GetParallelDecode() const { return m_parallel; }
+
+    // Whether the last update took the GDCM path.
+    [[nodiscard]] bool GetDecodedWithGdcm() const { return m_decodedWithGdcm; }
+
+    // True for encapsulated / deflated syntaxes, false for the three native ones.
+    [[nodiscard]] static bool isCompressed(const std::string &transferSyntax);
+
+protected:
+    ParallelDicomReader() = default;
+    ~ParallelDicomReader() override = default;
+
+    int RequestData(vtkInformation *request,
+                    vtkInformationVector **inputVector,
+                    vtkInformationVector *outputVector) override;
+
+private:
+    ParallelDicomReader(const ParallelDicomReader &) = delete;
+    void operator=(const ParallelDicomReader &) = delete;
+
+#ifdef HAVE_GDCM
+    // The GDCM path, or false (nothing written) when the series needs
+    // vtkDICOMReader; `failed` is set when a file would not decode.
+    bool decodeWithGdcm(vtkInformationVector *outputVector, bool &failed);
+#endif
+
+    bool m_parallel = true;
+    bool m_decodedWithGdcm = false;
+};
+
+#endif // PARALLELDICOMREADER_H
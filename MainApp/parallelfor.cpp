@@ -0,0 +1,118 @@
+#include "parallelfor.h"
+#include "taskscheduler.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+thread_local bool t_insideChunk = false;
+
+/// @brief Marks the thread as running a chunk for its lifetime; the flag is
+/// restored on the way out even when the chunk throws.
+struct ChunkScope
+{
+    const bool outer = t_insideChunk;
+    ChunkScope() { t_insideChunk = true; }
+    ~ChunkScope() { t_insideChunk = outer; }
+
+    ChunkScope(const ChunkScope &) = delete;
+    ChunkScope &operator=(const ChunkScope &) = delete;
+};
+
+/// @brief One forRange() call. Chunks are claimed through an atomic cursor so
+/// the caller and any number of workers can drain it concurrently.
+struct Job
+{
+    std::atomic<int> next{0};
+    int end = 0;
+    int grain = 1;
+    // a copy: a helper may still be on its way out after the caller returned
+    std::function<void(int, int)> fn;
+
+    std::atomic<int> remaining{0}; // chunks not yet finished
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    std::atomic<bool> failed{false};
+    std::exception_ptr error; // the first exception fn threw, under doneMutex
+
+    void runChunks()
+    {
+        for (;;) {
+            const int b = next.fetch_add(grain);
+            if (b >= end)
+                return;
+            // after a failure the remaining chunks are only counted off
+            if (!failed.load()) {
+                try {
+                    TRACE_SCOPE("parallel.chunk");
+                    ChunkScope chunk;
+                    fn(b, std::min(b + grain, end));
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    if (!error)
+                        error = std::current_exception();
+                    failed = true;
+                }
+            }
+            if (remaining.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(doneMutex);
+                doneCv.notify_all();
+            }
+        }
+    }
+};
+
+} // namespace
+
+namespace Parallel {
+
+int threadCount()
+{
+    return TaskScheduler::instance().threadCount();
+}
+
+void forRange(int begin, int end, int grain, const std::function<void(int, int)> &fn)
+{
+    if (end <= begin)
+        return;
+    grain = std::max(1, grain);
+
+    // Small ranges and nested calls: no point paying for the hand-off.
+    if (t_insideChunk || end - begin <= grain || threadCount() == 1) {
+        for (int b = begin; b < end; b += grain)
+            fn(b, std::min(b + grain, end));
+        return;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->next = begin;
+    job->end = end;
+    job->grain = grain;
+    job->fn = fn;
+    const int chunks = (end - begin + grain - 1) / grain;
+    job->remaining = chunks;
+
+    // Helpers go through the shared scheduler at the caller's priority, so a
+    // prefetch loop cannot crowd out an interactive one. Each holds the job
+    // alive; one that starts after the caller drained everything finds no
+    // chunk left and returns without calling fn.
+    TaskScheduler &scheduler = TaskScheduler::instance();
+    const int helpers = std::min(threadCount() - 1, chunks - 1);
+    for (int i = 0; i < helpers; ++i)
+        scheduler.submit(TaskScheduler::currentPriority(), [job] { job->runChunks(); });
+
+    job->runChunks();
+
+    std::unique_lock<std::mutex> lock(job->doneMutex);
+    job->doneCv.wait(lock, [&] { return job->remaining.load() == 0; });
+    if (job->error)
+        std::rethrow_exception(job->error);
+}
+
+} // namespace Parallel
@@ -0,0 +1,20 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <functional>
+
+namespace Parallel {
+
+// Number of threads that take part in forRange() (pool workers + caller).
+[[nodiscard]] int threadCount();
+
+// Split [begin, end) into chunks of `grain` items and run fn(chunkBegin, chunkEnd)
+// on the shared TaskScheduler. The calling thread helps and blocks until every
+// chunk has finished. Nested calls from inside a chunk run inline. If fn
+// throws, the chunks not yet started are skipped and the first exception is
+// rethrown here once every running chunk has returned.
+void forRange(int begin, int end, int grain, const std::function<void(int, int)> &fn);
+
+} // namespace Parallel
+
+#endif // PARALLELFOR_H
@@ -0,0 +1,109 @@
+#include "preintegration.h"
+#include "parallelfor.h"
+
+#include <algorithm>
+#include <cmath>
+
+void PreIntegrationTable::setTransferFunction(const float *base, int n, double unitDistance)
+{
+    for (Slot &slot : m_slots) {
+        slot.length = -1.0;
+        slot.rgba.clear();
+    }
+    m_tau.clear();
+    m_color.clear();
+    m_tauIntegral.clear();
+    m_colorIntegral.clear();
+    if (!base || n <= 0)
+        return;
+
+    // Extinction per fine entry; opacity is clamped below 1 so the log stays
+    // finite (an opaque entry then saturates any segment anyway).
+    const double unit = std::max(1e-6, unitDistance);
+    std::vector<double> fineTau(n);
+    for (int j = 0; j < n; ++j) {
+        const double alpha = std::min(0.9999, std::max(0.0, static_cast<double>(base[j * 4 + 3])));
+        fineTau[j] = -std::log(1.0 - alpha) / unit;
+    }
+
+    // Running integrals over the fine entries (piecewise constant), sampled at
+    // the center of each coarse bin and expressed in coarse-bin units.
+    const double finePerBin = static_cast<double>(n) / kSize;
+    m_tau.resize(kSize);
+    m_color.resize(kSize * 3);
+    m_tauIntegral.resize(kSize);
+    m_colorIntegral.resize(kSize * 3);
+    double tauSum = 0.0;
+    double colorSum[3] = {0.0, 0.0, 0.0};
+    int next = 0; // fine entries [0, next) are summed
+    for (int i = 0; i < kSize; ++i) {
+        const double x = (i + 0.5) * finePerBin;
+        const int j = std::min(static_cast<int>(x), n - 1);
+        for (; next < j; ++next) {
+            tauSum += fineTau[next];
+            for (int c = 0; c < 3; ++c)
+                colorSum[c] += fineTau[next] * base[next * 4 + c];
+        }
+        const double partial = x - j;
+        m_tau[i] = static_cast<float>(fineTau[j]);
+        m_tauIntegral[i] = (tauSum + partial * fineTau[j]) / finePerBin;
+        for (int c = 0; c < 3; ++c) {
+            m_color[i * 3 + c] = base[j * 4 + c];
+            m_colorIntegral[i * 3 + c] = (colorSum[c] + partial * fineTau[j] * base[j * 4 + c]) / finePerBin;
+        }
+    }
+}
+
+const float *PreIntegrationTable::table(double segmentLength)
+{
+    if (m_tau.empty())
+        return nullptr;
+
+    ++m_useCounter;
+    for (Slot &slot : m_slots) {
+        if (slot.length == segmentLength) {
+            slot.lastUse = m_useCounter;
+            return slot.rgba.data();
+        }
+    }
+
+    Slot &victim = m_slots[0].lastUse <= m_slots[1].lastUse ? m_slots[0] : m_slots[1];
+    victim.length = segmentLength;
+    victim.lastUse = m_useCounter;
+    build(segmentLength, victim.rgba);
+    return victim.rgba.data();
+}
+
+// Segment opacity from the mean extinction between the two scalars; color is
+// the extinction-weighted mean color, premultiplied. Self-attenuation inside
+// the segment is neglected, which is exact for constant color.
+void PreIntegrationTable::build(double length, std::vector<float> &rgba) const
+{
+    rgba.resize(static_cast<size_t>(kSize) * kSize * 4);
+    Parallel::forRange(0, kSize, 8, [&](int backBegin, int backEnd) {
+        for (int back = backBegin; back < backEnd; ++back) {
+            float *row = rgba.data() + static_cast<size_t>(back) * kSize * 4;
+            for (int front = 0; front < kSize; ++front) {
+                float *entry = row + front * 4;
+                double alpha;
+                double color[3];
+                if (front == back) {
+                    alpha = 1.0 - std::exp(-m_tau[back] * length);
+                    for (int c = 0; c < 3; ++c)
+                        color[c] = m_color[back * 3 + c];
+                } else {
+                    const double tauDelta = m_tauIntegral[back] - m_tauIntegral[front];
+                    alpha = 1.0 - std::exp(-tauDelta / (back - front) * length);
+                    for (int c = 0; c < 3; ++c) {
+                        color[c] = std::abs(tauDelta) > 1e-12
+                                       ? (m_colorIntegral[back * 3 + c] - m_colorIntegral[front * 3 + c]) / tauDelta
+                                       : 0.5 * (m_color[front * 3 + c] + m_color[back * 3 + c]);
+                    }
+                }
+                for (int c = 0; c < 3; ++c)
+                    entry[c] = static_cast<float>(color[c] * alpha);
+                entry[3] = static_cast<float>(alpha);
+            }
+        }
+    });
+}
@@ -0,0 +1,52 @@
+#ifndef PREINTEGRATION_H
+#define PREINTEGRATION_H
+
+#include <array>
+#include <vector>
+
+/// @brief Pre-integrated transfer function for composite raycasting.
+///
+/// Entry (front, back) holds the color and opacity of a whole ray segment
+/// whose scalar runs linearly from `front` to `back`, so features narrower
+/// than the sample distance (thin bone edges) still contribute. Only prefix
+/// integrals are kept per transfer function; the 2D tables are built per
+/// segment length on demand, in parallel, and the last two lengths are
+/// cached (progressive passes alternate between a coarse and a fine step).
+class PreIntegrationTable
+{
+public:
+    // Scalar bins per axis; size x size x RGBA floats per table.
+    static constexpr int kSize = 256;
+
+    PreIntegrationTable() = default;
+
+    // `base`: n entries of (r, g, b, opacity per unitDistance) evenly spanning
+    // the scalar range. Drops every cached table.
+    void setTransferFunction(const float *base, int n, double unitDistance);
+
+    // kSize x kSize premultiplied RGBA, indexed [(back * kSize + front) * 4].
+    // Empty before setTransferFunction().
+    [[nodiscard]] const float *table(double segmentLength);
+
+private:
+    struct Slot
+    {
+        double length = -1.0;
+        unsigned long lastUse = 0;
+        std::vector<float> rgba;
+    };
+
+    void build(double length, std::vector<float> &rgba) const;
+
+    // Per bin center: extinction (1/mm), color, and running integrals of
+    // extinction and extinction-weighted color from the low end of the range.
+    std::vector<float> m_tau;
+    std::vector<float> m_color;
+    std::vector<double> m_tauIntegral;
+    std::vector<double> m_colorIntegral;
+
+    std::array<Slot, 2> m_slots;
+    unsigned long m_useCounter = 0;
+};
+
+#endif // PREINTEGRATION_H
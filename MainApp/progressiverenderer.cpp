@@ -0,0 +1,83 @@
+#include "progressiverenderer.h"
+#include "vtkCamera.h"
+#include "vtkCommand.h"
+#include "vtkRenderWindow.h"
+#include "vtkRenderer.h"
+
+#include <algorithm>
+
+ProgressiveRenderer::ProgressiveRenderer(vtkRenderer *renderer, PassHandler applyPass, QObject *parent)
+    : QObject(parent)
+    , m_renderer(renderer)
+    , m_applyPass(std::move(applyPass))
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &ProgressiveRenderer::refineStep);
+
+    m_camera = m_renderer->GetActiveCamera();
+    m_cameraCallback->SetCallback(ProgressiveRenderer::onCameraModified);
+    m_cameraCallback->SetClientData(this);
+    m_observerTag = m_camera->AddObserver(vtkCommand::ModifiedEvent, m_cameraCallback);
+    viewChanged(); // record the starting view
+
+    m_applyPass(m_pass);
+}
+
+ProgressiveRenderer::~ProgressiveRenderer()
+{
+    m_camera->RemoveObserver(m_observerTag);
+}
+
+void ProgressiveRenderer::onCameraModified(vtkObject * /*caller*/,
+                                           unsigned long /*eventId*/,
+                                           void *clientData,
+                                           void * /*callData*/)
+{
+    auto *self = static_cast<ProgressiveRenderer *>(clientData);
+    // Clipping-range resets during a render modify the camera too — only a
+    // real view change interrupts refinement.
+    if (self->m_refining || !self->viewChanged())
+        return;
+    self->interrupt();
+}
+
+void ProgressiveRenderer::interrupt()
+{
+    if (m_pass != RefinePass::Preview) {
+        m_pass = RefinePass::Preview;
+        m_applyPass(m_pass);
+    }
+    m_timer.start(m_settleDelayMs);
+}
+
+// One pass per timer tick; the zero-delay restart returns to the event loop
+// first, so a mouse event queued meanwhile wins over the next pass.
+void ProgressiveRenderer::refineStep()
+{
+    if (m_pass == RefinePass::Final)
+        return;
+
+    m_pass = m_pass == RefinePass::Preview ? RefinePass::FullResolution : RefinePass::Final;
+    m_applyPass(m_pass);
+
+    m_refining = true;
+    m_renderer->GetRenderWindow()->Render();
+    m_refining = false;
+
+    if (m_pass != RefinePass::Final)
+        m_timer.start(0);
+}
+
+bool ProgressiveRenderer::viewChanged()
+{
+    double view[11];
+    m_camera->GetPosition(view);
+    m_camera->GetFocalPoint(view + 3);
+    m_camera->GetViewUp(view + 6);
+    view[9] = m_camera->GetViewAngle();
+    view[10] = m_camera->GetParallelScale();
+    if (std::equal(view, view + 11, m_lastView))
+        return false;
+    std::copy(view, view + 11, m_lastView);
+    return true;
+}
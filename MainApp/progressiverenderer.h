@@ -0,0 +1,60 @@
+#ifndef PROGRESSIVERENDERER_H
+#define PROGRESSIVERENDERER_H
+
+#include "cpuraycaster.h"
+#include "vtkCallbackCommand.h"
+#include "vtkNew.h"
+
+#include <QObject>
+#include <QTimer>
+#include <functional>
+
+class vtkCamera;
+class vtkRenderer;
+
+/// @brief Drives a 3D view through RefinePass levels.
+///
+/// Every camera change drops the view to Preview and restarts a short settle
+/// timer; once the camera has been still that long, the remaining passes run
+/// one per event-loop turn, so new interaction interrupts refinement between
+/// passes. How a pass is applied is up to the caller (CPU raycaster pass, or
+/// GPU mapper image/sample distances).
+class ProgressiveRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    using PassHandler = std::function<void(RefinePass)>;
+
+    ProgressiveRenderer(vtkRenderer *renderer, PassHandler applyPass, QObject *parent = nullptr);
+    ~ProgressiveRenderer() override;
+
+    // Camera stillness (ms) required before refinement starts.
+    void setSettleDelay(int ms) { m_settleDelayMs = ms; }
+    RefinePass currentPass() const { return m_pass; }
+
+    // Scene changes other than the camera (e.g. a crop box drag) restart
+    // refinement the same way a camera move does.
+    void interrupt();
+
+private slots:
+    void refineStep();
+
+private:
+    static void onCameraModified(vtkObject *caller, unsigned long eventId, void *clientData, void *callData);
+    bool viewChanged();
+
+    vtkRenderer *m_renderer = nullptr;
+    vtkCamera *m_camera = nullptr;
+    unsigned long m_observerTag = 0;
+    vtkNew<vtkCallbackCommand> m_cameraCallback;
+    PassHandler m_applyPass;
+
+    QTimer m_timer;
+    int m_settleDelayMs = 150;
+    RefinePass m_pass = RefinePass::Final;
+    bool m_refining = false;   // our own Render() also touches the camera
+    double m_lastView[11] = {}; // position, focal point, view up, angle, scale
+};
+
+#endif // PROGRESSIVERENDERER_H
@@ -0,0 +1,278 @@
+#include "projectionviewer.h"
+#include "memoryledger.h"
+#include "tracing.h"
+#include "vtkMatrix4x4.h"
+#include "volumeofinterest.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace Projection {
+
+/// @brief Reslice matrix + slab dimension for one projection axis.
+/// matrix[]   - storing the current selected axis matrix
+/// slabDimIdx - storing which axis the matrix belongs to
+/// planeDimIdx - volume axes along the output image X and Y
+struct AxisConfig
+{
+    double matrix[16];
+    int slabDimIdx;
+    int planeDimIdx[2];
+};
+
+// Column layout (VTK reslice axes convention):
+//   col 0 = world direction → output image X-axis
+//   col 1 = world direction → output image Y-axis
+//   col 2 = projection / slab direction (rays fire along this)
+//   col 3 = origin (filled at runtime)
+static constexpr AxisConfig kAxisConfigs[] = {
+
+    // axis directions :
+    // saggital x - to x +
+    // coronal y - to y +
+    // axial z - to z +
+
+    // Sagittal
+    // looking from  x- to x+ (projection) (1, 0, 0)
+    // ouput image plane will be in the yz plane
+    // output image horizontal axis y- to y+  (0, 1, 0)
+    // output image vertical axis z- to z+  (0, 0 , 1)
+
+    {{0, 0, 1, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1}, 0, {1, 2}},
+
+    // coronal
+    {{1, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1}, 1, {0, 2}},
+
+    // axial
+    {{1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}, 2, {0, 1}},
+};
+
+} // namespace Projection
+
+ProjectionViewer::ProjectionViewer(Kernel kernel)
+    : m_kernel(std::move(kernel))
+{
+    Trace::observe(m_reslice, m_kernel.traceName);
+}
+
+ProjectionViewer::~ProjectionViewer()
+{
+    m_requestToken.cancel();
+    m_prefetchToken.cancel();
+    for (auto &future : m_pending)
+        future.wait();
+}
+
+void ProjectionViewer::setInput(vtkImageData *data, BrickStore *bricked, const std::function<void()> &locked)
+{
+    // results for the previous series are stale
+    m_requestToken.cancel();
+    m_requestToken = CancelToken();
+    m_prefetchToken.cancel();
+    m_prefetchToken = CancelToken();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_imageData = data;
+    m_bricked = bricked;
+    m_brickSource->SetVolume(bricked);
+    if (data && !bricked) {
+        m_input->ShallowCopy(data);
+    }
+    if (locked) {
+        locked();
+    }
+    m_layouts.setInputData(nullptr); // built from the resliced volume on first use
+    m_layoutBytes = 0;
+
+    vtkImageAlgorithm *prefilter = m_kernel.prefilter;
+    if (prefilter) {
+        if (bricked) {
+            prefilter->SetInputConnection(m_brickSource->GetOutputPort());
+        } else {
+            prefilter->SetInputData(m_input);
+        }
+        m_reslice->SetInputConnection(prefilter->GetOutputPort());
+    } else if (bricked) {
+        m_reslice->SetInputConnection(m_brickSource->GetOutputPort());
+    } else {
+        m_reslice->SetInputData(m_input);
+    }
+    m_reslice->SetOutputScalarType(VTK_FLOAT);
+    for (auto &slot : m_cache)
+        slot = CachedImage();
+}
+
+void ProjectionViewer::setLayoutBudget(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_layouts.setBudget(bytes);
+    m_layoutBytes = m_layouts.residentBytes();
+}
+
+bool ProjectionViewer::currentBox(Box &box) const
+{
+    if (!m_imageData) {
+        return false;
+    }
+    // Project through the VOI (or the whole volume): the output image covers
+    // its footprint and the slab its depth, so reslice work follows the box.
+    if (m_voi) {
+        // mapped through world space: the input may be a resampled copy of
+        // the volume the box was drawn on
+        m_voi->boxIn(m_imageData, box.extent, box.bounds);
+    } else {
+        m_imageData->GetExtent(box.extent);
+        m_imageData->GetBounds(box.bounds);
+    }
+    return true;
+}
+
+vtkImageData *ProjectionViewer::view(int axis)
+{
+    Box box;
+    if (!currentBox(box)) {
+        return nullptr; // Fail fast — caller forgot setInput()
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    vtkImageData *image = project(axis, box);
+    m_outputBytes = MemoryLedger::dataBytes(image);
+    return image;
+}
+
+void ProjectionViewer::request(int axis, Callback done)
+{
+    Box box;
+    if (!currentBox(box)) {
+        return;
+    }
+    // Only the newest request matters: an axis the user already left is dropped.
+    m_requestToken.cancel();
+    m_requestToken = CancelToken();
+    const CancelToken token = m_requestToken;
+    track(TaskScheduler::instance().submit(TaskPriority::Visible, [this, axis, box, token, done] {
+        vtkSmartPointer<vtkImageData> image = cachedProjection(axis, box, token);
+        if (image && !token.isCancelled()) {
+            done(image);
+        }
+    }, token));
+}
+
+void ProjectionViewer::prefetch()
+{
+    Box box;
+    if (m_bricked || !currentBox(box)) {
+        return;
+    }
+    m_prefetchToken.cancel();
+    m_prefetchToken = CancelToken();
+    const CancelToken token = m_prefetchToken;
+    for (int axis = 0; axis < 3; ++axis) {
+        track(TaskScheduler::instance().submit(TaskPriority::Prefetch, [this, axis, box, token] {
+            (void) cachedProjection(axis, box, token);
+        }, token));
+    }
+}
+
+vtkSmartPointer<vtkImageData> ProjectionViewer::cachedProjection(int axis, const Box &box, const CancelToken &token)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CachedImage &slot = m_cache[axis];
+    if (slot.image && std::equal(box.extent, box.extent + 6, slot.extent)) {
+        return slot.image;
+    }
+    if (token.isCancelled()) {
+        return nullptr; // superseded while waiting for the lock
+    }
+    vtkImageData *projection = project(axis, box);
+
+    // The cached copy is handed out and never written again, so the GUI
+    // thread may display it while the reslice runs the next request.
+    auto image = vtkSmartPointer<vtkImageData>::New();
+    image->DeepCopy(projection);
+    std::copy(box.extent, box.extent + 6, slot.extent);
+    slot.image = image;
+
+    size_t bytes = MemoryLedger::dataBytes(projection);
+    for (const auto &cached : m_cache)
+        bytes += MemoryLedger::dataBytes(cached.image);
+    m_outputBytes = bytes;
+    return image;
+}
+
+void ProjectionViewer::track(std::shared_future<void> future)
+{
+    // drop finished tasks so the list stays as short as the queue
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                   [](const std::shared_future<void> &f) {
+                                       return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                                   }),
+                    m_pending.end());
+    m_pending.push_back(std::move(future));
+}
+
+vtkImageData *ProjectionViewer::project(int axis, const Box &box)
+{
+    const int *extent = box.extent;
+    const double *bounds = box.bounds;
+    const double *spacing = m_imageData->GetSpacing();
+
+    const auto &cfg = Projection::kAxisConfigs[axis];
+    const int u = cfg.planeDimIdx[0];
+    const int v = cfg.planeDimIdx[1];
+    const int s = cfg.slabDimIdx;
+
+    vtkNew<vtkMatrix4x4> resliceAxes;
+    resliceAxes->DeepCopy(cfg.matrix);
+    // slab centred on the box; in-plane output coordinates stay world
+    // coordinates, so a cropped image keeps its place in the view
+    resliceAxes->SetElement(s, 3, (bounds[2 * s] + bounds[2 * s + 1]) * 0.5);
+
+    m_reslice->SetOutputDimensionality(2);
+    m_reslice->SetResliceAxes(resliceAxes);
+    m_reslice->SetOutputOrigin(bounds[2 * u], bounds[2 * v], 0.0);
+    m_reslice->SetOutputSpacing(std::abs(spacing[u]), std::abs(spacing[v]), std::abs(spacing[s]));
+    m_reslice->SetOutputExtent(0, extent[2 * u + 1] - extent[2 * u],
+                               0, extent[2 * v + 1] - extent[2 * v],
+                               0, 0);
+    m_reslice->SetInterpolationModeToLinear();
+    m_kernel.slab(m_reslice, s, std::abs(spacing[s]));
+
+    vtkImageAlgorithm *prefilter = m_kernel.prefilter;
+    if (m_bricked) {
+        // bricked: one brick layer deep at a time, partial images combined
+        Bricks::projectByLayers(m_reslice, resliceAxes, s, extent, bounds, std::abs(spacing[s]),
+                                m_bricked->brickSize(), m_kernel.combine, m_layered);
+        if (prefilter) {
+            m_prefilterBytes = MemoryLedger::dataBytes(prefilter->GetOutput());
+        }
+        return m_layered;
+    }
+
+    // Reslice a copy of the (prefiltered) volume whose rows run along the
+    // output X axis when the native rows don't (sagittal); built on the
+    // first such view, within budget, and dropped when the prefilter
+    // re-executes.
+    vtkImageData *source = m_input;
+    if (prefilter) {
+        prefilter->Update();
+        source = prefilter->GetOutput();
+        m_prefilterBytes = MemoryLedger::dataBytes(source);
+    }
+    m_layouts.setInputData(source);
+    vtkImageData *layout = m_layouts.layoutFor(u, s);
+    m_layoutBytes = m_layouts.residentBytes();
+    if (layout && layout != source) {
+        int perm[3];
+        VolumeLayouts::order(u, s, perm);
+        VolumeLayouts::toLayoutFrame(perm, resliceAxes);
+        m_reslice->SetInputData(layout);
+    } else if (prefilter) {
+        m_reslice->SetInputConnection(prefilter->GetOutputPort());
+    } else {
+        m_reslice->SetInputData(m_input);
+    }
+    // how many vosels deep the box along slab axis
+    m_reslice->SetSlabNumberOfSlices(extent[2 * s + 1] - extent[2 * s] + 1);
+    m_reslice->Update();
+    return m_reslice->GetOutput();
+}
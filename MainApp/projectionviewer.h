@@ -0,0 +1,133 @@
+#ifndef PROJECTIONVIEWER_H
+#define PROJECTIONVIEWER_H
+
+#include "brickedvolume.h"
+#include "taskscheduler.h"
+#include "volumelayouts.h"
+#include "vtkImageAlgorithm.h"
+#include "vtkImageData.h"
+#include "vtkImageReslice.h"
+#include "vtkNew.h"
+#include "vtkSmartPointer.h"
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <vector>
+
+class VolumeOfInterest;
+
+/// @brief Slab-reslice projections of a volume along its three axes, shared
+/// by MipViewer and DrrViewer.
+///
+/// Owns the reslice and everything around it: the shallow input copy, the
+/// brick-layer path for bricked input, the axis-permuted layouts, the VOI
+/// snapshot, the per-axis cache and the cancellable requests on the
+/// TaskScheduler. A viewer supplies only its Kernel — what happens along the
+/// rays — and keeps its own public API.
+class ProjectionViewer
+{
+public:
+    using Callback = std::function<void(vtkSmartPointer<vtkImageData>)>;
+
+    /// @brief What one kind of projection does along its rays.
+    struct Kernel
+    {
+        // Span name of the reslice in traces.
+        const char *traceName = "projection.reslice";
+        // How the partial images of a bricked projection add up.
+        Bricks::Combine combine = Bricks::Combine::Max;
+        // Sets the slab mode (and scale) for a slab along `slabAxis` with
+        // voxels `slabSpacing` apart. Runs with the projection lock held.
+        std::function<void(vtkImageReslice *reslice, int slabAxis, double slabSpacing)> slab;
+        // Optional filter in front of the reslice (the DRR's HU remap); its
+        // output is what gets resliced and permuted.
+        vtkImageAlgorithm *prefilter = nullptr;
+    };
+
+    explicit ProjectionViewer(Kernel kernel);
+    // Cancels queued requests and waits for a running one.
+    ~ProjectionViewer();
+
+    // Non-copyable — owns VTK pipeline objects with reference semantics.
+    ProjectionViewer(const ProjectionViewer &) = delete;
+    ProjectionViewer &operator=(const ProjectionViewer &) = delete;
+
+    // In-RAM input, or with `bricked` the brick store whose geometry `data`
+    // is; the store must outlive this object or the next setInput call.
+    // `locked` runs under the projection lock once older requests are
+    // cancelled, for kernel state that goes with the input.
+    void setInput(vtkImageData *data, BrickStore *bricked, const std::function<void()> &locked = {});
+    // Bytes the viewer may spend on an axis-permuted input copy (sagittal
+    // rows contiguous); 0 = always reslice the native layout.
+    void setLayoutBudget(size_t bytes);
+    // Project only through this box (nullptr = whole volume); read on every view call.
+    void setVolumeOfInterest(const VolumeOfInterest *voi) { m_voi = voi; }
+
+    // Recompute the projection along `axis` (0 sagittal, 1 coronal, 2 axial)
+    // on the calling thread.
+    [[nodiscard]] vtkImageData *view(int axis);
+
+    // Compute on the TaskScheduler (Visible) and pass the finished image to
+    // done on the worker thread. The image is never touched again by the
+    // viewer. A newer request cancels this one; done is then not called.
+    void request(int axis, Callback done);
+    // Fill the per-axis cache for the current VOI at Prefetch priority, so a
+    // later axis switch is served without reslicing. Skipped for bricked
+    // input, where every axis is a full pass over the bricks. A prefetch that
+    // already started holds the reslice until it finishes; queued ones are
+    // dropped by the next prefetch() or setInput().
+    void prefetch();
+
+    // Bytes held by the reslice output and the cached projections.
+    [[nodiscard]] size_t outputBytes() const { return m_outputBytes.load(); }
+    // Bytes held by the axis-permuted input copy.
+    [[nodiscard]] size_t layoutBytes() const { return m_layoutBytes.load(); }
+    // Bytes held by the prefilter's output.
+    [[nodiscard]] size_t prefilterBytes() const { return m_prefilterBytes.load(); }
+
+private:
+    /// @brief VOI snapshot taken on the caller's thread.
+    struct Box
+    {
+        int extent[6];
+        double bounds[6];
+    };
+
+    /// @brief Last projection per axis and the extent it covers.
+    struct CachedImage
+    {
+        int extent[6] = {0, -1, 0, -1, 0, -1};
+        vtkSmartPointer<vtkImageData> image;
+    };
+
+    [[nodiscard]] bool currentBox(Box &box) const;
+    vtkImageData *project(int axis, const Box &box); // m_mutex held
+    vtkSmartPointer<vtkImageData> cachedProjection(int axis, const Box &box, const CancelToken &token);
+    void track(std::shared_future<void> future);
+
+    const Kernel m_kernel;
+    vtkNew<vtkImageReslice> m_reslice;
+    vtkImageData *m_imageData = nullptr;
+    // Shallow copy of the input: shares the voxels, but not the reader's
+    // pipeline information, which the GUI thread keeps updating.
+    vtkNew<vtkImageData> m_input;
+    const VolumeOfInterest *m_voi = nullptr;
+    BrickStore *m_bricked = nullptr;
+    vtkNew<BrickedImageSource> m_brickSource;
+    vtkNew<vtkImageData> m_layered; // combined layers of a bricked projection
+    VolumeLayouts m_layouts;
+
+    std::mutex m_mutex; // m_reslice, the prefilter, m_layouts, m_cache
+    CachedImage m_cache[3];
+    std::atomic<size_t> m_outputBytes{0};
+    std::atomic<size_t> m_layoutBytes{0};
+    std::atomic<size_t> m_prefilterBytes{0};
+
+    CancelToken m_requestToken;
+    CancelToken m_prefetchToken;
+    std::vector<std::shared_future<void>> m_pending;
+};
+
+#endif // PROJECTIONVIEWER_H
@@ -0,0 +1,241 @@
+#include "segmentmeasure.h"
+#include "parallelfor.h"
+#include "vtkImageData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace Measure {
+
+/// @brief Geometry of the sampled volume, shared by both kernels.
+struct Grid
+{
+    int dims[3];
+    double spacing[3];
+    double origin[3]; // world position of the first voxel in the scalar buffer
+};
+
+/// @brief Partial ROI sums for one chunk of the parallel reduction.
+struct Partial
+{
+    long long count = 0;
+    double sum = 0.0;
+    double sumSq = 0.0;
+    double minV = std::numeric_limits<double>::max();
+    double maxV = std::numeric_limits<double>::lowest();
+};
+
+// Amanatides–Woo voxel walk from a to b. Voxel i covers index range
+// [i - 0.5, i + 0.5) so each sample is the voxel the segment actually crosses.
+template<typename T>
+void profileKernel(const T *volume, const Grid &g, const double a[3], const double b[3], double lengthMm, SegmentStats &stats)
+{
+    stats.profileMm.clear();
+    stats.profileHu.clear();
+
+    double p0[3], p1[3];
+    for (int i = 0; i < 3; ++i) {
+        p0[i] = (a[i] - g.origin[i]) / g.spacing[i] + 0.5;
+        p1[i] = (b[i] - g.origin[i]) / g.spacing[i] + 0.5;
+    }
+
+    int cell[3], step[3];
+    double tMax[3], tDelta[3];
+    for (int i = 0; i < 3; ++i) {
+        const double d = p1[i] - p0[i];
+        cell[i] = static_cast<int>(std::floor(p0[i]));
+        if (d > 1e-12) {
+            step[i] = 1;
+            tMax[i] = (cell[i] + 1 - p0[i]) / d;
+            tDelta[i] = 1.0 / d;
+        } else if (d < -1e-12) {
+            step[i] = -1;
+            tMax[i] = (p0[i] - cell[i]) / -d;
+            tDelta[i] = 1.0 / -d;
+        } else {
+            step[i] = 0;
+            tMax[i] = std::numeric_limits<double>::max();
+            tDelta[i] = std::numeric_limits<double>::max();
+        }
+    }
+
+    const std::int64_t strideY = g.dims[0];
+    const std::int64_t strideZ = static_cast<std::int64_t>(g.dims[0]) * g.dims[1];
+    double tEnter = 0.0;
+    for (;;) {
+        const int axis = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        const double tLeave = std::min(tMax[axis], 1.0);
+
+        if (cell[0] >= 0 && cell[1] >= 0 && cell[2] >= 0 && cell[0] < g.dims[0] && cell[1] < g.dims[1]
+            && cell[2] < g.dims[2]) {
+            const T v = volume[cell[0] + cell[1] * strideY + cell[2] * strideZ];
+            stats.profileMm.push_back(static_cast<float>((tEnter + tLeave) * 0.5 * lengthMm));
+            stats.profileHu.push_back(static_cast<float>(v));
+        }
+
+        if (tMax[axis] >= 1.0)
+            break;
+        tEnter = tMax[axis];
+        cell[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+    }
+}
+
+// Statistics over voxel centers inside the finite cylinder of the given
+// radius around [a, b]. Slices of the ROI bounding box are reduced in parallel.
+template<typename T>
+void roiKernel(const T *volume, const Grid &g, const double a[3], const double b[3], double radius, SegmentStats &stats)
+{
+    const double axis[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    const double r2 = radius * radius;
+
+    int lo[3], hi[3];
+    for (int i = 0; i < 3; ++i) {
+        const double wlo = std::min(a[i], b[i]) - radius;
+        const double whi = std::max(a[i], b[i]) + radius;
+        lo[i] = std::max(0, static_cast<int>(std::ceil((wlo - g.origin[i]) / g.spacing[i])));
+        hi[i] = std::min(g.dims[i] - 1, static_cast<int>(std::floor((whi - g.origin[i]) / g.spacing[i])));
+    }
+    if (lo[0] > hi[0] || lo[1] > hi[1] || lo[2] > hi[2])
+        return;
+
+    const std::int64_t strideY = g.dims[0];
+    const std::int64_t strideZ = static_cast<std::int64_t>(g.dims[0]) * g.dims[1];
+    std::vector<Partial> partials(hi[2] - lo[2] + 1);
+
+    Parallel::forRange(lo[2], hi[2] + 1, 1, [&](int z0, int z1) {
+        for (int z = z0; z < z1; ++z) {
+            Partial &acc = partials[z - lo[2]];
+            const double wz = g.origin[2] + z * g.spacing[2] - a[2];
+            for (int y = lo[1]; y <= hi[1]; ++y) {
+                const double wy = g.origin[1] + y * g.spacing[1] - a[1];
+                const T *row = volume + y * strideY + z * strideZ;
+                for (int x = lo[0]; x <= hi[0]; ++x) {
+                    const double wx = g.origin[0] + x * g.spacing[0] - a[0];
+                    // inside the end caps when 0 <= (w · axis) <= |axis|²
+                    const double proj = wx * axis[0] + wy * axis[1] + wz * axis[2];
+                    if (proj < 0.0 || proj > len2)
+                        continue;
+                    const double dist2 = wx * wx + wy * wy + wz * wz - (len2 > 0.0 ? proj * proj / len2 : 0.0);
+                    if (dist2 > r2)
+                        continue;
+                    const double v = row[x];
+                    ++acc.count;
+                    acc.sum += v;
+                    acc.sumSq += v * v;
+                    acc.minV = std::min(acc.minV, v);
+                    acc.maxV = std::max(acc.maxV, v);
+                }
+            }
+        }
+    });
+
+    Partial total;
+    for (const Partial &p : partials) {
+        total.count += p.count;
+        total.sum += p.sum;
+        total.sumSq += p.sumSq;
+        total.minV = std::min(total.minV, p.minV);
+        total.maxV = std::max(total.maxV, p.maxV);
+    }
+    if (total.count == 0)
+        return;
+
+    stats.voxelCount = total.count;
+    stats.meanHu = total.sum / total.count;
+    stats.stdHu = std::sqrt(std::max(0.0, total.sumSq / total.count - stats.meanHu * stats.meanHu));
+    stats.minHu = total.minV;
+    stats.maxHu = total.maxV;
+}
+
+template<typename T>
+void measureAll(const T *volume, const Grid &g, SegmentStats &stats)
+{
+    const double *a = stats.endpoints;
+    const double *b = stats.endpoints + 3;
+    profileKernel(volume, g, a, b, stats.lengthMm, stats);
+    roiKernel(volume, g, a, b, stats.radius, stats);
+}
+
+} // namespace Measure
+
+size_t SegmentMeasure::cacheBytes() const
+{
+    size_t bytes = m_cache.capacity() * sizeof(SegmentStats);
+    for (const SegmentStats &stats : m_cache)
+        bytes += (stats.profileMm.capacity() + stats.profileHu.capacity()) * sizeof(float);
+    return bytes;
+}
+
+void SegmentMeasure::setInputData(vtkImageData *data)
+{
+    m_imageData = data;
+    invalidate();
+}
+
+const SegmentStats &SegmentMeasure::measure(int pair, const double a[3], const double b[3], double radius)
+{
+    if (pair >= static_cast<int>(m_cache.size()))
+        m_cache.resize(pair + 1);
+
+    SegmentStats &stats = m_cache[pair];
+    const bool unchanged = stats.radius == radius && std::equal(a, a + 3, stats.endpoints)
+                           && std::equal(b, b + 3, stats.endpoints + 3);
+    if (unchanged)
+        return stats;
+
+    std::copy(a, a + 3, stats.endpoints);
+    std::copy(b, b + 3, stats.endpoints + 3);
+    stats.radius = radius;
+    compute(stats);
+    return stats;
+}
+
+void SegmentMeasure::compute(SegmentStats &stats) const
+{
+    const double *a = stats.endpoints;
+    const double *b = stats.endpoints + 3;
+    stats.lengthMm = std::sqrt((b[0] - a[0]) * (b[0] - a[0]) + (b[1] - a[1]) * (b[1] - a[1])
+                               + (b[2] - a[2]) * (b[2] - a[2]));
+    stats.voxelCount = 0;
+    stats.meanHu = stats.minHu = stats.maxHu = stats.stdHu = 0.0;
+    stats.profileMm.clear();
+    stats.profileHu.clear();
+
+    if (!m_imageData || !m_imageData->GetScalarPointer())
+        return;
+
+    Measure::Grid g;
+    int extent[6];
+    m_imageData->GetDimensions(g.dims);
+    m_imageData->GetExtent(extent);
+    m_imageData->GetSpacing(g.spacing);
+    m_imageData->GetOrigin(g.origin);
+    // the buffer starts at the extent's corner, not at index 0
+    for (int i = 0; i < 3; ++i)
+        g.origin[i] += extent[2 * i] * g.spacing[i];
+    const void *in = m_imageData->GetScalarPointer();
+
+    switch (m_imageData->GetScalarType()) {
+    case VTK_SHORT:
+        Measure::measureAll(static_cast<const short *>(in), g, stats);
+        break;
+    case VTK_UNSIGNED_SHORT:
+        Measure::measureAll(static_cast<const unsigned short *>(in), g, stats);
+        break;
+    case VTK_INT:
+        Measure::measureAll(static_cast<const int *>(in), g, stats);
+        break;
+    case VTK_FLOAT:
+        Measure::measureAll(static_cast<const float *>(in), g, stats);
+        break;
+    case VTK_DOUBLE:
+        Measure::measureAll(static_cast<const double *>(in), g, stats);
+        break;
+    default:
+        break; // unsupported voxel type: length only
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef SEGMENTMEASURE_H
+#define SEGMENTMEASURE_H
+
+#include <cstddef>
+#include <vector>
+
+class vtkImageData;
+
+/// @brief What an annotation segment measures against the voxels underneath.
+struct SegmentStats
+{
+    double endpoints[6] = {0, 0, 0, 0, 0, 0}; // a, b in world (cache key)
+    double radius = 0.0;                      // 0 = never computed
+
+    double lengthMm = 0.0;
+    long long voxelCount = 0; // voxels inside the cylindrical ROI
+    double meanHu = 0.0;
+    double minHu = 0.0;
+    double maxHu = 0.0;
+    double stdHu = 0.0;
+
+    // Intensity profile: one sample per voxel the segment crosses.
+    std::vector<float> profileMm; // distance from endpoint a
+    std::vector<float> profileHu;
+};
+
+class SegmentMeasure
+{
+public:
+    SegmentMeasure() = default;
+    ~SegmentMeasure() = default;
+
+    SegmentMeasure(const SegmentMeasure &) = delete;
+    SegmentMeasure &operator=(const SegmentMeasure &) = delete;
+
+    void setInputData(vtkImageData *data);
+
+    // Measure pair `pair` with endpoints a, b and ROI radius (mm). Results are
+    // cached per pair; a pair whose endpoints or radius changed is measured
+    // again in full (profile walk and ROI reduction), nothing is carried over
+    // from its previous position. Untouched pairs cost a compare.
+    const SegmentStats &measure(int pair, const double a[3], const double b[3], double radius);
+
+    // Drop cached results, e.g. after pairs were removed or reindexed.
+    void invalidate() { m_cache.clear(); }
+
+    [[nodiscard]] size_t cacheBytes() const;
+
+private:
+    void compute(SegmentStats &stats) const;
+
+    vtkImageData *m_imageData = nullptr;
+    std::vector<SegmentStats> m_cache;
+};
+
+#endif // SEGMENTMEASURE_H
@@ -0,0 +1,152 @@
+#include "taskscheduler.h"
+#include "tracing.h"
+
+#include <algorithm>
+#include <string>
+
+namespace Scheduler {
+
+// Worker index of this thread in its scheduler (-1 = not a worker).
+thread_local int t_workerIndex = -1;
+thread_local TaskPriority t_priority = TaskPriority::Interactive;
+
+static const char *const kTaskNames[] = {"task.interactive", "task.visible", "task.background", "task.prefetch"};
+
+} // namespace Scheduler
+
+TaskScheduler &TaskScheduler::instance()
+{
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler()
+{
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 1; i < hw; ++i)
+        m_local.push_back(std::make_unique<Queues>());
+    for (unsigned i = 1; i < hw; ++i) {
+        const int index = static_cast<int>(i) - 1;
+        m_workers.emplace_back([this, index] {
+            Trace::setThreadName("pool worker " + std::to_string(index + 1));
+            workerLoop(index);
+        });
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_sleepCv.notify_all();
+    for (auto &t : m_workers)
+        t.join();
+}
+
+TaskPriority TaskScheduler::currentPriority()
+{
+    return Scheduler::t_priority;
+}
+
+std::shared_future<void> TaskScheduler::submit(TaskPriority priority, std::function<void()> fn, CancelToken token)
+{
+    Task task;
+    task.fn = std::move(fn);
+    task.token = std::move(token);
+    task.done = std::make_shared<std::promise<void>>();
+    task.priority = priority;
+    std::shared_future<void> future = task.done->get_future().share();
+
+    if (m_workers.empty()) {
+        run(task); // single core: nobody else would ever pick it up
+        return future;
+    }
+
+    const int worker = Scheduler::t_workerIndex;
+    Queues &queues = worker >= 0 ? *m_local[worker] : m_injected;
+    {
+        std::lock_guard<std::mutex> lock(queues.mutex);
+        queues.tasks[static_cast<int>(priority)].push_back(std::move(task));
+    }
+    m_queued.fetch_add(1);
+    {
+        // pairs with the predicate check in workerLoop: no lost wake-up
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_sleepCv.notify_one();
+    return future;
+}
+
+bool TaskScheduler::takeTask(int index, Task &out)
+{
+    const int workers = static_cast<int>(m_local.size());
+    for (int p = 0; p < kPriorities; ++p) {
+        // own deque, newest first
+        {
+            Queues &own = *m_local[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks[p].empty()) {
+                out = std::move(own.tasks[p].back());
+                own.tasks[p].pop_back();
+                return true;
+            }
+        }
+        // submitted from outside the pool, oldest first
+        {
+            std::lock_guard<std::mutex> lock(m_injected.mutex);
+            if (!m_injected.tasks[p].empty()) {
+                out = std::move(m_injected.tasks[p].front());
+                m_injected.tasks[p].pop_front();
+                return true;
+            }
+        }
+        // steal the oldest from the other workers
+        for (int k = 1; k < workers; ++k) {
+            Queues &victim = *m_local[(index + k) % workers];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks[p].empty()) {
+                out = std::move(victim.tasks[p].front());
+                victim.tasks[p].pop_front();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TaskScheduler::run(Task &task)
+{
+    if (!task.token.isCancelled()) {
+        const TaskPriority outer = Scheduler::t_priority;
+        Scheduler::t_priority = task.priority;
+        try {
+            Trace::Scope scope(Scheduler::kTaskNames[static_cast<int>(task.priority)], "task");
+            task.fn();
+        } catch (...) {
+            Scheduler::t_priority = outer;
+            task.done->set_exception(std::current_exception());
+            return;
+        }
+        Scheduler::t_priority = outer;
+    }
+    task.done->set_value();
+}
+
+void TaskScheduler::workerLoop(int index)
+{
+    Scheduler::t_workerIndex = index;
+    for (;;) {
+        Task task;
+        if (takeTask(index, task)) {
+            m_queued.fetch_sub(1);
+            run(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepCv.wait(lock, [this] { return m_stop || m_queued.load() > 0; });
+        if (m_stop)
+            return;
+    }
+}
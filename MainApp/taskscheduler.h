@@ -0,0 +1,101 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief Priority classes, most urgent first. A worker always takes the
+/// most urgent task it can find; a running task is never preempted.
+enum class TaskPriority {
+    Interactive = 0, // view updates the user is waiting on frame by frame
+    Visible,         // projections and loads that fill a visible pane
+    Background,      // precompute that speeds up a later action
+    Prefetch,        // speculative work that may never be used
+};
+
+/// @brief Shared cancellation flag. Copies observe the same flag; queued
+/// tasks whose token is cancelled are dropped without running, running ones
+/// poll isCancelled() at convenient points.
+class CancelToken
+{
+public:
+    CancelToken() : m_cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { m_cancelled->store(true, std::memory_order_relaxed); }
+    [[nodiscard]] bool isCancelled() const { return m_cancelled->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+/// @brief The application's one worker pool.
+///
+/// Every worker owns a deque per priority: tasks submitted from a worker go
+/// to its own deque (taken newest-first, cache-warm), tasks from other
+/// threads to a shared injection queue, and idle workers steal the oldest
+/// task from a busy worker. Parallel::forRange() runs on the same workers,
+/// so loading, projections and prefetch share the cores instead of each
+/// bringing their own threads.
+class TaskScheduler
+{
+public:
+    static TaskScheduler &instance();
+
+    // Workers plus the calling thread (forRange callers help).
+    [[nodiscard]] int threadCount() const { return static_cast<int>(m_workers.size()) + 1; }
+
+    // The future is ready once the task ran, or was dropped as cancelled.
+    std::shared_future<void> submit(TaskPriority priority, std::function<void()> fn,
+                                    CancelToken token = CancelToken());
+
+    // Priority of the task running on this thread; Interactive outside tasks
+    // (the GUI thread). Work forked from a task inherits it.
+    [[nodiscard]] static TaskPriority currentPriority();
+
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+private:
+    static constexpr int kPriorities = 4;
+
+    struct Task
+    {
+        std::function<void()> fn;
+        CancelToken token;
+        std::shared_ptr<std::promise<void>> done;
+        TaskPriority priority = TaskPriority::Visible;
+    };
+
+    /// @brief One deque per priority behind one lock.
+    struct Queues
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks[kPriorities];
+    };
+
+    TaskScheduler();
+
+    void workerLoop(int index);
+    bool takeTask(int index, Task &out);
+    void run(Task &task);
+
+    std::vector<std::unique_ptr<Queues>> m_local; // per worker
+    Queues m_injected;
+    std::vector<std::thread> m_workers;
+
+    std::atomic<int> m_queued{0};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepCv;
+    bool m_stop = false;
+};
+
+#endif // TASKSCHEDULER_H
@@ -0,0 +1,237 @@
+#include "tracing.h"
+#include "vtkCallbackCommand.h"
+#include "vtkCommand.h"
+#include "vtkNew.h"
+#include "vtkObject.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace Trace {
+namespace {
+
+// Events kept per thread: 64 K × 32 bytes = 2 MB, a few seconds of
+// per-chunk spans on a busy pool.
+constexpr std::uint64_t kCapacity = 1u << 16;
+
+/// @brief One ring slot. Relaxed atomics: a dump may read a slot while its
+/// thread reuses it, and drops what it read if so (see record()).
+struct Event
+{
+    std::atomic<const char *> name;
+    std::atomic<const char *> category;
+    std::atomic<std::int64_t> beginNs;
+    std::atomic<std::int64_t> endNs;
+};
+
+/// @brief One thread's ring. Only the owning thread writes; `written`
+/// publishes how far it got.
+struct ThreadBuffer
+{
+    int tid = 0;
+    std::string threadName;
+    std::unique_ptr<Event[]> ring{new Event[kCapacity]};
+    std::atomic<std::uint64_t> written{0};
+    std::atomic<std::uint64_t> clearedAt{0}; // events before this are dropped
+};
+
+/// @brief Every buffer ever created. Buffers outlive their threads so a
+/// dump still sees what short-lived threads did.
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::set<std::string> names;
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+thread_local ThreadBuffer *t_buffer = nullptr;
+thread_local std::string t_threadName;
+
+ThreadBuffer &threadBuffer()
+{
+    if (!t_buffer) {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto buffer = std::make_unique<ThreadBuffer>();
+        buffer->tid = static_cast<int>(reg.buffers.size()) + 1;
+        buffer->threadName = t_threadName.empty() ? "thread " + std::to_string(buffer->tid) : t_threadName;
+        t_buffer = buffer.get();
+        reg.buffers.push_back(std::move(buffer));
+    }
+    return *t_buffer;
+}
+
+/// @brief Per-observed-object state, owned by its callback command.
+struct Probe
+{
+    const char *name;
+    const char *stepName;
+    bool progressSpans;
+    std::int64_t begin = -1; // -1 = started while disabled
+    std::int64_t lastStep = 0;
+};
+
+void onProbeEvent(vtkObject * /*caller*/, unsigned long eventId, void *clientData, void * /*callData*/)
+{
+    auto *probe = static_cast<Probe *>(clientData);
+    if (eventId == vtkCommand::StartEvent) {
+        probe->begin = isEnabled() ? now() : -1;
+        probe->lastStep = probe->begin;
+        return;
+    }
+    if (probe->begin < 0)
+        return;
+    const std::int64_t t = now();
+    if (eventId == vtkCommand::ProgressEvent) {
+        record(probe->stepName, "vtk", probe->lastStep, t);
+        probe->lastStep = t;
+    } else if (eventId == vtkCommand::EndEvent) {
+        record(probe->name, "vtk", probe->begin, t);
+        probe->begin = -1;
+    }
+}
+
+void deleteProbe(void *clientData)
+{
+    delete static_cast<Probe *>(clientData);
+}
+
+void writeEscaped(std::FILE *out, const char *text)
+{
+    std::fputc('"', out);
+    for (const char *c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\')
+            std::fputc('\\', out);
+        if (static_cast<unsigned char>(*c) >= 0x20)
+            std::fputc(*c, out);
+    }
+    std::fputc('"', out);
+}
+
+} // namespace
+
+void setEnabled(bool enabled)
+{
+    detail::g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::int64_t now()
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void record(const char *name, const char *category, std::int64_t beginNs, std::int64_t endNs)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    const std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    Event &event = buffer.ring[index % kCapacity];
+    // Seqlock-style: a dump that reads any of the stores below sees
+    // `written` at `index` or later after its acquire fence, and knows the
+    // slot was being reused.
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.category.store(category, std::memory_order_relaxed);
+    event.beginNs.store(beginNs, std::memory_order_relaxed);
+    event.endNs.store(endNs, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void setThreadName(const std::string &name)
+{
+    t_threadName = name;
+    if (t_buffer) {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        t_buffer->threadName = name;
+    }
+}
+
+const char *intern(const std::string &text)
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.names.insert(text).first->c_str();
+}
+
+void observe(vtkObject *object, const char *name, bool progressSpans)
+{
+    if (!object)
+        return;
+    auto *probe = new Probe{intern(name), intern(std::string(name) + ".step"), progressSpans};
+
+    vtkNew<vtkCallbackCommand> callback;
+    callback->SetCallback(onProbeEvent);
+    callback->SetClientData(probe);
+    callback->SetClientDataDeleteCallback(deleteProbe);
+    object->AddObserver(vtkCommand::StartEvent, callback);
+    object->AddObserver(vtkCommand::EndEvent, callback);
+    if (progressSpans)
+        object->AddObserver(vtkCommand::ProgressEvent, callback);
+}
+
+void clear()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &buffer : reg.buffers)
+        buffer->clearedAt.store(buffer->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+bool writeChromeJson(const std::string &path)
+{
+    std::FILE *out = std::fopen(path.c_str(), "wb");
+    if (!out)
+        return false;
+
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", out);
+    bool first = true;
+    for (const auto &buffer : reg.buffers) {
+        std::fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                     first ? "" : ",\n", buffer->tid);
+        writeEscaped(out, buffer->threadName.c_str());
+        std::fputs("}}", out);
+        first = false;
+
+        const std::uint64_t end = buffer->written.load(std::memory_order_acquire);
+        std::uint64_t begin = buffer->clearedAt.load(std::memory_order_relaxed);
+        if (end - begin > kCapacity)
+            begin = end - kCapacity; // wrapped: the oldest were overwritten
+        for (std::uint64_t i = begin; i < end; ++i) {
+            const Event &event = buffer->ring[i % kCapacity];
+            const char *name = event.name.load(std::memory_order_relaxed);
+            const char *category = event.category.load(std::memory_order_relaxed);
+            const std::int64_t beginNs = event.beginNs.load(std::memory_order_relaxed);
+            const std::int64_t endNs = event.endNs.load(std::memory_order_relaxed);
+            // The thread still records: once it reached index i + kCapacity
+            // it may have rewritten the slot under the copy. Drop it.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (buffer->written.load(std::memory_order_relaxed) >= i + kCapacity)
+                continue;
+
+            std::fputs(",\n{\"ph\":\"X\",\"name\":", out);
+            writeEscaped(out, name);
+            std::fputs(",\"cat\":", out);
+            writeEscaped(out, category);
+            // microseconds, as the format expects
+            std::fprintf(out, ",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", buffer->tid, beginNs / 1000.0,
+                         (endNs - beginNs) / 1000.0);
+        }
+    }
+    std::fputs("\n]}\n", out);
+    return std::fclose(out) == 0;
+}
+
+} // namespace Trace
@@ -0,0 +1,88 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class vtkObject;
+
+/// @brief Scoped wall-clock tracing of the hot paths, exported as Chrome
+/// trace JSON (chrome://tracing, ui.perfetto.dev).
+///
+/// Every thread records into its own fixed-size ring buffer; the oldest
+/// events are overwritten once it is full. While tracing is disabled a
+/// scope costs one relaxed atomic load.
+namespace Trace {
+
+namespace detail {
+inline std::atomic<bool> g_enabled{false};
+} // namespace detail
+
+[[nodiscard]] inline bool isEnabled()
+{
+    return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled);
+
+// Monotonic nanoseconds since the first call.
+[[nodiscard]] std::int64_t now();
+
+// Appends a finished span to the calling thread's buffer. `name` and
+// `category` must outlive the trace (literals or intern()ed).
+void record(const char *name, const char *category, std::int64_t beginNs, std::int64_t endNs);
+
+// Label of the calling thread in the exported trace. Cheap: the thread's
+// buffer is only allocated by its first recorded span.
+void setThreadName(const std::string &name);
+
+// Stable copy of a runtime string, for names built at run time.
+[[nodiscard]] const char *intern(const std::string &text);
+
+// Spans every StartEvent..EndEvent of a VTK algorithm or render window as
+// `name` (copied). With `progressSpans`, each ProgressEvent in between also
+// closes a `<name>.step` span — vtkDICOMReader reports progress once per
+// file, so that is one span per decoded slice.
+void observe(vtkObject *object, const char *name, bool progressSpans = false);
+
+// Drops every recorded event.
+void clear();
+
+// Writes the buffers as Chrome trace event JSON. Threads may keep recording
+// meanwhile: events they overwrite during the write are left out.
+bool writeChromeJson(const std::string &path);
+
+/// @brief Records the lifetime of the enclosing block.
+class Scope
+{
+public:
+    explicit Scope(const char *name, const char *category = "app")
+        : m_name(isEnabled() ? name : nullptr)
+        , m_category(category)
+    {
+        if (m_name)
+            m_begin = now();
+    }
+    ~Scope()
+    {
+        if (m_name)
+            record(m_name, m_category, m_begin, now());
+    }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+private:
+    const char *m_name;
+    const char *m_category;
+    std::int64_t m_begin = 0;
+};
+
+} // namespace Trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#endif // TRACING_H
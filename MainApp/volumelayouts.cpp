@@ -0,0 +1,151 @@
+#include "volumelayouts.h"
+#include "parallelfor.h"
+#include "tracing.h"
+#include "vtkMatrix4x4.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace Layouts {
+
+// Slices per work item and side of the square tiles the copy walks: the
+// strided side of a tile reuses each input cache line for kTile voxels.
+static constexpr int kTile = 16;
+
+template <typename T>
+static void permute(const T *in, const int dims[3], const int perm[3], T *out)
+{
+    const std::size_t inStride[3] = {1, std::size_t(dims[0]), std::size_t(dims[0]) * dims[1]};
+    const int n[3] = {dims[perm[0]], dims[perm[1]], dims[perm[2]]};
+    const std::size_t s0 = inStride[perm[0]];
+    const std::size_t s1 = inStride[perm[1]];
+    const std::size_t s2 = inStride[perm[2]];
+
+    const int blocks = (n[2] + kTile - 1) / kTile;
+    Parallel::forRange(0, blocks, 1, [&](int begin, int end) {
+        for (int b = begin; b < end; ++b) {
+            const int k0 = b * kTile;
+            const int k1 = std::min(n[2], k0 + kTile);
+            for (int j = 0; j < n[1]; ++j) {
+                for (int i0 = 0; i0 < n[0]; i0 += kTile) {
+                    const int i1 = std::min(n[0], i0 + kTile);
+                    for (int k = k0; k < k1; ++k) {
+                        const T *src = in + j * s1 + k * s2;
+                        T *dst = out + (std::size_t(k) * n[1] + j) * n[0];
+                        for (int i = i0; i < i1; ++i)
+                            dst[i] = src[i * s0];
+                    }
+                }
+            }
+        }
+    });
+}
+
+} // namespace Layouts
+
+void VolumeLayouts::setInputData(vtkImageData *data)
+{
+    if (data == m_input && (!data || data->GetMTime() == m_inputTime)) {
+        return;
+    }
+    clear();
+    m_input = data;
+    m_inputTime = data ? data->GetMTime() : 0;
+}
+
+void VolumeLayouts::setBudget(std::size_t bytes)
+{
+    m_budget = bytes;
+    if (m_resident > m_budget)
+        clear();
+}
+
+void VolumeLayouts::clear()
+{
+    m_layouts.clear();
+    m_resident = 0;
+}
+
+void VolumeLayouts::order(int rowAxis, int slabAxis, int perm[3])
+{
+    perm[0] = rowAxis;
+    perm[1] = 3 - rowAxis - slabAxis;
+    perm[2] = slabAxis;
+}
+
+void VolumeLayouts::toLayoutFrame(const int perm[3], vtkMatrix4x4 *axes)
+{
+    // input axis perm[i] is layout axis i: row perm[i] moves to row i
+    double rows[3][4];
+    for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 4; ++c)
+            rows[r][c] = axes->GetElement(r, c);
+    for (int i = 0; i < 3; ++i)
+        for (int c = 0; c < 4; ++c)
+            axes->SetElement(i, c, rows[perm[i]][c]);
+}
+
+vtkImageData *VolumeLayouts::layoutFor(int rowAxis, int slabAxis)
+{
+    if (!m_input || rowAxis == 0) {
+        return m_input; // rows already contiguous
+    }
+    int perm[3];
+    order(rowAxis, slabAxis, perm);
+    for (const Layout &layout : m_layouts) {
+        if (std::equal(perm, perm + 3, layout.perm)) {
+            return layout.image;
+        }
+    }
+
+    const int scalarSize = m_input->GetScalarSize() * m_input->GetNumberOfScalarComponents();
+    const std::size_t bytes = std::size_t(m_input->GetNumberOfPoints()) * scalarSize;
+    if (bytes > m_budget || m_input->GetNumberOfScalarComponents() != 1) {
+        return nullptr; // no room (or multi-component): native layout
+    }
+    if (m_resident + bytes > m_budget) {
+        clear(); // make room: the other copies are rebuilt if asked for again
+    }
+
+    TRACE_SCOPE("layout.permute");
+    int dims[3], extent[6];
+    double spacing[3], origin[3];
+    m_input->GetDimensions(dims);
+    m_input->GetExtent(extent);
+    m_input->GetSpacing(spacing);
+    m_input->GetOrigin(origin);
+
+    auto image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent(extent[2 * perm[0]], extent[2 * perm[0] + 1], extent[2 * perm[1]], extent[2 * perm[1] + 1],
+                     extent[2 * perm[2]], extent[2 * perm[2] + 1]);
+    image->SetSpacing(spacing[perm[0]], spacing[perm[1]], spacing[perm[2]]);
+    image->SetOrigin(origin[perm[0]], origin[perm[1]], origin[perm[2]]);
+    image->AllocateScalars(m_input->GetScalarType(), 1);
+
+    const void *in = m_input->GetScalarPointer();
+    void *out = image->GetScalarPointer();
+    // only the bits move: any scalar type of the same width permutes alike
+    switch (scalarSize) {
+    case 1:
+        Layouts::permute(static_cast<const std::uint8_t *>(in), dims, perm, static_cast<std::uint8_t *>(out));
+        break;
+    case 2:
+        Layouts::permute(static_cast<const std::uint16_t *>(in), dims, perm, static_cast<std::uint16_t *>(out));
+        break;
+    case 4:
+        Layouts::permute(static_cast<const std::uint32_t *>(in), dims, perm, static_cast<std::uint32_t *>(out));
+        break;
+    case 8:
+        Layouts::permute(static_cast<const std::uint64_t *>(in), dims, perm, static_cast<std::uint64_t *>(out));
+        break;
+    default:
+        return nullptr;
+    }
+
+    Layout layout;
+    std::copy(perm, perm + 3, layout.perm);
+    layout.image = image;
+    m_layouts.push_back(layout);
+    m_resident += bytes;
+    return image;
+}
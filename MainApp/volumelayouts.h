@@ -0,0 +1,68 @@
+#ifndef VOLUMELAYOUTS_H
+#define VOLUMELAYOUTS_H
+
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include <cstddef>
+#include <vector>
+
+class vtkMatrix4x4;
+
+/// @brief Axis-permuted copies of one volume, built on first use.
+///
+/// vtkImageReslice's slab mode walks the input one output row at a time, so
+/// a projection is only as fast as the input axis under its output rows is
+/// contiguous. For sagittal views that axis is y (stride = one x row); a copy
+/// with y moved to the fastest axis and the ray axis to the slowest turns
+/// every row read into a linear scan. Copies count against a byte budget;
+/// past it the caller keeps the native layout.
+class VolumeLayouts
+{
+public:
+    static constexpr std::size_t kDefaultBudget = std::size_t(1) << 30;
+
+    VolumeLayouts() = default;
+
+    // Non-copyable — holds full-size volume copies.
+    VolumeLayouts(const VolumeLayouts &) = delete;
+    VolumeLayouts &operator=(const VolumeLayouts &) = delete;
+
+    // Copies are dropped when the input changes (pointer or MTime).
+    void setInputData(vtkImageData *data);
+    void setBudget(std::size_t bytes);
+    [[nodiscard]] std::size_t budget() const { return m_budget; }
+
+    // Axis order for projecting along `slabAxis` with output rows along
+    // `rowAxis`: perm[i] is the input axis stored as axis i.
+    static void order(int rowAxis, int slabAxis, int perm[3]);
+    // Re-expresses reslice axes given in the input's frame in the frame of a
+    // layout stored in order `perm`.
+    static void toLayoutFrame(const int perm[3], vtkMatrix4x4 *axes);
+
+    // The input stored as order(rowAxis, slabAxis), or the input itself when
+    // its rows already run along rowAxis (x). nullptr when the copy would
+    // exceed the budget. In the copy, axis i has the input's spacing and
+    // origin of axis perm[i], so world coordinates permute with it.
+    [[nodiscard]] vtkImageData *layoutFor(int rowAxis, int slabAxis);
+
+    // Bytes held by the copies.
+    [[nodiscard]] std::size_t residentBytes() const { return m_resident; }
+
+private:
+    struct Layout
+    {
+        int perm[3];
+        vtkSmartPointer<vtkImageData> image;
+    };
+
+    void clear();
+
+    vtkImageData *m_input = nullptr;
+    vtkMTimeType m_inputTime = 0;
+    std::vector<Layout> m_layouts;
+    std::size_t m_resident = 0;
+    std::size_t m_budget = kDefaultBudget;
+};
+
+#endif // VOLUMELAYOUTS_H
@@ -0,0 +1,123 @@
+#include "volumeofinterest.h"
+#include "vtkImageData.h"
+
+#include <algorithm>
+#include <cmath>
+
+void VolumeOfInterest::setInputData(vtkImageData *data)
+{
+    if (data == m_imageData) {
+        return;
+    }
+    m_imageData = data;
+    reset();
+}
+
+void VolumeOfInterest::reset()
+{
+    if (m_imageData) {
+        m_imageData->GetExtent(m_wholeExtent);
+    } else {
+        const int empty[6] = {0, -1, 0, -1, 0, -1};
+        std::copy(empty, empty + 6, m_wholeExtent);
+    }
+    std::copy(m_wholeExtent, m_wholeExtent + 6, m_extent);
+}
+
+bool VolumeOfInterest::setExtent(const int extent[6])
+{
+    if (!m_imageData) {
+        return false;
+    }
+
+    int clamped[6];
+    for (int axis = 0; axis < 3; ++axis) {
+        const int lo = m_wholeExtent[2 * axis];
+        const int hi = m_wholeExtent[2 * axis + 1];
+        int a = std::clamp(extent[2 * axis], lo, hi);
+        int b = std::clamp(extent[2 * axis + 1], lo, hi);
+        if (a > b)
+            std::swap(a, b);
+        clamped[2 * axis] = a;
+        clamped[2 * axis + 1] = b;
+    }
+    if (std::equal(clamped, clamped + 6, m_extent)) {
+        return false;
+    }
+    std::copy(clamped, clamped + 6, m_extent);
+    return true;
+}
+
+bool VolumeOfInterest::setBounds(const double bounds[6])
+{
+    if (!m_imageData) {
+        return false;
+    }
+
+    const double *origin = m_imageData->GetOrigin();
+    const double *spacing = m_imageData->GetSpacing();
+    int extent[6];
+    for (int axis = 0; axis < 3; ++axis) {
+        double a = (bounds[2 * axis] - origin[axis]) / spacing[axis];
+        double b = (bounds[2 * axis + 1] - origin[axis]) / spacing[axis];
+        if (a > b)
+            std::swap(a, b); // negative spacing
+        extent[2 * axis] = static_cast<int>(std::floor(a));
+        extent[2 * axis + 1] = static_cast<int>(std::ceil(b));
+    }
+    return setExtent(extent);
+}
+
+void VolumeOfInterest::bounds(double out[6]) const
+{
+    if (!m_imageData) {
+        std::fill(out, out + 6, 0.0);
+        return;
+    }
+
+    const double *origin = m_imageData->GetOrigin();
+    const double *spacing = m_imageData->GetSpacing();
+    for (int axis = 0; axis < 3; ++axis) {
+        const double a = origin[axis] + m_extent[2 * axis] * spacing[axis];
+        const double b = origin[axis] + m_extent[2 * axis + 1] * spacing[axis];
+        out[2 * axis] = std::min(a, b);
+        out[2 * axis + 1] = std::max(a, b);
+    }
+}
+
+void VolumeOfInterest::boxIn(vtkImageData *image, int extent[6], double bounds[6]) const
+{
+    if (image == m_imageData || !image) {
+        std::copy(m_extent, m_extent + 6, extent);
+        this->bounds(bounds);
+        return;
+    }
+
+    double world[6];
+    this->bounds(world);
+    const double *origin = image->GetOrigin();
+    const double *spacing = image->GetSpacing();
+    const int *whole = image->GetExtent();
+    for (int axis = 0; axis < 3; ++axis) {
+        double a = (world[2 * axis] - origin[axis]) / spacing[axis];
+        double b = (world[2 * axis + 1] - origin[axis]) / spacing[axis];
+        if (a > b)
+            std::swap(a, b); // negative spacing
+        // tolerance: centres that coincide up to rounding count as inside
+        int lo = std::clamp(static_cast<int>(std::ceil(a - 1e-6)), whole[2 * axis], whole[2 * axis + 1]);
+        int hi = std::clamp(static_cast<int>(std::floor(b + 1e-6)), whole[2 * axis], whole[2 * axis + 1]);
+        if (lo > hi)
+            lo = hi = std::clamp(static_cast<int>(std::lround(0.5 * (a + b))), whole[2 * axis], whole[2 * axis + 1]);
+        extent[2 * axis] = lo;
+        extent[2 * axis + 1] = hi;
+        const double p = origin[axis] + lo * spacing[axis];
+        const double q = origin[axis] + hi * spacing[axis];
+        bounds[2 * axis] = std::min(p, q);
+        bounds[2 * axis + 1] = std::max(p, q);
+    }
+}
+
+bool VolumeOfInterest::isWholeVolume() const
+{
+    return std::equal(m_extent, m_extent + 6, m_wholeExtent);
+}
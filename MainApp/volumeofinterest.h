@@ -0,0 +1,48 @@
+#ifndef VOLUMEOFINTEREST_H
+#define VOLUMEOFINTEREST_H
+
+class vtkImageData;
+
+/// @brief Axis-aligned box of voxels that projections and rendering are
+/// restricted to.
+///
+/// One instance per loaded volume, shared by pointer with every view; views
+/// narrow their own iteration ranges to it, so nothing is ever cropped into a
+/// copy. Stored as an inclusive voxel extent, always clamped to the image.
+class VolumeOfInterest
+{
+public:
+    VolumeOfInterest() = default;
+    ~VolumeOfInterest() = default;
+
+    // Non-copyable — views hold it by pointer.
+    VolumeOfInterest(const VolumeOfInterest &) = delete;
+    VolumeOfInterest &operator=(const VolumeOfInterest &) = delete;
+
+    // A different image resets the box to the whole volume.
+    void setInputData(vtkImageData *data);
+    void reset();
+
+    // Both return false when the (clamped) box is unchanged.
+    bool setExtent(const int extent[6]);
+    // World bounds (mm), widened outward to whole voxels.
+    bool setBounds(const double bounds[6]);
+
+    const int *extent() const { return m_extent; }
+    // World bounds of the outermost voxel centres.
+    void bounds(double out[6]) const;
+    // The box in the index space of another image in the same world frame
+    // (e.g. a resampled copy): the voxels whose centres lie inside it, at
+    // least one per axis, and their bounds.
+    void boxIn(vtkImageData *image, int extent[6], double bounds[6]) const;
+    // Voxels along one axis.
+    int size(int axis) const { return m_extent[2 * axis + 1] - m_extent[2 * axis] + 1; }
+    bool isWholeVolume() const;
+
+private:
+    vtkImageData *m_imageData = nullptr;
+    int m_wholeExtent[6] = {0, -1, 0, -1, 0, -1};
+    int m_extent[6] = {0, -1, 0, -1, 0, -1};
+};
+
+#endif // VOLUMEOFINTEREST_H
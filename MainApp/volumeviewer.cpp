@@ -0,0 +1,131 @@
+#include "volumeviewer.h"
+#include "volumeofinterest.h"
+#include "vtkGPUVolumeRayCastMapper.h"
+#include "vtkImageData.h"
+#include "vtkRenderWindow.h"
+
+#include <algorithm>
+
+VolumeViewer::VolumeViewer(bool cpuRendering)
+    : m_cpuRendering(cpuRendering)
+{
+    if (m_cpuRendering) {
+        m_mapper = vtkSmartPointer<CpuVolumeMapper>::New();
+    } else {
+        // Passes replace the mapper's own frame-rate driven adjustment.
+        auto gpuMapper = vtkSmartPointer<vtkGPUVolumeRayCastMapper>::New();
+        gpuMapper->AutoAdjustSampleDistancesOff();
+        m_mapper = gpuMapper;
+    }
+    m_mapper->SetBlendModeToComposite();
+    m_volume->SetMapper(m_mapper);
+    m_volume->SetProperty(m_property);
+    m_renderer->SetBackground(0.05, 0.05, 0.05);
+}
+
+void VolumeViewer::setInputData(vtkImageData *data)
+{
+    m_imageData = data;
+    if (!data) {
+        // Bricked series: nothing in RAM to map. Take the prop out of the
+        // scene so neither mapper is ever rendered without input.
+        m_renderer->RemoveVolume(m_volume);
+    }
+    m_mapper->SetInputData(data); // reference, not a copy
+    if (data) {
+        const double *spacing = data->GetSpacing();
+        m_sampleDistance = std::min({spacing[0], spacing[1], spacing[2]});
+    }
+    // transfer functions and sample distance follow the new scalars
+    m_prepared = false;
+}
+
+void VolumeViewer::setRenderWindow(vtkRenderWindow *window)
+{
+    window->AddRenderer(m_renderer);
+}
+
+void VolumeViewer::prepare()
+{
+    if (m_prepared || !m_imageData) {
+        return;
+    }
+    m_prepared = true;
+
+    // Same composite preset as SandBox: air hidden, soft tissue faint, bone
+    // ramping to opaque.
+    double range[2];
+    m_imageData->GetScalarRange(range);
+    m_opacity->RemoveAllPoints();
+    m_opacity->AddPoint(range[0], 0.0);
+    m_opacity->AddPoint(-1000, 0.0);
+    m_opacity->AddPoint(0, 0.05);
+    m_opacity->AddPoint(300, 0.2);
+    m_opacity->AddPoint(700, 0.7);
+    m_opacity->AddPoint(range[1], 1.0);
+
+    m_color->RemoveAllPoints();
+    m_color->AddRGBPoint(range[0], 0.0, 0.0, 0.0);
+    m_color->AddRGBPoint(range[1], 1.0, 1.0, 1.0);
+
+    m_property->SetScalarOpacity(m_opacity);
+    m_property->SetColor(m_color);
+    m_property->SetInterpolationTypeToLinear();
+    m_property->ShadeOff();
+
+    if (m_cpuRendering) {
+        // pre-integrated segments hold thin edges at twice the voxel step
+        static_cast<CpuVolumeMapper *>(m_mapper.Get())->raycaster().setSampleDistance(2.0 * m_sampleDistance);
+    }
+    applyPass(RefinePass::Final);
+    updateCropping();
+
+    m_renderer->AddVolume(m_volume);
+    m_renderer->ResetCamera();
+}
+
+void VolumeViewer::updateCropping()
+{
+    // Mapper cropping planes serve both paths: the GPU mapper clips in its
+    // shader, CpuVolumeMapper clips each ray to the box before marching.
+    if (!m_voi || m_voi->isWholeVolume()) {
+        m_mapper->CroppingOff();
+        return;
+    }
+    double bounds[6];
+    m_voi->bounds(bounds);
+    m_mapper->SetCroppingRegionPlanes(bounds);
+    m_mapper->SetCroppingRegionFlagsToSubVolume();
+    m_mapper->CroppingOn();
+}
+
+size_t VolumeViewer::cacheBytes() const
+{
+    return m_cpuRendering ? static_cast<CpuVolumeMapper *>(m_mapper.Get())->raycaster().memoryBytes() : 0;
+}
+
+size_t VolumeViewer::gradientBytes() const
+{
+    return m_cpuRendering ? static_cast<CpuVolumeMapper *>(m_mapper.Get())->raycaster().gradientBytes() : 0;
+}
+
+size_t VolumeViewer::textureBytesEstimate() const
+{
+    if (m_cpuRendering || !m_prepared || !m_imageData) {
+        return 0;
+    }
+    return static_cast<size_t>(m_imageData->GetNumberOfPoints()) * m_imageData->GetScalarSize()
+           * m_imageData->GetNumberOfScalarComponents();
+}
+
+void VolumeViewer::applyPass(RefinePass pass)
+{
+    if (m_cpuRendering) {
+        static_cast<CpuVolumeMapper *>(m_mapper.Get())->setPass(pass);
+        return;
+    }
+    auto *gpuMapper = static_cast<vtkGPUVolumeRayCastMapper *>(m_mapper.Get());
+    gpuMapper->SetImageSampleDistance(pass == RefinePass::Preview ? 2.0f : 1.0f);
+    gpuMapper->SetSampleDistance(static_cast<float>(
+        pass == RefinePass::Final ? m_sampleDistance : 2.0 * m_sampleDistance));
+}
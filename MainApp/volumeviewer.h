@@ -0,0 +1,75 @@
+#ifndef VOLUMEVIEWER_H
+#define VOLUMEVIEWER_H
+
+#include "cpuraycaster.h"
+#include "vtkColorTransferFunction.h"
+#include "vtkNew.h"
+#include "vtkPiecewiseFunction.h"
+#include "vtkRenderer.h"
+#include "vtkSmartPointer.h"
+#include "vtkVolume.h"
+#include "vtkVolumeProperty.h"
+
+class vtkImageData;
+class vtkRenderWindow;
+class VolumeOfInterest;
+
+/// @brief Composite 3D rendering of the loaded series.
+///
+/// The mapper reads the caller's vtkImageData in place — the same buffer the
+/// slice, MIP and DRR views use, never a second decode or copy. Transfer
+/// functions, the volume prop and the camera are only set up by prepare(), so
+/// a pane that is never opened costs nothing beyond the (empty) renderer.
+class VolumeViewer
+{
+public:
+    // cpuRendering: CpuVolumeMapper instead of vtkGPUVolumeRayCastMapper.
+    explicit VolumeViewer(bool cpuRendering = false);
+    ~VolumeViewer() = default;
+
+    // Non-copyable — owns VTK pipeline objects with reference semantics.
+    VolumeViewer(const VolumeViewer &) = delete;
+    VolumeViewer &operator=(const VolumeViewer &) = delete;
+
+    void setInputData(vtkImageData *data);
+    void setRenderWindow(vtkRenderWindow *window);
+    // Rays are cropped to this box (nullptr = whole volume); call
+    // updateCropping() after the box changes.
+    void setVolumeOfInterest(const VolumeOfInterest *voi) { m_voi = voi; }
+    void updateCropping();
+
+    // First call after setInputData() builds the transfer functions from the
+    // input's scalar range, sets the sample distance and fits the camera;
+    // later calls return immediately. Does nothing without in-RAM input.
+    void prepare();
+    bool isPrepared() const { return m_prepared; }
+
+    // Quality level for ProgressiveRenderer.
+    void applyPass(RefinePass pass);
+
+    // CPU raycaster working set and gradient volume (0 on the GPU path), and
+    // the 3D texture the GPU mapper uploads once prepared: the scalars at
+    // their own width (0 on the CPU path).
+    [[nodiscard]] size_t cacheBytes() const;
+    [[nodiscard]] size_t gradientBytes() const;
+    [[nodiscard]] size_t textureBytesEstimate() const;
+
+    [[nodiscard]] vtkRenderer *renderer() { return m_renderer; }
+    [[nodiscard]] vtkVolumeProperty *property() { return m_property; }
+
+private:
+    vtkImageData *m_imageData = nullptr;
+    const VolumeOfInterest *m_voi = nullptr;
+    bool m_cpuRendering = false;
+    bool m_prepared = false;
+    double m_sampleDistance = 1.0; // mm, smallest voxel edge
+
+    vtkSmartPointer<vtkVolumeMapper> m_mapper;
+    vtkNew<vtkPiecewiseFunction> m_opacity;
+    vtkNew<vtkColorTransferFunction> m_color;
+    vtkNew<vtkVolumeProperty> m_property;
+    vtkNew<vtkVolume> m_volume;
+    vtkNew<vtkRenderer> m_renderer;
+};
+
+#endif // VOLUMEVIEWER_H
@@ -1,3 +1,3 @@
 TEMPLATE = subdirs
-SUBDIRS = MainApp SandBox
+SUBDIRS = MainApp SandBox Benchmark LatencyHarness BatchCli RenderService RenderLoad
 win32-msvc*: QMAKE_CXXFLAGS += /MP
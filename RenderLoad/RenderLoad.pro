@@ -0,0 +1,20 @@
+TEMPLATE = app
+TARGET = RenderLoad
+CONFIG += console
+CONFIG -= app_bundle
+QT += network
+
+
+include(../shared_config.pri)
+
+# Talks to RenderService over HTTP only; the JSON report is shared with
+# Benchmark.
+INCLUDEPATH += ../Benchmark
+DEPENDPATH  += ../Benchmark
+
+SOURCES += \
+    load_main.cpp \
+    ../Benchmark/benchreport.cpp
+
+HEADERS += \
+    ../Benchmark/benchreport.h
@@ -0,0 +1,358 @@
+// Load generator for RenderService: concurrent keep-alive clients asking for
+// a fixed pool of distinct images, reporting throughput and tail latency.
+//
+// Usage: RenderLoad [options]
+//   --url URL                    service address                       (default http://127.0.0.1:8090)
+//   --connections N              concurrent clients                    (default 8)
+//   --requests N                 requests in total                     (default 2000)
+//   --duration S                 run for S seconds instead of --requests
+//   --views slice,mip,drr        views asked for                       (default slice,mip,drr)
+//   --distinct N                 distinct requests in the pool; fewer
+//                                means more cache hits and coalescing  (default 64)
+//   --size N                     output width, height keeps the aspect (default 256)
+//   --format png|raw                                                   (default png)
+//   --seed N                     pool and request order                (default 1)
+//   --json FILE                  machine-readable report ("-" = stdout)
+//
+// Every client draws requests uniformly from the pool. The X-Cache counts
+// show how many were rendered, served from the cache, or answered by an
+// identical request already in flight. Exit code 1 when a request failed.
+
+#include "benchreport.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTcpSocket>
+#include <QUrl>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+constexpr int kTimeoutMs = 30000;
+
+const char *const kViewNames[3] = {"slice", "mip", "drr"};
+const char *const kAxisNames[3] = {"sagittal", "coronal", "axial"};
+
+/// @brief One HTTP answer, as much of it as the client looks at.
+struct Reply
+{
+    int status = 0;
+    QByteArray cache; // X-Cache
+    QByteArray body;
+};
+
+/// @brief A blocking keep-alive connection; used from one thread only.
+class Client
+{
+public:
+    Client(const QString &host, quint16 port)
+        : m_host(host)
+        , m_port(port)
+    {
+    }
+
+    // Reconnects when the server closed the previous connection.
+    bool get(const QByteArray &target, Reply &reply)
+    {
+        if (m_socket.state() != QAbstractSocket::ConnectedState) {
+            m_socket.abort();
+            m_buffer.clear();
+            m_socket.connectToHost(m_host, m_port);
+            if (!m_socket.waitForConnected(kTimeoutMs))
+                return false;
+        }
+        m_socket.write("GET " + target + " HTTP/1.1\r\nHost: " + m_host.toLatin1() + "\r\n\r\n");
+        if (!m_socket.waitForBytesWritten(kTimeoutMs))
+            return false;
+
+        int end;
+        while ((end = m_buffer.indexOf("\r\n\r\n")) < 0) {
+            if (!read())
+                return false;
+        }
+        const QList<QByteArray> lines = m_buffer.left(end).split('\n');
+        m_buffer.remove(0, end + 4);
+        const QList<QByteArray> statusLine = lines.first().trimmed().split(' ');
+        if (statusLine.size() < 2)
+            return false;
+        reply.status = statusLine[1].toInt();
+        reply.cache.clear();
+        long long length = 0;
+        bool close = false;
+        for (int i = 1; i < lines.size(); ++i) {
+            const int colon = lines[i].indexOf(':');
+            if (colon < 0)
+                continue;
+            const QByteArray name = lines[i].left(colon).trimmed().toLower();
+            const QByteArray value = lines[i].mid(colon + 1).trimmed();
+            if (name == "content-length")
+                length = value.toLongLong();
+            else if (name == "x-cache")
+                reply.cache = value;
+            else if (name == "connection")
+                close = value.toLower() == "close";
+        }
+        while (m_buffer.size() < length) {
+            if (!read())
+                return false;
+        }
+        reply.body = m_buffer.left(int(length));
+        m_buffer.remove(0, int(length));
+        if (close)
+            m_socket.disconnectFromHost();
+        return true;
+    }
+
+private:
+    bool read()
+    {
+        if (m_socket.bytesAvailable() == 0 && !m_socket.waitForReadyRead(kTimeoutMs))
+            return false;
+        m_buffer += m_socket.readAll();
+        return true;
+    }
+
+    QString m_host;
+    quint16 m_port;
+    QTcpSocket m_socket;
+    QByteArray m_buffer;
+};
+
+/// @brief What one client saw.
+struct ClientResult
+{
+    std::vector<double> latencyMs;
+    long long bytes = 0;
+    int errors = 0;
+    int rendered = 0;
+    int cached = 0;
+    int coalesced = 0;
+};
+
+// Nearest-rank percentile.
+double percentile(std::vector<double> samples, double p)
+{
+    if (samples.empty())
+        return 0.0;
+    std::sort(samples.begin(), samples.end());
+    const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+    return samples[std::min(samples.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+// `count` render targets over the served series; the same seed gives the
+// same pool, so runs against a service compare.
+std::vector<QByteArray> buildPool(const QJsonArray &series, const std::vector<int> &views, int count, int size,
+                                  const QString &format, unsigned seed)
+{
+    static const int kSlabs[3] = {0, 16, 48};
+    static const double kWindows[3][2] = {{400, 40}, {1500, -600}, {2000, 300}}; // soft tissue, lung, bone
+    std::mt19937 rng(seed);
+    std::vector<QByteArray> pool;
+    for (int i = 0; i < count; ++i) {
+        const QJsonObject item = series[int(rng() % unsigned(series.size()))].toObject();
+        const int view = views[rng() % views.size()];
+        const int axis = int(rng() % 3);
+        const int slices = std::max(1, item.value("dims").toArray().at(axis).toInt());
+        const double *window = kWindows[rng() % 3];
+        QString target = QString("/render?series=%1&view=%2&axis=%3&width=%4&format=%5")
+                             .arg(QString::fromLatin1(QUrl::toPercentEncoding(item.value("name").toString())),
+                                  QLatin1String(kViewNames[view]), QLatin1String(kAxisNames[axis]),
+                                  QString::number(size), format);
+        const int slab = view == 0 ? 0 : kSlabs[rng() % 3];
+        if (view == 0 || slab > 0)
+            target += QString("&slice=%1").arg(int(rng() % unsigned(slices)));
+        if (slab > 0)
+            target += QString("&slab=%1").arg(slab);
+        if (format == "png")
+            target += QString("&window=%1&level=%2").arg(window[0]).arg(window[1]);
+        pool.push_back(target.toLatin1());
+    }
+    return pool;
+}
+
+bool parseViews(const QString &text, std::vector<int> &out)
+{
+    out.clear();
+    for (const QString &item : text.split(',', Qt::SkipEmptyParts)) {
+        const QString name = item.trimmed().toLower();
+        const auto found = std::find(std::begin(kViewNames), std::end(kViewNames), name);
+        if (found == std::end(kViewNames))
+            return false;
+        out.push_back(int(found - std::begin(kViewNames)));
+    }
+    return !out.empty();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Concurrent clients for RenderService; throughput and tail latency.");
+    parser.addHelpOption();
+    const QCommandLineOption urlOption("url", "Service address.", "url", "http://127.0.0.1:8090");
+    const QCommandLineOption connectionsOption("connections", "Concurrent clients.", "n", "8");
+    const QCommandLineOption requestsOption("requests", "Requests in total.", "n", "2000");
+    const QCommandLineOption durationOption("duration", "Seconds to run, instead of --requests.", "s");
+    const QCommandLineOption viewsOption("views", "slice, mip, drr.", "list", "slice,mip,drr");
+    const QCommandLineOption distinctOption("distinct", "Distinct requests in the pool.", "n", "64");
+    const QCommandLineOption sizeOption("size", "Output width.", "n", "256");
+    const QCommandLineOption formatOption("format", "png or raw.", "name", "png");
+    const QCommandLineOption seedOption("seed", "Pool and request order.", "n", "1");
+    const QCommandLineOption jsonOption("json", "Write a JSON report (\"-\" = stdout).", "file");
+    parser.addOptions({urlOption, connectionsOption, requestsOption, durationOption, viewsOption, distinctOption,
+                       sizeOption, formatOption, seedOption, jsonOption});
+    parser.process(app);
+
+    const QUrl url(parser.value(urlOption));
+    if (!url.isValid() || url.host().isEmpty()) {
+        std::fprintf(stderr, "bad --url '%s'\n", qPrintable(parser.value(urlOption)));
+        return 1;
+    }
+    std::vector<int> views;
+    if (!parseViews(parser.value(viewsOption), views)) {
+        std::fprintf(stderr, "bad --views '%s'\n", qPrintable(parser.value(viewsOption)));
+        return 1;
+    }
+    const QString format = parser.value(formatOption);
+    if (format != "png" && format != "raw") {
+        std::fprintf(stderr, "unknown format '%s'\n", qPrintable(format));
+        return 1;
+    }
+    const int connections = std::max(1, parser.value(connectionsOption).toInt());
+    const long long requests = std::max(1LL, parser.value(requestsOption).toLongLong());
+    const double durationS = parser.isSet(durationOption) ? parser.value(durationOption).toDouble() : 0.0;
+    const int distinct = std::max(1, parser.value(distinctOption).toInt());
+    const int size = std::max(0, parser.value(sizeOption).toInt());
+    const unsigned seed = parser.value(seedOption).toUInt();
+    const QString host = url.host();
+    const quint16 port = quint16(url.port(8090));
+
+    Reply reply;
+    Client probe(host, port);
+    if (!probe.get("/series", reply) || reply.status != 200) {
+        std::fprintf(stderr, "no service at %s\n", qPrintable(url.toString()));
+        return 1;
+    }
+    const QJsonArray series = QJsonDocument::fromJson(reply.body).array();
+    if (series.isEmpty()) {
+        std::fprintf(stderr, "the service has no series\n");
+        return 1;
+    }
+    const std::vector<QByteArray> pool = buildPool(series, views, distinct, size, format, seed);
+
+    std::printf("%s: %d series, %zu distinct requests, %d connections, %s\n", qPrintable(url.toString()),
+                int(series.size()), pool.size(), connections,
+                durationS > 0 ? qPrintable(QString("%1 s").arg(durationS))
+                              : qPrintable(QString("%1 requests").arg(requests)));
+
+    // Requests are handed out from one counter (or until the deadline), so
+    // fast clients take more of them, as real viewers would.
+    std::atomic<long long> issued{0};
+    std::vector<ClientResult> results(connections);
+    std::vector<std::thread> clients;
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(durationS));
+    for (int c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c] {
+            ClientResult &result = results[c];
+            Client client(host, port);
+            std::mt19937 rng(seed * 7919u + unsigned(c));
+            Reply answer;
+            for (;;) {
+                if (durationS > 0 ? Clock::now() >= deadline : issued++ >= requests)
+                    break;
+                const QByteArray &target = pool[rng() % pool.size()];
+                const auto t0 = Clock::now();
+                const bool ok = client.get(target, answer);
+                const double ms = elapsedMs(t0);
+                if (!ok || answer.status != 200) {
+                    ++result.errors;
+                    continue;
+                }
+                result.latencyMs.push_back(ms);
+                result.bytes += answer.body.size();
+                if (answer.cache == "cached")
+                    ++result.cached;
+                else if (answer.cache == "coalesced")
+                    ++result.coalesced;
+                else
+                    ++result.rendered;
+            }
+        });
+    }
+    for (auto &client : clients)
+        client.join();
+    const double seconds = elapsedMs(start) / 1000.0;
+
+    ClientResult total;
+    for (const ClientResult &result : results) {
+        total.latencyMs.insert(total.latencyMs.end(), result.latencyMs.begin(), result.latencyMs.end());
+        total.bytes += result.bytes;
+        total.errors += result.errors;
+        total.rendered += result.rendered;
+        total.cached += result.cached;
+        total.coalesced += result.coalesced;
+    }
+    const size_t answered = total.latencyMs.size();
+    const double p50 = percentile(total.latencyMs, 50.0);
+    const double p90 = percentile(total.latencyMs, 90.0);
+    const double p99 = percentile(total.latencyMs, 99.0);
+    const double p999 = percentile(total.latencyMs, 99.9);
+    const double maxMs = percentile(total.latencyMs, 100.0);
+    std::printf("%zu requests, %d errors in %.2f s: %.1f req/s, %.1f MB/s\n", answered, total.errors, seconds,
+                answered / seconds, total.bytes / 1e6 / seconds);
+    std::printf("latency ms: p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f\n", p50, p90, p99, p999, maxMs);
+    std::printf("rendered %d  cached %d  coalesced %d\n", total.rendered, total.cached, total.coalesced);
+    if (probe.get("/stats", reply) && reply.status == 200)
+        std::printf("service: %s\n", reply.body.constData());
+
+    if (parser.isSet(jsonOption)) {
+        BenchReport report;
+        report.setContext("url", url.toString());
+        report.setContext("date", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+        report.setContext("os", QSysInfo::prettyProductName());
+        BenchCase c;
+        c.name = "service.load";
+        c.params.insert("connections", connections);
+        c.params.insert("distinct", int(pool.size()));
+        c.params.insert("views", parser.value(viewsOption));
+        c.params.insert("size", size);
+        c.params.insert("format", format);
+        c.metrics.insert("requestsPerSecond", answered / seconds);
+        c.metrics.insert("errors", total.errors);
+        c.metrics.insert("p50", p50);
+        c.metrics.insert("p90", p90);
+        c.metrics.insert("p99", p99);
+        c.metrics.insert("p999", p999);
+        c.metrics.insert("rendered", total.rendered);
+        c.metrics.insert("cached", total.cached);
+        c.metrics.insert("coalesced", total.coalesced);
+        c.samplesMs = std::move(total.latencyMs);
+        report.add(std::move(c));
+        if (!report.write(parser.value(jsonOption)))
+            return 1;
+    }
+    return total.errors > 0 ? 1 : 0;
+}
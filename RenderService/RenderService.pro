@@ -0,0 +1,33 @@
+TEMPLATE = app
+TARGET = RenderService
+CONFIG += console
+CONFIG -= app_bundle
+QT += network
+
+
+include(../shared_config.pri)
+
+# The projection viewers are compiled straight from MainApp — no widgets,
+# no render window.
+INCLUDEPATH += ../MainApp
+DEPENDPATH  += ../MainApp
+
+SOURCES += \
+    httpserver.cpp \
+    renderservice.cpp \
+    service_main.cpp \
+    ../MainApp/brickedvolume.cpp \
+    ../MainApp/drrviewer.cpp \
+    ../MainApp/memoryledger.cpp \
+    ../MainApp/mipviewer.cpp \
+    ../MainApp/paralleldicomreader.cpp \
+    ../MainApp/parallelfor.cpp \
+    ../MainApp/projectionviewer.cpp \
+    ../MainApp/taskscheduler.cpp \
+    ../MainApp/tracing.cpp \
+    ../MainApp/volumelayouts.cpp \
+    ../MainApp/volumeofinterest.cpp
+
+HEADERS += \
+    httpserver.h \
+    renderservice.h
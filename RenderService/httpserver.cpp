@@ -0,0 +1,188 @@
+#include "httpserver.h"
+#include "renderservice.h"
+
+#include <QTcpSocket>
+#include <QUrl>
+#include <QUrlQuery>
+
+namespace Service {
+
+// Requests are a line and a few headers; anything longer is not ours.
+static constexpr int kMaxHeaderBytes = 16 * 1024;
+
+static const char *reason(int status)
+{
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 431: return "Request Header Fields Too Large";
+    default: return "Internal Server Error";
+    }
+}
+
+static const char *cacheName(RenderService::Source source)
+{
+    switch (source) {
+    case RenderService::Source::Cached: return "cached";
+    case RenderService::Source::Coalesced: return "coalesced";
+    default: return "rendered";
+    }
+}
+
+} // namespace Service
+
+HttpServer::HttpServer(RenderService &service)
+    : m_service(service)
+{
+    QObject::connect(&m_server, &QTcpServer::newConnection, &m_server, [this] { accept(); });
+}
+
+HttpServer::~HttpServer()
+{
+    m_server.close();
+    m_service.waitForRenders(); // no callback may outlive the sockets it posts to
+}
+
+bool HttpServer::listen(const QHostAddress &address, quint16 port)
+{
+    return m_server.listen(address, port);
+}
+
+void HttpServer::accept()
+{
+    while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+        m_connections.insert(socket, Connection());
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket] {
+            auto found = m_connections.find(socket);
+            if (found == m_connections.end())
+                return;
+            found->buffer += socket->readAll();
+            process(socket);
+        });
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, [this, socket] {
+            auto found = m_connections.find(socket);
+            if (found == m_connections.end())
+                return;
+            if (found->busy) {
+                found->gone = true; // a render will still post to this socket
+                return;
+            }
+            m_connections.erase(found);
+            socket->deleteLater();
+        });
+    }
+}
+
+void HttpServer::process(QTcpSocket *socket)
+{
+    // One request per pass; a render ends the loop and picks it up again
+    // when its response is written, so answers keep the request order.
+    for (;;) {
+        auto found = m_connections.find(socket);
+        if (found == m_connections.end() || found->busy || found->gone)
+            return;
+        Connection &connection = *found;
+
+        const int end = connection.buffer.indexOf("\r\n\r\n");
+        if (end < 0) {
+            if (connection.buffer.size() > Service::kMaxHeaderBytes) {
+                connection.close = true;
+                respond(socket, 431, "text/plain", "request too large\n");
+            }
+            return;
+        }
+        const QList<QByteArray> lines = connection.buffer.left(end).split('\n');
+        connection.buffer.remove(0, end + 4);
+
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() != 3) {
+            connection.close = true;
+            respond(socket, 400, "text/plain", "bad request line\n");
+            return;
+        }
+        connection.close = requestLine[2] == "HTTP/1.0";
+        for (int i = 1; i < lines.size(); ++i) {
+            const int colon = lines[i].indexOf(':');
+            if (colon < 0 || lines[i].left(colon).trimmed().toLower() != "connection")
+                continue;
+            const QByteArray value = lines[i].mid(colon + 1).trimmed().toLower();
+            if (value.contains("close"))
+                connection.close = true;
+            else if (value.contains("keep-alive"))
+                connection.close = false;
+        }
+        const bool close = connection.close;
+        if (requestLine[0] != "GET") {
+            respond(socket, 405, "text/plain", "GET only\n", "Allow: GET\r\n");
+            if (close)
+                return;
+            continue;
+        }
+
+        const QUrl url(QString::fromLatin1("http://localhost") + QString::fromLatin1(requestLine[1]));
+        const QString path = url.path();
+        if (path == "/render") {
+            RenderRequest request;
+            QString error;
+            if (RenderRequest::parse(QUrlQuery(url), request, error)) {
+                connection.busy = true;
+                m_service.render(request, [this, socket](std::shared_ptr<const RenderResponse> response,
+                                                         RenderService::Source source) {
+                    // Back on the socket's thread; the socket stays alive while busy.
+                    QMetaObject::invokeMethod(socket, [this, socket, response, source] {
+                        if (!finish(socket))
+                            return;
+                        QByteArray headers = QByteArray("X-Cache: ") + Service::cacheName(source) + "\r\n";
+                        if (response->status == 200) {
+                            headers += "X-Image-Width: " + QByteArray::number(response->width) + "\r\n";
+                            headers += "X-Image-Height: " + QByteArray::number(response->height) + "\r\n";
+                        }
+                        const bool close = m_connections.value(socket).close;
+                        respond(socket, response->status, response->contentType, response->body, headers);
+                        if (!close)
+                            process(socket); // pipelined requests
+                    }, Qt::QueuedConnection);
+                });
+                return;
+            }
+            respond(socket, 400, "text/plain", error.toUtf8() + "\n");
+        } else if (path == "/series") {
+            respond(socket, 200, "application/json", m_service.seriesJson());
+        } else if (path == "/stats") {
+            respond(socket, 200, "application/json", m_service.statsJson());
+        } else {
+            respond(socket, 404, "text/plain", "unknown path\n");
+        }
+        if (close)
+            return;
+    }
+}
+
+bool HttpServer::finish(QTcpSocket *socket)
+{
+    auto found = m_connections.find(socket);
+    found->busy = false;
+    if (!found->gone)
+        return true;
+    m_connections.erase(found);
+    socket->deleteLater();
+    return false;
+}
+
+void HttpServer::respond(QTcpSocket *socket, int status, const QByteArray &contentType, const QByteArray &body,
+                         const QByteArray &extraHeaders)
+{
+    const bool close = m_connections.value(socket).close;
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(status) + ' ' + Service::reason(status) + "\r\n";
+    head += "Content-Type: " + contentType + "\r\n";
+    head += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    head += close ? "Connection: close\r\n" : "Connection: keep-alive\r\n";
+    head += extraHeaders;
+    head += "\r\n";
+    socket->write(head);
+    socket->write(body);
+    if (close)
+        socket->disconnectFromHost(); // after the pending bytes are written
+}
@@ -0,0 +1,57 @@
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QTcpServer>
+
+class QTcpSocket;
+class RenderService;
+
+/// @brief Minimal HTTP/1.1 front end of a RenderService.
+///
+/// GET only, keep-alive, requests on one connection answered in order.
+///   /render?series=...   image (see RenderRequest::parse); X-Cache says
+///                        whether it was rendered, cached or coalesced
+///   /series              loaded series as JSON
+///   /stats               service counters as JSON
+/// Sockets live on the thread that runs the event loop; renders finish on
+/// workers and are written back through a queued call.
+class HttpServer
+{
+public:
+    explicit HttpServer(RenderService &service);
+    // Waits for the service's renders: their callbacks post to the sockets.
+    ~HttpServer();
+
+    // Non-copyable — owns the listening socket and the connections.
+    HttpServer(const HttpServer &) = delete;
+    HttpServer &operator=(const HttpServer &) = delete;
+
+    bool listen(const QHostAddress &address, quint16 port);
+    [[nodiscard]] QString errorString() const { return m_server.errorString(); }
+
+private:
+    /// @brief Bytes received but not yet answered, per connection.
+    struct Connection
+    {
+        QByteArray buffer;
+        bool busy = false;  // a response is being produced
+        bool close = false; // client asked for Connection: close
+        bool gone = false;  // disconnected while busy: deleted once the render is back
+    };
+
+    void accept();
+    void process(QTcpSocket *socket);
+    // Clears busy; false (and the socket deleted) if the client left meanwhile.
+    bool finish(QTcpSocket *socket);
+    void respond(QTcpSocket *socket, int status, const QByteArray &contentType, const QByteArray &body,
+                 const QByteArray &extraHeaders = QByteArray());
+
+    RenderService &m_service;
+    QTcpServer m_server;
+    QHash<QTcpSocket *, Connection> m_connections;
+};
+
+#endif // HTTPSERVER_H
@@ -0,0 +1,422 @@
+#include "renderservice.h"
+#include "taskscheduler.h"
+#include "tracing.h"
+
+#include "vtkImageCast.h"
+#include "vtkImageResize.h"
+#include "vtkImageShiftScale.h"
+#include "vtkNew.h"
+#include "vtkPNGWriter.h"
+#include "vtkUnsignedCharArray.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QUrlQuery>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace Service {
+
+// Volume axes along the output image X and Y, as in the projection viewers.
+static constexpr int kPlaneAxes[3][2] = {{1, 2}, {0, 2}, {0, 1}};
+
+// One voxel plane of `volume` in the projection viewers' orientation.
+static vtkSmartPointer<vtkImageData> extractSlice(vtkImageData *volume, int axis, int index)
+{
+    const int u = kPlaneAxes[axis][0];
+    const int v = kPlaneAxes[axis][1];
+    int dims[3];
+    double spacing[3];
+    volume->GetDimensions(dims);
+    volume->GetSpacing(spacing);
+
+    auto slice = vtkSmartPointer<vtkImageData>::New();
+    slice->SetDimensions(dims[u], dims[v], 1);
+    slice->SetSpacing(std::abs(spacing[u]), std::abs(spacing[v]), 1.0);
+    slice->AllocateScalars(volume->GetScalarType(), volume->GetNumberOfScalarComponents());
+
+    const std::size_t voxel = std::size_t(volume->GetScalarSize()) * volume->GetNumberOfScalarComponents();
+    const std::size_t stride[3] = {voxel, voxel * dims[0], voxel * dims[0] * dims[1]};
+    const auto *in = static_cast<const unsigned char *>(volume->GetScalarPointer()) + index * stride[axis];
+    auto *out = static_cast<unsigned char *>(slice->GetScalarPointer());
+    for (int j = 0; j < dims[v]; ++j) {
+        const unsigned char *row = in + j * stride[v];
+        if (u == 0) {
+            std::memcpy(out, row, voxel * dims[u]); // x rows are contiguous
+            out += voxel * dims[u];
+            continue;
+        }
+        for (int i = 0; i < dims[u]; ++i, out += voxel)
+            std::memcpy(out, row + i * stride[u], voxel);
+    }
+    return slice;
+}
+
+static std::shared_ptr<RenderResponse> failure(int status, const char *message)
+{
+    auto response = std::make_shared<RenderResponse>();
+    response->status = status;
+    response->contentType = "text/plain";
+    response->body = QByteArray(message) + "\n";
+    return response;
+}
+
+// Resized (physical aspect kept when only one side is given), then PNG
+// through window/level or float32 as is.
+static std::shared_ptr<RenderResponse> encode(vtkImageData *image, const RenderRequest &request)
+{
+    int dims[3];
+    double spacing[3];
+    image->GetDimensions(dims);
+    image->GetSpacing(spacing);
+    int width = request.width;
+    int height = request.height;
+    vtkSmartPointer<vtkImageData> sized = image;
+    if (width > 0 || height > 0) {
+        const double aspect = (dims[1] * std::abs(spacing[1])) / (dims[0] * std::abs(spacing[0])); // height / width
+        if (width <= 0)
+            width = std::max(1, static_cast<int>(std::lround(height / aspect)));
+        if (height <= 0)
+            height = std::max(1, static_cast<int>(std::lround(width * aspect)));
+        vtkNew<vtkImageResize> resize;
+        resize->SetInputData(image);
+        resize->SetResizeMethodToOutputDimensions();
+        resize->SetOutputDimensions(width, height, 1);
+        resize->Update();
+        sized = resize->GetOutput();
+    } else {
+        width = dims[0];
+        height = dims[1];
+    }
+
+    auto response = std::make_shared<RenderResponse>();
+    response->width = width;
+    response->height = height;
+    if (request.format == RenderFormat::Raw) {
+        vtkNew<vtkImageCast> cast;
+        cast->SetInputData(sized);
+        cast->SetOutputScalarTypeToFloat();
+        cast->Update();
+        response->contentType = "application/octet-stream";
+        response->body = QByteArray(static_cast<const char *>(cast->GetOutput()->GetScalarPointer()),
+                                    int(std::size_t(width) * height * sizeof(float)));
+        return response;
+    }
+
+    double lo, hi;
+    if (request.window > 0) {
+        lo = request.level - request.window * 0.5;
+        hi = request.level + request.window * 0.5;
+    } else {
+        double range[2];
+        sized->GetScalarRange(range);
+        lo = range[0];
+        hi = range[1];
+    }
+    vtkNew<vtkImageShiftScale> toBytes;
+    toBytes->SetInputData(sized);
+    toBytes->SetShift(-lo);
+    toBytes->SetScale(hi > lo ? 255.0 / (hi - lo) : 0.0);
+    toBytes->SetOutputScalarTypeToUnsignedChar();
+    toBytes->ClampOverflowOn();
+    vtkNew<vtkPNGWriter> writer;
+    writer->SetInputConnection(toBytes->GetOutputPort());
+    writer->WriteToMemoryOn();
+    writer->Write();
+    vtkUnsignedCharArray *png = writer->GetResult();
+    if (!png) {
+        return failure(500, "cannot encode image");
+    }
+    response->contentType = "image/png";
+    response->body = QByteArray(reinterpret_cast<const char *>(png->GetPointer(0)), int(png->GetNumberOfValues()));
+    return response;
+}
+
+} // namespace Service
+
+bool RenderRequest::parse(const QUrlQuery &query, RenderRequest &out, QString &error)
+{
+    RenderRequest request;
+    request.series = query.queryItemValue("series", QUrl::FullyDecoded).toStdString();
+    if (request.series.empty()) {
+        error = "missing series";
+        return false;
+    }
+
+    const QString view = query.queryItemValue("view").toLower();
+    if (view == "slice")
+        request.view = RenderView::Slice;
+    else if (view == "drr")
+        request.view = RenderView::Drr;
+    else if (view.isEmpty() || view == "mip")
+        request.view = RenderView::Mip;
+    else {
+        error = "unknown view " + view;
+        return false;
+    }
+
+    const QString axis = query.queryItemValue("axis").toLower();
+    const QStringList axisNames = {"sagittal", "coronal", "axial"};
+    if (axisNames.contains(axis)) {
+        request.axis = axisNames.indexOf(axis);
+    } else if (!axis.isEmpty()) {
+        bool ok = false;
+        request.axis = axis.toInt(&ok);
+        if (!ok || request.axis < 0 || request.axis > 2) {
+            error = "unknown axis " + axis;
+            return false;
+        }
+    }
+
+    const auto readInt = [&](const char *name, int &value) {
+        if (!query.hasQueryItem(name))
+            return true;
+        bool ok = false;
+        value = query.queryItemValue(name).toInt(&ok);
+        if (!ok)
+            error = QString("bad %1").arg(name);
+        return ok;
+    };
+    const auto readDouble = [&](const char *name, double &value) {
+        if (!query.hasQueryItem(name))
+            return true;
+        bool ok = false;
+        value = query.queryItemValue(name).toDouble(&ok);
+        if (!ok)
+            error = QString("bad %1").arg(name);
+        return ok;
+    };
+    if (!readInt("slice", request.slice) || !readInt("slab", request.slab) || !readInt("width", request.width)
+        || !readInt("height", request.height) || !readDouble("window", request.window)
+        || !readDouble("level", request.level)) {
+        return false;
+    }
+
+    const QString format = query.queryItemValue("format").toLower();
+    if (format == "raw")
+        request.format = RenderFormat::Raw;
+    else if (!format.isEmpty() && format != "png") {
+        error = "unknown format " + format;
+        return false;
+    }
+    out = request;
+    return true;
+}
+
+RenderService::~RenderService()
+{
+    waitForRenders();
+}
+
+void RenderService::waitForRenders()
+{
+    std::vector<std::shared_future<void>> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pending = m_pending;
+    }
+    for (auto &future : pending)
+        future.wait();
+}
+
+void RenderService::addSeries(const std::string &name, vtkImageData *volume)
+{
+    auto series = std::make_unique<Series>();
+    series->volume = volume;
+    volume->GetDimensions(series->dims);
+    series->mipBox.setInputData(volume);
+    series->drrBox.setInputData(volume);
+    series->mip.setInputData(volume);
+    series->mip.setVolumeOfInterest(&series->mipBox);
+    series->drr.setInputData(volume);
+    series->drr.setVolumeOfInterest(&series->drrBox);
+    m_series[name] = std::move(series);
+}
+
+QByteArray RenderService::seriesJson() const
+{
+    QJsonArray list;
+    for (const auto &entry : m_series) {
+        const Series &series = *entry.second;
+        const double *spacing = series.volume->GetSpacing();
+        QJsonObject item;
+        item.insert("name", QString::fromStdString(entry.first));
+        item.insert("dims", QJsonArray{series.dims[0], series.dims[1], series.dims[2]});
+        item.insert("spacing", QJsonArray{spacing[0], spacing[1], spacing[2]});
+        list.append(item);
+    }
+    return QJsonDocument(list).toJson(QJsonDocument::Compact);
+}
+
+QByteArray RenderService::statsJson() const
+{
+    QJsonObject stats;
+    const long long rendered = m_rendered.load();
+    stats.insert("requests", double(m_requests.load()));
+    stats.insert("cached", double(m_cached.load()));
+    stats.insert("coalesced", double(m_coalesced.load()));
+    stats.insert("rendered", double(rendered));
+    stats.insert("meanRenderMs", rendered > 0 ? m_renderMicros.load() / 1000.0 / rendered : 0.0);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.insert("cacheEntries", int(m_cache.size()));
+        stats.insert("cacheMB", m_cacheBytes / 1e6);
+        stats.insert("inFlight", int(m_inFlight.size()));
+    }
+    return QJsonDocument(stats).toJson(QJsonDocument::Compact);
+}
+
+void RenderService::setCacheBudget(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cacheBudget = bytes;
+    while (m_cacheBytes > m_cacheBudget && !m_lru.empty()) {
+        auto victim = m_cache.find(m_lru.back());
+        m_cacheBytes -= std::size_t(victim->second.response->body.size());
+        m_cache.erase(victim);
+        m_lru.pop_back();
+    }
+}
+
+void RenderService::normalize(RenderRequest &request, const int dims[3])
+{
+    const int count = dims[request.axis];
+    if (request.view != RenderView::Slice && (request.slab <= 0 || request.slab >= count)) {
+        request.slab = 0; // whole volume: the centre does not matter
+        request.slice = -1;
+    } else {
+        request.slice = request.slice < 0 ? count / 2 : std::min(request.slice, count - 1);
+        if (request.view == RenderView::Slice)
+            request.slab = 0;
+    }
+    if (request.window <= 0 || request.format == RenderFormat::Raw) {
+        request.window = 0; // raw images carry the values themselves
+        request.level = 0;
+    }
+    request.width = std::clamp(request.width, 0, kMaxOutputSize);
+    request.height = std::clamp(request.height, 0, kMaxOutputSize);
+}
+
+std::string RenderService::key(const RenderRequest &request)
+{
+    char text[160];
+    std::snprintf(text, sizeof(text), "|%d|%d|%d|%d|%.6g|%.6g|%d|%d|%d", static_cast<int>(request.view), request.axis,
+                  request.slice, request.slab, request.window, request.level, request.width, request.height,
+                  static_cast<int>(request.format));
+    return request.series + text;
+}
+
+void RenderService::render(RenderRequest request, Callback done)
+{
+    ++m_requests;
+    auto found = m_series.find(request.series);
+    if (found == m_series.end()) {
+        done(Service::failure(404, "unknown series"), Source::Rendered);
+        return;
+    }
+    Series &series = *found->second;
+    normalize(request, series.dims);
+    const std::string requestKey = key(request);
+
+    std::shared_ptr<const RenderResponse> cached;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto hit = m_cache.find(requestKey);
+        if (hit != m_cache.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, hit->second.lru);
+            cached = hit->second.response;
+        } else {
+            auto flight = m_inFlight.find(requestKey);
+            if (flight != m_inFlight.end()) {
+                flight->second.waiting.push_back(std::move(done)); // answered with the running render
+                ++m_coalesced;
+                return;
+            }
+            m_inFlight[requestKey].waiting.push_back(std::move(done));
+        }
+    }
+    if (cached) {
+        ++m_cached;
+        done(cached, Source::Cached);
+        return;
+    }
+
+    auto future = TaskScheduler::instance().submit(TaskPriority::Visible, [this, &series, request, requestKey] {
+        const auto t0 = std::chrono::steady_clock::now();
+        std::shared_ptr<const RenderResponse> response = produce(series, request);
+        m_renderMicros += std::chrono::duration_cast<std::chrono::microseconds>(
+                              std::chrono::steady_clock::now() - t0).count();
+        ++m_rendered;
+
+        std::vector<Callback> waiting;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto flight = m_inFlight.find(requestKey);
+            waiting = std::move(flight->second.waiting);
+            m_inFlight.erase(flight);
+            if (response->status == 200)
+                insertCache(requestKey, response);
+        }
+        for (std::size_t i = 0; i < waiting.size(); ++i)
+            waiting[i](response, i == 0 ? Source::Rendered : Source::Coalesced);
+    });
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // drop finished renders so the list stays as short as the queue
+    m_pending.erase(std::remove_if(m_pending.begin(), m_pending.end(),
+                                   [](const std::shared_future<void> &f) {
+                                       return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                                   }),
+                    m_pending.end());
+    m_pending.push_back(std::move(future));
+}
+
+void RenderService::insertCache(const std::string &requestKey, const std::shared_ptr<const RenderResponse> &response)
+{
+    const std::size_t bytes = std::size_t(response->body.size());
+    if (bytes > m_cacheBudget) {
+        return;
+    }
+    while (m_cacheBytes + bytes > m_cacheBudget && !m_lru.empty()) {
+        auto victim = m_cache.find(m_lru.back());
+        m_cacheBytes -= std::size_t(victim->second.response->body.size());
+        m_cache.erase(victim);
+        m_lru.pop_back();
+    }
+    m_lru.push_front(requestKey);
+    m_cache[requestKey] = {response, m_lru.begin()};
+    m_cacheBytes += bytes;
+}
+
+std::shared_ptr<const RenderResponse> RenderService::produce(Series &series, const RenderRequest &request)
+{
+    TRACE_SCOPE("service.render");
+    vtkSmartPointer<vtkImageData> image;
+    if (request.view == RenderView::Slice) {
+        image = Service::extractSlice(series.volume, request.axis, request.slice);
+    } else {
+        const bool mip = request.view == RenderView::Mip;
+        std::lock_guard<std::mutex> lock(mip ? series.mipMutex : series.drrMutex);
+        int extent[6];
+        series.volume->GetExtent(extent);
+        if (request.slab > 0) {
+            const int first = extent[2 * request.axis] + request.slice - (request.slab - 1) / 2;
+            extent[2 * request.axis] = first;
+            extent[2 * request.axis + 1] = first + request.slab - 1; // clamped by the box
+        }
+        (mip ? series.mipBox : series.drrBox).setExtent(extent);
+        vtkImageData *projection = mip ? series.mip.viewMip(static_cast<MipAxis>(request.axis))
+                                       : series.drr.viewDrr(static_cast<DrrAxis>(request.axis));
+        if (!projection) {
+            return Service::failure(500, "projection failed");
+        }
+        image = vtkSmartPointer<vtkImageData>::New();
+        image->DeepCopy(projection); // the viewer reuses its output for the next request
+    }
+    return Service::encode(image, request);
+}
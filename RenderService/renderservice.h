@@ -0,0 +1,160 @@
+#ifndef RENDERSERVICE_H
+#define RENDERSERVICE_H
+
+#include "drrviewer.h"
+#include "mipviewer.h"
+#include "volumeofinterest.h"
+#include "vtkImageData.h"
+#include "vtkSmartPointer.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class QUrlQuery;
+
+enum class RenderView {
+    Slice,
+    Mip,
+    Drr,
+};
+
+enum class RenderFormat {
+    Png, // 8-bit grey, window/level applied
+    Raw, // float32, no window/level
+};
+
+/// @brief One image request; parsed from a query string.
+struct RenderRequest
+{
+    std::string series;
+    RenderView view = RenderView::Mip;
+    int axis = 2;       // 0 sagittal, 1 coronal, 2 axial
+    int slice = -1;     // voxel index along `axis`: the slice, or the slab centre; -1 = middle
+    int slab = 0;       // projections: voxels through the slab; 0 = whole volume
+    double window = 0;  // <= 0: the image's own range
+    double level = 0;
+    int width = 0;      // output size; 0 = native, one of them 0 keeps the aspect ratio
+    int height = 0;
+    RenderFormat format = RenderFormat::Png;
+
+    // series=&view=slice|mip|drr&axis=sagittal|coronal|axial|0..2&slice=&slab=
+    // &window=&level=&width=&height=&format=png|raw. False + message on bad input.
+    static bool parse(const QUrlQuery &query, RenderRequest &out, QString &error);
+};
+
+/// @brief Encoded image, shared by every request with the same key.
+struct RenderResponse
+{
+    int status = 200;
+    QByteArray contentType;
+    QByteArray body;
+    int width = 0;
+    int height = 0;
+};
+
+/// @brief Loaded volumes answering image requests from several clients.
+///
+/// Each series keeps its decoded volume and one MipViewer / DrrViewer (with
+/// their HU remap and layout copies) resident. Requests are normalized to a
+/// key; a key already rendered is served from a byte-bounded LRU cache, and
+/// a key being rendered gets the same response as the request that started
+/// it instead of a second render. Renders run on the TaskScheduler.
+class RenderService
+{
+public:
+    enum class Source {
+        Rendered,  // this request rendered it
+        Cached,    // served from the response cache
+        Coalesced, // waited for an identical request in flight
+    };
+    using Callback = std::function<void(std::shared_ptr<const RenderResponse>, Source)>;
+
+    static constexpr std::size_t kDefaultCacheBudget = std::size_t(256) << 20;
+    static constexpr int kMaxOutputSize = 4096;
+
+    RenderService() = default;
+    // Waits for renders still running.
+    ~RenderService();
+
+    // Non-copyable — owns the viewers and the in-flight bookkeeping.
+    RenderService(const RenderService &) = delete;
+    RenderService &operator=(const RenderService &) = delete;
+
+    // Register before serving; the volume stays resident until destruction.
+    void addSeries(const std::string &name, vtkImageData *volume);
+    // {"name", dims, spacing} per series.
+    [[nodiscard]] QByteArray seriesJson() const;
+
+    void setCacheBudget(std::size_t bytes);
+    // done runs on a worker thread (or on the caller's, for cache hits and
+    // errors). Unknown series: status 404.
+    void render(RenderRequest request, Callback done);
+
+    // Blocks until every render submitted so far has called back.
+    void waitForRenders();
+
+    // Counters since start, as JSON.
+    [[nodiscard]] QByteArray statsJson() const;
+
+private:
+    /// @brief A resident volume and its projection pipelines. The viewers
+    /// read the VOI on every call, so each is used under its own lock.
+    struct Series
+    {
+        vtkSmartPointer<vtkImageData> volume;
+        int dims[3] = {0, 0, 0};
+        VolumeOfInterest mipBox;
+        VolumeOfInterest drrBox;
+        MipViewer mip;
+        DrrViewer drr;
+        std::mutex mipMutex;
+        std::mutex drrMutex;
+    };
+
+    /// @brief Renders waiting on one key.
+    struct InFlight
+    {
+        std::vector<Callback> waiting;
+    };
+
+    struct CacheEntry
+    {
+        std::shared_ptr<const RenderResponse> response;
+        std::list<std::string>::iterator lru;
+    };
+
+    static void normalize(RenderRequest &request, const int dims[3]);
+    static std::string key(const RenderRequest &request);
+    std::shared_ptr<const RenderResponse> produce(Series &series, const RenderRequest &request);
+    void insertCache(const std::string &key, const std::shared_ptr<const RenderResponse> &response); // m_mutex held
+
+    std::map<std::string, std::unique_ptr<Series>> m_series;
+
+    mutable std::mutex m_mutex; // m_inFlight, m_cache, m_lru, m_cacheBytes, m_cacheBudget, m_pending
+    std::unordered_map<std::string, InFlight> m_inFlight;
+    std::unordered_map<std::string, CacheEntry> m_cache;
+    std::list<std::string> m_lru; // most recent first
+    std::size_t m_cacheBytes = 0;
+    std::size_t m_cacheBudget = kDefaultCacheBudget;
+    std::vector<std::shared_future<void>> m_pending;
+
+    std::atomic<long long> m_requests{0};
+    std::atomic<long long> m_cached{0};
+    std::atomic<long long> m_coalesced{0};
+    std::atomic<long long> m_rendered{0};
+    std::atomic<long long> m_renderMicros{0};
+};
+
+#endif // RENDERSERVICE_H
@@ -0,0 +1,159 @@
+// Local render service: DICOM series decoded once and kept resident, slices
+// and MIP / DRR projections answered over HTTP to several clients.
+//
+// Usage: RenderService [options] [name=]dir...
+//   --host ADDRESS               listening address                     (default 127.0.0.1)
+//   --port N                     listening port                        (default 8090)
+//   --depth N                    directory levels scanned for series   (default 1)
+//   --cache-mb MB                encoded responses kept                (default 256)
+//
+// A series is requested by its name: the one given before '=', else its
+// folder name; further series under the same argument get -2, -3, ...
+//
+//   GET /series                                   loaded series, JSON
+//   GET /render?series=NAME&view=slice|mip|drr&axis=sagittal|coronal|axial
+//              &slice=N&slab=N&window=W&level=L&width=W&height=H&format=png|raw
+//   GET /stats                                    requests / cache hits / coalesced renders
+//
+// RenderLoad drives it with concurrent clients.
+
+#include "httpserver.h"
+#include "memoryledger.h"
+#include "paralleldicomreader.h"
+#include "renderservice.h"
+
+#include "vtkDICOMDirectory.h"
+#include "vtkImageData.h"
+#include "vtkNew.h"
+#include "vtkSmartPointer.h"
+#include "vtkStringArray.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QSet>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Decodes every series under `dir` and hands it to the service. False when
+// there was none or one could not be read.
+bool loadSeries(const QString &argument, int depth, RenderService &service, QSet<QString> &names)
+{
+    const int equals = argument.indexOf('=');
+    const QString dir = equals > 0 ? argument.mid(equals + 1) : argument;
+    const QString given = equals > 0 ? argument.left(equals) : QString();
+
+    vtkNew<vtkDICOMDirectory> directory;
+    directory->SetDirectoryName(dir.toUtf8().constData());
+    directory->SetScanDepth(depth);
+    directory->Update();
+    if (directory->GetNumberOfSeries() == 0) {
+        std::fprintf(stderr, "no DICOM series in %s\n", qPrintable(dir));
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < directory->GetNumberOfSeries(); ++i) {
+        vtkStringArray *files = directory->GetFileNamesForSeries(i);
+        if (!files || files->GetNumberOfValues() == 0)
+            continue;
+        const QString base = !given.isEmpty()
+                                 ? given
+                                 : QFileInfo(QString::fromStdString(files->GetValue(0))).dir().dirName();
+        QString name = base;
+        for (int n = 2; names.contains(name); ++n)
+            name = QString("%1-%2").arg(base).arg(n);
+
+        const auto t0 = Clock::now();
+        vtkNew<ParallelDicomReader> reader;
+        reader->SetFileNames(files);
+        reader->Update();
+        vtkImageData *volume = reader->GetOutput();
+        if (reader->GetErrorCode() != 0 || volume->GetNumberOfPoints() == 0) {
+            std::fprintf(stderr, "cannot read series %d of %s\n", i + 1, qPrintable(dir));
+            ok = false;
+            continue;
+        }
+        auto resident = vtkSmartPointer<vtkImageData>::New();
+        resident->ShallowCopy(volume); // outlives the reader
+        service.addSeries(name.toStdString(), resident);
+        names.insert(name);
+
+        int dims[3];
+        resident->GetDimensions(dims);
+        std::printf("  %-32s %4dx%4dx%4d  %8.1f MB  %8.1f ms\n", qPrintable(name), dims[0], dims[1], dims[2],
+                    MemoryLedger::dataBytes(resident) / 1e6, elapsedMs(t0));
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Slices and MIP / DRR projections of resident DICOM series, over HTTP.");
+    parser.addHelpOption();
+    const QCommandLineOption hostOption("host", "Listening address.", "address", "127.0.0.1");
+    const QCommandLineOption portOption("port", "Listening port.", "n", "8090");
+    const QCommandLineOption depthOption("depth", "Directory levels scanned for series.", "n", "1");
+    const QCommandLineOption cacheOption("cache-mb", "Encoded responses kept, MB.", "MB",
+                                         QString::number(RenderService::kDefaultCacheBudget >> 20));
+    parser.addOptions({hostOption, portOption, depthOption, cacheOption});
+    parser.addPositionalArgument("series", "Directories scanned for DICOM series, optionally name=dir.",
+                                 "[name=]dir...");
+    parser.process(app);
+
+    if (parser.positionalArguments().isEmpty()) {
+        parser.showHelp(1);
+    }
+    const QHostAddress host(parser.value(hostOption));
+    if (host.isNull()) {
+        std::fprintf(stderr, "bad --host '%s'\n", qPrintable(parser.value(hostOption)));
+        return 1;
+    }
+    bool portOk = false;
+    const uint port = parser.value(portOption).toUInt(&portOk);
+    if (!portOk || port > 65535) {
+        std::fprintf(stderr, "bad --port '%s'\n", qPrintable(parser.value(portOption)));
+        return 1;
+    }
+    const int depth = std::max(1, parser.value(depthOption).toInt());
+
+    RenderService service;
+    service.setCacheBudget(std::size_t(std::max(0.0, parser.value(cacheOption).toDouble()) * 1024 * 1024));
+
+    QSet<QString> names;
+    for (const QString &argument : parser.positionalArguments()) {
+        if (!loadSeries(argument, depth, service, names))
+            return 1;
+    }
+    if (names.isEmpty()) {
+        std::fprintf(stderr, "nothing to serve\n");
+        return 1;
+    }
+
+    HttpServer server(service);
+    if (!server.listen(host, quint16(port))) {
+        std::fprintf(stderr, "cannot listen on %s:%u: %s\n", qPrintable(host.toString()), port,
+                     qPrintable(server.errorString()));
+        return 1;
+    }
+    std::printf("%d series on http://%s:%u\n", int(names.size()), qPrintable(host.toString()), port);
+    std::fflush(stdout);
+    return app.exec();
+}
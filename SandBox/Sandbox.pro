@@ -4,8 +4,27 @@ TARGET = Sandbox
 
 include(../shared_config.pri)
 
+# CPU raycaster, progressive refinement and worker pool are shared with the main app.
+INCLUDEPATH += ../MainApp
+
 SOURCES += sandbox_main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    ../MainApp/cpuraycaster.cpp \
+    ../MainApp/gradientvolume.cpp \
+    ../MainApp/isosurface.cpp \
+    ../MainApp/parallelfor.cpp \
+    ../MainApp/preintegration.cpp \
+    ../MainApp/progressiverenderer.cpp \
+    ../MainApp/taskscheduler.cpp \
+    ../MainApp/tracing.cpp
 
 HEADERS += \
-    mainwindow.h
+    mainwindow.h \
+    ../MainApp/cpuraycaster.h \
+    ../MainApp/gradientvolume.h \
+    ../MainApp/isosurface.h \
+    ../MainApp/parallelfor.h \
+    ../MainApp/preintegration.h \
+    ../MainApp/progressiverenderer.h \
+    ../MainApp/taskscheduler.h \
+    ../MainApp/tracing.h
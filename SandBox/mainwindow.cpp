@@ -1,18 +1,22 @@
 #include "mainwindow.h"
+#include <QCheckBox>
 #include <QHBoxLayout>
 #include <QLabel>
 #include <QSlider>
 #include <QVBoxLayout>
+#include <algorithm>
 #include "vtkCamera.h"
 #include "vtkImageViewer2.h"
+#include "vtkProperty.h"
 #include "vtkSampleFunction.h"
 #include "vtkSphere.h"
 #include "vtkSphereSource.h"
 
 const char *dirPath = "C:/Users/cdac/Projects/SE2dcm";
 
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(bool cpuRendering, QWidget *parent)
     : QMainWindow{parent}
+    , m_cpuRendering(cpuRendering)
 {
     m_vtkWidget = new QVTKOpenGLNativeWidget(this);
     qDebug() << "Constructor";
@@ -43,27 +47,37 @@ vtkImageData *MainWindow::getImageData()
 
 void MainWindow::setupVtk()
 {
-    // getImageData();
-    // m_mapper->SetInputData(getImageData());
-
-    m_dir->SetDirectoryName(dirPath);
-    m_dir->Update();
-    if (m_dir->GetNumberOfSeries() == 0) {
-        // qDebug() << "Hello Before";
-        std::cerr << "No dicom series found in the directory ";
+    // One scan and one decode; every consumer below shares this output.
+    vtkImageData *image = getImageData();
+    if (!image) {
+        return;
     }
-    // qDebug() << "Hello After";
-    m_reader->SetFileNames(m_dir->GetFileNamesForSeries(0));
-    m_reader->Update();
 
     double range[2];
-    m_reader->GetOutput()->GetScalarRange(range);
-    // qDebug() << "Dicom scalar range: " << range[0] << " to " << range[1];
-
-    int *dims = m_reader->GetOutput()->GetDimensions();
-    // qDebug() << "Dimensions " << dims[0] << dims[1] << dims[2];
-    m_mapper->SetInputConnection(m_reader->GetOutputPort());
-    m_mapper->AutoAdjustSampleDistancesOn();
+    image->GetScalarRange(range);
+
+    const double *spacing = image->GetSpacing();
+    const double sampleDistance = std::min({spacing[0], spacing[1], spacing[2]});
+    ProgressiveRenderer::PassHandler applyPass;
+    if (m_cpuRendering) {
+        auto cpuMapper = vtkSmartPointer<CpuVolumeMapper>::New();
+        // pre-integrated segments hold thin edges at twice the voxel step
+        cpuMapper->raycaster().setSampleDistance(2.0 * sampleDistance);
+        applyPass = [mapper = cpuMapper.Get()](RefinePass pass) { mapper->setPass(pass); };
+        m_mapper = cpuMapper;
+    } else {
+        // Passes replace the mapper's own frame-rate driven adjustment; the GPU
+        // path re-renders each pass from scratch.
+        auto gpuMapper = vtkSmartPointer<vtkGPUVolumeRayCastMapper>::New();
+        gpuMapper->AutoAdjustSampleDistancesOff();
+        applyPass = [mapper = gpuMapper.Get(), sampleDistance](RefinePass pass) {
+            mapper->SetImageSampleDistance(pass == RefinePass::Preview ? 2.0f : 1.0f);
+            mapper->SetSampleDistance(static_cast<float>(
+                pass == RefinePass::Final ? sampleDistance : 2.0 * sampleDistance));
+        };
+        m_mapper = gpuMapper;
+    }
+    m_mapper->SetInputData(image);
     // m_mapper->AutoAdjustSampleDistancesOff();
     // m_mapper->SetSampleDistance(0.5);
     m_mapper->SetBlendModeToComposite();
@@ -96,6 +110,12 @@ void MainWindow::setupVtk()
     // m_camera->SetFocalPoint(0, 0, 0);
 
     m_renderer->AddVolume(m_volume);
+
+    m_isoMapper->ScalarVisibilityOff();
+    m_isoActor->SetMapper(m_isoMapper);
+    m_isoActor->GetProperty()->SetColor(0.95, 0.92, 0.84); // bone
+    m_isoActor->VisibilityOff();
+    m_renderer->AddActor(m_isoActor);
     // m_renderer->SetActiveCamera(m_camera);
     // m_renderer->SetBackground(23.0 / 255.0, 146.0 / 255.0, 153.0 / 255.0);
 
@@ -110,6 +130,7 @@ void MainWindow::setupVtk()
     m_vtkWidget->SetRenderWindow(m_renderWindow);
 
     m_renderer->ResetCamera();
+    m_progressive = new ProgressiveRenderer(m_renderer, applyPass, this);
     // m_renderWindow->GetInteractor()->Initialize();
     // qDebug() << "GPU mode: " << (m_mapper->GetLastUsedRenderMode() == 0);
 }
@@ -132,5 +153,54 @@ void MainWindow::setupUI()
     controlsLayout->addWidget(windowLabel);
     controlsLayout->addWidget(slider);
     slider->setMinimumWidth(150);
+
+    // Gradients are computed the first time shading is switched on (CPU path:
+    // one shared GradientVolume per volume).
+    QCheckBox *shadingCheck = new QCheckBox("Shading", rightControlPanel);
+    controlsLayout->addWidget(shadingCheck);
+    connect(shadingCheck, &QCheckBox::toggled, this, [this](bool on) {
+        m_prop->SetShade(on ? 1 : 0);
+        m_renderWindow->Render();
+    });
+
+    QCheckBox *isoCheck = new QCheckBox("Isosurface", rightControlPanel);
+    QLabel *isoLabel = new QLabel(QString("Iso value: %1 HU").arg(m_isoValue), rightControlPanel);
+    QSlider *isoSlider = new QSlider(Qt::Horizontal, rightControlPanel);
+    isoSlider->setRange(-1000, 3000);
+    isoSlider->setValue(m_isoValue);
+    controlsLayout->addWidget(isoCheck);
+    controlsLayout->addWidget(isoLabel);
+    controlsLayout->addWidget(isoSlider);
+    connect(isoCheck, &QCheckBox::toggled, this, &MainWindow::setIsoSurfaceMode);
+    // valueChanged fires on every drag step; only straddling blocks re-extract
+    connect(isoSlider, &QSlider::valueChanged, this, [this, isoLabel](int value) {
+        m_isoValue = value;
+        isoLabel->setText(QString("Iso value: %1 HU").arg(value));
+        if (m_isoMode)
+            updateIsoSurface();
+    });
     controlsLayout->addStretch();
 }
+
+void MainWindow::setIsoSurfaceMode(bool enabled)
+{
+    m_isoMode = enabled;
+    m_volume->SetVisibility(!enabled);
+    m_isoActor->SetVisibility(enabled);
+    if (enabled) {
+        updateIsoSurface(); // first use builds the min/max octree
+    } else {
+        m_renderWindow->Render();
+    }
+}
+
+void MainWindow::updateIsoSurface()
+{
+    m_isoExtractor.setInputData(m_reader->GetOutput());
+    vtkPolyData *surface = m_isoExtractor.extract(m_isoValue);
+    if (!surface) {
+        return;
+    }
+    m_isoMapper->SetInputData(surface);
+    m_renderWindow->Render();
+}
@@ -5,7 +5,11 @@
 #include <QMainWindow>
 #include <QObject>
 #include "QVTKOpenGLNativeWidget.h"
+#include "vtkActor.h"
 #include "vtkCamera.h"
+#include "cpuraycaster.h"
+#include "isosurface.h"
+#include "progressiverenderer.h"
 #include "vtkColorTransferFunction.h"
 #include "vtkDICOMDirectory.h"
 #include "vtkDICOMReader.h"
@@ -16,6 +20,7 @@
 #include "vtkNew.h"
 #include "vtkOpenGLGPUVolumeRayCastMapper.h"
 #include "vtkPiecewiseFunction.h"
+#include "vtkPolyDataMapper.h"
 #include "vtkRenderWindow.h"
 #include "vtkRenderWindowInteractor.h"
 #include "vtkRenderer.h"
@@ -30,10 +35,13 @@ class MainWindow : public QMainWindow
 {
     Q_OBJECT
 public:
-    explicit MainWindow(QWidget *parent = nullptr);
+    // cpuRendering: raycast on the CPU (no usable GPU, CI boxes).
+    explicit MainWindow(bool cpuRendering = false, QWidget *parent = nullptr);
     vtkImageData *getImageData();
     void setupVtk();
     void setupUI();
+    void setIsoSurfaceMode(bool enabled);
+    void updateIsoSurface();
 
 signals:
 private:
@@ -44,13 +52,24 @@ private:
     vtkNew<vtkVolumeProperty> m_prop;
     // vtkNew<vtkSmartVolumeMapper> m_mapper;
     // vtkNew<vtkFixedPointVolumeRayCastMapper> m_mapper;
-    vtkNew<vtkGPUVolumeRayCastMapper> m_mapper;
+    // vtkGPUVolumeRayCastMapper, or CpuVolumeMapper with --cpu
+    vtkSmartPointer<vtkVolumeMapper> m_mapper;
+    bool m_cpuRendering = false;
     vtkNew<vtkVolume> m_volume;
     vtkNew<vtkRenderer> m_renderer;
     vtkNew<vtkGenericOpenGLRenderWindow> m_renderWindow;
     vtkRenderWindowInteractor *m_interactor = nullptr;
     QVTKOpenGLNativeWidget *m_vtkWidget = nullptr;
     vtkNew<vtkCamera> m_camera;
+    // Preview while the camera moves, refined passes once it settles.
+    ProgressiveRenderer *m_progressive = nullptr;
+
+    // Isosurface mode replaces the volume with a mesh at m_isoValue (HU).
+    IsoSurfaceExtractor m_isoExtractor;
+    vtkNew<vtkPolyDataMapper> m_isoMapper;
+    vtkNew<vtkActor> m_isoActor;
+    bool m_isoMode = false;
+    int m_isoValue = 300;
 };
 
 #endif // MAINWINDOW_H
@@ -24,7 +24,8 @@ int main(int argc, char *argv[])
     QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
 
     QApplication app(argc, argv);
-    MainWindow w;
+    // --cpu: software raycaster for workstations without a usable GPU
+    MainWindow w(app.arguments().contains("--cpu"));
     w.show();
     return app.exec();
 }
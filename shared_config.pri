@@ -79,29 +79,34 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 
 
 
-# # --- GDCM ---
-# GDCM_PATH = $$PWD/../GDCM
-
-# INCLUDEPATH += $$GDCM_PATH/include/gdcm-2.6
-# QMAKE_LIBDIR += $$GDCM_PATH/lib
-
-# LIBS += \
-#     -lvtkgdcm \
-#     -lgdcmMSFF \
-#     -lgdcmIOD \
-#     -lgdcmDSED \
-#     -lgdcmDICT \
-#     -lgdcmCommon \
-#     -lgdcmCharls \
-#     -lgdcmjpeg8 \
-#     -lgdcmjpeg12 \
-#     -lgdcmjpeg16 \
-#     -lgdcmMEXD \
-#     -lgdcmexpat \
-#     -lgdcmgetopt \
-#     -lgdcmopenjpeg \
-#     -lgdcmzlib \
-#     -lsocketxx \
+# --- GDCM (optional) ---
+# Found next to the repository: compressed transfer syntaxes (JPEG-Lossless,
+# JPEG 2000, ...) are then decoded in parallel by ParallelDicomReader.
+# Without it the reader is plain vtkDICOMReader.
+GDCM_PATH = $$PWD/../GDCM
+
+exists($$GDCM_PATH/include/gdcm-2.6) {
+    DEFINES += HAVE_GDCM
+    INCLUDEPATH += $$GDCM_PATH/include/gdcm-2.6
+    QMAKE_LIBDIR += $$GDCM_PATH/lib
+
+    LIBS += \
+        -lgdcmMSFF \
+        -lgdcmIOD \
+        -lgdcmDSED \
+        -lgdcmDICT \
+        -lgdcmCommon \
+        -lgdcmCharls \
+        -lgdcmjpeg8 \
+        -lgdcmjpeg12 \
+        -lgdcmjpeg16 \
+        -lgdcmMEXD \
+        -lgdcmexpat \
+        -lgdcmgetopt \
+        -lgdcmopenjpeg \
+        -lgdcmzlib \
+        -lsocketxx
+}
 
 
 